@@ -0,0 +1,369 @@
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "core/job_system.hpp"
+#include "graphics/indirect_renderer.hpp"
+#include "graphics/render_manager.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint32_t DEFAULT_FRAME_COUNT     = 300;
+constexpr uint32_t DEFAULT_WARMUP_COUNT    = 30;
+constexpr uint32_t GRAPHICS_INSTANCE_COUNT = 100'000;
+constexpr uint32_t COMPUTE_INSTANCE_COUNT  = 1'000'000;
+constexpr uint32_t COMPUTE_DISPATCH_COUNT  = 8;
+constexpr uint32_t COMPUTE_BUCKET_COUNT    = 256;
+constexpr uint32_t COMPUTE_GROUP_SIZE      = 64;
+constexpr uint32_t COMPUTE_BINDING_COUNT   = 4;
+constexpr uint32_t COMPUTE_FRAME_LAG       = 2;
+constexpr float    SCATTER_EXTENT          = 2.0f;
+constexpr float    INSTANCE_SCALE          = 0.02f;
+constexpr uint32_t RANDOM_SEED             = 1234;
+
+
+// =================================================================================================
+// Compute workload
+// =================================================================================================
+
+// The culling shader run on buffers of its own, every instance passes so each dispatch writes all of its commands
+struct Compute_workload
+{
+	VkDevice              device                = VK_NULL_HANDLE;
+	Gpu_allocator*        gpu_allocator         = nullptr;
+	VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+	VkDescriptorPool      descriptor_pool       = VK_NULL_HANDLE;
+	VkDescriptorSet       descriptor_set        = VK_NULL_HANDLE;
+	VkPipelineLayout      pipeline_layout       = VK_NULL_HANDLE;
+	VkPipeline            pipeline              = VK_NULL_HANDLE;
+	Cull_constants        constants             = {};
+
+	VkBuffer       buffers[COMPUTE_BINDING_COUNT] = {};
+	Gpu_allocation allocations[COMPUTE_BINDING_COUNT];
+};
+
+static bool create_workload(Render_manager& render_manager, Compute_workload& workload)
+{
+	workload.device        = render_manager.get_device();
+	workload.gpu_allocator = &render_manager.get_gpu_allocator();
+
+	// Instances and buckets are written once from the host, commands and counts never leave the device
+	uint32_t              per_bucket                          = (COMPUTE_INSTANCE_COUNT + COMPUTE_BUCKET_COUNT - 1) / COMPUTE_BUCKET_COUNT;
+	VkDeviceSize          buffer_sizes[COMPUTE_BINDING_COUNT] = {sizeof(Gpu_instance) * COMPUTE_INSTANCE_COUNT,
+	                                                             sizeof(uint32_t) * 2 * COMPUTE_BUCKET_COUNT,
+	                                                             sizeof(VkDrawIndexedIndirectCommand) * per_bucket * COMPUTE_BUCKET_COUNT,
+	                                                             sizeof(uint32_t) * COMPUTE_BUCKET_COUNT};
+	VkMemoryPropertyFlags host_memory                         = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	VkMemoryPropertyFlags memory[COMPUTE_BINDING_COUNT]       = {host_memory, host_memory, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT};
+
+	for (uint32_t i = 0; i < COMPUTE_BINDING_COUNT; i++)
+	{
+		if (!workload.gpu_allocator->create_buffer(buffer_sizes[i], VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, memory[i], workload.buffers[i], workload.allocations[i]))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create compute buffers.");
+			return false;
+		}
+	}
+
+	std::vector<Gpu_instance> instances(COMPUTE_INSTANCE_COUNT);
+	for (uint32_t i = 0; i < COMPUTE_INSTANCE_COUNT; i++)
+	{
+		instances[i].bounds    = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		instances[i].transform = glm::vec4(0.0f, 0.0f, INSTANCE_SCALE, 0.0f);
+		instances[i].bucket    = i % COMPUTE_BUCKET_COUNT;
+	}
+	std::memcpy(workload.allocations[0].mapped, instances.data(), buffer_sizes[0]);
+
+	std::vector<uint32_t> buckets(2 * COMPUTE_BUCKET_COUNT);
+	for (uint32_t i = 0; i < COMPUTE_BUCKET_COUNT; i++)
+	{
+		buckets[2 * i + 0] = 3;
+		buckets[2 * i + 1] = i * per_bucket;
+	}
+	std::memcpy(workload.allocations[1].mapped, buckets.data(), buffer_sizes[1]);
+
+	// Zero planes keep every sphere inside
+	workload.constants.instance_count = COMPUTE_INSTANCE_COUNT;
+
+	VkDescriptorSetLayoutBinding bindings[COMPUTE_BINDING_COUNT] = {};
+	for (uint32_t i = 0; i < COMPUTE_BINDING_COUNT; i++)
+	{
+		bindings[i].binding         = i;
+		bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount                    = COMPUTE_BINDING_COUNT;
+	layout_info.pBindings                       = bindings;
+
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_size.descriptorCount      = COMPUTE_BINDING_COUNT;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets                    = 1;
+	pool_info.poolSizeCount              = 1;
+	pool_info.pPoolSizes                 = &pool_size;
+
+	if (vkCreateDescriptorSetLayout(workload.device, &layout_info, nullptr, &workload.descriptor_set_layout) != VK_SUCCESS || vkCreateDescriptorPool(workload.device, &pool_info, nullptr, &workload.descriptor_pool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create compute descriptors.");
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool              = workload.descriptor_pool;
+	allocate_info.descriptorSetCount          = 1;
+	allocate_info.pSetLayouts                 = &workload.descriptor_set_layout;
+
+	if (vkAllocateDescriptorSets(workload.device, &allocate_info, &workload.descriptor_set) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate compute descriptor set.");
+		return false;
+	}
+
+	VkDescriptorBufferInfo buffer_infos[COMPUTE_BINDING_COUNT] = {};
+	VkWriteDescriptorSet   writes[COMPUTE_BINDING_COUNT]       = {};
+	for (uint32_t i = 0; i < COMPUTE_BINDING_COUNT; i++)
+	{
+		buffer_infos[i].buffer = workload.buffers[i];
+		buffer_infos[i].range  = VK_WHOLE_SIZE;
+
+		writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet          = workload.descriptor_set;
+		writes[i].dstBinding      = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo     = &buffer_infos[i];
+	}
+	vkUpdateDescriptorSets(workload.device, COMPUTE_BINDING_COUNT, writes, 0, nullptr);
+
+	VkPushConstantRange push_constant_range = {};
+	push_constant_range.stageFlags          = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_range.size                = sizeof(Cull_constants);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+	pipeline_layout_info.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_info.setLayoutCount             = 1;
+	pipeline_layout_info.pSetLayouts                = &workload.descriptor_set_layout;
+	pipeline_layout_info.pushConstantRangeCount     = 1;
+	pipeline_layout_info.pPushConstantRanges        = &push_constant_range;
+
+	if (vkCreatePipelineLayout(workload.device, &pipeline_layout_info, nullptr, &workload.pipeline_layout) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create compute pipeline layout.");
+		return false;
+	}
+
+	Shader_manager&          shader_manager = render_manager.get_shader_manager();
+	const std::vector<char>& code           = shader_manager.get_code(shader_manager.load("cull.comp", "cull.spv"));
+
+	VkShaderModuleCreateInfo module_info = {};
+	module_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	module_info.codeSize                 = code.size();
+	module_info.pCode                    = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shader_module;
+	if (vkCreateShaderModule(workload.device, &module_info, nullptr, &shader_module) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create compute shader module.");
+		return false;
+	}
+
+	VkComputePipelineCreateInfo pipeline_info = {};
+	pipeline_info.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_info.stage.sType                 = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_info.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_info.stage.module                = shader_module;
+	pipeline_info.stage.pName                 = "main";
+	pipeline_info.layout                      = workload.pipeline_layout;
+
+	VkResult result = vkCreateComputePipelines(workload.device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &workload.pipeline);
+	vkDestroyShaderModule(workload.device, shader_module, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create compute pipeline.");
+		return false;
+	}
+
+	return true;
+}
+
+static void destroy_workload(Compute_workload& workload)
+{
+	vkDestroyPipeline(workload.device, workload.pipeline, nullptr);
+	vkDestroyPipelineLayout(workload.device, workload.pipeline_layout, nullptr);
+	vkDestroyDescriptorPool(workload.device, workload.descriptor_pool, nullptr);
+	vkDestroyDescriptorSetLayout(workload.device, workload.descriptor_set_layout, nullptr);
+
+	for (uint32_t i = 0; i < COMPUTE_BINDING_COUNT; i++)
+	{
+		if (workload.buffers[i] != VK_NULL_HANDLE)
+		{
+			workload.gpu_allocator->destroy_buffer(workload.buffers[i], workload.allocations[i]);
+		}
+	}
+}
+
+static void record_workload(const Compute_workload& workload, VkCommandBuffer command_buffer)
+{
+	// Earlier submissions to the queue wrote the same buffers
+	VkMemoryBarrier barrier = {};
+	barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, workload.pipeline);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, workload.pipeline_layout, 0, 1, &workload.descriptor_set, 0, nullptr);
+	vkCmdPushConstants(command_buffer, workload.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Cull_constants), &workload.constants);
+
+	for (uint32_t i = 0; i < COMPUTE_DISPATCH_COUNT; i++)
+	{
+		vkCmdFillBuffer(command_buffer, workload.buffers[3], 0, VK_WHOLE_SIZE, 0);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		vkCmdDispatch(command_buffer, (COMPUTE_INSTANCE_COUNT + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE, 1, 1);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+
+// Overlapped compute waits on nothing and is only throttled on the CPU. Serialized compute waits for the previous
+// graphics frame and the next graphics frame waits for it, so the two queues take turns.
+static double run_mode(Render_manager& render_manager, const Compute_workload& workload, bool serialized, uint32_t frame_count, uint32_t warmup_count)
+{
+	Compute_queue& compute_queue     = render_manager.get_compute_queue();
+	Gpu_timeline&  graphics_timeline = render_manager.get_graphics_timeline();
+
+	uint64_t compute_values[COMPUTE_FRAME_LAG] = {};
+	uint64_t start_ns                          = 0;
+
+	for (uint32_t i = 0; i < warmup_count + frame_count; i++)
+	{
+		if (i == warmup_count)
+		{
+			start_ns = SDL_GetTicksNS();
+		}
+
+		uint64_t& compute_value = compute_values[i % COMPUTE_FRAME_LAG];
+		compute_queue.get_timeline().wait(compute_value);
+
+		VkCommandBuffer command_buffer = compute_queue.begin();
+		record_workload(workload, command_buffer);
+
+		if (serialized)
+		{
+			Timeline_wait graphics_wait = graphics_timeline.get_wait(graphics_timeline.get_submitted_value(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+			compute_value               = compute_queue.submit(command_buffer, {&graphics_wait, 1});
+			render_manager.wait_for_compute(compute_value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+		else
+		{
+			compute_value = compute_queue.submit(command_buffer);
+		}
+
+		render_manager.update();
+	}
+
+	// Both queues have to drain for the wall time to cover all the work
+	graphics_timeline.wait(graphics_timeline.get_submitted_value());
+	compute_queue.get_timeline().wait(compute_queue.get_timeline().get_submitted_value());
+
+	return static_cast<double>(SDL_GetTicksNS() - start_ns) / 1'000'000.0 / frame_count;
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	uint32_t frame_count  = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_FRAME_COUNT;
+	uint32_t warmup_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_WARMUP_COUNT;
+	if (frame_count == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [frame_count] [warmup_count]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Render_settings settings;
+	settings.headless = true;
+
+	Job_system job_system;
+	job_system.startup();
+
+	Render_manager render_manager;
+	if (!render_manager.startup(job_system, settings))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start render manager.");
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<Vertex>   triangle_vertices = {{{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}}, {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}}, {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}};
+	const std::vector<uint32_t> triangle_indices  = {0, 1, 2};
+	Mesh_handle                 triangle          = render_manager.create_mesh(triangle_vertices, triangle_indices);
+
+	std::mt19937                          random(RANDOM_SEED);
+	std::uniform_real_distribution<float> position(-SCATTER_EXTENT, SCATTER_EXTENT);
+
+	std::vector<Mesh_instance> instances(GRAPHICS_INSTANCE_COUNT);
+	for (Mesh_instance& instance : instances)
+	{
+		instance.mesh   = triangle;
+		instance.offset = glm::vec2(position(random), position(random));
+		instance.scale  = INSTANCE_SCALE;
+	}
+	render_manager.set_instances(instances);
+
+	Compute_workload workload;
+	if (!create_workload(render_manager, workload))
+	{
+		destroy_workload(workload);
+		render_manager.shutdown();
+		job_system.shutdown();
+		return EXIT_FAILURE;
+	}
+
+	bool async = render_manager.get_compute_queue().is_async();
+	if (!async)
+	{
+		SDL_Log("Device has no second compute capable queue, both modes run on the graphics queue.");
+	}
+
+	double serialized_ms = run_mode(render_manager, workload, true, frame_count, warmup_count);
+	double overlapped_ms = run_mode(render_manager, workload, false, frame_count, warmup_count);
+
+	SDL_Log("Average over %u frames (%u warmup), %u instances drawn, %u x %u instances culled on the compute queue:", frame_count, warmup_count, GRAPHICS_INSTANCE_COUNT, COMPUTE_DISPATCH_COUNT, COMPUTE_INSTANCE_COUNT);
+	SDL_Log("%12s | %12s | %8s", "serialized", "overlapped", "speedup");
+	SDL_Log("%9.3f ms | %9.3f ms | %7.2fx", serialized_ms, overlapped_ms, serialized_ms / overlapped_ms);
+
+	vkDeviceWaitIdle(render_manager.get_device());
+	destroy_workload(workload);
+
+	render_manager.shutdown();
+	job_system.shutdown();
+
+	return EXIT_SUCCESS;
+}
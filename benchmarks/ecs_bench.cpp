@@ -0,0 +1,192 @@
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "core/job_system.hpp"
+#include "ecs/world.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint32_t DEFAULT_ENTITY_COUNT = 1'000'000;
+constexpr uint32_t ITERATION_REPEATS    = 20;
+constexpr uint32_t CHURN_DIVISOR        = 10;
+constexpr float    DELTA_TIME           = 1.0f / 60.0f;
+
+
+// =================================================================================================
+// Components
+// =================================================================================================
+struct Position
+{
+	float x, y, z;
+};
+
+struct Velocity
+{
+	float x, y, z;
+};
+
+struct Rotation
+{
+	float x, y, z, w;
+};
+
+struct Scale
+{
+	float value;
+};
+
+struct Health
+{
+	float value;
+};
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+static double to_ms(uint64_t ns)
+{
+	return static_cast<double>(ns) / 1'000'000.0;
+}
+
+// Best of several runs, the first touches cold memory and later ones show the steady state
+template <typename Function>
+static uint64_t best_of(uint32_t repeats, const Function& function)
+{
+	uint64_t best = UINT64_MAX;
+	for (uint32_t i = 0; i < repeats; i++)
+	{
+		uint64_t start = SDL_GetTicksNS();
+		function();
+		best = std::min(best, SDL_GetTicksNS() - start);
+	}
+	return best;
+}
+
+static void report_iteration(const char* name, uint64_t elapsed, uint32_t entity_count)
+{
+	SDL_Log("%-24s | %8.3f ms | %6.2f ns/entity", name, to_ms(elapsed), static_cast<double>(elapsed) / entity_count);
+}
+
+
+// =================================================================================================
+// Scenarios
+// =================================================================================================
+static void run_iteration(World& world, Job_system& job_system, uint32_t entity_count)
+{
+	auto integrate = [](Position& position, const Velocity& velocity)
+	{
+		position.x += velocity.x * DELTA_TIME;
+		position.y += velocity.y * DELTA_TIME;
+		position.z += velocity.z * DELTA_TIME;
+	};
+
+	auto spin = [](Position& position, Velocity& velocity, Rotation& rotation)
+	{
+		rotation.z += velocity.x * DELTA_TIME;
+		rotation.w  = std::sqrt(std::max(0.0f, 1.0f - rotation.z * rotation.z));
+		position.x += velocity.x * DELTA_TIME;
+	};
+
+	auto transform = [](Position& position, Velocity& velocity, Rotation& rotation, Scale& scale)
+	{
+		position.x += (velocity.x * rotation.w - velocity.y * rotation.z) * scale.value * DELTA_TIME;
+		position.y += (velocity.x * rotation.z + velocity.y * rotation.w) * scale.value * DELTA_TIME;
+		position.z += velocity.z * scale.value * DELTA_TIME;
+	};
+
+	SDL_Log("Query iteration over %u entities (best of %u, %u workers):", entity_count, ITERATION_REPEATS, job_system.get_worker_count());
+
+	report_iteration("2 components", best_of(ITERATION_REPEATS, [&]() { world.each<Position, Velocity>(integrate); }), entity_count);
+	report_iteration("3 components", best_of(ITERATION_REPEATS, [&]() { world.each<Position, Velocity, Rotation>(spin); }), entity_count);
+	report_iteration("4 components", best_of(ITERATION_REPEATS, [&]() { world.each<Position, Velocity, Rotation, Scale>(transform); }), entity_count);
+	report_iteration("2 components parallel", best_of(ITERATION_REPEATS, [&]() { world.parallel_each<Position, Velocity>(job_system, integrate); }), entity_count);
+	report_iteration("3 components parallel", best_of(ITERATION_REPEATS, [&]() { world.parallel_each<Position, Velocity, Rotation>(job_system, spin); }), entity_count);
+	report_iteration("4 components parallel", best_of(ITERATION_REPEATS, [&]() { world.parallel_each<Position, Velocity, Rotation, Scale>(job_system, transform); }), entity_count);
+}
+
+static void run_churn(World& world, const std::vector<Entity>& entities)
+{
+	// Every other entity moves, so the swap removal keeps shuffling rows between the two archetypes
+	size_t churn_count = entities.size() / CHURN_DIVISOR;
+
+	uint64_t start = SDL_GetTicksNS();
+	for (size_t i = 0; i < churn_count; i++)
+	{
+		world.add_component<Health>(entities[i * 2 % entities.size()], Health{100.0f});
+	}
+	uint64_t added = SDL_GetTicksNS();
+	for (size_t i = 0; i < churn_count; i++)
+	{
+		world.remove_component<Health>(entities[i * 2 % entities.size()]);
+	}
+	uint64_t removed = SDL_GetTicksNS();
+
+	SDL_Log("Component churn over %zu entities:", churn_count);
+	SDL_Log("%-24s | %8.3f ms | %6.2f ns/op", "add component", to_ms(added - start), static_cast<double>(added - start) / churn_count);
+	SDL_Log("%-24s | %8.3f ms | %6.2f ns/op", "remove component", to_ms(removed - added), static_cast<double>(removed - added) / churn_count);
+}
+
+static void run_destroy(World& world, std::vector<Entity>& entities)
+{
+	uint64_t start = SDL_GetTicksNS();
+	for (Entity entity : entities)
+	{
+		world.destroy_entity(entity);
+	}
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	SDL_Log("%-24s | %8.3f ms | %6.2f ns/entity", "destroy entity", to_ms(elapsed), static_cast<double>(elapsed) / entities.size());
+	entities.clear();
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	uint32_t entity_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_ENTITY_COUNT;
+	if (entity_count == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [entity_count]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Job_system job_system;
+	job_system.startup(std::max(std::thread::hardware_concurrency(), 1u));
+
+	World               world;
+	std::vector<Entity> entities;
+	entities.reserve(entity_count);
+
+	uint64_t start = SDL_GetTicksNS();
+	for (uint32_t i = 0; i < entity_count; i++)
+	{
+		Entity entity = world.create_entity();
+		world.add_component<Position>(entity, {static_cast<float>(i), 0.0f, 0.0f});
+		world.add_component<Velocity>(entity, {1.0f, 0.5f, 0.25f});
+		world.add_component<Rotation>(entity, {0.0f, 0.0f, 0.0f, 1.0f});
+		world.add_component<Scale>(entity, {1.0f});
+		entities.push_back(entity);
+	}
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	SDL_Log("Entity creation:");
+	SDL_Log("%-24s | %8.3f ms | %6.2f ns/entity", "create with 4 components", to_ms(elapsed), static_cast<double>(elapsed) / entity_count);
+
+	run_iteration(world, job_system, entity_count);
+	run_churn(world, entities);
+	run_destroy(world, entities);
+
+	job_system.shutdown();
+
+	return EXIT_SUCCESS;
+}
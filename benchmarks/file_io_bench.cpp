@@ -0,0 +1,212 @@
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "core/file_io.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint64_t DEFAULT_FILE_SIZE_MB = 4096;
+constexpr size_t   WRITE_BLOCK_SIZE     = 64 * 1024 * 1024;
+constexpr size_t   READ_CHUNK_SIZE      = 8 * 1024 * 1024;
+constexpr size_t   READS_IN_FLIGHT      = 8;
+constexpr size_t   PREFETCH_DISTANCE    = 64 * 1024 * 1024;
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+static double to_ms(uint64_t ns)
+{
+	return static_cast<double>(ns) / 1'000'000.0;
+}
+
+static uint64_t checksum(const char* data, size_t size)
+{
+	uint64_t sum = 0;
+	for (size_t i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		sum += word;
+	}
+	return sum;
+}
+
+static bool write_test_file(const std::string& path, uint64_t size)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::vector<uint64_t> block(WRITE_BLOCK_SIZE / sizeof(uint64_t));
+	for (uint64_t written = 0; written < size; written += WRITE_BLOCK_SIZE)
+	{
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			block[i] = (written / sizeof(uint64_t) + i) * 0x9e3779b97f4a7c15ull;
+		}
+		file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(std::min<uint64_t>(WRITE_BLOCK_SIZE, size - written)));
+	}
+
+	return file.good();
+}
+
+static void report(const char* name, uint64_t elapsed, uint64_t size, size_t resident, uint64_t sum)
+{
+	SDL_Log("%-10s | %9.3f ms | %6.2f GB/s | %8.1f MB buffered | checksum %016llx",
+	        name,
+	        to_ms(elapsed),
+	        static_cast<double>(size) / static_cast<double>(elapsed),
+	        static_cast<double>(resident) / (1024.0 * 1024.0),
+	        static_cast<unsigned long long>(sum));
+}
+
+
+// =================================================================================================
+// Scenarios
+// =================================================================================================
+
+// What Render_manager::read_file used to do: size with a seek, then copy everything into a vector
+static void run_stream_copy(const std::string& path)
+{
+	uint64_t start = SDL_GetTicksNS();
+
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	size_t        file_size = static_cast<size_t>(file.tellg());
+
+	std::vector<char> buffer(file_size);
+	file.seekg(0);
+	file.read(buffer.data(), static_cast<std::streamsize>(file_size));
+
+	uint64_t sum     = checksum(buffer.data(), buffer.size());
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	report("ifstream", elapsed, file_size, buffer.size(), sum);
+}
+
+static void run_mapped(const std::string& path)
+{
+	uint64_t start = SDL_GetTicksNS();
+
+	Mapped_file file;
+	if (!file.open(path, Access_pattern::sequential))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to map %s.", path.c_str());
+		return;
+	}
+
+	// Walk it in chunks and keep the kernel a little ahead of the faults
+	std::span<const char> data = file.get_data();
+	uint64_t              sum  = 0;
+	for (size_t offset = 0; offset < data.size(); offset += READ_CHUNK_SIZE)
+	{
+		file.prefetch(offset + PREFETCH_DISTANCE, READ_CHUNK_SIZE);
+		sum += checksum(data.data() + offset, std::min(READ_CHUNK_SIZE, data.size() - offset));
+	}
+
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	report("mmap", elapsed, data.size(), 0, sum);
+}
+
+static void run_async(const std::string& path, uint64_t file_size)
+{
+	uint64_t start = SDL_GetTicksNS();
+
+	Async_file_reader reader;
+	reader.startup();
+
+	// A fixed ring of chunk buffers, so memory stays flat however large the file is
+	std::vector<std::unique_ptr<char[]>> buffers(READS_IN_FLIGHT);
+	std::vector<Read_request>            requests(READS_IN_FLIGHT);
+	for (size_t i = 0; i < READS_IN_FLIGHT; i++)
+	{
+		buffers[i] = std::make_unique<char[]>(READ_CHUNK_SIZE);
+	}
+
+	uint64_t chunk_count = (file_size + READ_CHUNK_SIZE - 1) / READ_CHUNK_SIZE;
+	uint64_t submitted   = 0;
+	uint64_t sum         = 0;
+	bool     succeeded   = true;
+
+	auto submit = [&](uint64_t chunk)
+	{
+		Read_request& request = requests[chunk % READS_IN_FLIGHT];
+		request.path          = path;
+		request.offset        = chunk * READ_CHUNK_SIZE;
+		request.size          = std::min<uint64_t>(READ_CHUNK_SIZE, file_size - request.offset);
+		request.destination   = buffers[chunk % READS_IN_FLIGHT].get();
+		reader.submit(request);
+	};
+
+	for (; submitted < std::min<uint64_t>(chunk_count, READS_IN_FLIGHT); submitted++)
+	{
+		submit(submitted);
+	}
+
+	for (uint64_t chunk = 0; chunk < chunk_count; chunk++)
+	{
+		Read_request& request = requests[chunk % READS_IN_FLIGHT];
+		succeeded             = Async_file_reader::wait(request) && succeeded;
+		sum += checksum(static_cast<const char*>(request.destination), request.size);
+
+		if (submitted < chunk_count)
+		{
+			submit(submitted++);
+		}
+	}
+
+	reader.shutdown();
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	if (!succeeded)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Async reads of %s failed.", path.c_str());
+	}
+	report("async", elapsed, file_size, READS_IN_FLIGHT * READ_CHUNK_SIZE, sum);
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	uint64_t size_mb = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_FILE_SIZE_MB;
+	if (size_mb == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [file_size_mb] [file_path]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	uint64_t    file_size = size_mb * 1024 * 1024;
+	std::string path      = argc > 2 ? argv[2] : (std::filesystem::temp_directory_path() / "dawns_ballad_io_bench.bin").string();
+
+	SDL_Log("Writing %llu MB to %s...", static_cast<unsigned long long>(size_mb), path.c_str());
+	if (!write_test_file(path, file_size))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to write %s.", path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	// The file was just written, so every run reads from a warm page cache; drop caches between runs for cold numbers
+	SDL_Log("Reading %llu MB, %zu MB chunks:", static_cast<unsigned long long>(size_mb), READ_CHUNK_SIZE / (1024 * 1024));
+	run_stream_copy(path);
+	run_mapped(path);
+	run_async(path, file_size);
+
+	std::error_code error;
+	std::filesystem::remove(path, error);
+
+	return EXIT_SUCCESS;
+}
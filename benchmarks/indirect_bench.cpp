@@ -0,0 +1,129 @@
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "core/job_system.hpp"
+#include "graphics/render_manager.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint32_t DEFAULT_FRAME_COUNT  = 300;
+constexpr uint32_t DEFAULT_WARMUP_COUNT = 30;
+constexpr uint32_t INSTANCE_COUNTS[]    = {1'000, 10'000, 100'000};
+constexpr float    SCATTER_EXTENT       = 2.0f;
+constexpr float    INSTANCE_SCALE       = 0.02f;
+constexpr uint32_t RANDOM_SEED          = 1234;
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+struct Mode_result
+{
+	double record_ms = 0.0;
+	double frame_ms  = 0.0;
+};
+
+static double median_ms(std::vector<uint64_t>& samples)
+{
+	std::sort(samples.begin(), samples.end());
+	return static_cast<double>(samples[samples.size() / 2]) / 1'000'000.0;
+}
+
+static Mode_result run_mode(Render_manager& render_manager, bool gpu_culling, uint32_t frame_count, uint32_t warmup_count)
+{
+	render_manager.set_gpu_culling(gpu_culling);
+
+	for (uint32_t i = 0; i < warmup_count; i++)
+	{
+		render_manager.update();
+	}
+
+	std::vector<uint64_t> record_samples;
+	std::vector<uint64_t> frame_samples;
+	record_samples.reserve(frame_count);
+	frame_samples.reserve(frame_count);
+
+	for (uint32_t i = 0; i < frame_count; i++)
+	{
+		render_manager.update();
+
+		// Headless frames are paced by the fence, so cpu plus fence wait is the full frame including the GPU
+		const Frame_timings& timings = render_manager.get_last_frame_timings();
+		record_samples.push_back(timings.record_ns);
+		frame_samples.push_back(timings.cpu_ns + timings.fence_wait_ns);
+	}
+
+	return {median_ms(record_samples), median_ms(frame_samples)};
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	uint32_t frame_count  = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_FRAME_COUNT;
+	uint32_t warmup_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_WARMUP_COUNT;
+	if (frame_count == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [frame_count] [warmup_count]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Render_settings settings;
+	settings.headless = true;
+
+	Job_system job_system;
+	job_system.startup();
+
+	Render_manager render_manager;
+	if (!render_manager.startup(job_system, settings))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start render manager.");
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<Vertex>   triangle_vertices = {{{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}}, {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}}, {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}};
+	const std::vector<uint32_t> triangle_indices  = {0, 1, 2};
+	Mesh_handle                 triangle          = render_manager.create_mesh(triangle_vertices, triangle_indices);
+
+	bool gpu_culling_supported = render_manager.is_gpu_culling_supported();
+	if (!gpu_culling_supported)
+	{
+		SDL_Log("Device lacks multiDrawIndirect or drawIndirectFirstInstance, only the CPU path is measured.");
+	}
+
+	// Instances are scattered over twice the visible range, so roughly a quarter survive culling
+	std::mt19937                          random(RANDOM_SEED);
+	std::uniform_real_distribution<float> position(-SCATTER_EXTENT, SCATTER_EXTENT);
+
+	SDL_Log("Median over %u frames (%u warmup), record is CPU time, frame includes the GPU:", frame_count, warmup_count);
+	SDL_Log("%10s | %12s %12s | %12s %12s", "instances", "cpu record", "cpu frame", "gpu record", "gpu frame");
+
+	for (uint32_t instance_count : INSTANCE_COUNTS)
+	{
+		std::vector<Mesh_instance> instances(instance_count);
+		for (Mesh_instance& instance : instances)
+		{
+			instance.mesh   = triangle;
+			instance.offset = glm::vec2(position(random), position(random));
+			instance.scale  = INSTANCE_SCALE;
+		}
+		render_manager.set_instances(instances);
+
+		Mode_result cpu = run_mode(render_manager, false, frame_count, warmup_count);
+		Mode_result gpu = gpu_culling_supported ? run_mode(render_manager, true, frame_count, warmup_count) : Mode_result{};
+
+		SDL_Log("%10u | %9.3f ms %9.3f ms | %9.3f ms %9.3f ms", instance_count, cpu.record_ms, cpu.frame_ms, gpu.record_ms, gpu.frame_ms);
+	}
+
+	render_manager.shutdown();
+	job_system.shutdown();
+
+	return EXIT_SUCCESS;
+}
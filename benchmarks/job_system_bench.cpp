@@ -0,0 +1,226 @@
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "core/job_system.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint32_t DEFAULT_JOB_COUNT = 1'000'000;
+constexpr uint32_t SPAWN_BATCH_SIZE  = 1024;
+constexpr uint32_t STEAL_WORK_ITERS  = 2000;
+constexpr size_t   SCALING_ELEMENTS  = 1 << 22;
+constexpr size_t   SCALING_GRAIN     = 4096;
+constexpr uint32_t SCALING_REPEATS   = 10;
+constexpr uint32_t CHAIN_LENGTH      = 10'000;
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+static double to_ms(uint64_t ns)
+{
+	return static_cast<double>(ns) / 1'000'000.0;
+}
+
+static float burn(uint32_t iterations, float seed)
+{
+	float value = seed;
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		value = std::sqrt(value * value + 1.0f);
+	}
+	return value;
+}
+
+
+// =================================================================================================
+// Scenarios
+// =================================================================================================
+static void run_spawn_overhead(uint32_t worker_count, uint32_t job_count)
+{
+	Job_system job_system;
+	job_system.startup(worker_count);
+
+	std::atomic<uint32_t> executed = 0;
+
+	// Batched so the per-thread job ring never wraps onto jobs still in flight
+	uint64_t start = SDL_GetTicksNS();
+	for (uint32_t spawned = 0; spawned < job_count; spawned += SPAWN_BATCH_SIZE)
+	{
+		Job_counter counter;
+		for (uint32_t i = 0; i < SPAWN_BATCH_SIZE; i++)
+		{
+			job_system.run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		}
+		job_system.wait_for(counter);
+	}
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	SDL_Log("spawn     %2u workers | %8.3f ms | %7.1f ns/job | %u jobs", worker_count, to_ms(elapsed), static_cast<double>(elapsed) / executed.load(), executed.load());
+
+	job_system.shutdown();
+}
+
+static void run_steal_throughput(uint32_t worker_count, uint32_t job_count)
+{
+	Job_system job_system;
+	job_system.startup(worker_count);
+
+	// Everything is pushed onto worker 0's deque, so any job that runs elsewhere was stolen
+	std::atomic<uint32_t> executed = 0;
+	std::atomic<uint32_t> stolen   = 0;
+	std::atomic<float>    sink     = 0.0f;
+
+	uint64_t start = SDL_GetTicksNS();
+	for (uint32_t spawned = 0; spawned < job_count; spawned += SPAWN_BATCH_SIZE)
+	{
+		Job_counter counter;
+		for (uint32_t i = 0; i < SPAWN_BATCH_SIZE; i++)
+		{
+			job_system.run(
+			    [&executed, &stolen, &sink, i]()
+			    {
+				    executed.fetch_add(1, std::memory_order_relaxed);
+				    if (Job_system::get_worker_index() != 0)
+				    {
+					    stolen.fetch_add(1, std::memory_order_relaxed);
+				    }
+				    sink.store(burn(STEAL_WORK_ITERS, static_cast<float>(i)), std::memory_order_relaxed);
+			    },
+			    &counter);
+		}
+		job_system.wait_for(counter);
+	}
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	SDL_Log("steal     %2u workers | %8.3f ms | %7.1f ns/job | %5.1f%% stolen",
+	        worker_count,
+	        to_ms(elapsed),
+	        static_cast<double>(elapsed) / executed.load(),
+	        100.0 * stolen.load() / executed.load());
+
+	job_system.shutdown();
+}
+
+static void run_continuation_chain(uint32_t worker_count)
+{
+	Job_system job_system;
+	job_system.startup(worker_count);
+
+	// Each link only becomes runnable once the previous one's counter drops, so this measures release latency
+	std::vector<Job_counter> counters(CHAIN_LENGTH);
+	std::atomic<uint32_t>    order_errors = 0;
+	std::atomic<uint32_t>    next_link    = 0;
+
+	uint64_t start = SDL_GetTicksNS();
+	job_system.run([&]() { next_link.fetch_add(1, std::memory_order_relaxed); }, &counters[0]);
+	for (uint32_t i = 1; i < CHAIN_LENGTH; i++)
+	{
+		job_system.run_after(
+		    counters[i - 1],
+		    [&, i]()
+		    {
+			    if (next_link.fetch_add(1, std::memory_order_relaxed) != i)
+			    {
+				    order_errors.fetch_add(1, std::memory_order_relaxed);
+			    }
+		    },
+		    &counters[i]);
+
+		// Keep the per-thread job ring from wrapping onto unfinished links
+		if (i % SPAWN_BATCH_SIZE == 0)
+		{
+			job_system.wait_for(counters[i]);
+		}
+	}
+	job_system.wait_for(counters[CHAIN_LENGTH - 1]);
+	uint64_t elapsed = SDL_GetTicksNS() - start;
+
+	SDL_Log("chain     %2u workers | %8.3f ms | %7.1f ns/link | %u out of order", worker_count, to_ms(elapsed), static_cast<double>(elapsed) / CHAIN_LENGTH, order_errors.load());
+
+	job_system.shutdown();
+}
+
+static double run_scaling(uint32_t worker_count, const std::vector<float>& input, std::vector<float>& output)
+{
+	Job_system job_system;
+	job_system.startup(worker_count);
+
+	uint64_t best = UINT64_MAX;
+	for (uint32_t repeat = 0; repeat < SCALING_REPEATS; repeat++)
+	{
+		uint64_t start = SDL_GetTicksNS();
+		job_system.parallel_for(input.size(),
+		                        SCALING_GRAIN,
+		                        [&](size_t first, size_t last)
+		                        {
+			                        for (size_t i = first; i < last; i++)
+			                        {
+				                        output[i] = burn(16, input[i]);
+			                        }
+		                        });
+		best = std::min(best, SDL_GetTicksNS() - start);
+	}
+
+	job_system.shutdown();
+
+	return to_ms(best);
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	uint32_t job_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_JOB_COUNT;
+	if (job_count == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [job_count]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t max_workers = std::max(std::thread::hardware_concurrency(), 1u);
+
+	SDL_Log("Job system overhead over %u jobs:", job_count);
+	run_spawn_overhead(1, job_count);
+	run_spawn_overhead(max_workers, job_count);
+	run_steal_throughput(max_workers, job_count / 10);
+	run_continuation_chain(max_workers);
+
+	std::vector<float> input(SCALING_ELEMENTS);
+	std::vector<float> output(SCALING_ELEMENTS);
+	for (size_t i = 0; i < input.size(); i++)
+	{
+		input[i] = static_cast<float>(i);
+	}
+
+	SDL_Log("Scaling over %zu elements (best of %u):", SCALING_ELEMENTS, SCALING_REPEATS);
+
+	// Powers of two up to the core count, plus the full width when it is not one
+	std::vector<uint32_t> worker_counts;
+	for (uint32_t workers = 1; workers < max_workers; workers *= 2)
+	{
+		worker_counts.push_back(workers);
+	}
+	worker_counts.push_back(max_workers);
+
+	double baseline = 0.0;
+	for (uint32_t workers : worker_counts)
+	{
+		double elapsed = run_scaling(workers, input, output);
+		baseline       = workers == 1 ? elapsed : baseline;
+
+		SDL_Log("scaling   %2u workers | %8.3f ms | %5.2fx speedup | %5.1f%% efficiency", workers, elapsed, baseline / elapsed, 100.0 * baseline / elapsed / workers);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "core/job_system.hpp"
+#include "graphics/render_manager.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint32_t DEFAULT_FRAME_COUNT  = 1000;
+constexpr uint32_t DEFAULT_WARMUP_COUNT = 100;
+
+constexpr uint32_t   RESIZE_INTERVAL      = 7;
+constexpr uint64_t   STALL_THRESHOLD_NS   = 250'000'000;
+constexpr auto       WATCHDOG_TIMEOUT     = std::chrono::seconds(5);
+constexpr VkExtent2D RESIZE_EXTENTS[]     = {{800, 600}, {1280, 720}, {640, 480}, {1920, 1080}, {333, 777}};
+constexpr size_t     RESIZE_EXTENTS_COUNT = sizeof(RESIZE_EXTENTS) / sizeof(RESIZE_EXTENTS[0]);
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+static double percentile_ms(const std::vector<uint64_t>& sorted_samples, double percentile)
+{
+	size_t index = static_cast<size_t>(percentile * static_cast<double>(sorted_samples.size() - 1));
+	return static_cast<double>(sorted_samples[index]) / 1'000'000.0;
+}
+
+static void report(const char* name, std::vector<uint64_t>& samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	SDL_Log("%-12s p50 %8.3f ms | p90 %8.3f ms | p99 %8.3f ms | max %8.3f ms",
+	        name,
+	        percentile_ms(samples, 0.50),
+	        percentile_ms(samples, 0.90),
+	        percentile_ms(samples, 0.99),
+	        percentile_ms(samples, 1.00));
+}
+
+
+// =================================================================================================
+// Scenarios
+// =================================================================================================
+static int run_frame_timings(Render_manager& render_manager, uint32_t frame_count, uint32_t warmup_count)
+{
+	for (uint32_t i = 0; i < warmup_count; i++)
+	{
+		render_manager.update();
+	}
+
+	std::vector<uint64_t> cpu_samples;
+	std::vector<uint64_t> record_samples;
+	std::vector<uint64_t> submit_samples;
+	std::vector<uint64_t> fence_wait_samples;
+	cpu_samples.reserve(frame_count);
+	record_samples.reserve(frame_count);
+	submit_samples.reserve(frame_count);
+	fence_wait_samples.reserve(frame_count);
+
+	for (uint32_t i = 0; i < frame_count; i++)
+	{
+		render_manager.update();
+
+		const Frame_timings& timings = render_manager.get_last_frame_timings();
+		cpu_samples.push_back(timings.cpu_ns);
+		record_samples.push_back(timings.record_ns);
+		submit_samples.push_back(timings.submit_ns);
+		fence_wait_samples.push_back(timings.fence_wait_ns);
+	}
+
+	SDL_Log("Headless frame timings over %u frames (%u warmup):", frame_count, warmup_count);
+	report("cpu", cpu_samples);
+	report("record", record_samples);
+	report("submit", submit_samples);
+	report("fence wait", fence_wait_samples);
+
+	return EXIT_SUCCESS;
+}
+
+static int run_resize_stress(Render_manager& render_manager, uint32_t frame_count)
+{
+	// A deadlocked frame never returns, so a watchdog thread has to be the one to notice it
+	std::atomic<uint64_t> frames_completed = 0;
+	std::atomic<bool>     done             = false;
+
+	std::thread watchdog(
+	    [&]()
+	    {
+		    uint64_t last_count    = 0;
+		    auto     last_progress = std::chrono::steady_clock::now();
+
+		    while (!done.load())
+		    {
+			    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+			    uint64_t count = frames_completed.load();
+			    auto     now   = std::chrono::steady_clock::now();
+			    if (count != last_count)
+			    {
+				    last_count    = count;
+				    last_progress = now;
+			    }
+			    else if (now - last_progress > WATCHDOG_TIMEOUT)
+			    {
+				    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Renderer deadlocked after %llu frames.", static_cast<unsigned long long>(count));
+				    std::_Exit(EXIT_FAILURE);
+			    }
+		    }
+	    });
+
+	std::vector<uint64_t> frame_samples;
+	frame_samples.reserve(frame_count);
+
+	uint32_t stall_count  = 0;
+	uint32_t resize_count = 0;
+
+	for (uint32_t i = 0; i < frame_count; i++)
+	{
+		if (i % RESIZE_INTERVAL == 0)
+		{
+			const VkExtent2D& extent = RESIZE_EXTENTS[resize_count % RESIZE_EXTENTS_COUNT];
+			render_manager.resize(extent.width, extent.height);
+			resize_count++;
+		}
+
+		render_manager.update();
+		frames_completed++;
+
+		const Frame_timings& timings = render_manager.get_last_frame_timings();
+		frame_samples.push_back(timings.cpu_ns + timings.fence_wait_ns);
+		if (timings.fence_wait_ns > STALL_THRESHOLD_NS)
+		{
+			stall_count++;
+		}
+	}
+
+	done = true;
+	watchdog.join();
+
+	SDL_Log("Resize stress over %u frames with %u resizes:", frame_count, resize_count);
+	report("frame", frame_samples);
+
+	if (stall_count > 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%u frames waited longer than %llu ms on their fence.", stall_count, static_cast<unsigned long long>(STALL_THRESHOLD_NS / 1'000'000));
+		return EXIT_FAILURE;
+	}
+
+	SDL_Log("No stalls detected.");
+	return EXIT_SUCCESS;
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	bool                  stress_resize = false;
+	uint32_t              draw_count    = 1;
+	std::vector<uint32_t> counts;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--stress-resize") == 0)
+		{
+			stress_resize = true;
+		}
+		else if (std::strcmp(argv[i], "--draws") == 0 && i + 1 < argc)
+		{
+			draw_count = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else
+		{
+			counts.push_back(static_cast<uint32_t>(std::strtoul(argv[i], nullptr, 10)));
+		}
+	}
+
+	uint32_t frame_count  = counts.size() > 0 ? counts[0] : DEFAULT_FRAME_COUNT;
+	uint32_t warmup_count = counts.size() > 1 ? counts[1] : DEFAULT_WARMUP_COUNT;
+	if (frame_count == 0 || draw_count == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [--stress-resize] [--draws count] [frame_count] [warmup_count]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Render_settings settings;
+	settings.headless = true;
+
+	Job_system job_system;
+	job_system.startup();
+
+	Render_manager render_manager;
+	if (!render_manager.startup(job_system, settings))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start render manager: %s", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	// Every draw is the same triangle submitted from the CPU, which keeps the GPU cost trivial and isolates recording cost
+	const std::vector<Vertex>   triangle_vertices = {{{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}}, {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}}, {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}};
+	const std::vector<uint32_t> triangle_indices  = {0, 1, 2};
+	Mesh_handle                 triangle          = render_manager.create_mesh(triangle_vertices, triangle_indices);
+	render_manager.set_instances(std::vector<Mesh_instance>(draw_count, Mesh_instance{triangle}));
+	render_manager.set_gpu_culling(false);
+
+	int result = stress_resize ? run_resize_stress(render_manager, frame_count) : run_frame_timings(render_manager, frame_count, warmup_count);
+
+	render_manager.shutdown();
+	job_system.shutdown();
+
+	return result;
+}
@@ -0,0 +1,311 @@
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <random>
+#include <vector>
+
+#include "core/simd_math.hpp"
+
+
+// =================================================================================================
+// Benchmark configuration
+// =================================================================================================
+constexpr uint32_t DEFAULT_OBJECT_COUNT = 100'000;
+constexpr uint32_t ITERATION_REPEATS    = 20;
+constexpr uint32_t RANDOM_SEED          = 1234;
+constexpr float    SCATTER_EXTENT       = 60.0f;
+constexpr float    MAX_EXTENT           = 4.0f;
+
+// A camera at the origin looking down -z with a 90 degree field of view, near at 1 and far at 100
+const glm::vec4 PLANES[FRUSTUM_PLANE_COUNT] = {
+    glm::vec4(0.70710678f, 0.0f, -0.70710678f, 0.0f),
+    glm::vec4(-0.70710678f, 0.0f, -0.70710678f, 0.0f),
+    glm::vec4(0.0f, 0.70710678f, -0.70710678f, 0.0f),
+    glm::vec4(0.0f, -0.70710678f, -0.70710678f, 0.0f),
+    glm::vec4(0.0f, 0.0f, -1.0f, -1.0f),
+    glm::vec4(0.0f, 0.0f, 1.0f, 100.0f),
+};
+
+
+// =================================================================================================
+// Scene
+// =================================================================================================
+struct Scene
+{
+	uint32_t  object_count = 0;
+	glm::mat4 matrix;
+
+	// The glm side, one object per element
+	std::vector<glm::vec4> points;
+	std::vector<glm::vec4> spheres;
+	std::vector<glm::vec3> centers;
+	std::vector<glm::vec3> extents;
+	std::vector<glm::mat4> parents;
+	std::vector<glm::mat4> locals;
+	std::vector<glm::quat> from;
+	std::vector<glm::quat> to;
+	std::vector<float>     factors;
+
+	// The same objects in blocks of eight
+	std::vector<Vec4_block> point_blocks;
+	std::vector<Vec4_block> sphere_blocks;
+	std::vector<Aabb_block> box_blocks;
+	std::vector<Vec4_block> from_blocks;
+	std::vector<Vec4_block> to_blocks;
+	std::vector<float>      factor_lanes;
+};
+
+struct Results
+{
+	std::vector<glm::vec4> points;
+	std::vector<glm::mat4> matrices;
+	std::vector<uint32_t>  visible_spheres;
+	std::vector<uint32_t>  visible_boxes;
+	std::vector<glm::quat> rotations;
+};
+
+static glm::quat random_rotation(std::mt19937& random)
+{
+	std::normal_distribution<float> component;
+
+	glm::vec4 value(component(random), component(random), component(random), component(random));
+	value = value * (1.0f / std::sqrt(glm::dot(value, value)));
+	return glm::quat(value.w, value.x, value.y, value.z);
+}
+
+static Scene create_scene(uint32_t object_count)
+{
+	std::mt19937                          random(RANDOM_SEED);
+	std::uniform_real_distribution<float> position(-SCATTER_EXTENT, SCATTER_EXTENT);
+	std::uniform_real_distribution<float> extent(0.1f, MAX_EXTENT);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_real_distribution<float> signed_unit(-1.0f, 1.0f);
+
+	Scene scene;
+	scene.object_count = object_count;
+	scene.matrix       = glm::mat4(1.0f);
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			scene.matrix[column][row] += signed_unit(random) * 0.5f;
+		}
+	}
+
+	size_t block_count = get_block_count(object_count);
+	scene.point_blocks.resize(block_count);
+	scene.sphere_blocks.resize(block_count);
+	scene.box_blocks.resize(block_count);
+	scene.from_blocks.resize(block_count);
+	scene.to_blocks.resize(block_count);
+	scene.factor_lanes.resize(block_count * SIMD_BLOCK_WIDTH);
+
+	for (uint32_t i = 0; i < object_count; i++)
+	{
+		// Centered on the frustum's middle so a good share is inside, outside and crossing a plane
+		glm::vec3 center(position(random), position(random), position(random) - SCATTER_EXTENT);
+		glm::vec3 box_extent(extent(random), extent(random), extent(random));
+
+		glm::mat4 parent(1.0f);
+		glm::mat4 local(1.0f);
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				parent[column][row] = signed_unit(random);
+				local[column][row]  = signed_unit(random);
+			}
+		}
+
+		scene.points.push_back(glm::vec4(center, 1.0f));
+		scene.spheres.push_back(glm::vec4(center, box_extent.x));
+		scene.centers.push_back(center);
+		scene.extents.push_back(box_extent);
+		scene.parents.push_back(parent);
+		scene.locals.push_back(local);
+		scene.from.push_back(random_rotation(random));
+		scene.to.push_back(random_rotation(random));
+		scene.factors.push_back(unit(random));
+
+		size_t block = i / SIMD_BLOCK_WIDTH;
+		size_t lane  = i % SIMD_BLOCK_WIDTH;
+		set_lane(scene.point_blocks[block], lane, scene.points[i]);
+		set_lane(scene.sphere_blocks[block], lane, scene.spheres[i]);
+		set_lane(scene.box_blocks[block], lane, center, box_extent);
+		set_lane(scene.from_blocks[block], lane, glm::vec4(scene.from[i].x, scene.from[i].y, scene.from[i].z, scene.from[i].w));
+		set_lane(scene.to_blocks[block], lane, glm::vec4(scene.to[i].x, scene.to[i].y, scene.to[i].z, scene.to[i].w));
+		scene.factor_lanes[i] = scene.factors[i];
+	}
+
+	return scene;
+}
+
+
+// =================================================================================================
+// Reference loops
+// =================================================================================================
+static float get_sphere_margin(const glm::vec4& sphere)
+{
+	float margin = INFINITY;
+	for (const glm::vec4& plane : PLANES)
+	{
+		margin = std::min(margin, plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w + sphere.w);
+	}
+	return margin;
+}
+
+static float get_box_margin(const glm::vec3& center, const glm::vec3& extent)
+{
+	float margin = INFINITY;
+	for (const glm::vec4& plane : PLANES)
+	{
+		float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		float reach    = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+		margin         = std::min(margin, distance + reach);
+	}
+	return margin;
+}
+
+
+// =================================================================================================
+// Timing
+// =================================================================================================
+// Best of several runs, the first touches cold memory and later ones show the steady state
+template <typename Function>
+static uint64_t best_of(uint32_t repeats, const Function& function)
+{
+	uint64_t best = UINT64_MAX;
+	for (uint32_t i = 0; i < repeats; i++)
+	{
+		uint64_t start = SDL_GetTicksNS();
+		function();
+		best = std::min(best, SDL_GetTicksNS() - start);
+	}
+	return best;
+}
+
+static void report(const char* kernel, const char* level, uint64_t elapsed, uint64_t baseline, uint32_t object_count)
+{
+	SDL_Log("%-10s %-8s | %8.3f ms | %6.2f ns/object | %5.2fx",
+	        kernel,
+	        level,
+	        static_cast<double>(elapsed) / 1'000'000.0,
+	        static_cast<double>(elapsed) / object_count,
+	        static_cast<double>(baseline) / std::max<uint64_t>(elapsed, 1));
+}
+
+static void run_timings(const Scene& scene, Results& results)
+{
+	uint32_t object_count = scene.object_count;
+	size_t   block_count  = scene.point_blocks.size();
+
+	std::vector<Vec4_block> points(block_count);
+	std::vector<glm::mat4>  matrices(object_count);
+	std::vector<Vec4_block> rotations(block_count);
+	std::vector<uint32_t>   visible(object_count);
+
+	results.points.resize(object_count);
+	results.matrices.resize(object_count);
+	results.rotations.resize(object_count);
+
+	auto glm_transform = [&]()
+	{
+		for (uint32_t i = 0; i < object_count; i++)
+		{
+			results.points[i] = scene.matrix * scene.points[i];
+		}
+	};
+	auto glm_multiply = [&]()
+	{
+		for (uint32_t i = 0; i < object_count; i++)
+		{
+			results.matrices[i] = scene.parents[i] * scene.locals[i];
+		}
+	};
+	auto glm_spheres = [&]()
+	{
+		results.visible_spheres.clear();
+		for (uint32_t i = 0; i < object_count; i++)
+		{
+			if (get_sphere_margin(scene.spheres[i]) >= 0.0f)
+			{
+				results.visible_spheres.push_back(i);
+			}
+		}
+	};
+	auto glm_boxes = [&]()
+	{
+		results.visible_boxes.clear();
+		for (uint32_t i = 0; i < object_count; i++)
+		{
+			if (get_box_margin(scene.centers[i], scene.extents[i]) >= 0.0f)
+			{
+				results.visible_boxes.push_back(i);
+			}
+		}
+	};
+	auto glm_slerp = [&]()
+	{
+		for (uint32_t i = 0; i < object_count; i++)
+		{
+			results.rotations[i] = glm::slerp(scene.from[i], scene.to[i], scene.factors[i]);
+		}
+	};
+
+	uint64_t baselines[5] = {
+	    best_of(ITERATION_REPEATS, glm_transform),
+	    best_of(ITERATION_REPEATS, glm_multiply),
+	    best_of(ITERATION_REPEATS, glm_spheres),
+	    best_of(ITERATION_REPEATS, glm_boxes),
+	    best_of(ITERATION_REPEATS, glm_slerp),
+	};
+
+	SDL_Log("%u objects, best of %u:", object_count, ITERATION_REPEATS);
+	report("transform", "glm", baselines[0], baselines[0], object_count);
+	report("multiply", "glm", baselines[1], baselines[1], object_count);
+	report("spheres", "glm", baselines[2], baselines[2], object_count);
+	report("boxes", "glm", baselines[3], baselines[3], object_count);
+	report("slerp", "glm", baselines[4], baselines[4], object_count);
+
+	for (uint8_t level = 0; level <= static_cast<uint8_t>(get_supported_simd_level()); level++)
+	{
+		set_simd_level(static_cast<Simd_level>(level));
+		const char* name = get_simd_level_name(get_simd_level());
+
+		report("transform", name, best_of(ITERATION_REPEATS, [&]() { transform_vectors(scene.matrix, scene.point_blocks.data(), points.data(), block_count); }), baselines[0], object_count);
+		report("multiply", name, best_of(ITERATION_REPEATS, [&]() { multiply_matrices(scene.parents.data(), scene.locals.data(), matrices.data(), object_count); }), baselines[1], object_count);
+		report("spheres", name, best_of(ITERATION_REPEATS, [&]() { cull_spheres(PLANES, scene.sphere_blocks.data(), object_count, visible.data()); }), baselines[2], object_count);
+		report("boxes", name, best_of(ITERATION_REPEATS, [&]() { cull_aabbs(PLANES, scene.box_blocks.data(), object_count, visible.data()); }), baselines[3], object_count);
+		report("slerp",
+		       name,
+		       best_of(ITERATION_REPEATS, [&]() { slerp_quaternions(scene.from_blocks.data(), scene.to_blocks.data(), scene.factor_lanes.data(), rotations.data(), block_count); }),
+		       baselines[4],
+		       object_count);
+	}
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	uint32_t object_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_OBJECT_COUNT;
+	if (object_count == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [object_count]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	// Correctness against glm is covered by the simd math tests, this only times the kernels
+	Scene   scene = create_scene(object_count);
+	Results results;
+	SDL_Log("Widest supported level: %s", get_simd_level_name(get_supported_simd_level()));
+	run_timings(scene, results);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,22 @@
+// Included by shaders that read resources through bindless handles, matches Bindless_descriptors and Draw_resources
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(set = 1, binding = 0) uniform texture2D textures[];
+layout(set = 1, binding = 2) uniform sampler samplers[];
+
+// Storage buffers are declared by the shaders that read them, with their own element type
+#define BINDLESS_BUFFER(Name, Element) layout(std430, set = 1, binding = 1) readonly buffer Name { Element data[]; } Name##_buffers[]
+
+// The cull constants take the first 100 bytes of the push constant range
+layout(push_constant) uniform Draw_resources
+{
+	layout(offset = 112) uint texture_handle;
+	uint sampler_handle;
+	uint buffer_handle;
+};
+
+vec4 sample_bindless(uint texture_index, uint sampler_index, vec2 uv)
+{
+	return texture(sampler2D(textures[nonuniformEXT(texture_index)], samplers[nonuniformEXT(sampler_index)]), uv);
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #!/bin/bash
 
 glslc shader.vert -o vert.spv
-glslc shader.frag -o frag.spv
\ No newline at end of file
+glslc shader.frag -o frag.spv
+glslc cull.comp -o cull.spv
\ No newline at end of file
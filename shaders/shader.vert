@@ -1,12 +1,25 @@
 #version 450
 
-layout(location = 0) out vec3 fragColor;
+struct Instance
+{
+	vec4 bounds;
+	vec4 transform;
+	uint bucket;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
 
-vec2 positions[3] = vec2[](vec2(0.0, -0.5), vec2(0.5, 0.5), vec2(-0.5, 0.5));
-vec3 colors[3]    = vec3[](vec3(1.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(0.0, 0.0, 1.0));
+layout(location = 0) out vec3 fragColor;
 
 void main()
 {
-	gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-	fragColor   = colors[gl_VertexIndex];
+	vec4 transform = instances[gl_InstanceIndex].transform;
+	gl_Position    = vec4(inPosition * transform.z + transform.xy, 0.0, 1.0);
+	fragColor      = inColor;
 }
\ No newline at end of file
@@ -12,4 +12,68 @@ static constexpr const char* GAME_DOMAIN  = "com.dawnsballad.www";
 // Window configuration
 // =================================================================================================
 constexpr uint32_t WINDOW_WIDTH  = 800;
-constexpr uint32_t WINDOW_HEIGHT = 600;
\ No newline at end of file
+constexpr uint32_t WINDOW_HEIGHT = 600;
+
+// =================================================================================================
+// Renderer configuration
+// =================================================================================================
+static constexpr const char* PIPELINE_CACHE_FILE   = "pipeline_cache.bin";
+static constexpr const char* ASSET_ARCHIVE_FILE    = "assets.pak";
+constexpr uint32_t           MAX_FRAMES_IN_FLIGHT  = 2;
+constexpr uint64_t           TRANSIENT_BUFFER_SIZE = 4 * 1024 * 1024;
+constexpr size_t             PARALLEL_RECORD_DRAWS = 512;
+constexpr uint64_t           GPU_MEMORY_BLOCK_SIZE = 64 * 1024 * 1024;
+constexpr uint64_t           STAGING_BUFFER_SIZE   = 16 * 1024 * 1024;
+
+// =================================================================================================
+// Shader configuration
+// =================================================================================================
+static constexpr const char* SHADER_DIRECTORY        = "shaders/";
+static constexpr const char* SHADER_CACHE_DIRECTORY  = "shader_cache/";
+static constexpr const char* SHADER_COMPILER         = "glslc";
+constexpr uint64_t           SHADER_POLL_INTERVAL_MS = 250;
+
+// =================================================================================================
+// Streaming configuration
+// =================================================================================================
+constexpr uint64_t STREAM_UPLOAD_BUDGET = 4 * 1024 * 1024;
+constexpr uint64_t STREAM_MEMORY_BUDGET = 256 * 1024 * 1024;
+constexpr uint32_t STREAM_MAX_DECODES   = 4;
+
+// =================================================================================================
+// Profiler configuration
+// =================================================================================================
+static constexpr const char* PROFILE_TRACE_FILE     = "frame_trace.json";
+constexpr uint32_t           PROFILE_CAPTURE_FRAMES = 120;
+
+// =================================================================================================
+// Frame pacing configuration
+// =================================================================================================
+constexpr uint32_t FRAME_RATE_LIMIT        = 0;
+constexpr uint32_t MAX_QUEUED_FRAMES       = 1;
+constexpr uint64_t PRESENT_WAIT_TIMEOUT_MS = 100;
+constexpr uint32_t LATENCY_REPORT_SAMPLES  = 300;
+
+// =================================================================================================
+// Simulation configuration
+// =================================================================================================
+constexpr uint32_t SIMULATION_TICK_RATE          = 60;
+constexpr uint64_t SIMULATION_MAX_CATCH_UP_TICKS = 5;
+constexpr float    SIMULATION_BOUNDS             = 0.5f;
+
+// =================================================================================================
+// Bindless configuration
+// =================================================================================================
+constexpr uint32_t BINDLESS_MAX_SAMPLED_IMAGES  = 16384;
+constexpr uint32_t BINDLESS_MAX_STORAGE_BUFFERS = 4096;
+constexpr uint32_t BINDLESS_MAX_SAMPLERS        = 256;
+
+// =================================================================================================
+// Pipeline configuration
+// =================================================================================================
+constexpr uint32_t PIPELINE_MAX_COMPILES = 2;
+
+// =================================================================================================
+// Device selection configuration
+// =================================================================================================
+static constexpr const char* GPU_OVERRIDE_ENV = "DAWNS_BALLAD_GPU";
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "asset_archive.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <climits>
+#include <cstring>
+#include <lz4.h>
+
+
+// Reads trust every entry that passed this, so it has to hold for hostile archives as well as corrupt ones
+static bool is_entry_valid(const Asset_entry& entry, uint64_t file_size)
+{
+	if (entry.offset > file_size || entry.stored_size > file_size - entry.offset)
+	{
+		return false;
+	}
+
+	switch (entry.compression)
+	{
+	case Asset_compression::none:
+		return entry.stored_size == entry.size;
+
+	case Asset_compression::lz4:
+		return entry.stored_size <= INT_MAX && entry.size <= INT_MAX;
+	}
+
+	return false;
+}
+
+bool Asset_archive::open(const std::string& path)
+{
+	close();
+
+	if (!file.open(path, Access_pattern::random))
+	{
+		return false;
+	}
+
+	std::span<const char> contents = file.get_data();
+	Asset_archive_header  header   = {};
+	if (contents.size() < sizeof(header))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Asset archive %s is truncated.", path.c_str());
+		close();
+		return false;
+	}
+	std::memcpy(&header, contents.data(), sizeof(header));
+
+	bool valid_slot_count = header.slot_count != 0 && (header.slot_count & (header.slot_count - 1)) == 0 && header.entry_count < header.slot_count;
+	if (header.magic != ASSET_ARCHIVE_MAGIC || header.version != ASSET_ARCHIVE_VERSION || !valid_slot_count || header.index_offset % alignof(Asset_entry) != 0
+	    || header.index_offset > contents.size() || uint64_t(header.slot_count) * sizeof(Asset_entry) > contents.size() - header.index_offset)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Asset archive %s is corrupt or from another version.", path.c_str());
+		close();
+		return false;
+	}
+
+	slots       = {reinterpret_cast<const Asset_entry*>(contents.data() + header.index_offset), header.slot_count};
+	entry_count = header.entry_count;
+
+	// Checked once here, so lookups and reads can trust every offset
+	for (const Asset_entry& entry : slots)
+	{
+		if (entry.path_hash != EMPTY_ASSET_SLOT && !is_entry_valid(entry, contents.size()))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Asset archive %s has an entry outside the file or with inconsistent sizes.", path.c_str());
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Asset_archive::close()
+{
+	file.close();
+	slots       = {};
+	entry_count = 0;
+}
+
+const Asset_entry* Asset_archive::find(std::string_view path) const
+{
+	uint64_t hash = hash_asset_path(path);
+	uint64_t mask = slots.size() - 1;
+
+	// The table is at most half full, so a probe sequence ends on an empty slot after a step or two
+	for (uint64_t i = 0; i < slots.size(); i++)
+	{
+		const Asset_entry& entry = slots[(hash + i) & mask];
+		if (entry.path_hash == hash)
+		{
+			return &entry;
+		}
+		if (entry.path_hash == EMPTY_ASSET_SLOT)
+		{
+			return nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+std::span<const char> Asset_archive::get_stored_data(const Asset_entry& entry) const
+{
+	return file.get_data().subspan(entry.offset, entry.stored_size);
+}
+
+bool Asset_archive::read(const Asset_entry& entry, std::span<char> destination) const
+{
+	if (destination.size() < entry.size)
+	{
+		return false;
+	}
+
+	std::span<const char> stored = get_stored_data(entry);
+
+	switch (entry.compression)
+	{
+	case Asset_compression::none:
+		if (stored.size() != entry.size)
+		{
+			return false;
+		}
+		std::memcpy(destination.data(), stored.data(), stored.size());
+		return true;
+
+	case Asset_compression::lz4:
+		return LZ4_decompress_safe(stored.data(), destination.data(), static_cast<int>(stored.size()), static_cast<int>(entry.size)) == static_cast<int>(entry.size);
+	}
+
+	return false;
+}
+
+bool Asset_archive::read(std::string_view path, std::vector<char>& data) const
+{
+	const Asset_entry* entry = find(path);
+	if (!entry)
+	{
+		return false;
+	}
+
+	data.resize(entry->size);
+	return read(*entry, data);
+}
+
+bool Asset_archive::is_open() const
+{
+	return file.is_open();
+}
+
+uint32_t Asset_archive::get_entry_count() const
+{
+	return entry_count;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/file_io.hpp"
+#include "core/hash.hpp"
+
+
+constexpr uint32_t ASSET_ARCHIVE_MAGIC     = 0x4b504244; // "DBPK"
+constexpr uint32_t ASSET_ARCHIVE_VERSION   = 1;
+constexpr uint64_t ASSET_ARCHIVE_ALIGNMENT = 64;
+constexpr uint64_t EMPTY_ASSET_SLOT        = 0;
+
+
+enum class Asset_compression : uint32_t
+{
+	none,
+	lz4,
+};
+
+// The index follows the header directly: an open addressed table of slot_count entries, slot_count a power of two
+struct Asset_archive_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entry_count;
+	uint32_t slot_count;
+	uint64_t index_offset;
+};
+
+struct Asset_entry
+{
+	uint64_t          path_hash;
+	uint64_t          offset;
+	uint64_t          stored_size;
+	uint64_t          size;
+	Asset_compression compression;
+	uint32_t          reserved;
+};
+
+// Hashes the path with forward slashes, shared by the packer and the reader. Zero marks an empty slot
+constexpr uint64_t hash_asset_path(std::string_view path)
+{
+	uint64_t hash = FNV_OFFSET_BASIS;
+	for (char character : path)
+	{
+		hash = hash_byte(hash, static_cast<uint8_t>(character == '\\' ? '/' : character));
+	}
+
+	return hash == EMPTY_ASSET_SLOT ? 1 : hash;
+}
+
+// Read only view of a packed archive. The whole file is mapped once, lookups hash the path and probe the index in place
+class Asset_archive
+{
+public:
+
+	bool open(const std::string& path);
+	void close();
+
+	const Asset_entry* find(std::string_view path) const;
+
+	// Uncompressed entries can be used straight out of the mapping
+	std::span<const char> get_stored_data(const Asset_entry& entry) const;
+
+	bool read(const Asset_entry& entry, std::span<char> destination) const;
+	bool read(std::string_view path, std::vector<char>& data) const;
+
+	bool     is_open() const;
+	uint32_t get_entry_count() const;
+
+private:
+
+	Mapped_file                  file;
+	std::span<const Asset_entry> slots;
+	uint32_t                     entry_count = 0;
+};
@@ -0,0 +1,340 @@
+#include "file_io.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#include "core/profiler.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef _WIN32
+static bool read_range(const std::string& path, uint64_t offset, uint64_t size, void* destination)
+{
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	uint64_t read_total = 0;
+	while (read_total < size)
+	{
+		uint64_t position   = offset + read_total;
+		DWORD    chunk      = static_cast<DWORD>(std::min<uint64_t>(size - read_total, 1u << 30));
+		DWORD    bytes_read = 0;
+
+		OVERLAPPED overlapped = {};
+		overlapped.Offset     = static_cast<DWORD>(position);
+		overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+		if (!ReadFile(file, static_cast<char*>(destination) + read_total, chunk, &bytes_read, &overlapped) || bytes_read == 0)
+		{
+			break;
+		}
+		read_total += bytes_read;
+	}
+
+	CloseHandle(file);
+	return read_total == size;
+}
+#else
+static bool read_range(const std::string& path, uint64_t offset, uint64_t size, void* destination)
+{
+	int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	// pread may return short counts, large reads are split by the kernel
+	uint64_t read_total = 0;
+	while (read_total < size)
+	{
+		ssize_t bytes_read = pread(file, static_cast<char*>(destination) + read_total, size - read_total, static_cast<off_t>(offset + read_total));
+		if (bytes_read <= 0)
+		{
+			break;
+		}
+		read_total += static_cast<uint64_t>(bytes_read);
+	}
+
+	::close(file);
+	return read_total == size;
+}
+#endif
+
+
+Mapped_file::Mapped_file(Mapped_file&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+Mapped_file& Mapped_file::operator=(Mapped_file&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+		data   = std::exchange(other.data, nullptr);
+		size   = std::exchange(other.size, 0);
+		opened = std::exchange(other.opened, false);
+#ifdef _WIN32
+		file_handle    = std::exchange(other.file_handle, nullptr);
+		mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+	}
+
+	return *this;
+}
+
+Mapped_file::~Mapped_file()
+{
+	close();
+}
+
+bool Mapped_file::open(const std::string& path, Access_pattern access_pattern)
+{
+	close();
+
+#ifdef _WIN32
+	DWORD flags = access_pattern == Access_pattern::random ? FILE_FLAG_RANDOM_ACCESS : access_pattern == Access_pattern::sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL;
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER file_size = {};
+	GetFileSizeEx(file, &file_size);
+
+	file_handle = file;
+	size        = static_cast<size_t>(file_size.QuadPart);
+	opened      = true;
+
+	// Zero length files cannot be mapped, they open as an empty view
+	if (size == 0)
+	{
+		return true;
+	}
+
+	mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping_handle)
+	{
+		close();
+		return false;
+	}
+
+	data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (!data)
+	{
+		close();
+		return false;
+	}
+#else
+	int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat file_stat = {};
+	if (fstat(file, &file_stat) != 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	size   = static_cast<size_t>(file_stat.st_size);
+	opened = true;
+
+	// Zero length files cannot be mapped, they open as an empty view
+	if (size == 0)
+	{
+		::close(file);
+		return true;
+	}
+
+	// The mapping keeps its own reference to the file, so the descriptor is not needed past this point
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+
+	if (mapping == MAP_FAILED)
+	{
+		size   = 0;
+		opened = false;
+		return false;
+	}
+
+	data = static_cast<const char*>(mapping);
+
+	int advice = access_pattern == Access_pattern::random ? MADV_RANDOM : access_pattern == Access_pattern::sequential ? MADV_SEQUENTIAL : MADV_NORMAL;
+	madvise(mapping, size, advice);
+#endif
+
+	return true;
+}
+
+void Mapped_file::close()
+{
+#ifdef _WIN32
+	if (data)
+	{
+		UnmapViewOfFile(data);
+	}
+	if (mapping_handle)
+	{
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle)
+	{
+		CloseHandle(file_handle);
+	}
+	file_handle    = nullptr;
+	mapping_handle = nullptr;
+#else
+	if (data)
+	{
+		munmap(const_cast<char*>(data), size);
+	}
+#endif
+
+	data   = nullptr;
+	size   = 0;
+	opened = false;
+}
+
+void Mapped_file::prefetch(size_t offset, size_t length) const
+{
+	if (!data || offset >= size)
+	{
+		return;
+	}
+	length = std::min(length, size - offset);
+
+#ifdef _WIN32
+	WIN32_MEMORY_RANGE_ENTRY range = {};
+	range.VirtualAddress           = const_cast<char*>(data + offset);
+	range.NumberOfBytes            = length;
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// madvise wants a page aligned start, so round down and grow the range to match
+	size_t page_size    = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t aligned_head = offset & ~(page_size - 1);
+	madvise(const_cast<char*>(data + aligned_head), length + (offset - aligned_head), MADV_WILLNEED);
+#endif
+}
+
+std::span<const char> Mapped_file::get_data() const
+{
+	return {data, size};
+}
+
+bool Mapped_file::is_open() const
+{
+	return opened;
+}
+
+
+void Async_file_reader::startup(uint32_t thread_count)
+{
+	stopping = false;
+
+	for (uint32_t i = 0; i < std::max(thread_count, 1u); i++)
+	{
+		threads.emplace_back(&Async_file_reader::thread_loop, this);
+	}
+}
+
+void Async_file_reader::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+
+	// Whatever was still queued never ran, so nobody waiting on it is left hanging
+	for (Read_request* request : queue)
+	{
+		request->status.store(Read_status::failed, std::memory_order_release);
+		request->status.notify_all();
+	}
+	queue.clear();
+}
+
+void Async_file_reader::submit(Read_request& request)
+{
+	request.status.store(Read_status::pending, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(&request);
+	}
+	condition.notify_one();
+}
+
+bool Async_file_reader::wait(const Read_request& request)
+{
+	request.status.wait(Read_status::pending, std::memory_order_acquire);
+	return request.status.load(std::memory_order_acquire) == Read_status::complete;
+}
+
+void Async_file_reader::thread_loop()
+{
+	PROFILE_THREAD_NAME("File reader");
+
+	while (true)
+	{
+		Read_request* request = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return stopping || !queue.empty(); });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			request = queue.front();
+			queue.pop_front();
+		}
+
+		PROFILE_SCOPE("Read file range");
+		bool succeeded = read_range(request->path, request->offset, request->size, request->destination);
+
+		request->status.store(succeeded ? Read_status::complete : Read_status::failed, std::memory_order_release);
+		request->status.notify_all();
+	}
+}
+
+
+bool read_file(const std::string& path, std::vector<char>& data)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	data.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(data.data(), static_cast<std::streamsize>(data.size()));
+
+	return file.good();
+}
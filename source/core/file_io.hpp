@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+constexpr uint32_t ASYNC_READ_THREAD_COUNT = 2;
+
+
+enum class Access_pattern
+{
+	normal,
+	sequential,
+	random,
+};
+
+enum class Read_status : uint32_t
+{
+	pending,
+	complete,
+	failed,
+};
+
+// Read only view of a whole file. Pages are faulted in on first touch and shared with the page cache, nothing is copied
+class Mapped_file
+{
+public:
+
+	Mapped_file() = default;
+	Mapped_file(Mapped_file&& other) noexcept;
+	Mapped_file& operator=(Mapped_file&& other) noexcept;
+	~Mapped_file();
+
+	Mapped_file(const Mapped_file&)            = delete;
+	Mapped_file& operator=(const Mapped_file&) = delete;
+
+	bool open(const std::string& path, Access_pattern access_pattern = Access_pattern::normal);
+	void close();
+
+	// Lets the kernel start paging a range in before the first access faults on it
+	void prefetch(size_t offset, size_t size) const;
+
+	std::span<const char> get_data() const;
+	bool                  is_open() const;
+
+private:
+
+	const char* data   = nullptr;
+	size_t      size   = 0;
+	bool        opened = false;
+#ifdef _WIN32
+	void* file_handle    = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+// Owned by the caller and has to stay put until its status leaves pending
+struct Read_request
+{
+	std::string              path;
+	uint64_t                 offset      = 0;
+	uint64_t                 size        = 0;
+	void*                    destination = nullptr;
+	std::atomic<Read_status> status      = Read_status::complete;
+};
+
+// Reads file ranges straight into caller memory on its own threads, so blocking I/O never parks a job system worker
+class Async_file_reader
+{
+public:
+
+	void startup(uint32_t thread_count = ASYNC_READ_THREAD_COUNT);
+	void shutdown();
+
+	void        submit(Read_request& request);
+	static bool wait(const Read_request& request);
+
+private:
+
+	std::vector<std::thread>  threads;
+	std::mutex                mutex;
+	std::condition_variable   condition;
+	std::deque<Read_request*> queue;
+	bool                      stopping = false;
+
+	void thread_loop();
+};
+
+// Copies a whole file into memory, for data that has to outlive the file or be edited in place
+bool read_file(const std::string& path, std::vector<char>& data);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME        = 0x100000001b3ull;
+
+
+// 64-bit FNV-1a, for cache keys, lookups and spotting corrupt files. Start from FNV_OFFSET_BASIS and pass the result
+// back in to hash data that arrives in pieces.
+constexpr uint64_t hash_byte(uint64_t hash, uint8_t byte)
+{
+	return (hash ^ byte) * FNV_PRIME;
+}
+
+inline uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash = hash_byte(hash, bytes[i]);
+	}
+
+	return hash;
+}
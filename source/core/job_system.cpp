@@ -0,0 +1,334 @@
+#include "job_system.hpp"
+
+#include <string>
+
+#include "core/profiler.hpp"
+
+
+static thread_local uint32_t               worker_index   = INVALID_WORKER;
+static thread_local std::unique_ptr<Job[]> job_ring       = nullptr;
+static thread_local size_t                 job_ring_index = 0;
+
+
+bool Job_counter::is_done() const
+{
+	return value.load(std::memory_order_acquire) == 0;
+}
+
+Work_stealing_deque::Work_stealing_deque()
+    : buffer(std::make_unique<std::atomic<Job*>[]>(JOB_DEQUE_SIZE))
+{
+}
+
+bool Work_stealing_deque::push(Job* job)
+{
+	int64_t b = bottom.load(std::memory_order_relaxed);
+	int64_t t = top.load(std::memory_order_acquire);
+	if (b - t >= static_cast<int64_t>(JOB_DEQUE_SIZE))
+	{
+		return false;
+	}
+
+	buffer[b & (JOB_DEQUE_SIZE - 1)].store(job, std::memory_order_release);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom.store(b + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+Job* Work_stealing_deque::pop()
+{
+	int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top.load(std::memory_order_relaxed);
+
+	if (t > b)
+	{
+		bottom.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = buffer[b & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+	if (t == b)
+	{
+		// Last job left, race the thieves for it
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+Job* Work_stealing_deque::steal()
+{
+	int64_t t = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = bottom.load(std::memory_order_acquire);
+
+	if (t >= b)
+	{
+		return nullptr;
+	}
+
+	Job* job = buffer[t & (JOB_DEQUE_SIZE - 1)].load(std::memory_order_acquire);
+	if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+
+	return job;
+}
+
+bool Job_system::startup(uint32_t worker_count)
+{
+	if (worker_count == 0)
+	{
+		worker_count = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	// Worker 0 is the calling thread; it only runs jobs while helping in wait_for()
+	workers.resize(worker_count);
+	for (std::unique_ptr<Worker>& worker : workers)
+	{
+		worker = std::make_unique<Worker>();
+	}
+
+	worker_index = 0;
+	running      = true;
+
+	for (uint32_t i = 1; i < worker_count; i++)
+	{
+		workers[i]->thread = std::thread(&Job_system::worker_loop, this, i);
+	}
+
+	return true;
+}
+
+void Job_system::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		running = false;
+	}
+	wake_up.notify_all();
+
+	for (std::unique_ptr<Worker>& worker : workers)
+	{
+		if (worker->thread.joinable())
+		{
+			worker->thread.join();
+		}
+	}
+
+	workers.clear();
+	worker_index = INVALID_WORKER;
+}
+
+void Job_system::wait_for(Job_counter& counter)
+{
+	// Run other jobs instead of blocking, the one we are waiting for may be queued behind them
+	uint32_t idle_spins = 0;
+	while (!counter.is_done())
+	{
+		if (Job* job = find_job())
+		{
+			execute(job);
+			idle_spins = 0;
+		}
+		else if (++idle_spins > IDLE_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+uint32_t Job_system::get_worker_count() const
+{
+	return static_cast<uint32_t>(workers.size());
+}
+
+uint32_t Job_system::get_worker_index()
+{
+	return worker_index;
+}
+
+Job* Job_system::allocate_job()
+{
+	if (!job_ring)
+	{
+		job_ring = std::make_unique<Job[]>(JOB_RING_SIZE);
+	}
+
+	// Jobs are recycled round-robin per thread and slots still in flight are skipped. With the whole ring in flight
+	// the thread runs jobs itself until one of its slots is free again.
+	while (true)
+	{
+		for (size_t i = 0; i < JOB_RING_SIZE; i++)
+		{
+			Job& job = job_ring[job_ring_index++ & (JOB_RING_SIZE - 1)];
+			if (!job.invoke.load(std::memory_order_acquire))
+			{
+				return &job;
+			}
+		}
+
+		if (Job* job = find_job())
+		{
+			execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void Job_system::submit(Job* job)
+{
+	if (worker_index < workers.size())
+	{
+		if (!workers[worker_index]->deque.push(job))
+		{
+			// Deque is full, running inline is always correct, just not parallel
+			execute(job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(injected_mutex);
+		injected_jobs.push_back(job);
+	}
+
+	wake_workers();
+}
+
+Job* Job_system::find_job()
+{
+	if (worker_index < workers.size())
+	{
+		if (Job* job = workers[worker_index]->deque.pop())
+		{
+			return job;
+		}
+	}
+
+	uint32_t worker_count = static_cast<uint32_t>(workers.size());
+	uint32_t start        = worker_index < worker_count ? workers[worker_index]->next_victim++ : 0;
+	for (uint32_t i = 0; i < worker_count; i++)
+	{
+		uint32_t victim = (start + i) % worker_count;
+		if (victim == worker_index)
+		{
+			continue;
+		}
+
+		if (Job* job = workers[victim]->deque.steal())
+		{
+			return job;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(injected_mutex);
+	if (injected_jobs.empty())
+	{
+		return nullptr;
+	}
+
+	Job* job = injected_jobs.back();
+	injected_jobs.pop_back();
+	return job;
+}
+
+void Job_system::execute(Job* job)
+{
+	Job_counter* counter = job->counter;
+	job->invoke.load(std::memory_order_relaxed)(*job);
+	job->invoke.store(nullptr, std::memory_order_release);
+
+	if (!counter)
+	{
+		return;
+	}
+
+	// The last job out parks the counter in a releasing state, so waiters keep waiting until it is done touching it
+	int64_t value = counter->value.load(std::memory_order_relaxed);
+	while (!counter->value.compare_exchange_weak(value, value > 1 ? value - 1 : COUNTER_RELEASING, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+	}
+
+	if (value > 1)
+	{
+		return;
+	}
+
+	std::vector<Job*> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->continuations_mutex);
+		continuations.swap(counter->continuations);
+	}
+
+	// Nothing may touch the counter after this store, the waiter is free to destroy it
+	counter->value.store(0, std::memory_order_release);
+
+	for (Job* continuation : continuations)
+	{
+		submit(continuation);
+	}
+}
+
+void Job_system::worker_loop(uint32_t index)
+{
+	worker_index = index;
+	PROFILE_THREAD_NAME("Worker " + std::to_string(index));
+
+	uint32_t idle_spins = 0;
+	while (running.load(std::memory_order_relaxed))
+	{
+		if (Job* job = find_job())
+		{
+			execute(job);
+			idle_spins = 0;
+			continue;
+		}
+
+		if (++idle_spins < IDLE_SPIN_COUNT)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Announce we are going to sleep before the last look, so a concurrent submit either sees us or we see its job
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		sleeping_workers.fetch_add(1, std::memory_order_seq_cst);
+		if (Job* job = find_job())
+		{
+			sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+			lock.unlock();
+			execute(job);
+			idle_spins = 0;
+			continue;
+		}
+
+		if (running.load(std::memory_order_relaxed))
+		{
+			wake_up.wait_for(lock, IDLE_SLEEP_DURATION);
+		}
+		sleeping_workers.fetch_sub(1, std::memory_order_relaxed);
+		idle_spins = 0;
+	}
+}
+
+void Job_system::wake_workers()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping_workers.load(std::memory_order_relaxed) > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		wake_up.notify_one();
+	}
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+constexpr size_t   JOB_PAYLOAD_SIZE    = 48;
+constexpr size_t   JOB_RING_SIZE       = 4096;
+constexpr size_t   JOB_DEQUE_SIZE      = 4096;
+constexpr uint32_t INVALID_WORKER      = UINT32_MAX;
+constexpr int64_t  COUNTER_RELEASING   = -1;
+constexpr size_t   JOBS_PER_WORKER     = 4;
+constexpr uint32_t IDLE_SPIN_COUNT     = 64;
+constexpr auto     IDLE_SLEEP_DURATION = std::chrono::milliseconds(1);
+
+
+class Job_counter;
+
+// A slot is free again once invoke has been reset after the job ran
+struct alignas(64) Job
+{
+	std::atomic<void (*)(Job& job)> invoke  = nullptr;
+	Job_counter*                    counter = nullptr;
+	alignas(16) unsigned char payload[JOB_PAYLOAD_SIZE];
+};
+
+// Counts outstanding jobs; jobs queued with run_after() are released when it drops to zero
+class Job_counter
+{
+public:
+
+	bool is_done() const;
+
+private:
+
+	friend class Job_system;
+
+	std::atomic<int64_t> value = 0;
+	std::mutex           continuations_mutex;
+	std::vector<Job*>    continuations;
+};
+
+// Chase-Lev deque: the owning worker pushes and pops at the bottom, thieves steal from the top
+class Work_stealing_deque
+{
+public:
+
+	Work_stealing_deque();
+
+	bool push(Job* job);
+	Job* pop();
+	Job* steal();
+
+private:
+
+	alignas(64) std::atomic<int64_t> top = 0;
+	alignas(64) std::atomic<int64_t> bottom = 0;
+	std::unique_ptr<std::atomic<Job*>[]> buffer;
+};
+
+class Job_system
+{
+public:
+
+	bool startup(uint32_t worker_count = 0);
+	void shutdown();
+
+	template <typename Function>
+	void run(Function&& function, Job_counter* counter = nullptr);
+
+	template <typename Function>
+	void run_after(Job_counter& dependency, Function&& function, Job_counter* counter = nullptr);
+
+	template <typename Function>
+	void parallel_for(size_t count, size_t grain_size, const Function& function);
+
+	void wait_for(Job_counter& counter);
+
+	uint32_t        get_worker_count() const;
+	static uint32_t get_worker_index();
+
+private:
+
+	struct alignas(64) Worker
+	{
+		Work_stealing_deque deque;
+		std::thread         thread;
+		uint32_t            next_victim = 0;
+	};
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::atomic<bool>                    running          = false;
+	std::atomic<uint32_t>                sleeping_workers = 0;
+	std::mutex                           sleep_mutex;
+	std::condition_variable              wake_up;
+	std::mutex                           injected_mutex;
+	std::vector<Job*>                    injected_jobs;
+
+	template <typename Function>
+	Job* create_job(Function&& function, Job_counter* counter);
+
+	Job* allocate_job();
+
+	void submit(Job* job);
+	Job* find_job();
+	void execute(Job* job);
+	void worker_loop(uint32_t worker_index);
+	void wake_workers();
+};
+
+
+template <typename Function>
+Job* Job_system::create_job(Function&& function, Job_counter* counter)
+{
+	using Callable = std::decay_t<Function>;
+	static_assert(sizeof(Callable) <= JOB_PAYLOAD_SIZE, "Job captures too much state, capture a pointer instead");
+	static_assert(alignof(Callable) <= 16, "Job captures over-aligned state");
+
+	Job* job     = allocate_job();
+	job->counter = counter;
+	job->invoke  = [](Job& job)
+	{
+		Callable* callable = std::launder(reinterpret_cast<Callable*>(job.payload));
+		(*callable)();
+		callable->~Callable();
+	};
+	new (job->payload) Callable(std::forward<Function>(function));
+
+	if (counter)
+	{
+		counter->value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+template <typename Function>
+void Job_system::run(Function&& function, Job_counter* counter)
+{
+	submit(create_job(std::forward<Function>(function), counter));
+}
+
+template <typename Function>
+void Job_system::run_after(Job_counter& dependency, Function&& function, Job_counter* counter)
+{
+	Job* job = create_job(std::forward<Function>(function), counter);
+
+	{
+		// Checked under the same lock the finishing job takes; once the last job is out the dependency is met and it can run now
+		std::lock_guard<std::mutex> lock(dependency.continuations_mutex);
+		if (dependency.value.load(std::memory_order_acquire) > 0)
+		{
+			dependency.continuations.push_back(job);
+			return;
+		}
+	}
+
+	submit(job);
+}
+
+template <typename Function>
+void Job_system::parallel_for(size_t count, size_t grain_size, const Function& function)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Coarsen the grain so a huge range cannot overrun the job ring
+	size_t max_jobs = std::max<size_t>(workers.size() * JOBS_PER_WORKER, 1);
+	grain_size      = std::max({grain_size, (count + max_jobs - 1) / max_jobs, size_t(1)});
+
+	// Jobs reference the caller's function, so this has to wait before returning
+	Job_counter counter;
+	for (size_t first = 0; first < count; first += grain_size)
+	{
+		size_t last = std::min(first + grain_size, count);
+		run([&function, first, last]() { function(first, last); }, &counter);
+	}
+	wait_for(counter);
+}
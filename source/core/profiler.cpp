@@ -0,0 +1,236 @@
+#include "profiler.hpp"
+
+#if PROFILER_ENABLED
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+constexpr uint64_t PROFILE_RING_MASK = PROFILE_RING_SIZE - 1;
+constexpr uint32_t GPU_TRACK         = 0;
+
+static_assert((PROFILE_RING_SIZE & PROFILE_RING_MASK) == 0, "Profile ring size has to be a power of two");
+
+
+// Only the owning thread writes events, write_index publishes them to the main thread
+struct Profile_ring
+{
+	std::string                      thread_name;
+	uint32_t                         track = 0;
+	std::unique_ptr<Profile_event[]> events;
+	std::atomic<uint64_t>            write_index = 0;
+	uint64_t                         read_index  = 0;
+};
+
+struct Captured_event
+{
+	Profile_event event;
+	uint32_t      track = 0;
+};
+
+// Rings outlive their threads, so events from a worker that has already exited can still be written out
+struct Profiler_state
+{
+	std::mutex                                 mutex;
+	std::vector<std::unique_ptr<Profile_ring>> rings;
+	std::vector<Captured_event>                captured_events;
+	std::string                                capture_path;
+	uint32_t                                   capture_frames = 0;
+	uint64_t                                   dropped_events = 0;
+};
+
+static Profiler_state             profiler_state;
+static thread_local Profile_ring* thread_ring = nullptr;
+
+
+static Profile_ring& get_thread_ring()
+{
+	if (!thread_ring)
+	{
+		std::lock_guard<std::mutex> lock(profiler_state.mutex);
+
+		std::unique_ptr<Profile_ring> ring = std::make_unique<Profile_ring>();
+		ring->track                        = static_cast<uint32_t>(profiler_state.rings.size()) + 1;
+		ring->thread_name                  = "Thread " + std::to_string(ring->track);
+		ring->events                       = std::make_unique<Profile_event[]>(PROFILE_RING_SIZE);
+
+		thread_ring = ring.get();
+		profiler_state.rings.push_back(std::move(ring));
+	}
+
+	return *thread_ring;
+}
+
+static void write_json_string(FILE* file, const char* text)
+{
+	std::fputc('"', file);
+	for (const char* character = text; *character; character++)
+	{
+		if (*character == '"' || *character == '\\')
+		{
+			std::fputc('\\', file);
+		}
+		std::fputc(static_cast<unsigned char>(*character) < 0x20 ? ' ' : *character, file);
+	}
+	std::fputc('"', file);
+}
+
+static void write_trace(const std::string& path, const std::vector<Captured_event>& events, const std::vector<std::unique_ptr<Profile_ring>>& rings)
+{
+	FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to open %s for the profile trace.", path.c_str());
+		return;
+	}
+
+	// Chrome trace timestamps are microseconds, relative to the first event so the numbers stay readable
+	uint64_t origin_ns = UINT64_MAX;
+	for (const Captured_event& captured : events)
+	{
+		origin_ns = std::min(origin_ns, captured.event.begin_ns);
+	}
+
+	std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+	std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU\"}},\n");
+	std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":%u,\"args\":{\"name\":\"Graphics queue\"}}", GPU_TRACK);
+	for (const std::unique_ptr<Profile_ring>& ring : rings)
+	{
+		std::fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", ring->track);
+		write_json_string(file, ring->thread_name.c_str());
+		std::fputs("}}", file);
+	}
+
+	for (const Captured_event& captured : events)
+	{
+		const Profile_event& event = captured.event;
+		std::fputs(",\n{\"name\":", file);
+		write_json_string(file, event.name);
+		std::fprintf(file,
+		             ",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+		             captured.track == GPU_TRACK ? 2u : 1u,
+		             captured.track,
+		             static_cast<double>(event.begin_ns - origin_ns) / 1000.0,
+		             static_cast<double>(event.end_ns - event.begin_ns) / 1000.0);
+	}
+	std::fputs("\n]}\n", file);
+
+	bool written = std::ferror(file) == 0;
+	std::fclose(file);
+
+	if (!written)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to write the profile trace to %s.", path.c_str());
+		return;
+	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Wrote %zu profile events to %s.", events.size(), path.c_str());
+}
+
+
+uint64_t Profiler::now_ns()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::set_thread_name(const std::string& name)
+{
+	Profile_ring&               ring = get_thread_ring();
+	std::lock_guard<std::mutex> lock(profiler_state.mutex);
+	ring.thread_name = name;
+}
+
+void Profiler::record(const char* name, uint64_t begin_ns, uint64_t end_ns)
+{
+	Profile_ring& ring  = get_thread_ring();
+	uint64_t      index = ring.write_index.load(std::memory_order_relaxed);
+
+	ring.events[index & PROFILE_RING_MASK] = {name, begin_ns, end_ns};
+	ring.write_index.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::record_gpu(const char* name, uint64_t begin_ns, uint64_t end_ns)
+{
+	if (is_capturing())
+	{
+		profiler_state.captured_events.push_back({{name, begin_ns, end_ns}, GPU_TRACK});
+	}
+}
+
+void Profiler::start_capture(uint32_t frame_count, const std::string& path)
+{
+	if (is_capturing() || frame_count == 0)
+	{
+		return;
+	}
+
+	profiler_state.captured_events.clear();
+	profiler_state.capture_path   = path;
+	profiler_state.capture_frames = frame_count;
+	profiler_state.dropped_events = 0;
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Capturing %u frames to %s.", frame_count, path.c_str());
+}
+
+bool Profiler::is_capturing()
+{
+	return profiler_state.capture_frames > 0;
+}
+
+void Profiler::end_frame()
+{
+	std::lock_guard<std::mutex> lock(profiler_state.mutex);
+
+	bool capturing = is_capturing();
+	for (const std::unique_ptr<Profile_ring>& ring : profiler_state.rings)
+	{
+		uint64_t write_index = ring->write_index.load(std::memory_order_acquire);
+		uint64_t read_index  = ring->read_index;
+		ring->read_index     = write_index;
+
+		if (!capturing)
+		{
+			continue;
+		}
+
+		// A thread that wrapped its ring since the last drain has overwritten events nobody read, those are lost
+		if (write_index - read_index > PROFILE_RING_SIZE)
+		{
+			profiler_state.dropped_events += write_index - read_index - PROFILE_RING_SIZE;
+			read_index = write_index - PROFILE_RING_SIZE;
+		}
+
+		size_t first = profiler_state.captured_events.size();
+		for (uint64_t index = read_index; index < write_index; index++)
+		{
+			profiler_state.captured_events.push_back({ring->events[index & PROFILE_RING_MASK], ring->track});
+		}
+
+		// The owner keeps writing while we copy, anything it lapped during the copy may be torn and is thrown away
+		uint64_t current_index = ring->write_index.load(std::memory_order_acquire);
+		if (current_index > read_index + PROFILE_RING_SIZE)
+		{
+			uint64_t torn = std::min(current_index - PROFILE_RING_SIZE, write_index) - read_index;
+			profiler_state.captured_events.erase(profiler_state.captured_events.begin() + first, profiler_state.captured_events.begin() + first + torn);
+			profiler_state.dropped_events += torn;
+		}
+	}
+
+	if (capturing && --profiler_state.capture_frames == 0)
+	{
+		if (profiler_state.dropped_events > 0)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Profile capture dropped %llu events, a thread overran its ring.", static_cast<unsigned long long>(profiler_state.dropped_events));
+		}
+		write_trace(profiler_state.capture_path, profiler_state.captured_events, profiler_state.rings);
+		profiler_state.captured_events.clear();
+		profiler_state.captured_events.shrink_to_fit();
+	}
+}
+
+#endif
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Profiling compiles out with the rest of the debug tooling, define PROFILER_IN_RELEASE to keep it in an optimised build
+#if !defined(NDEBUG) || defined(PROFILER_IN_RELEASE)
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+
+
+constexpr size_t PROFILE_RING_SIZE = 1 << 16;
+
+
+// Names are not copied, they have to be string literals or otherwise outlive the capture
+struct Profile_event
+{
+	const char* name     = nullptr;
+	uint64_t    begin_ns = 0;
+	uint64_t    end_ns   = 0;
+};
+
+// Every thread records into a ring of its own without locking, the main thread drains them all once a frame.
+// A capture collects the drained events for a number of frames and writes them out as a Chrome trace, which
+// chrome://tracing and Perfetto both open.
+class Profiler
+{
+public:
+
+#if PROFILER_ENABLED
+	// Steady clock nanoseconds, GPU timestamps are calibrated into the same domain
+	static uint64_t now_ns();
+
+	static void set_thread_name(const std::string& name);
+	static void record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+
+	// Main thread only, GPU scopes go to a track of their own
+	static void record_gpu(const char* name, uint64_t begin_ns, uint64_t end_ns);
+
+	static void start_capture(uint32_t frame_count, const std::string& path);
+	static bool is_capturing();
+	static void end_frame();
+#else
+	static uint64_t now_ns() { return 0; }
+	static void     set_thread_name(const std::string&) {}
+	static void     record(const char*, uint64_t, uint64_t) {}
+	static void     record_gpu(const char*, uint64_t, uint64_t) {}
+	static void     start_capture(uint32_t, const std::string&) {}
+	static bool     is_capturing() { return false; }
+	static void     end_frame() {}
+#endif
+};
+
+
+#if PROFILER_ENABLED
+class Profile_scope
+{
+public:
+
+	explicit Profile_scope(const char* name) : name(name), begin_ns(Profiler::now_ns()) {}
+	~Profile_scope() { Profiler::record(name, begin_ns, Profiler::now_ns()); }
+
+	Profile_scope(const Profile_scope&)            = delete;
+	Profile_scope& operator=(const Profile_scope&) = delete;
+
+private:
+
+	const char* name;
+	uint64_t    begin_ns;
+};
+
+#define PROFILE_CONCATENATE_INNER(a, b) a##b
+#define PROFILE_CONCATENATE(a, b)       PROFILE_CONCATENATE_INNER(a, b)
+#define PROFILE_SCOPE(name)             Profile_scope PROFILE_CONCATENATE(profile_scope_, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name)       Profiler::set_thread_name(name)
+#else
+#define PROFILE_SCOPE(name)       ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
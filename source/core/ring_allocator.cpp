@@ -0,0 +1,73 @@
+#include "ring_allocator.hpp"
+
+#include <algorithm>
+
+
+void Ring_allocator::startup(uint64_t ring_size, uint32_t frame_count)
+{
+	size = ring_size;
+	head = 0;
+	tail = 0;
+	frame_ends.assign(frame_count, 0);
+}
+
+void Ring_allocator::shutdown()
+{
+	frame_ends.clear();
+	size = 0;
+	head = 0;
+	tail = 0;
+}
+
+bool Ring_allocator::allocate(uint64_t allocation_size, uint64_t alignment, uint64_t& offset)
+{
+	// Head and tail grow forever and are wrapped on use, so aligning them aligns the wrapped offset as long as the size is a multiple of the alignment
+	uint64_t start = (head + alignment - 1) & ~(alignment - 1);
+
+	// An allocation never straddles the end of the ring, it skips ahead to the start instead
+	if (start % size + allocation_size > size)
+	{
+		start = (start / size + 1) * size;
+	}
+
+	if (start + allocation_size - tail > size)
+	{
+		return false;
+	}
+
+	head   = start + allocation_size;
+	offset = start % size;
+
+	return true;
+}
+
+void Ring_allocator::begin_frame(uint32_t frame_index)
+{
+	// The caller has waited for this frame's previous submission, so everything it allocated is free again
+	release(frame_ends[frame_index]);
+}
+
+void Ring_allocator::end_frame(uint32_t frame_index)
+{
+	frame_ends[frame_index] = head;
+}
+
+uint64_t Ring_allocator::get_head() const
+{
+	return head;
+}
+
+void Ring_allocator::release(uint64_t position)
+{
+	tail = std::max(tail, position);
+}
+
+uint64_t Ring_allocator::get_size() const
+{
+	return size;
+}
+
+uint64_t Ring_allocator::get_used_size() const
+{
+	return head - tail;
+}
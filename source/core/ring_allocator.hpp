@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+// Linear allocator over an abstract ring of offsets, space is reclaimed a whole frame (or batch) at a time
+class Ring_allocator
+{
+public:
+
+	void startup(uint64_t size, uint32_t frame_count);
+	void shutdown();
+
+	bool allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+	void begin_frame(uint32_t frame_index);
+	void end_frame(uint32_t frame_index);
+
+	// For owners that retire by something other than frames, such as a timeline value
+	uint64_t get_head() const;
+	void     release(uint64_t position);
+
+	uint64_t get_size() const;
+	uint64_t get_used_size() const;
+
+private:
+
+	std::vector<uint64_t> frame_ends;
+	uint64_t              size = 0;
+	uint64_t              head = 0;
+	uint64_t              tail = 0;
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "core/simd_math.hpp"
+
+
+// Internal to the SIMD math, each instruction set's translation unit fills in one table. They are built with their own
+// target flags, so they take raw floats and must not call into glm or anything else inline that other translation units
+// also compile, the linker would be free to keep the wider copy.
+struct Simd_kernels
+{
+	void (*transform_vectors)(const float* matrix, const Vec4_block* input, Vec4_block* output, size_t block_count);
+	void (*multiply_matrices)(const float* parents, const float* locals, float* result, size_t count);
+
+	// One bit per lane and one byte per block, set where the object is inside every plane
+	void (*cull_spheres)(const float* planes, const Vec4_block* spheres, size_t block_count, uint8_t* masks);
+	void (*cull_aabbs)(const float* planes, const Aabb_block* boxes, size_t block_count, uint8_t* masks);
+
+	void (*slerp_quaternions)(const Vec4_block* from, const Vec4_block* to, const float* t, Vec4_block* result, size_t block_count);
+};
+
+// nullptr when the build has no code for the instruction set, whether the CPU has it is up to the caller
+const Simd_kernels* get_sse4_kernels();
+const Simd_kernels* get_avx2_kernels();
+
+
+// Eberly's coefficients for slerp as a polynomial in cos(theta), the last pair is scaled to correct the truncated series
+constexpr float SLERP_MU   = 1.85298109240830f;
+constexpr float SLERP_U[8] = {1.0f / 3.0f, 1.0f / 10.0f, 1.0f / 21.0f, 1.0f / 36.0f, 1.0f / 55.0f, 1.0f / 78.0f, 1.0f / 105.0f, SLERP_MU / 136.0f};
+constexpr float SLERP_V[8] = {1.0f / 3.0f, 2.0f / 5.0f, 3.0f / 7.0f, 4.0f / 9.0f, 5.0f / 11.0f, 6.0f / 13.0f, 7.0f / 15.0f, SLERP_MU * 8.0f / 17.0f};
+
+
+// The structure-of-arrays kernels are written once over a lane type, which every translation unit declares in an
+// anonymous namespace. A lane type has a WIDTH that divides SIMD_BLOCK_WIDTH, arithmetic operators, and static load,
+// store, broadcast, greater_equal, bitwise_and, mask_bits, abs and flip_sign functions.
+template <typename Lanes>
+void transform_vectors_kernel(const float* matrix, const Vec4_block* input, Vec4_block* output, size_t block_count);
+
+template <typename Lanes>
+void cull_spheres_kernel(const float* planes, const Vec4_block* spheres, size_t block_count, uint8_t* masks);
+
+template <typename Lanes>
+void cull_aabbs_kernel(const float* planes, const Aabb_block* boxes, size_t block_count, uint8_t* masks);
+
+template <typename Lanes>
+void slerp_quaternions_kernel(const Vec4_block* from, const Vec4_block* to, const float* t, Vec4_block* result, size_t block_count);
+
+
+template <typename Lanes>
+void transform_vectors_kernel(const float* matrix, const Vec4_block* input, Vec4_block* output, size_t block_count)
+{
+	Lanes m[16];
+	for (size_t i = 0; i < 16; i++)
+	{
+		m[i] = Lanes::broadcast(matrix[i]);
+	}
+
+	for (size_t block = 0; block < block_count; block++)
+	{
+		for (size_t lane = 0; lane < SIMD_BLOCK_WIDTH; lane += Lanes::WIDTH)
+		{
+			// Everything is loaded before the first store, so input and output may be the same blocks
+			Lanes x = Lanes::load(input[block].x + lane);
+			Lanes y = Lanes::load(input[block].y + lane);
+			Lanes z = Lanes::load(input[block].z + lane);
+			Lanes w = Lanes::load(input[block].w + lane);
+
+			// Column-major, so row r of the matrix is every fourth float from r, summed in the order glm sums the columns
+			Lanes::store(output[block].x + lane, m[0] * x + m[4] * y + m[8] * z + m[12] * w);
+			Lanes::store(output[block].y + lane, m[1] * x + m[5] * y + m[9] * z + m[13] * w);
+			Lanes::store(output[block].z + lane, m[2] * x + m[6] * y + m[10] * z + m[14] * w);
+			Lanes::store(output[block].w + lane, m[3] * x + m[7] * y + m[11] * z + m[15] * w);
+		}
+	}
+}
+
+template <typename Lanes>
+void cull_spheres_kernel(const float* planes, const Vec4_block* spheres, size_t block_count, uint8_t* masks)
+{
+	Lanes plane[FRUSTUM_PLANE_COUNT][4];
+	for (size_t i = 0; i < FRUSTUM_PLANE_COUNT * 4; i++)
+	{
+		plane[i / 4][i % 4] = Lanes::broadcast(planes[i]);
+	}
+
+	Lanes zero = Lanes::broadcast(0.0f);
+	for (size_t block = 0; block < block_count; block++)
+	{
+		uint32_t mask = 0;
+		for (size_t lane = 0; lane < SIMD_BLOCK_WIDTH; lane += Lanes::WIDTH)
+		{
+			Lanes x               = Lanes::load(spheres[block].x + lane);
+			Lanes y               = Lanes::load(spheres[block].y + lane);
+			Lanes z               = Lanes::load(spheres[block].z + lane);
+			Lanes negative_radius = zero - Lanes::load(spheres[block].w + lane);
+
+			Lanes inside = Lanes::greater_equal(plane[0][0] * x + plane[0][1] * y + plane[0][2] * z + plane[0][3], negative_radius);
+			for (size_t i = 1; i < FRUSTUM_PLANE_COUNT; i++)
+			{
+				inside = Lanes::bitwise_and(inside, Lanes::greater_equal(plane[i][0] * x + plane[i][1] * y + plane[i][2] * z + plane[i][3], negative_radius));
+			}
+			mask |= Lanes::mask_bits(inside) << lane;
+		}
+		masks[block] = static_cast<uint8_t>(mask);
+	}
+}
+
+template <typename Lanes>
+void cull_aabbs_kernel(const float* planes, const Aabb_block* boxes, size_t block_count, uint8_t* masks)
+{
+	// The box reaches furthest along the normal by its extent projected onto the absolute normal
+	Lanes plane[FRUSTUM_PLANE_COUNT][4];
+	Lanes absolute_normal[FRUSTUM_PLANE_COUNT][3];
+	for (size_t i = 0; i < FRUSTUM_PLANE_COUNT * 4; i++)
+	{
+		plane[i / 4][i % 4] = Lanes::broadcast(planes[i]);
+		if (i % 4 != 3)
+		{
+			absolute_normal[i / 4][i % 4] = Lanes::abs(plane[i / 4][i % 4]);
+		}
+	}
+
+	Lanes zero = Lanes::broadcast(0.0f);
+	for (size_t block = 0; block < block_count; block++)
+	{
+		uint32_t mask = 0;
+		for (size_t lane = 0; lane < SIMD_BLOCK_WIDTH; lane += Lanes::WIDTH)
+		{
+			Lanes center_x = Lanes::load(boxes[block].center_x + lane);
+			Lanes center_y = Lanes::load(boxes[block].center_y + lane);
+			Lanes center_z = Lanes::load(boxes[block].center_z + lane);
+			Lanes extent_x = Lanes::load(boxes[block].extent_x + lane);
+			Lanes extent_y = Lanes::load(boxes[block].extent_y + lane);
+			Lanes extent_z = Lanes::load(boxes[block].extent_z + lane);
+
+			Lanes inside = Lanes::broadcast(0.0f);
+			for (size_t i = 0; i < FRUSTUM_PLANE_COUNT; i++)
+			{
+				Lanes distance = plane[i][0] * center_x + plane[i][1] * center_y + plane[i][2] * center_z + plane[i][3];
+				Lanes reach    = absolute_normal[i][0] * extent_x + absolute_normal[i][1] * extent_y + absolute_normal[i][2] * extent_z;
+				Lanes visible  = Lanes::greater_equal(distance + reach, zero);
+				inside         = i == 0 ? visible : Lanes::bitwise_and(inside, visible);
+			}
+			mask |= Lanes::mask_bits(inside) << lane;
+		}
+		masks[block] = static_cast<uint8_t>(mask);
+	}
+}
+
+template <typename Lanes>
+void slerp_quaternions_kernel(const Vec4_block* from, const Vec4_block* to, const float* t, Vec4_block* result, size_t block_count)
+{
+	Lanes one = Lanes::broadcast(1.0f);
+	Lanes u[8];
+	Lanes v[8];
+	for (size_t i = 0; i < 8; i++)
+	{
+		u[i] = Lanes::broadcast(SLERP_U[i]);
+		v[i] = Lanes::broadcast(SLERP_V[i]);
+	}
+
+	for (size_t block = 0; block < block_count; block++)
+	{
+		for (size_t lane = 0; lane < SIMD_BLOCK_WIDTH; lane += Lanes::WIDTH)
+		{
+			Lanes from_x = Lanes::load(from[block].x + lane);
+			Lanes from_y = Lanes::load(from[block].y + lane);
+			Lanes from_z = Lanes::load(from[block].z + lane);
+			Lanes from_w = Lanes::load(from[block].w + lane);
+			Lanes to_x   = Lanes::load(to[block].x + lane);
+			Lanes to_y   = Lanes::load(to[block].y + lane);
+			Lanes to_z   = Lanes::load(to[block].z + lane);
+			Lanes to_w   = Lanes::load(to[block].w + lane);
+
+			// The series needs cos(theta) in [0, 1], negating the target when it is not also takes the shortest path
+			Lanes cosine = from_x * to_x + from_y * to_y + from_z * to_z + from_w * to_w;
+			to_x         = Lanes::flip_sign(to_x, cosine);
+			to_y         = Lanes::flip_sign(to_y, cosine);
+			to_z         = Lanes::flip_sign(to_z, cosine);
+			to_w         = Lanes::flip_sign(to_w, cosine);
+
+			Lanes cosine_minus_one = Lanes::abs(cosine) - one;
+			Lanes factor_to        = Lanes::load(t + block * SIMD_BLOCK_WIDTH + lane);
+			Lanes factor_from      = one - factor_to;
+			Lanes squared_to       = factor_to * factor_to;
+			Lanes squared_from     = factor_from * factor_from;
+
+			// Horner's scheme over the eight terms, innermost first
+			Lanes series_to   = one;
+			Lanes series_from = one;
+			for (size_t i = 8; i-- > 0;)
+			{
+				series_to   = one + (u[i] * squared_to - v[i]) * cosine_minus_one * series_to;
+				series_from = one + (u[i] * squared_from - v[i]) * cosine_minus_one * series_from;
+			}
+
+			Lanes weight_to   = factor_to * series_to;
+			Lanes weight_from = factor_from * series_from;
+			Lanes::store(result[block].x + lane, from_x * weight_from + to_x * weight_to);
+			Lanes::store(result[block].y + lane, from_y * weight_from + to_y * weight_to);
+			Lanes::store(result[block].z + lane, from_z * weight_from + to_z * weight_to);
+			Lanes::store(result[block].w + lane, from_w * weight_from + to_w * weight_to);
+		}
+	}
+}
@@ -0,0 +1,269 @@
+#include "simd_math.hpp"
+
+#include <SDL3/SDL_cpuinfo.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+#include "core/simd_kernels.hpp"
+
+
+// Masks are compacted a stretch of blocks at a time, so culling needs no memory of its own
+constexpr size_t CULL_MASK_BLOCKS = 64;
+
+
+namespace
+{
+// One lane at a time, for CPUs or builds without any of the vector instruction sets
+struct Scalar_lanes
+{
+	static constexpr size_t WIDTH = 1;
+
+	float value = 0.0f;
+
+	static Scalar_lanes load(const float* source)
+	{
+		return {*source};
+	}
+
+	static void store(float* destination, Scalar_lanes lanes)
+	{
+		*destination = lanes.value;
+	}
+
+	static Scalar_lanes broadcast(float value)
+	{
+		return {value};
+	}
+
+	static Scalar_lanes greater_equal(Scalar_lanes a, Scalar_lanes b)
+	{
+		return {std::bit_cast<float>(a.value >= b.value ? UINT32_MAX : 0u)};
+	}
+
+	static Scalar_lanes bitwise_and(Scalar_lanes a, Scalar_lanes b)
+	{
+		return {std::bit_cast<float>(std::bit_cast<uint32_t>(a.value) & std::bit_cast<uint32_t>(b.value))};
+	}
+
+	static uint32_t mask_bits(Scalar_lanes mask)
+	{
+		return std::bit_cast<uint32_t>(mask.value) >> 31;
+	}
+
+	static Scalar_lanes abs(Scalar_lanes a)
+	{
+		return {std::bit_cast<float>(std::bit_cast<uint32_t>(a.value) & 0x7FFFFFFFu)};
+	}
+
+	// a with its sign flipped where sign is negative
+	static Scalar_lanes flip_sign(Scalar_lanes a, Scalar_lanes sign)
+	{
+		return {std::bit_cast<float>(std::bit_cast<uint32_t>(a.value) ^ (std::bit_cast<uint32_t>(sign.value) & 0x80000000u))};
+	}
+
+	Scalar_lanes operator+(Scalar_lanes other) const
+	{
+		return {value + other.value};
+	}
+
+	Scalar_lanes operator-(Scalar_lanes other) const
+	{
+		return {value - other.value};
+	}
+
+	Scalar_lanes operator*(Scalar_lanes other) const
+	{
+		return {value * other.value};
+	}
+};
+}
+
+
+static void multiply_matrices_scalar(const float* parents, const float* locals, float* result, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* parent = parents + i * 16;
+		const float* local  = locals + i * 16;
+		float*       output = result + i * 16;
+
+		// Column by column, each one the parent's columns weighted by the local column, in glm's order
+		for (size_t column = 0; column < 4; column++)
+		{
+			const float* weights = local + column * 4;
+			for (size_t row = 0; row < 4; row++)
+			{
+				output[column * 4 + row] = parent[row] * weights[0] + parent[4 + row] * weights[1] + parent[8 + row] * weights[2] + parent[12 + row] * weights[3];
+			}
+		}
+	}
+}
+
+static const Simd_kernels SCALAR_KERNELS = {
+    transform_vectors_kernel<Scalar_lanes>,
+    multiply_matrices_scalar,
+    cull_spheres_kernel<Scalar_lanes>,
+    cull_aabbs_kernel<Scalar_lanes>,
+    slerp_quaternions_kernel<Scalar_lanes>,
+};
+
+
+static const Simd_kernels* get_kernels(Simd_level level)
+{
+	switch (level)
+	{
+	case Simd_level::avx2:
+		return get_avx2_kernels();
+	case Simd_level::sse4:
+		return get_sse4_kernels();
+	default:
+		return &SCALAR_KERNELS;
+	}
+}
+
+static std::atomic<Simd_level>& get_active_level()
+{
+	static std::atomic<Simd_level> level = get_supported_simd_level();
+	return level;
+}
+
+static const Simd_kernels& get_active_kernels()
+{
+	return *get_kernels(get_active_level().load(std::memory_order_relaxed));
+}
+
+// Turns per block lane masks into ascending indices, the lanes past count in the last block are dropped
+template <typename Object>
+static size_t cull(const glm::vec4 (&planes)[FRUSTUM_PLANE_COUNT],
+                   const Object* objects,
+                   size_t        count,
+                   uint32_t*     visible,
+                   void (*kernel)(const float*, const Object*, size_t, uint8_t*))
+{
+	size_t  block_count   = get_block_count(count);
+	size_t  visible_count = 0;
+	uint8_t masks[CULL_MASK_BLOCKS];
+
+	for (size_t first = 0; first < block_count; first += CULL_MASK_BLOCKS)
+	{
+		size_t stretch = std::min(CULL_MASK_BLOCKS, block_count - first);
+		kernel(&planes[0].x, objects + first, stretch, masks);
+
+		for (size_t block = 0; block < stretch; block++)
+		{
+			size_t   base = (first + block) * SIMD_BLOCK_WIDTH;
+			uint32_t mask = masks[block];
+			if (count - base < SIMD_BLOCK_WIDTH)
+			{
+				mask &= (1u << (count - base)) - 1;
+			}
+
+			while (mask != 0)
+			{
+				visible[visible_count++] = static_cast<uint32_t>(base + std::countr_zero(mask));
+				mask &= mask - 1;
+			}
+		}
+	}
+
+	return visible_count;
+}
+
+
+Simd_level get_simd_level()
+{
+	return get_active_level().load(std::memory_order_relaxed);
+}
+
+Simd_level get_supported_simd_level()
+{
+	if (SDL_HasAVX2() && get_avx2_kernels() != nullptr)
+	{
+		return Simd_level::avx2;
+	}
+
+	if (SDL_HasSSE41() && get_sse4_kernels() != nullptr)
+	{
+		return Simd_level::sse4;
+	}
+
+	return Simd_level::scalar;
+}
+
+void set_simd_level(Simd_level level)
+{
+	Simd_level supported = get_supported_simd_level();
+	get_active_level().store(static_cast<uint8_t>(level) > static_cast<uint8_t>(supported) ? supported : level, std::memory_order_relaxed);
+}
+
+const char* get_simd_level_name(Simd_level level)
+{
+	switch (level)
+	{
+	case Simd_level::avx2:
+		return "AVX2";
+	case Simd_level::sse4:
+		return "SSE4.1";
+	default:
+		return "scalar";
+	}
+}
+
+size_t get_block_count(size_t count)
+{
+	return (count + SIMD_BLOCK_WIDTH - 1) / SIMD_BLOCK_WIDTH;
+}
+
+void set_lane(Vec4_block& block, size_t lane, const glm::vec4& value)
+{
+	block.x[lane] = value.x;
+	block.y[lane] = value.y;
+	block.z[lane] = value.z;
+	block.w[lane] = value.w;
+}
+
+glm::vec4 get_lane(const Vec4_block& block, size_t lane)
+{
+	return glm::vec4(block.x[lane], block.y[lane], block.z[lane], block.w[lane]);
+}
+
+void set_lane(Aabb_block& block, size_t lane, const glm::vec3& center, const glm::vec3& extent)
+{
+	block.center_x[lane] = center.x;
+	block.center_y[lane] = center.y;
+	block.center_z[lane] = center.z;
+	block.extent_x[lane] = extent.x;
+	block.extent_y[lane] = extent.y;
+	block.extent_z[lane] = extent.z;
+}
+
+void transform_vectors(const glm::mat4& matrix, const Vec4_block* input, Vec4_block* output, size_t block_count)
+{
+	get_active_kernels().transform_vectors(&matrix[0].x, input, output, block_count);
+}
+
+void multiply_matrices(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* result, size_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	get_active_kernels().multiply_matrices(&parents[0][0].x, &locals[0][0].x, &result[0][0].x, count);
+}
+
+size_t cull_spheres(const glm::vec4 (&planes)[FRUSTUM_PLANE_COUNT], const Vec4_block* spheres, size_t count, uint32_t* visible)
+{
+	return cull(planes, spheres, count, visible, get_active_kernels().cull_spheres);
+}
+
+size_t cull_aabbs(const glm::vec4 (&planes)[FRUSTUM_PLANE_COUNT], const Aabb_block* boxes, size_t count, uint32_t* visible)
+{
+	return cull(planes, boxes, count, visible, get_active_kernels().cull_aabbs);
+}
+
+void slerp_quaternions(const Vec4_block* from, const Vec4_block* to, const float* t, Vec4_block* result, size_t block_count)
+{
+	get_active_kernels().slerp_quaternions(from, to, t, result, block_count);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+
+constexpr size_t   SIMD_BLOCK_WIDTH    = 8;
+constexpr uint32_t FRUSTUM_PLANE_COUNT = 6;
+
+
+// Batched data is stored AoSoA: blocks of eight, component-major inside a block, so one load fills a whole register
+// of a component at either width. Counts that are not a multiple of eight leave the tail lanes of the last block unused.
+struct alignas(32) Vec4_block
+{
+	float x[SIMD_BLOCK_WIDTH];
+	float y[SIMD_BLOCK_WIDTH];
+	float z[SIMD_BLOCK_WIDTH];
+	float w[SIMD_BLOCK_WIDTH];
+};
+
+struct alignas(32) Aabb_block
+{
+	float center_x[SIMD_BLOCK_WIDTH];
+	float center_y[SIMD_BLOCK_WIDTH];
+	float center_z[SIMD_BLOCK_WIDTH];
+	float extent_x[SIMD_BLOCK_WIDTH];
+	float extent_y[SIMD_BLOCK_WIDTH];
+	float extent_z[SIMD_BLOCK_WIDTH];
+};
+
+enum class Simd_level : uint8_t
+{
+	scalar,
+	sse4,
+	avx2
+};
+
+
+// The widest level the CPU has is picked on first use. Forcing a level is for benchmarks and comparisons, a level the
+// CPU lacks falls back to the widest it has.
+Simd_level  get_simd_level();
+Simd_level  get_supported_simd_level();
+void        set_simd_level(Simd_level level);
+const char* get_simd_level_name(Simd_level level);
+
+size_t    get_block_count(size_t count);
+void      set_lane(Vec4_block& block, size_t lane, const glm::vec4& value);
+glm::vec4 get_lane(const Vec4_block& block, size_t lane);
+void      set_lane(Aabb_block& block, size_t lane, const glm::vec3& center, const glm::vec3& extent);
+
+// matrix * (x, y, z, w) for every lane
+void transform_vectors(const glm::mat4& matrix, const Vec4_block* input, Vec4_block* output, size_t block_count);
+
+// result[i] = parents[i] * locals[i], one level of a transform hierarchy at a time
+void multiply_matrices(const glm::mat4* parents, const glm::mat4* locals, glm::mat4* result, size_t count);
+
+// Planes as in Indirect_renderer, normalised with the normal in xyz. Spheres keep their radius in w. The indices of the
+// visible objects are written to visible in ascending order, which needs room for count of them, and their number returned.
+size_t cull_spheres(const glm::vec4 (&planes)[FRUSTUM_PLANE_COUNT], const Vec4_block* spheres, size_t count, uint32_t* visible);
+size_t cull_aabbs(const glm::vec4 (&planes)[FRUSTUM_PLANE_COUNT], const Aabb_block* boxes, size_t count, uint32_t* visible);
+
+// Shortest path slerp of unit quaternions stored (x, y, z, w), t holds one factor per lane and needs no alignment. Uses
+// Eberly's polynomial form, which needs no trigonometry and stays within 2e-5 of the exact result, plenty for blending
+// animation but not for accumulating rotations over many steps.
+void slerp_quaternions(const Vec4_block* from, const Vec4_block* to, const float* t, Vec4_block* result, size_t block_count);
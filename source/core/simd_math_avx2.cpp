@@ -0,0 +1,121 @@
+#include "core/simd_kernels.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+
+namespace
+{
+// Eight lanes, a whole block at once
+struct Avx2_lanes
+{
+	static constexpr size_t WIDTH = 8;
+
+	__m256 value;
+
+	static Avx2_lanes load(const float* source)
+	{
+		return {_mm256_loadu_ps(source)};
+	}
+
+	static void store(float* destination, Avx2_lanes lanes)
+	{
+		_mm256_storeu_ps(destination, lanes.value);
+	}
+
+	static Avx2_lanes broadcast(float value)
+	{
+		return {_mm256_set1_ps(value)};
+	}
+
+	static Avx2_lanes greater_equal(Avx2_lanes a, Avx2_lanes b)
+	{
+		return {_mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ)};
+	}
+
+	static Avx2_lanes bitwise_and(Avx2_lanes a, Avx2_lanes b)
+	{
+		return {_mm256_and_ps(a.value, b.value)};
+	}
+
+	static uint32_t mask_bits(Avx2_lanes mask)
+	{
+		return static_cast<uint32_t>(_mm256_movemask_ps(mask.value));
+	}
+
+	static Avx2_lanes abs(Avx2_lanes a)
+	{
+		return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.value)};
+	}
+
+	static Avx2_lanes flip_sign(Avx2_lanes a, Avx2_lanes sign)
+	{
+		return {_mm256_xor_ps(a.value, _mm256_and_ps(sign.value, _mm256_set1_ps(-0.0f)))};
+	}
+
+	Avx2_lanes operator+(Avx2_lanes other) const
+	{
+		return {_mm256_add_ps(value, other.value)};
+	}
+
+	Avx2_lanes operator-(Avx2_lanes other) const
+	{
+		return {_mm256_sub_ps(value, other.value)};
+	}
+
+	Avx2_lanes operator*(Avx2_lanes other) const
+	{
+		return {_mm256_mul_ps(value, other.value)};
+	}
+};
+}
+
+
+// Two columns of the result at a time, every parent column sits in both halves of a register and the components of two
+// local columns are broadcast within their half
+static void multiply_matrices_avx2(const float* parents, const float* locals, float* result, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* parent   = parents + i * 16;
+		const float* local    = locals + i * 16;
+		__m256       column_0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent));
+		__m256       column_1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 4));
+		__m256       column_2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 8));
+		__m256       column_3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(parent + 12));
+
+		for (size_t column = 0; column < 4; column += 2)
+		{
+			__m256 weights = _mm256_loadu_ps(local + column * 4);
+			__m256 sum     = _mm256_mul_ps(column_0, _mm256_permute_ps(weights, _MM_SHUFFLE(0, 0, 0, 0)));
+			sum            = _mm256_add_ps(sum, _mm256_mul_ps(column_1, _mm256_permute_ps(weights, _MM_SHUFFLE(1, 1, 1, 1))));
+			sum            = _mm256_add_ps(sum, _mm256_mul_ps(column_2, _mm256_permute_ps(weights, _MM_SHUFFLE(2, 2, 2, 2))));
+			sum            = _mm256_add_ps(sum, _mm256_mul_ps(column_3, _mm256_permute_ps(weights, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm256_storeu_ps(result + i * 16 + column * 4, sum);
+		}
+	}
+}
+
+static const Simd_kernels AVX2_KERNELS = {
+    transform_vectors_kernel<Avx2_lanes>,
+    multiply_matrices_avx2,
+    cull_spheres_kernel<Avx2_lanes>,
+    cull_aabbs_kernel<Avx2_lanes>,
+    slerp_quaternions_kernel<Avx2_lanes>,
+};
+
+
+const Simd_kernels* get_avx2_kernels()
+{
+	return &AVX2_KERNELS;
+}
+
+#else
+
+const Simd_kernels* get_avx2_kernels()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#include "core/simd_kernels.hpp"
+
+#if defined(__SSE4_1__) || defined(_M_X64)
+
+#include <smmintrin.h>
+
+
+namespace
+{
+// Four lanes, each block is worked through in two halves
+struct Sse4_lanes
+{
+	static constexpr size_t WIDTH = 4;
+
+	__m128 value;
+
+	static Sse4_lanes load(const float* source)
+	{
+		return {_mm_loadu_ps(source)};
+	}
+
+	static void store(float* destination, Sse4_lanes lanes)
+	{
+		_mm_storeu_ps(destination, lanes.value);
+	}
+
+	static Sse4_lanes broadcast(float value)
+	{
+		return {_mm_set1_ps(value)};
+	}
+
+	static Sse4_lanes greater_equal(Sse4_lanes a, Sse4_lanes b)
+	{
+		return {_mm_cmpge_ps(a.value, b.value)};
+	}
+
+	static Sse4_lanes bitwise_and(Sse4_lanes a, Sse4_lanes b)
+	{
+		return {_mm_and_ps(a.value, b.value)};
+	}
+
+	static uint32_t mask_bits(Sse4_lanes mask)
+	{
+		return static_cast<uint32_t>(_mm_movemask_ps(mask.value));
+	}
+
+	static Sse4_lanes abs(Sse4_lanes a)
+	{
+		return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.value)};
+	}
+
+	static Sse4_lanes flip_sign(Sse4_lanes a, Sse4_lanes sign)
+	{
+		return {_mm_xor_ps(a.value, _mm_and_ps(sign.value, _mm_set1_ps(-0.0f)))};
+	}
+
+	Sse4_lanes operator+(Sse4_lanes other) const
+	{
+		return {_mm_add_ps(value, other.value)};
+	}
+
+	Sse4_lanes operator-(Sse4_lanes other) const
+	{
+		return {_mm_sub_ps(value, other.value)};
+	}
+
+	Sse4_lanes operator*(Sse4_lanes other) const
+	{
+		return {_mm_mul_ps(value, other.value)};
+	}
+};
+}
+
+
+// A column of the result at a time, the parent's columns scaled by the broadcast components of the local column
+static void multiply_matrices_sse4(const float* parents, const float* locals, float* result, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* parent   = parents + i * 16;
+		const float* local    = locals + i * 16;
+		__m128       column_0 = _mm_loadu_ps(parent);
+		__m128       column_1 = _mm_loadu_ps(parent + 4);
+		__m128       column_2 = _mm_loadu_ps(parent + 8);
+		__m128       column_3 = _mm_loadu_ps(parent + 12);
+
+		for (size_t column = 0; column < 4; column++)
+		{
+			__m128 weights = _mm_loadu_ps(local + column * 4);
+			__m128 sum     = _mm_mul_ps(column_0, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+			sum            = _mm_add_ps(sum, _mm_mul_ps(column_1, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+			sum            = _mm_add_ps(sum, _mm_mul_ps(column_2, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+			sum            = _mm_add_ps(sum, _mm_mul_ps(column_3, _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(result + i * 16 + column * 4, sum);
+		}
+	}
+}
+
+static const Simd_kernels SSE4_KERNELS = {
+    transform_vectors_kernel<Sse4_lanes>,
+    multiply_matrices_sse4,
+    cull_spheres_kernel<Sse4_lanes>,
+    cull_aabbs_kernel<Sse4_lanes>,
+    slerp_quaternions_kernel<Sse4_lanes>,
+};
+
+
+const Simd_kernels* get_sse4_kernels()
+{
+	return &SSE4_KERNELS;
+}
+
+#else
+
+const Simd_kernels* get_sse4_kernels()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,299 @@
+#include "tlsf_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+
+
+static uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+void Tlsf_allocator::startup(uint64_t total_size)
+{
+	shutdown();
+
+	size = total_size & ~(TLSF_MIN_BLOCK - 1);
+	if (size >= TLSF_MIN_BLOCK)
+	{
+		insert_free(create_node(0, size));
+	}
+}
+
+void Tlsf_allocator::shutdown()
+{
+	nodes.clear();
+	unused_nodes.clear();
+	std::fill(&free_lists[0][0], &free_lists[0][0] + TLSF_FL_COUNT * TLSF_SL_COUNT, TLSF_INVALID_NODE);
+	std::fill(std::begin(sl_bitmaps), std::end(sl_bitmaps), 0u);
+	fl_bitmap        = 0;
+	size             = 0;
+	used_size        = 0;
+	allocation_count = 0;
+}
+
+bool Tlsf_allocator::allocate(uint64_t requested_size, uint64_t alignment, Tlsf_allocation& allocation)
+{
+	// Offsets are always TLSF_MIN_BLOCK aligned, so a larger alignment costs at most alignment - TLSF_MIN_BLOCK of padding
+	uint64_t block_size = align_up(std::max<uint64_t>(requested_size, 1), TLSF_MIN_BLOCK);
+	alignment           = std::max(std::bit_ceil(alignment), TLSF_MIN_BLOCK);
+
+	uint32_t node = find_free_node(block_size + alignment - TLSF_MIN_BLOCK);
+	if (node == TLSF_INVALID_NODE)
+	{
+		return false;
+	}
+	remove_free(node);
+
+	uint64_t padding = align_up(nodes[node].offset, alignment) - nodes[node].offset;
+	if (padding > 0)
+	{
+		// The block before a free block is always in use, so the padding cannot merge and just goes back on a free list
+		uint32_t aligned = split(node, padding);
+		insert_free(node);
+		node = aligned;
+	}
+
+	if (nodes[node].size - block_size >= TLSF_MIN_BLOCK)
+	{
+		insert_free(split(node, block_size));
+	}
+
+	nodes[node].free = false;
+	used_size += nodes[node].size;
+	allocation_count++;
+
+	allocation.offset = nodes[node].offset;
+	allocation.size   = nodes[node].size;
+	allocation.node   = node;
+
+	return true;
+}
+
+void Tlsf_allocator::free(const Tlsf_allocation& allocation)
+{
+	uint32_t node = allocation.node;
+	if (node == TLSF_INVALID_NODE || nodes[node].free)
+	{
+		return;
+	}
+
+	used_size -= nodes[node].size;
+	allocation_count--;
+	nodes[node].free = true;
+
+	// Merging with both physical neighbours keeps the invariant that no two free blocks touch
+	uint32_t prev = nodes[node].prev_physical;
+	if (prev != TLSF_INVALID_NODE && nodes[prev].free)
+	{
+		remove_free(prev);
+		nodes[prev].size += nodes[node].size;
+		nodes[prev].next_physical = nodes[node].next_physical;
+		if (nodes[node].next_physical != TLSF_INVALID_NODE)
+		{
+			nodes[nodes[node].next_physical].prev_physical = prev;
+		}
+		release_node(node);
+		node = prev;
+	}
+
+	uint32_t next = nodes[node].next_physical;
+	if (next != TLSF_INVALID_NODE && nodes[next].free)
+	{
+		remove_free(next);
+		nodes[node].size += nodes[next].size;
+		nodes[node].next_physical = nodes[next].next_physical;
+		if (nodes[next].next_physical != TLSF_INVALID_NODE)
+		{
+			nodes[nodes[next].next_physical].prev_physical = node;
+		}
+		release_node(next);
+	}
+
+	insert_free(node);
+}
+
+uint64_t Tlsf_allocator::get_size() const
+{
+	return size;
+}
+
+uint64_t Tlsf_allocator::get_used_size() const
+{
+	return used_size;
+}
+
+uint64_t Tlsf_allocator::get_largest_free_block() const
+{
+	if (fl_bitmap == 0)
+	{
+		return 0;
+	}
+
+	uint32_t fl = 63 - std::countl_zero(fl_bitmap);
+	uint32_t sl = 31 - std::countl_zero(sl_bitmaps[fl]);
+
+	uint64_t largest = 0;
+	for (uint32_t node = free_lists[fl][sl]; node != TLSF_INVALID_NODE; node = nodes[node].next_free)
+	{
+		largest = std::max(largest, nodes[node].size);
+	}
+
+	return largest;
+}
+
+uint32_t Tlsf_allocator::get_allocation_count() const
+{
+	return allocation_count;
+}
+
+bool Tlsf_allocator::is_empty() const
+{
+	return allocation_count == 0;
+}
+
+void Tlsf_allocator::mapping(uint64_t block_size, uint32_t& fl, uint32_t& sl)
+{
+	fl = 63 - std::countl_zero(block_size);
+	sl = static_cast<uint32_t>(block_size >> (fl - TLSF_SL_BITS)) & (TLSF_SL_COUNT - 1);
+}
+
+uint32_t Tlsf_allocator::create_node(uint64_t offset, uint64_t block_size)
+{
+	uint32_t node;
+	if (!unused_nodes.empty())
+	{
+		node = unused_nodes.back();
+		unused_nodes.pop_back();
+	}
+	else
+	{
+		node = static_cast<uint32_t>(nodes.size());
+		nodes.emplace_back();
+	}
+
+	nodes[node]        = {};
+	nodes[node].offset = offset;
+	nodes[node].size   = block_size;
+
+	return node;
+}
+
+void Tlsf_allocator::release_node(uint32_t node)
+{
+	unused_nodes.push_back(node);
+}
+
+uint32_t Tlsf_allocator::find_free_node(uint64_t block_size)
+{
+	uint32_t fl;
+	uint32_t sl;
+
+	// Rounding up to the next class boundary means any block found through the bitmaps fits without checking its size
+	mapping(block_size, fl, sl);
+	uint64_t rounded = block_size + (1ull << (fl - TLSF_SL_BITS)) - 1;
+
+	uint32_t search_fl;
+	uint32_t search_sl;
+	mapping(rounded, search_fl, search_sl);
+
+	uint32_t sl_map = search_fl < TLSF_FL_COUNT ? sl_bitmaps[search_fl] & (~0u << search_sl) : 0;
+	if (sl_map == 0)
+	{
+		uint64_t fl_map = search_fl + 1 < TLSF_FL_COUNT ? fl_bitmap & (~0ull << (search_fl + 1)) : 0;
+		if (fl_map != 0)
+		{
+			search_fl = std::countr_zero(fl_map);
+			sl_map    = sl_bitmaps[search_fl];
+		}
+	}
+
+	if (sl_map != 0)
+	{
+		return free_lists[search_fl][std::countr_zero(sl_map)];
+	}
+
+	// Nothing in a larger class, but a block in the exact class may still be big enough
+	for (uint32_t node = free_lists[fl][sl]; node != TLSF_INVALID_NODE; node = nodes[node].next_free)
+	{
+		if (nodes[node].size >= block_size)
+		{
+			return node;
+		}
+	}
+
+	return TLSF_INVALID_NODE;
+}
+
+void Tlsf_allocator::insert_free(uint32_t node)
+{
+	uint32_t fl;
+	uint32_t sl;
+	mapping(nodes[node].size, fl, sl);
+
+	uint32_t head = free_lists[fl][sl];
+
+	nodes[node].free      = true;
+	nodes[node].prev_free = TLSF_INVALID_NODE;
+	nodes[node].next_free = head;
+	if (head != TLSF_INVALID_NODE)
+	{
+		nodes[head].prev_free = node;
+	}
+
+	free_lists[fl][sl] = node;
+	fl_bitmap |= 1ull << fl;
+	sl_bitmaps[fl] |= 1u << sl;
+}
+
+void Tlsf_allocator::remove_free(uint32_t node)
+{
+	uint32_t fl;
+	uint32_t sl;
+	mapping(nodes[node].size, fl, sl);
+
+	uint32_t prev = nodes[node].prev_free;
+	uint32_t next = nodes[node].next_free;
+	if (prev != TLSF_INVALID_NODE)
+	{
+		nodes[prev].next_free = next;
+	}
+	else
+	{
+		free_lists[fl][sl] = next;
+	}
+	if (next != TLSF_INVALID_NODE)
+	{
+		nodes[next].prev_free = prev;
+	}
+
+	if (free_lists[fl][sl] == TLSF_INVALID_NODE)
+	{
+		sl_bitmaps[fl] &= ~(1u << sl);
+		if (sl_bitmaps[fl] == 0)
+		{
+			fl_bitmap &= ~(1ull << fl);
+		}
+	}
+
+	nodes[node].free      = false;
+	nodes[node].prev_free = TLSF_INVALID_NODE;
+	nodes[node].next_free = TLSF_INVALID_NODE;
+}
+
+uint32_t Tlsf_allocator::split(uint32_t node, uint64_t head_size)
+{
+	uint32_t tail = create_node(nodes[node].offset + head_size, nodes[node].size - head_size);
+
+	// create_node may have grown the vector, so index again rather than holding a reference
+	nodes[tail].prev_physical = node;
+	nodes[tail].next_physical = nodes[node].next_physical;
+	if (nodes[node].next_physical != TLSF_INVALID_NODE)
+	{
+		nodes[nodes[node].next_physical].prev_physical = tail;
+	}
+	nodes[node].next_physical = tail;
+	nodes[node].size          = head_size;
+
+	return tail;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+constexpr uint32_t TLSF_SL_BITS      = 4;
+constexpr uint32_t TLSF_SL_COUNT     = 1 << TLSF_SL_BITS;
+constexpr uint32_t TLSF_FL_COUNT     = 64;
+constexpr uint64_t TLSF_MIN_BLOCK    = 1 << TLSF_SL_BITS;
+constexpr uint32_t TLSF_INVALID_NODE = UINT32_MAX;
+
+
+struct Tlsf_allocation
+{
+	uint64_t offset = 0;
+	uint64_t size   = 0;
+	uint32_t node   = TLSF_INVALID_NODE;
+};
+
+// Two-level segregated fit over an abstract range of offsets; it never touches the memory it manages
+class Tlsf_allocator
+{
+public:
+
+	void startup(uint64_t size);
+	void shutdown();
+
+	bool allocate(uint64_t size, uint64_t alignment, Tlsf_allocation& allocation);
+	void free(const Tlsf_allocation& allocation);
+
+	uint64_t get_size() const;
+	uint64_t get_used_size() const;
+	uint64_t get_largest_free_block() const;
+	uint32_t get_allocation_count() const;
+	bool     is_empty() const;
+
+private:
+
+	struct Node
+	{
+		uint64_t offset        = 0;
+		uint64_t size          = 0;
+		uint32_t prev_physical = TLSF_INVALID_NODE;
+		uint32_t next_physical = TLSF_INVALID_NODE;
+		uint32_t prev_free     = TLSF_INVALID_NODE;
+		uint32_t next_free     = TLSF_INVALID_NODE;
+		bool     free          = false;
+	};
+
+	std::vector<Node>     nodes;
+	std::vector<uint32_t> unused_nodes;
+	uint32_t              free_lists[TLSF_FL_COUNT][TLSF_SL_COUNT];
+	uint32_t              sl_bitmaps[TLSF_FL_COUNT];
+	uint64_t              fl_bitmap        = 0;
+	uint64_t              size             = 0;
+	uint64_t              used_size        = 0;
+	uint32_t              allocation_count = 0;
+
+	static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+
+	uint32_t create_node(uint64_t offset, uint64_t size);
+	void     release_node(uint32_t node);
+	uint32_t find_free_node(uint64_t size);
+	void     insert_free(uint32_t node);
+	void     remove_free(uint32_t node);
+	uint32_t split(uint32_t node, uint64_t size);
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+
+// Hands whole values from one writer thread to one reader thread without locks or waiting. The writer always owns a
+// buffer to fill and the reader one to read, publishing and acquiring swap them with the shared middle buffer. The
+// reader only ever sees the newest published value, values published in between are skipped.
+template <typename T>
+class Triple_buffer
+{
+public:
+
+	// Writer only, the buffer still holds an older value and is not cleared
+	T&   get_write_buffer();
+	void publish();
+
+	// Reader only, returns false when nothing was published since the last acquire and the read buffer is unchanged
+	bool     acquire();
+	const T& get_read_buffer() const;
+
+private:
+
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t FRESH_BIT  = 0x4;
+
+	std::array<T, 3> buffers;
+
+	// Each side's index on a cache line of its own, so the two threads only ever share the middle
+	alignas(64) std::atomic<uint8_t> middle = 1;
+	alignas(64) uint8_t write_index         = 0;
+	alignas(64) uint8_t read_index          = 2;
+};
+
+
+template <typename T>
+T& Triple_buffer<T>::get_write_buffer()
+{
+	return buffers[write_index];
+}
+
+template <typename T>
+void Triple_buffer<T>::publish()
+{
+	// Release makes the writes to the buffer visible to the acquire that picks it up
+	write_index = middle.exchange(write_index | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+template <typename T>
+bool Triple_buffer<T>::acquire()
+{
+	if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+	{
+		return false;
+	}
+
+	read_index = middle.exchange(read_index, std::memory_order_acq_rel) & INDEX_MASK;
+	return true;
+}
+
+template <typename T>
+const T& Triple_buffer<T>::get_read_buffer() const
+{
+	return buffers[read_index];
+}
@@ -0,0 +1,191 @@
+#include "archetype.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+static size_t align_up(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Columns are laid out back to back, each starting on its own cache line; returns the bytes a chunk of the given capacity needs
+static size_t compute_layout(Component_mask mask, uint32_t capacity, uint32_t (&column_offsets)[MAX_COMPONENT_TYPES])
+{
+	size_t offset = sizeof(Entity) * capacity;
+
+	for (Component_id component = 0; component < MAX_COMPONENT_TYPES; component++)
+	{
+		column_offsets[component] = INVALID_COLUMN;
+		if (!(mask & (Component_mask(1) << component)))
+		{
+			continue;
+		}
+
+		const Component_info& info = get_component_info(component);
+		offset                     = align_up(offset, CACHE_LINE_SIZE);
+		column_offsets[component]  = static_cast<uint32_t>(offset);
+		offset += info.size * capacity;
+	}
+
+	return offset;
+}
+
+// Start from the unpadded estimate and back off until the cache line padding fits as well, zero when a row does not fit even once
+static uint32_t compute_chunk_capacity(Component_mask mask, uint32_t (&column_offsets)[MAX_COMPONENT_TYPES])
+{
+	size_t row_size = sizeof(Entity);
+	for (Component_id component = 0; component < MAX_COMPONENT_TYPES; component++)
+	{
+		if (mask & (Component_mask(1) << component))
+		{
+			row_size += get_component_info(component).size;
+		}
+	}
+
+	uint32_t capacity = static_cast<uint32_t>(ECS_CHUNK_SIZE / row_size);
+	while (capacity > 1 && compute_layout(mask, capacity, column_offsets) > ECS_CHUNK_SIZE)
+	{
+		capacity--;
+	}
+	if (compute_layout(mask, capacity, column_offsets) > ECS_CHUNK_SIZE)
+	{
+		return 0;
+	}
+
+	return capacity;
+}
+
+
+Archetype::Archetype(Component_mask component_mask)
+    : mask(component_mask)
+{
+	chunk_capacity = compute_chunk_capacity(mask, column_offsets);
+
+	for (Component_id component = 0; component < MAX_COMPONENT_TYPES; component++)
+	{
+		if (column_offsets[component] != INVALID_COLUMN)
+		{
+			columns.push_back({component, column_offsets[component], static_cast<uint32_t>(get_component_info(component).size)});
+		}
+	}
+}
+
+Entity_location Archetype::push(Entity entity)
+{
+	Entity_location location = {};
+	location.chunk           = static_cast<uint32_t>(entity_count / chunk_capacity);
+	location.row             = static_cast<uint32_t>(entity_count % chunk_capacity);
+
+	if (location.chunk == chunks.size())
+	{
+		chunks.push_back(std::make_unique_for_overwrite<Chunk>());
+	}
+
+	get_entities(location.chunk)[location.row] = entity;
+	entity_count++;
+
+	return location;
+}
+
+Entity Archetype::swap_remove(Entity_location location)
+{
+	entity_count--;
+
+	Entity_location last = {};
+	last.chunk           = static_cast<uint32_t>(entity_count / chunk_capacity);
+	last.row             = static_cast<uint32_t>(entity_count % chunk_capacity);
+
+	Entity moved = {};
+	if (last.chunk != location.chunk || last.row != location.row)
+	{
+		// Fill the hole with the last row so the columns stay dense
+		Chunk* source      = chunks[last.chunk].get();
+		Chunk* destination = chunks[location.chunk].get();
+
+		moved                                      = get_entities(last.chunk)[last.row];
+		get_entities(location.chunk)[location.row] = moved;
+
+		for (const Archetype_column& column : columns)
+		{
+			std::memcpy(destination->data + column.offset + column.size * location.row, source->data + column.offset + column.size * last.row, column.size);
+		}
+	}
+
+	// Keep one spare chunk around so an entity bouncing across a chunk boundary does not allocate every time
+	while (chunks.size() > get_chunk_count() + 1)
+	{
+		chunks.pop_back();
+	}
+
+	return moved;
+}
+
+bool Archetype::fits_in_chunk(Component_mask mask)
+{
+	uint32_t column_offsets[MAX_COMPONENT_TYPES];
+	return compute_chunk_capacity(mask, column_offsets) > 0;
+}
+
+Component_mask Archetype::get_mask() const
+{
+	return mask;
+}
+
+const std::vector<Archetype_column>& Archetype::get_columns() const
+{
+	return columns;
+}
+
+uint32_t Archetype::get_chunk_capacity() const
+{
+	return chunk_capacity;
+}
+
+size_t Archetype::get_chunk_count() const
+{
+	if (chunk_capacity == 0)
+	{
+		return 0;
+	}
+	return (entity_count + chunk_capacity - 1) / chunk_capacity;
+}
+
+uint32_t Archetype::get_row_count(size_t chunk) const
+{
+	if (chunk >= get_chunk_count())
+	{
+		return 0;
+	}
+	return static_cast<uint32_t>(std::min<size_t>(chunk_capacity, entity_count - chunk * chunk_capacity));
+}
+
+size_t Archetype::get_entity_count() const
+{
+	return entity_count;
+}
+
+Entity* Archetype::get_entities(size_t chunk)
+{
+	return reinterpret_cast<Entity*>(chunks[chunk]->data);
+}
+
+void* Archetype::get_column(size_t chunk, Component_id component)
+{
+	if (column_offsets[component] == INVALID_COLUMN)
+	{
+		return nullptr;
+	}
+
+	return chunks[chunk]->data + column_offsets[component];
+}
+
+void* Archetype::get_component(Entity_location location, Component_id component)
+{
+	if (column_offsets[component] == INVALID_COLUMN)
+	{
+		return nullptr;
+	}
+
+	return chunks[location.chunk]->data + column_offsets[component] + static_cast<size_t>(get_component_info(component).size) * location.row;
+}
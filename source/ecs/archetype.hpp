@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ecs/entity.hpp"
+
+
+constexpr size_t   ECS_CHUNK_SIZE = 16 * 1024;
+constexpr uint32_t INVALID_COLUMN = UINT32_MAX;
+
+
+struct alignas(CACHE_LINE_SIZE) Chunk
+{
+	std::byte data[ECS_CHUNK_SIZE];
+};
+
+struct Archetype_column
+{
+	Component_id component = 0;
+	uint32_t     offset    = 0;
+	uint32_t     size      = 0;
+};
+
+struct Entity_location
+{
+	uint32_t chunk = 0;
+	uint32_t row   = 0;
+};
+
+// Every entity with exactly the same set of components, stored as one column per component in fixed size chunks.
+// Rows are kept dense, so only the last chunk is ever partially filled.
+class Archetype
+{
+public:
+
+	explicit Archetype(Component_mask mask);
+
+	Entity_location push(Entity entity);
+	Entity          swap_remove(Entity_location location);
+
+	// False when a row with these components does not fit in a chunk even once, such a set never gets an archetype
+	static bool fits_in_chunk(Component_mask mask);
+
+	Component_mask                       get_mask() const;
+	const std::vector<Archetype_column>& get_columns() const;
+	uint32_t                             get_chunk_capacity() const;
+	size_t                               get_chunk_count() const;
+	uint32_t                             get_row_count(size_t chunk) const;
+	size_t                               get_entity_count() const;
+
+	Entity* get_entities(size_t chunk);
+	void*   get_column(size_t chunk, Component_id component);
+	void*   get_component(Entity_location location, Component_id component);
+
+	template <typename Component>
+	Component* get_column(size_t chunk);
+
+	// Cached archetype transitions, filled in lazily by the world
+	Archetype* add_edges[MAX_COMPONENT_TYPES]    = {};
+	Archetype* remove_edges[MAX_COMPONENT_TYPES] = {};
+
+private:
+
+	Component_mask                      mask           = 0;
+	uint32_t                            chunk_capacity = 0;
+	uint32_t                            column_offsets[MAX_COMPONENT_TYPES];
+	std::vector<Archetype_column>       columns;
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	size_t                              entity_count = 0;
+};
+
+
+template <typename Component>
+Component* Archetype::get_column(size_t chunk)
+{
+	return static_cast<Component*>(get_column(chunk, get_component_id<Component>()));
+}
@@ -0,0 +1,40 @@
+#include "entity.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+
+static Component_info        component_infos[MAX_COMPONENT_TYPES];
+static std::atomic<uint32_t> component_type_count = 0;
+static std::mutex            registry_mutex;
+
+
+Component_id register_component_type(size_t size, size_t alignment)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	uint32_t id = component_type_count.load(std::memory_order_relaxed);
+	if (id == MAX_COMPONENT_TYPES)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "More than %u component types registered.", MAX_COMPONENT_TYPES);
+		std::abort();
+	}
+
+	if (size > MAX_COMPONENT_SIZE || alignment > CACHE_LINE_SIZE)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Component type of %zu bytes aligned to %zu does not fit in a chunk.", size, alignment);
+		std::abort();
+	}
+
+	component_infos[id] = {size, alignment};
+	component_type_count.store(id + 1, std::memory_order_release);
+
+	return id;
+}
+
+const Component_info& get_component_info(Component_id component)
+{
+	return component_infos[component];
+}
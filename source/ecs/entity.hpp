@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+constexpr uint32_t INVALID_ENTITY_INDEX = UINT32_MAX;
+constexpr uint32_t MAX_COMPONENT_TYPES  = 64;
+constexpr size_t   CACHE_LINE_SIZE      = 64;
+constexpr size_t   MAX_COMPONENT_SIZE   = 4 * 1024;
+
+
+// The generation is bumped whenever an index is recycled, so stale handles stop resolving
+struct Entity
+{
+	uint32_t index      = INVALID_ENTITY_INDEX;
+	uint32_t generation = 0;
+
+	bool operator==(const Entity& other) const = default;
+};
+
+using Component_id   = uint32_t;
+using Component_mask = uint64_t;
+
+struct Component_info
+{
+	size_t size      = 0;
+	size_t alignment = 0;
+};
+
+Component_id          register_component_type(size_t size, size_t alignment);
+const Component_info& get_component_info(Component_id component);
+
+// Ids are handed out on first use, so they are stable for the lifetime of the process but not across runs
+template <typename Component>
+Component_id get_component_id()
+{
+	static_assert(std::is_trivially_copyable_v<Component> && std::is_trivially_destructible_v<Component>, "Components are relocated between chunks with memcpy");
+	static_assert(alignof(Component) <= CACHE_LINE_SIZE, "Component columns are only aligned to a cache line");
+	static_assert(sizeof(Component) <= MAX_COMPONENT_SIZE, "Components have to leave room for several rows in a chunk");
+
+	static const Component_id id = register_component_type(sizeof(Component), alignof(Component));
+	return id;
+}
+
+template <typename... Components>
+Component_mask get_component_mask()
+{
+	return ((Component_mask(1) << get_component_id<Components>()) | ... | Component_mask(0));
+}
@@ -0,0 +1,170 @@
+#include "world.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <cstring>
+
+
+World::World()
+{
+	empty_archetype = get_archetype(0);
+}
+
+Entity World::create_entity()
+{
+	uint32_t index;
+	if (!free_indices.empty())
+	{
+		index = free_indices.back();
+		free_indices.pop_back();
+	}
+	else
+	{
+		index = static_cast<uint32_t>(records.size());
+		records.emplace_back();
+	}
+
+	Entity         entity = {index, records[index].generation};
+	Entity_record& record = records[index];
+	record.archetype      = empty_archetype;
+	record.location       = empty_archetype->push(entity);
+	entity_count++;
+
+	return entity;
+}
+
+void World::destroy_entity(Entity entity)
+{
+	if (!is_alive(entity))
+	{
+		return;
+	}
+
+	Entity_record& record = records[entity.index];
+
+	Entity moved = record.archetype->swap_remove(record.location);
+	if (moved.index != INVALID_ENTITY_INDEX)
+	{
+		records[moved.index].location = record.location;
+	}
+
+	record.archetype = nullptr;
+	record.generation++;
+	free_indices.push_back(entity.index);
+	entity_count--;
+}
+
+bool World::is_alive(Entity entity) const
+{
+	return entity.index < records.size() && records[entity.index].generation == entity.generation && records[entity.index].archetype != nullptr;
+}
+
+size_t World::get_entity_count() const
+{
+	return entity_count;
+}
+
+Archetype* World::get_archetype(Component_mask mask)
+{
+	auto it = archetype_lookup.find(mask);
+	if (it != archetype_lookup.end())
+	{
+		return it->second;
+	}
+
+	archetypes.push_back(std::make_unique<Archetype>(mask));
+	archetype_lookup[mask] = archetypes.back().get();
+
+	return archetypes.back().get();
+}
+
+void World::move_entity(Entity_record& record, Archetype* target)
+{
+	Archetype*      source          = record.archetype;
+	Entity_location source_location = record.location;
+	Entity          entity          = source->get_entities(source_location.chunk)[source_location.row];
+	Entity_location target_location = target->push(entity);
+
+	// Only the components both archetypes share carry over, an added one is written by the caller and a removed one is dropped
+	for (const Archetype_column& column : source->get_columns())
+	{
+		void* destination = target->get_component(target_location, column.component);
+		if (destination)
+		{
+			std::memcpy(destination, source->get_component(source_location, column.component), column.size);
+		}
+	}
+
+	Entity moved = source->swap_remove(source_location);
+	if (moved.index != INVALID_ENTITY_INDEX)
+	{
+		records[moved.index].location = source_location;
+	}
+
+	record.archetype = target;
+	record.location  = target_location;
+}
+
+void* World::add_component(Entity entity, Component_id component)
+{
+	if (!is_alive(entity))
+	{
+		return nullptr;
+	}
+
+	Entity_record& record = records[entity.index];
+	Component_mask bit    = Component_mask(1) << component;
+
+	if (!(record.archetype->get_mask() & bit))
+	{
+		Archetype*& target = record.archetype->add_edges[component];
+		if (!target)
+		{
+			// Refused before the archetype exists, so queries never see one they cannot split into chunks
+			if (!Archetype::fits_in_chunk(record.archetype->get_mask() | bit))
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Component %u does not fit in a chunk with the entity's other components.", component);
+				return nullptr;
+			}
+			target                          = get_archetype(record.archetype->get_mask() | bit);
+			target->remove_edges[component] = record.archetype;
+		}
+		move_entity(record, target);
+	}
+
+	return record.archetype->get_component(record.location, component);
+}
+
+void World::remove_component(Entity entity, Component_id component)
+{
+	if (!is_alive(entity))
+	{
+		return;
+	}
+
+	Entity_record& record = records[entity.index];
+	Component_mask bit    = Component_mask(1) << component;
+
+	if (!(record.archetype->get_mask() & bit))
+	{
+		return;
+	}
+
+	Archetype*& target = record.archetype->remove_edges[component];
+	if (!target)
+	{
+		target                       = get_archetype(record.archetype->get_mask() & ~bit);
+		target->add_edges[component] = record.archetype;
+	}
+	move_entity(record, target);
+}
+
+void* World::get_component(Entity entity, Component_id component) const
+{
+	if (!is_alive(entity))
+	{
+		return nullptr;
+	}
+
+	const Entity_record& record = records[entity.index];
+	return record.archetype->get_component(record.location, component);
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/job_system.hpp"
+#include "ecs/archetype.hpp"
+#include "ecs/entity.hpp"
+
+
+// Archetype based entity component system. Structural changes (creating, destroying, adding or removing components)
+// must not happen while a query is iterating, and are not thread safe.
+class World
+{
+public:
+
+	World();
+
+	Entity create_entity();
+	void   destroy_entity(Entity entity);
+	bool   is_alive(Entity entity) const;
+	size_t get_entity_count() const;
+
+	// Returns nullptr when the entity is not alive or its components would no longer fit in a chunk
+	template <typename Component>
+	Component* add_component(Entity entity, const Component& value = Component{});
+
+	template <typename Component>
+	void remove_component(Entity entity);
+
+	template <typename Component>
+	Component* get_component(Entity entity);
+
+	template <typename Component>
+	bool has_component(Entity entity) const;
+
+	// Calls function(Components&...) or function(Entity, Components&...) for every entity that has all the components
+	template <typename... Components, typename Function>
+	void each(Function&& function);
+
+	// Same as each, but chunks are spread over the job system, so function has to be safe to call concurrently
+	template <typename... Components, typename Function>
+	void parallel_each(Job_system& job_system, const Function& function);
+
+private:
+
+	struct Entity_record
+	{
+		Archetype*      archetype  = nullptr;
+		Entity_location location;
+		uint32_t        generation = 0;
+	};
+
+	struct Chunk_reference
+	{
+		Archetype* archetype = nullptr;
+		size_t     chunk     = 0;
+	};
+
+	std::vector<Entity_record>                     records;
+	std::vector<uint32_t>                          free_indices;
+	std::vector<std::unique_ptr<Archetype>>        archetypes;
+	std::unordered_map<Component_mask, Archetype*> archetype_lookup;
+	Archetype*                                     empty_archetype = nullptr;
+	size_t                                         entity_count    = 0;
+
+	Archetype* get_archetype(Component_mask mask);
+	void       move_entity(Entity_record& record, Archetype* target);
+	void*      add_component(Entity entity, Component_id component);
+	void       remove_component(Entity entity, Component_id component);
+	void*      get_component(Entity entity, Component_id component) const;
+
+	template <typename... Components, typename Function>
+	static void each_in_chunk(Archetype& archetype, size_t chunk, const Function& function);
+};
+
+
+template <typename Component>
+Component* World::add_component(Entity entity, const Component& value)
+{
+	Component* component = static_cast<Component*>(add_component(entity, get_component_id<Component>()));
+	if (component)
+	{
+		*component = value;
+	}
+	return component;
+}
+
+template <typename Component>
+void World::remove_component(Entity entity)
+{
+	remove_component(entity, get_component_id<Component>());
+}
+
+template <typename Component>
+Component* World::get_component(Entity entity)
+{
+	return static_cast<Component*>(get_component(entity, get_component_id<Component>()));
+}
+
+template <typename Component>
+bool World::has_component(Entity entity) const
+{
+	return get_component(entity, get_component_id<Component>()) != nullptr;
+}
+
+template <typename... Components, typename Function>
+void World::each_in_chunk(Archetype& archetype, size_t chunk, const Function& function)
+{
+	uint32_t                   row_count = archetype.get_row_count(chunk);
+	Entity*                    entities  = archetype.get_entities(chunk);
+	std::tuple<Components*...> columns(archetype.template get_column<Components>(chunk)...);
+
+	for (uint32_t row = 0; row < row_count; row++)
+	{
+		if constexpr (std::is_invocable_v<const Function&, Entity, Components&...>)
+		{
+			function(entities[row], std::get<Components*>(columns)[row]...);
+		}
+		else
+		{
+			function(std::get<Components*>(columns)[row]...);
+		}
+	}
+}
+
+template <typename... Components, typename Function>
+void World::each(Function&& function)
+{
+	Component_mask mask = get_component_mask<Components...>();
+
+	for (const std::unique_ptr<Archetype>& archetype : archetypes)
+	{
+		if ((archetype->get_mask() & mask) != mask)
+		{
+			continue;
+		}
+
+		for (size_t chunk = 0; chunk < archetype->get_chunk_count(); chunk++)
+		{
+			each_in_chunk<Components...>(*archetype, chunk, function);
+		}
+	}
+}
+
+template <typename... Components, typename Function>
+void World::parallel_each(Job_system& job_system, const Function& function)
+{
+	Component_mask mask = get_component_mask<Components...>();
+
+	// A chunk is the unit of work, it is small enough to balance and large enough to amortise the job overhead
+	std::vector<Chunk_reference> chunks;
+	for (const std::unique_ptr<Archetype>& archetype : archetypes)
+	{
+		if ((archetype->get_mask() & mask) != mask)
+		{
+			continue;
+		}
+
+		for (size_t chunk = 0; chunk < archetype->get_chunk_count(); chunk++)
+		{
+			chunks.push_back({archetype.get(), chunk});
+		}
+	}
+
+	job_system.parallel_for(chunks.size(),
+	                        1,
+	                        [&](size_t first, size_t last)
+	                        {
+		                        for (size_t i = first; i < last; i++)
+		                        {
+			                        each_in_chunk<Components...>(*chunks[i].archetype, chunks[i].chunk, function);
+		                        }
+	                        });
+}
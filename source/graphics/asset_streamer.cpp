@@ -0,0 +1,348 @@
+#include "asset_streamer.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <cstring>
+
+#include "config/application.hpp"
+#include "core/file_io.hpp"
+#include "core/profiler.hpp"
+#include "graphics/render_manager.hpp"
+
+
+static double to_mib(uint64_t bytes)
+{
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+
+void Asset_streamer::startup(Render_manager& render_manager, Job_system& job_system, const Asset_archive* asset_archive, uint64_t upload_budget, uint64_t memory_budget)
+{
+	this->render_manager = &render_manager;
+	this->job_system     = &job_system;
+	this->archive        = asset_archive;
+	this->upload_budget  = upload_budget;
+	this->memory_budget  = memory_budget;
+	frame_number         = 0;
+	stats                = {};
+}
+
+void Asset_streamer::shutdown()
+{
+	// Decode jobs hold pointers into the requests, they have to drain before anything is freed
+	if (job_system)
+	{
+		job_system->wait_for(decode_counter);
+	}
+
+	// The mesh slots belong to the renderer and are released with the rest of its meshes
+	requests.clear();
+	request_lookup.clear();
+	for (size_t i = 0; i < static_cast<size_t>(Stream_priority::count); i++)
+	{
+		decode_queues[i].clear();
+		upload_queues[i].clear();
+	}
+	decoding.clear();
+	uploading.clear();
+	stats = {};
+}
+
+Stream_handle Asset_streamer::request_mesh(const std::string& path, Stream_priority priority)
+{
+	Stream_handle stream;
+	auto          found = request_lookup.find(path);
+	if (found != request_lookup.end())
+	{
+		stream = found->second;
+	}
+	else
+	{
+		Mesh_handle mesh = render_manager->reserve_mesh(render_manager->get_placeholder_mesh());
+		if (mesh == INVALID_MESH)
+		{
+			return INVALID_STREAM;
+		}
+
+		stream = static_cast<Stream_handle>(requests.size());
+		requests.push_back(std::make_unique<Stream_request>());
+		requests.back()->path = path;
+		requests.back()->mesh = mesh;
+		request_lookup.emplace(path, stream);
+	}
+
+	Stream_request& request = *requests[stream];
+	request.references++;
+	request.last_used_frame = frame_number;
+
+	// Queues are never searched, an entry left behind by a priority change is skipped when it is popped
+	Stream_state state = request.state.load(std::memory_order_relaxed);
+	if (state == Stream_state::unloaded || (state == Stream_state::queued && priority < request.priority))
+	{
+		request.priority = priority;
+		request.state.store(Stream_state::queued, std::memory_order_relaxed);
+		decode_queues[static_cast<size_t>(priority)].push_back(stream);
+	}
+	else
+	{
+		request.priority = std::min(request.priority, priority);
+	}
+
+	return stream;
+}
+
+void Asset_streamer::release(Stream_handle stream)
+{
+	if (stream < requests.size() && requests[stream]->references > 0)
+	{
+		requests[stream]->references--;
+		requests[stream]->last_used_frame = frame_number;
+	}
+}
+
+void Asset_streamer::touch(Stream_handle stream)
+{
+	if (stream < requests.size())
+	{
+		requests[stream]->last_used_frame = frame_number;
+	}
+}
+
+Mesh_handle Asset_streamer::get_mesh(Stream_handle stream) const
+{
+	return stream < requests.size() ? requests[stream]->mesh : INVALID_MESH;
+}
+
+bool Asset_streamer::is_resident(Stream_handle stream) const
+{
+	return stream < requests.size() && requests[stream]->state.load(std::memory_order_relaxed) == Stream_state::resident;
+}
+
+void Asset_streamer::update(uint64_t frame_number)
+{
+	PROFILE_SCOPE("Stream assets");
+
+	this->frame_number   = frame_number;
+	stats.uploaded_count = 0;
+	stats.uploaded_bytes = 0;
+	stats.evicted_count  = 0;
+
+	collect_decodes();
+	collect_uploads();
+	start_decodes();
+	upload_decoded();
+	evict_unused();
+
+	stats.queued_count         = 0;
+	stats.pending_upload_count = 0;
+	stats.decoding_count       = static_cast<uint32_t>(decoding.size());
+	for (const std::unique_ptr<Stream_request>& request : requests)
+	{
+		Stream_state state = request->state.load(std::memory_order_relaxed);
+		stats.queued_count += state == Stream_state::queued;
+		stats.pending_upload_count += state == Stream_state::decoded;
+	}
+
+	if (stats.queued_count + stats.decoding_count + stats.pending_upload_count + stats.uploaded_count + stats.evicted_count > 0)
+	{
+		SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
+		             "Streaming: %u queued, %u decoding, %u waiting to upload, %u uploaded (%.2f MiB), %u evicted, %.2f MiB resident.",
+		             stats.queued_count,
+		             stats.decoding_count,
+		             stats.pending_upload_count,
+		             stats.uploaded_count,
+		             to_mib(stats.uploaded_bytes),
+		             stats.evicted_count,
+		             to_mib(stats.resident_bytes));
+	}
+}
+
+const Stream_stats& Asset_streamer::get_stats() const
+{
+	return stats;
+}
+
+void Asset_streamer::start_decodes()
+{
+	// Few decodes in flight keep the workers free for frame jobs, the main thread may pick them up while it waits
+	for (size_t queue = 0; queue < static_cast<size_t>(Stream_priority::count) && decoding.size() < STREAM_MAX_DECODES; queue++)
+	{
+		while (!decode_queues[queue].empty() && decoding.size() < STREAM_MAX_DECODES)
+		{
+			Stream_handle   stream  = decode_queues[queue].front();
+			Stream_request* request = requests[stream].get();
+			decode_queues[queue].pop_front();
+
+			if (request->state.load(std::memory_order_relaxed) != Stream_state::queued || static_cast<size_t>(request->priority) != queue)
+			{
+				continue;
+			}
+
+			// Released before it was ever decoded, a later request queues it again
+			if (request->references == 0)
+			{
+				request->state.store(Stream_state::unloaded, std::memory_order_relaxed);
+				continue;
+			}
+
+			request->state.store(Stream_state::decoding, std::memory_order_relaxed);
+			decoding.push_back(stream);
+			job_system->run([this, request]() { decode(*request); }, &decode_counter);
+		}
+	}
+}
+
+void Asset_streamer::collect_decodes()
+{
+	for (size_t i = 0; i < decoding.size();)
+	{
+		Stream_request& request = *requests[decoding[i]];
+		Stream_state    state   = request.state.load(std::memory_order_acquire);
+
+		if (state == Stream_state::decoded)
+		{
+			upload_queues[static_cast<size_t>(request.priority)].push_back(decoding[i]);
+		}
+		else if (state == Stream_state::failed)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to stream mesh %s, keeping its placeholder.", request.path.c_str());
+		}
+		else
+		{
+			i++;
+			continue;
+		}
+
+		decoding[i] = decoding.back();
+		decoding.pop_back();
+	}
+}
+
+void Asset_streamer::upload_decoded()
+{
+	// One upload always goes through, so a mesh larger than the budget is not starved
+	for (size_t queue = 0; queue < static_cast<size_t>(Stream_priority::count); queue++)
+	{
+		while (!upload_queues[queue].empty())
+		{
+			Stream_handle   stream  = upload_queues[queue].front();
+			Stream_request& request = *requests[stream];
+			if (stats.uploaded_count > 0 && stats.uploaded_bytes + request.size > upload_budget)
+			{
+				return;
+			}
+			upload_queues[queue].pop_front();
+
+			if (request.references == 0)
+			{
+				request.state.store(Stream_state::unloaded, std::memory_order_relaxed);
+			}
+			else if (render_manager->upload_mesh(request.mesh, request.vertices, request.indices))
+			{
+				request.state.store(Stream_state::uploading, std::memory_order_relaxed);
+				uploading.push_back(stream);
+				stats.uploaded_count++;
+				stats.uploaded_bytes += request.size;
+				stats.resident_bytes += request.size;
+			}
+			else
+			{
+				request.state.store(Stream_state::failed, std::memory_order_relaxed);
+			}
+
+			request.vertices = {};
+			request.indices  = {};
+		}
+	}
+}
+
+void Asset_streamer::collect_uploads()
+{
+	for (size_t i = 0; i < uploading.size();)
+	{
+		Stream_request& request = *requests[uploading[i]];
+		if (!render_manager->is_mesh_resident(request.mesh))
+		{
+			i++;
+			continue;
+		}
+
+		request.state.store(Stream_state::resident, std::memory_order_relaxed);
+		uploading[i] = uploading.back();
+		uploading.pop_back();
+	}
+}
+
+void Asset_streamer::evict_unused()
+{
+	if (stats.resident_bytes <= memory_budget)
+	{
+		return;
+	}
+
+	std::vector<Stream_request*> candidates;
+	for (const std::unique_ptr<Stream_request>& request : requests)
+	{
+		if (request->references == 0 && request->state.load(std::memory_order_relaxed) == Stream_state::resident)
+		{
+			candidates.push_back(request.get());
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Stream_request* a, const Stream_request* b) { return a->last_used_frame < b->last_used_frame; });
+
+	// Referenced meshes are never evicted, so the budget can be overrun while everything resident is in use
+	for (Stream_request* request : candidates)
+	{
+		if (stats.resident_bytes <= memory_budget)
+		{
+			break;
+		}
+
+		render_manager->unload_mesh(request->mesh);
+		request->state.store(Stream_state::unloaded, std::memory_order_relaxed);
+		stats.resident_bytes -= request->size;
+		stats.evicted_count++;
+	}
+}
+
+void Asset_streamer::decode(Stream_request& request) const
+{
+	PROFILE_SCOPE("Decode mesh");
+
+	std::vector<char> data;
+	Mesh_file_header  header = {};
+
+	bool loaded = (archive && archive->is_open() && archive->read(request.path, data)) || read_file(request.path, data);
+	if (loaded && data.size() >= sizeof(header))
+	{
+		std::memcpy(&header, data.data(), sizeof(header));
+	}
+
+	uint64_t vertex_size = uint64_t(header.vertex_count) * sizeof(Vertex);
+	uint64_t index_size  = uint64_t(header.index_count) * sizeof(uint32_t);
+	if (!loaded || header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION || header.index_count == 0 || data.size() != sizeof(header) + vertex_size + index_size)
+	{
+		request.state.store(Stream_state::failed, std::memory_order_release);
+		return;
+	}
+
+	request.vertices.resize(header.vertex_count);
+	request.indices.resize(header.index_count);
+	std::memcpy(request.vertices.data(), data.data() + sizeof(header), vertex_size);
+	std::memcpy(request.indices.data(), data.data() + sizeof(header) + vertex_size, index_size);
+
+	// An index past the vertex data would read outside the buffer on the GPU
+	for (uint32_t index : request.indices)
+	{
+		if (index >= header.vertex_count)
+		{
+			request.vertices = {};
+			request.indices  = {};
+			request.state.store(Stream_state::failed, std::memory_order_release);
+			return;
+		}
+	}
+
+	request.size = vertex_size + index_size;
+	request.state.store(Stream_state::decoded, std::memory_order_release);
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "core/asset_archive.hpp"
+#include "core/job_system.hpp"
+#include "graphics/mesh.hpp"
+
+
+class Render_manager;
+
+
+using Stream_handle = uint32_t;
+
+constexpr Stream_handle INVALID_STREAM    = UINT32_MAX;
+constexpr uint32_t      MESH_FILE_MAGIC   = 0x48534d44; // "DMSH"
+constexpr uint32_t      MESH_FILE_VERSION = 1;
+
+
+enum class Stream_priority : uint32_t
+{
+	critical,
+	high,
+	normal,
+	low,
+	count,
+};
+
+// A streamed mesh file is this header followed by vertex_count vertices and index_count 32 bit indices
+struct Mesh_file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertex_count;
+	uint32_t index_count;
+};
+
+// Queue depths are current, the upload and eviction counts cover the last update only
+struct Stream_stats
+{
+	uint32_t queued_count         = 0;
+	uint32_t decoding_count       = 0;
+	uint32_t pending_upload_count = 0;
+	uint32_t uploaded_count       = 0;
+	uint64_t uploaded_bytes       = 0;
+	uint32_t evicted_count        = 0;
+	uint64_t resident_bytes       = 0;
+};
+
+// Streams meshes in the background. Requests are decoded on the job system in priority order, uploaded under a
+// per-frame byte budget, and drawn as a placeholder until resident. Unreferenced meshes are evicted least recently
+// used first once the resident total passes the memory budget.
+class Asset_streamer
+{
+public:
+
+	void startup(Render_manager& render_manager, Job_system& job_system, const Asset_archive* asset_archive, uint64_t upload_budget, uint64_t memory_budget);
+	void shutdown();
+
+	// Repeated requests for the same path share one entry, a higher priority moves a queued request forward
+	Stream_handle request_mesh(const std::string& path, Stream_priority priority = Stream_priority::normal);
+	void          release(Stream_handle stream);
+	void          touch(Stream_handle stream);
+
+	// Valid from the request on, the mesh draws as its placeholder until the streamed data is resident
+	Mesh_handle get_mesh(Stream_handle stream) const;
+	bool        is_resident(Stream_handle stream) const;
+
+	// Call once per frame before the renderer flushes its uploads
+	void update(uint64_t frame_number);
+
+	const Stream_stats& get_stats() const;
+
+private:
+
+	enum class Stream_state : uint32_t
+	{
+		unloaded,
+		queued,
+		decoding,
+		decoded,
+		uploading,
+		resident,
+		failed,
+	};
+
+	// Decode jobs write the vertex data and then publish it through state, the main thread owns everything else
+	struct Stream_request
+	{
+		std::string               path;
+		Mesh_handle               mesh            = INVALID_MESH;
+		Stream_priority           priority        = Stream_priority::normal;
+		std::atomic<Stream_state> state           = Stream_state::unloaded;
+		uint32_t                  references      = 0;
+		uint64_t                  last_used_frame = 0;
+		uint64_t                  size            = 0;
+		std::vector<Vertex>       vertices;
+		std::vector<uint32_t>     indices;
+	};
+
+	Render_manager*                                render_manager = nullptr;
+	Job_system*                                    job_system     = nullptr;
+	const Asset_archive*                           archive        = nullptr;
+	uint64_t                                       upload_budget  = 0;
+	uint64_t                                       memory_budget  = 0;
+	uint64_t                                       frame_number   = 0;
+	std::vector<std::unique_ptr<Stream_request>>   requests;
+	std::unordered_map<std::string, Stream_handle> request_lookup;
+	std::deque<Stream_handle>                      decode_queues[static_cast<size_t>(Stream_priority::count)];
+	std::deque<Stream_handle>                      upload_queues[static_cast<size_t>(Stream_priority::count)];
+	std::vector<Stream_handle>                     decoding;
+	std::vector<Stream_handle>                     uploading;
+	Job_counter                                    decode_counter;
+	Stream_stats                                   stats;
+
+	void start_decodes();
+	void collect_decodes();
+	void collect_uploads();
+	void upload_decoded();
+	void evict_unused();
+	void decode(Stream_request& request) const;
+};
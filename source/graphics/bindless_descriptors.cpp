@@ -0,0 +1,291 @@
+#include "bindless_descriptors.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+#include "config/application.hpp"
+
+
+constexpr uint32_t BINDLESS_TYPE_COUNT = static_cast<uint32_t>(Bindless_type::count);
+
+constexpr VkDescriptorType BINDLESS_DESCRIPTOR_TYPES[BINDLESS_TYPE_COUNT] = {
+    VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_SAMPLER,
+};
+
+// Descriptors outside the bindless set that the shared pipeline layout makes visible to the same stages
+constexpr uint32_t BINDLESS_RESERVED_STAGE_RESOURCES = 16;
+
+
+bool Bindless_descriptors::startup(VkDevice logical_device, VkPhysicalDevice physical_device)
+{
+	device = logical_device;
+
+	VkPhysicalDeviceVulkan12Properties vulkan_12_properties = {};
+	vulkan_12_properties.sType                              = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+	VkPhysicalDeviceProperties2 properties = {};
+	properties.sType                       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext                       = &vulkan_12_properties;
+	vkGetPhysicalDeviceProperties2(physical_device, &properties);
+
+	// Every stage sees the whole set, so the per stage limits bound the arrays as much as the per set ones
+	slot_arrays[static_cast<size_t>(Bindless_type::sampled_image)].capacity = std::min({BINDLESS_MAX_SAMPLED_IMAGES,
+	                                                                                     vulkan_12_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+	                                                                                     vulkan_12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+	slot_arrays[static_cast<size_t>(Bindless_type::storage_buffer)].capacity = std::min({BINDLESS_MAX_STORAGE_BUFFERS,
+	                                                                                      vulkan_12_properties.maxDescriptorSetUpdateAfterBindStorageBuffers,
+	                                                                                      vulkan_12_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+	slot_arrays[static_cast<size_t>(Bindless_type::sampler)].capacity = std::min({BINDLESS_MAX_SAMPLERS,
+	                                                                               vulkan_12_properties.maxDescriptorSetUpdateAfterBindSamplers,
+	                                                                               vulkan_12_properties.maxPerStageDescriptorUpdateAfterBindSamplers});
+
+	// The arrays together count against the per stage resource limit, which is often lower than their sum. Scale them
+	// down alike and leave room for the instance set bound next to them.
+	uint32_t total_capacity = 0;
+	for (const Slot_array& slot_array : slot_arrays)
+	{
+		total_capacity += slot_array.capacity;
+	}
+	uint32_t stage_capacity = vulkan_12_properties.maxPerStageUpdateAfterBindResources > BINDLESS_RESERVED_STAGE_RESOURCES
+	                            ? vulkan_12_properties.maxPerStageUpdateAfterBindResources - BINDLESS_RESERVED_STAGE_RESOURCES
+	                            : 0;
+	if (total_capacity > stage_capacity)
+	{
+		for (Slot_array& slot_array : slot_arrays)
+		{
+			slot_array.capacity = static_cast<uint32_t>(static_cast<uint64_t>(slot_array.capacity) * stage_capacity / total_capacity);
+		}
+	}
+
+	for (const Slot_array& slot_array : slot_arrays)
+	{
+		if (slot_array.capacity == 0)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "The device's update after bind limits leave no room for bindless descriptors.");
+			return false;
+		}
+	}
+
+	// Slots are written while frames that bound the set are still in flight, and most of them are never written at all
+	VkDescriptorSetLayoutBinding bindings[BINDLESS_TYPE_COUNT]      = {};
+	VkDescriptorBindingFlags     binding_flags[BINDLESS_TYPE_COUNT] = {};
+	VkDescriptorPoolSize         pool_sizes[BINDLESS_TYPE_COUNT]    = {};
+	for (uint32_t i = 0; i < BINDLESS_TYPE_COUNT; i++)
+	{
+		bindings[i].binding           = i;
+		bindings[i].descriptorType    = BINDLESS_DESCRIPTOR_TYPES[i];
+		bindings[i].descriptorCount   = slot_arrays[i].capacity;
+		bindings[i].stageFlags        = VK_SHADER_STAGE_ALL;
+		binding_flags[i]              = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+		pool_sizes[i].type            = BINDLESS_DESCRIPTOR_TYPES[i];
+		pool_sizes[i].descriptorCount = slot_arrays[i].capacity;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info = {};
+	binding_flags_info.sType                                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	binding_flags_info.bindingCount                                = BINDLESS_TYPE_COUNT;
+	binding_flags_info.pBindingFlags                               = binding_flags;
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.pNext                           = &binding_flags_info;
+	layout_info.flags                           = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layout_info.bindingCount                    = BINDLESS_TYPE_COUNT;
+	layout_info.pBindings                       = bindings;
+
+	if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &set_layout) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create bindless descriptor set layout.");
+		return false;
+	}
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.flags                      = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	pool_info.maxSets                    = 1;
+	pool_info.poolSizeCount              = BINDLESS_TYPE_COUNT;
+	pool_info.pPoolSizes                 = pool_sizes;
+
+	if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create bindless descriptor pool.");
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool              = descriptor_pool;
+	allocate_info.descriptorSetCount          = 1;
+	allocate_info.pSetLayouts                 = &set_layout;
+
+	if (vkAllocateDescriptorSets(device, &allocate_info, &descriptor_set) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate the bindless descriptor set.");
+		return false;
+	}
+
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+	            "Bindless descriptors: %u sampled images, %u storage buffers, %u samplers.",
+	            slot_arrays[static_cast<size_t>(Bindless_type::sampled_image)].capacity,
+	            slot_arrays[static_cast<size_t>(Bindless_type::storage_buffer)].capacity,
+	            slot_arrays[static_cast<size_t>(Bindless_type::sampler)].capacity);
+
+	return true;
+}
+
+void Bindless_descriptors::shutdown()
+{
+	if (device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	// Destroying the pool frees the set with it. Either may be missing when startup failed halfway
+	vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, set_layout, nullptr);
+
+	for (Slot_array& slot_array : slot_arrays)
+	{
+		slot_array = {};
+	}
+	retired_slots.clear();
+
+	descriptor_set  = VK_NULL_HANDLE;
+	descriptor_pool = VK_NULL_HANDLE;
+	set_layout      = VK_NULL_HANDLE;
+	device          = VK_NULL_HANDLE;
+}
+
+Bindless_handle Bindless_descriptors::register_image(VkImageView image_view, VkImageLayout image_layout)
+{
+	Bindless_handle handle = allocate_slot(Bindless_type::sampled_image);
+	if (handle == INVALID_BINDLESS_HANDLE)
+	{
+		return INVALID_BINDLESS_HANDLE;
+	}
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.imageView             = image_view;
+	image_info.imageLayout           = image_layout;
+
+	write(Bindless_type::sampled_image, handle, &image_info, nullptr);
+	return handle;
+}
+
+Bindless_handle Bindless_descriptors::register_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	Bindless_handle handle = allocate_slot(Bindless_type::storage_buffer);
+	if (handle == INVALID_BINDLESS_HANDLE)
+	{
+		return INVALID_BINDLESS_HANDLE;
+	}
+
+	VkDescriptorBufferInfo buffer_info = {};
+	buffer_info.buffer                 = buffer;
+	buffer_info.offset                 = offset;
+	buffer_info.range                  = range;
+
+	write(Bindless_type::storage_buffer, handle, nullptr, &buffer_info);
+	return handle;
+}
+
+Bindless_handle Bindless_descriptors::register_sampler(VkSampler sampler)
+{
+	Bindless_handle handle = allocate_slot(Bindless_type::sampler);
+	if (handle == INVALID_BINDLESS_HANDLE)
+	{
+		return INVALID_BINDLESS_HANDLE;
+	}
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.sampler               = sampler;
+
+	write(Bindless_type::sampler, handle, &image_info, nullptr);
+	return handle;
+}
+
+void Bindless_descriptors::release(Bindless_type type, Bindless_handle handle, uint64_t timeline_value)
+{
+	if (handle == INVALID_BINDLESS_HANDLE || type == Bindless_type::count)
+	{
+		return;
+	}
+
+	retired_slots.push_back({type, handle, timeline_value});
+}
+
+void Bindless_descriptors::release_retired(uint64_t completed_value)
+{
+	// The slot keeps its stale descriptor until it is handed out again, partially bound arrays allow that as long as
+	// no shader reads it, and a shader only reads the slots of live handles
+	for (size_t i = 0; i < retired_slots.size();)
+	{
+		const Retired_slot& retired = retired_slots[i];
+		if (completed_value < retired.timeline_value)
+		{
+			i++;
+			continue;
+		}
+
+		slot_arrays[static_cast<size_t>(retired.type)].free_slots.push_back(retired.handle);
+		retired_slots[i] = retired_slots.back();
+		retired_slots.pop_back();
+	}
+}
+
+void Bindless_descriptors::bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout, VkPipelineBindPoint bind_point) const
+{
+	vkCmdBindDescriptorSets(command_buffer, bind_point, pipeline_layout, BINDLESS_SET, 1, &descriptor_set, 0, nullptr);
+}
+
+VkDescriptorSetLayout Bindless_descriptors::get_set_layout() const
+{
+	return set_layout;
+}
+
+uint32_t Bindless_descriptors::get_capacity(Bindless_type type) const
+{
+	return type == Bindless_type::count ? 0 : slot_arrays[static_cast<size_t>(type)].capacity;
+}
+
+Bindless_handle Bindless_descriptors::allocate_slot(Bindless_type type)
+{
+	if (descriptor_set == VK_NULL_HANDLE)
+	{
+		return INVALID_BINDLESS_HANDLE;
+	}
+
+	// Recycled slots first, so the handles stay dense and small
+	Slot_array& slot_array = slot_arrays[static_cast<size_t>(type)];
+	if (!slot_array.free_slots.empty())
+	{
+		Bindless_handle handle = slot_array.free_slots.back();
+		slot_array.free_slots.pop_back();
+		return handle;
+	}
+
+	if (slot_array.next_slot == slot_array.capacity)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "The bindless %s array is full.", type == Bindless_type::sampled_image ? "image" : type == Bindless_type::storage_buffer ? "buffer" : "sampler");
+		return INVALID_BINDLESS_HANDLE;
+	}
+
+	return slot_array.next_slot++;
+}
+
+void Bindless_descriptors::write(Bindless_type type, Bindless_handle handle, const VkDescriptorImageInfo* image_info, const VkDescriptorBufferInfo* buffer_info)
+{
+	VkWriteDescriptorSet write_set = {};
+	write_set.sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_set.dstSet               = descriptor_set;
+	write_set.dstBinding           = static_cast<uint32_t>(type);
+	write_set.dstArrayElement      = handle;
+	write_set.descriptorCount      = 1;
+	write_set.descriptorType       = BINDLESS_DESCRIPTOR_TYPES[static_cast<size_t>(type)];
+	write_set.pImageInfo           = image_info;
+	write_set.pBufferInfo          = buffer_info;
+
+	vkUpdateDescriptorSets(device, 1, &write_set, 0, nullptr);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+
+using Bindless_handle = uint32_t;
+
+constexpr Bindless_handle INVALID_BINDLESS_HANDLE = UINT32_MAX;
+constexpr uint32_t        BINDLESS_SET            = 1;
+
+// One array per type, the binding of each is its value. Matches bindless.glsl.
+enum class Bindless_type : uint8_t
+{
+	sampled_image,
+	storage_buffer,
+	sampler,
+	count
+};
+
+// Matches the push constants in bindless.glsl, how a draw names the resources it reads
+struct Draw_resources
+{
+	Bindless_handle texture_handle = 0;
+	Bindless_handle sampler_handle = 0;
+	Bindless_handle buffer_handle  = 0;
+	uint32_t        padding        = 0;
+};
+
+// One update-after-bind descriptor set with an array each of sampled images, storage buffers and samplers. Shaders
+// index the arrays with handles, so the set is bound once per command buffer rather than per draw, and registering a
+// resource writes a slot no frame in flight reads instead of allocating a set. A released slot is handed out again only
+// once every frame that could still read it has retired.
+class Bindless_descriptors
+{
+public:
+
+	// The device needs the descriptor indexing features for update after bind and partially bound runtime arrays.
+	// On failure call shutdown, the renderer then carries on without the set
+	bool startup(VkDevice device, VkPhysicalDevice physical_device);
+	void shutdown();
+
+	// INVALID_BINDLESS_HANDLE when the array is full
+	Bindless_handle register_image(VkImageView image_view, VkImageLayout image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	Bindless_handle register_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	Bindless_handle register_sampler(VkSampler sampler);
+
+	// The slot is reused once the timeline reaches the value of the last submission that may read it. The resource
+	// itself has to stay alive until then too, same as without bindless
+	void release(Bindless_type type, Bindless_handle handle, uint64_t timeline_value);
+
+	// Call before recording, with the value the timeline has completed
+	void release_retired(uint64_t completed_value);
+
+	// Bind points keep their own sets, so a command buffer that culls and draws binds the set at both
+	void                  bind(VkCommandBuffer command_buffer, VkPipelineLayout pipeline_layout, VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+	VkDescriptorSetLayout get_set_layout() const;
+	uint32_t              get_capacity(Bindless_type type) const;
+
+private:
+
+	struct Slot_array
+	{
+		std::vector<Bindless_handle> free_slots;
+		uint32_t                     next_slot = 0;
+		uint32_t                     capacity  = 0;
+	};
+
+	struct Retired_slot
+	{
+		Bindless_type   type           = Bindless_type::sampled_image;
+		Bindless_handle handle         = INVALID_BINDLESS_HANDLE;
+		uint64_t        timeline_value = 0;
+	};
+
+	VkDevice                  device          = VK_NULL_HANDLE;
+	VkDescriptorSetLayout     set_layout      = VK_NULL_HANDLE;
+	VkDescriptorPool          descriptor_pool = VK_NULL_HANDLE;
+	VkDescriptorSet           descriptor_set  = VK_NULL_HANDLE;
+	std::vector<Retired_slot> retired_slots;
+
+	Slot_array slot_arrays[static_cast<size_t>(Bindless_type::count)];
+
+	Bindless_handle allocate_slot(Bindless_type type);
+	void            write(Bindless_type type, Bindless_handle handle, const VkDescriptorImageInfo* image_info, const VkDescriptorBufferInfo* buffer_info);
+};
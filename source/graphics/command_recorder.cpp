@@ -0,0 +1,148 @@
+#include "command_recorder.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+
+bool Command_recorder::startup(VkDevice logical_device, uint32_t queue_family_index, uint32_t frames_in_flight, Job_system& jobs)
+{
+	device     = logical_device;
+	job_system = &jobs;
+
+	// One set of pools per job system worker, a pool is only ever touched by the thread that owns it
+	worker_count = job_system->get_worker_count();
+	worker_frames.resize(worker_count + 1);
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	pool_info.queueFamilyIndex        = queue_family_index;
+
+	for (std::vector<Worker_frame>& frames : worker_frames)
+	{
+		frames.resize(frames_in_flight);
+
+		for (Worker_frame& frame : frames)
+		{
+			if (vkCreateCommandPool(device, &pool_info, nullptr, &frame.command_pool) != VK_SUCCESS)
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create worker command pool.");
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void Command_recorder::shutdown()
+{
+	for (std::vector<Worker_frame>& frames : worker_frames)
+	{
+		for (Worker_frame& frame : frames)
+		{
+			vkDestroyCommandPool(device, frame.command_pool, nullptr);
+		}
+	}
+	worker_frames.clear();
+	worker_count = 0;
+	job_system   = nullptr;
+}
+
+void Command_recorder::begin_frame(uint32_t frame_index)
+{
+	// The frame's timeline value has been reached, so every buffer from its pools can be recycled in one go
+	for (std::vector<Worker_frame>& frames : worker_frames)
+	{
+		Worker_frame& frame = frames[frame_index];
+		vkResetCommandPool(device, frame.command_pool, 0);
+		frame.used_count = 0;
+	}
+}
+
+void Command_recorder::record(uint32_t                              frame_index,
+                              const VkCommandBufferInheritanceInfo& inheritance_info,
+                              size_t                                item_count,
+                              const Record_function&                record_function,
+                              std::vector<VkCommandBuffer>&         secondary_buffers)
+{
+	size_t chunk_count = std::min<size_t>(worker_count, item_count);
+	if (chunk_count == 0)
+	{
+		return;
+	}
+
+	size_t first_output = secondary_buffers.size();
+	secondary_buffers.resize(first_output + chunk_count);
+
+	job_system->parallel_for(chunk_count,
+	                         1,
+	                         [&](size_t first_chunk, size_t last_chunk)
+	                         {
+		                         uint32_t worker_index = Job_system::get_worker_index();
+
+		                         std::unique_lock<std::mutex> outside_lock(outside_mutex, std::defer_lock);
+		                         if (worker_index >= worker_count)
+		                         {
+			                         worker_index = worker_count;
+			                         outside_lock.lock();
+		                         }
+
+		                         for (size_t chunk = first_chunk; chunk < last_chunk; chunk++)
+		                         {
+			                         // Contiguous, evenly sized chunks keep the draws in submission order across buffers
+			                         size_t first = item_count * chunk / chunk_count;
+			                         size_t last  = item_count * (chunk + 1) / chunk_count;
+
+			                         VkCommandBuffer command_buffer = acquire_command_buffer(worker_index, frame_index);
+
+			                         VkCommandBufferBeginInfo begin_info = {};
+			                         begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			                         begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			                         begin_info.pInheritanceInfo         = &inheritance_info;
+
+			                         if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+			                         {
+				                         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to begin recording secondary command buffer.");
+			                         }
+
+			                         record_function(command_buffer, first, last);
+
+			                         if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+			                         {
+				                         SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to record secondary command buffer.");
+			                         }
+
+			                         // Each chunk writes only its own slot, so no lock is needed
+			                         secondary_buffers[first_output + chunk] = command_buffer;
+		                         }
+	                         });
+}
+
+uint32_t Command_recorder::get_worker_count() const
+{
+	return worker_count;
+}
+
+VkCommandBuffer Command_recorder::acquire_command_buffer(uint32_t worker_index, uint32_t frame_index)
+{
+	Worker_frame& frame = worker_frames[worker_index][frame_index];
+
+	if (frame.used_count == frame.command_buffers.size())
+	{
+		VkCommandBufferAllocateInfo alloc_info = {};
+		alloc_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.commandPool                 = frame.command_pool;
+		alloc_info.level                       = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		alloc_info.commandBufferCount          = 1;
+
+		VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+		if (vkAllocateCommandBuffers(device, &alloc_info, &command_buffer) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate secondary command buffer.");
+		}
+		frame.command_buffers.push_back(command_buffer);
+	}
+
+	return frame.command_buffers[frame.used_count++];
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/job_system.hpp"
+
+
+using Record_function = std::function<void(VkCommandBuffer command_buffer, size_t first, size_t last)>;
+
+class Command_recorder
+{
+public:
+
+	bool startup(VkDevice device, uint32_t queue_family_index, uint32_t frames_in_flight, Job_system& job_system);
+	void shutdown();
+
+	void     begin_frame(uint32_t frame_index);
+	void     record(uint32_t frame_index, const VkCommandBufferInheritanceInfo& inheritance_info, size_t item_count, const Record_function& record_function, std::vector<VkCommandBuffer>& secondary_buffers);
+	uint32_t get_worker_count() const;
+
+private:
+
+	struct Worker_frame
+	{
+		VkCommandPool                command_pool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> command_buffers;
+		uint32_t                     used_count = 0;
+	};
+
+	VkDevice                               device       = VK_NULL_HANDLE;
+	Job_system*                            job_system   = nullptr;
+	uint32_t                               worker_count = 0;
+	std::vector<std::vector<Worker_frame>> worker_frames;
+
+	// Threads outside the job system can pick up a chunk while they help in wait_for, they share the last set of pools
+	std::mutex outside_mutex;
+
+	VkCommandBuffer acquire_command_buffer(uint32_t worker_index, uint32_t frame_index);
+};
@@ -0,0 +1,162 @@
+#include "compute_queue.hpp"
+
+#include <SDL3/SDL_log.h>
+
+#include "core/profiler.hpp"
+
+
+constexpr size_t MAX_COMPUTE_WAITS = 8;
+
+
+bool Compute_queue::startup(VkDevice logical_device, VkQueue compute_queue, uint32_t queue_family, bool async_queue)
+{
+	device = logical_device;
+	queue  = compute_queue;
+	family = queue_family;
+	async  = async_queue;
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	pool_info.queueFamilyIndex        = family;
+
+	if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create compute command pool.");
+		return false;
+	}
+
+	return timeline.startup(device);
+}
+
+void Compute_queue::shutdown()
+{
+	// The caller has waited for the device to go idle, so every submission is done
+	timeline.shutdown();
+	vkDestroyCommandPool(device, command_pool, nullptr);
+
+	command_pool = VK_NULL_HANDLE;
+	in_flight.clear();
+	free_command_buffers.clear();
+}
+
+VkCommandBuffer Compute_queue::begin()
+{
+	retire();
+
+	VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+	if (!free_command_buffers.empty())
+	{
+		command_buffer = free_command_buffers.back();
+		free_command_buffers.pop_back();
+	}
+	else
+	{
+		VkCommandBufferAllocateInfo allocate_info = {};
+		allocate_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocate_info.commandPool                 = command_pool;
+		allocate_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocate_info.commandBufferCount          = 1;
+
+		if (vkAllocateCommandBuffers(device, &allocate_info, &command_buffer) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate compute command buffer.");
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(command_buffer, &begin_info);
+
+	return command_buffer;
+}
+
+uint64_t Compute_queue::submit(VkCommandBuffer command_buffer, std::span<const Timeline_wait> waits)
+{
+	PROFILE_SCOPE("Submit compute");
+
+	if (waits.size() > MAX_COMPUTE_WAITS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Compute submission waits on %zu timelines, at most %zu are supported.", waits.size(), MAX_COMPUTE_WAITS);
+		return 0;
+	}
+
+	if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to record compute command buffer.");
+		free_command_buffers.push_back(command_buffer);
+		return 0;
+	}
+
+	VkSemaphore          wait_semaphores[MAX_COMPUTE_WAITS] = {};
+	uint64_t             wait_values[MAX_COMPUTE_WAITS]     = {};
+	VkPipelineStageFlags wait_stages[MAX_COMPUTE_WAITS]     = {};
+	for (size_t i = 0; i < waits.size(); i++)
+	{
+		wait_semaphores[i] = waits[i].semaphore;
+		wait_values[i]     = waits[i].value;
+		wait_stages[i]     = waits[i].stage_mask;
+	}
+
+	uint64_t    signal_value     = timeline.get_next_value();
+	VkSemaphore signal_semaphore = timeline.get_semaphore();
+
+	VkTimelineSemaphoreSubmitInfo timeline_info = {};
+	timeline_info.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_info.waitSemaphoreValueCount       = static_cast<uint32_t>(waits.size());
+	timeline_info.pWaitSemaphoreValues          = wait_values;
+	timeline_info.signalSemaphoreValueCount     = 1;
+	timeline_info.pSignalSemaphoreValues        = &signal_value;
+
+	VkSubmitInfo submit_info         = {};
+	submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.pNext                = &timeline_info;
+	submit_info.waitSemaphoreCount   = static_cast<uint32_t>(waits.size());
+	submit_info.pWaitSemaphores      = wait_semaphores;
+	submit_info.pWaitDstStageMask    = wait_stages;
+	submit_info.commandBufferCount   = 1;
+	submit_info.pCommandBuffers      = &command_buffer;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores    = &signal_semaphore;
+
+	// The value is only taken once the submit went through, nothing may wait on one that is never signalled
+	if (vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to submit compute command buffer.");
+		free_command_buffers.push_back(command_buffer);
+		return 0;
+	}
+
+	timeline.advance();
+	in_flight.push_back({command_buffer, signal_value});
+
+	return signal_value;
+}
+
+Gpu_timeline& Compute_queue::get_timeline()
+{
+	return timeline;
+}
+
+uint32_t Compute_queue::get_family() const
+{
+	return family;
+}
+
+bool Compute_queue::is_async() const
+{
+	return async;
+}
+
+void Compute_queue::retire()
+{
+	uint64_t completed_value = timeline.get_completed_value();
+	while (!in_flight.empty() && in_flight.front().value <= completed_value)
+	{
+		free_command_buffers.push_back(in_flight.front().command_buffer);
+		in_flight.pop_front();
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "graphics/gpu_timeline.hpp"
+
+
+// Compute work that runs beside the frame: particles, culling or post-processing recorded on its own queue. A
+// dedicated family maps to the async compute engines where the hardware has them, otherwise this is a second queue of
+// the graphics family or the graphics queue itself, and the work is still correct but no longer overlaps. Other queues
+// are ordered against it by timeline values only. Buffers it shares with graphics have to be created concurrent or
+// transferred between the families.
+class Compute_queue
+{
+public:
+
+	bool startup(VkDevice device, VkQueue queue, uint32_t queue_family, bool async);
+	void shutdown();
+
+	// A primary command buffer in the recording state, recycled once the timeline passes its submission
+	VkCommandBuffer begin();
+
+	// Returns the value the compute timeline reaches once the work is done, zero when it was not submitted
+	uint64_t submit(VkCommandBuffer command_buffer, std::span<const Timeline_wait> waits = {});
+
+	Gpu_timeline& get_timeline();
+	uint32_t      get_family() const;
+	bool          is_async() const;
+
+private:
+
+	struct Submission
+	{
+		VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+		uint64_t        value          = 0;
+	};
+
+	VkDevice                     device       = VK_NULL_HANDLE;
+	VkQueue                      queue        = VK_NULL_HANDLE;
+	uint32_t                     family       = 0;
+	bool                         async        = false;
+	VkCommandPool                command_pool = VK_NULL_HANDLE;
+	Gpu_timeline                 timeline;
+	std::deque<Submission>       in_flight;
+	std::vector<VkCommandBuffer> free_command_buffers;
+
+	void retire();
+};
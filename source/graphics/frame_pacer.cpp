@@ -0,0 +1,189 @@
+#include "frame_pacer.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+
+#include "config/application.hpp"
+#include "core/profiler.hpp"
+
+
+static const char* get_present_mode_name(Present_mode mode)
+{
+	switch (mode)
+	{
+	case Present_mode::fifo:
+		return "FIFO";
+	case Present_mode::fifo_relaxed:
+		return "relaxed FIFO";
+	case Present_mode::mailbox:
+		return "mailbox";
+	case Present_mode::immediate:
+		return "immediate";
+	}
+	return "unknown";
+}
+
+static double to_ms(uint64_t ns)
+{
+	return static_cast<double>(ns) / SDL_NS_PER_MS;
+}
+
+
+void Frame_pacer::startup(VkDevice device, bool present_wait, uint32_t frame_rate_limit, uint32_t max_queued_frames)
+{
+	this->device            = device;
+	this->max_queued_frames = max_queued_frames;
+	stats                   = {};
+
+	if (present_wait)
+	{
+		wait_for_present = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+	}
+	stats.measures_display = wait_for_present != nullptr;
+
+	set_frame_rate_limit(frame_rate_limit);
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Frame pacing %s present wait.", wait_for_present ? "uses" : "has no");
+}
+
+void Frame_pacer::shutdown()
+{
+	wait_for_present = nullptr;
+	pending_latencies.clear();
+	pending_input_ns = 0;
+}
+
+VkPresentModeKHR Frame_pacer::choose_present_mode(Present_mode requested, const std::vector<VkPresentModeKHR>& available_present_modes)
+{
+	static constexpr VkPresentModeKHR PRESENT_MODES[] = {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+
+	VkPresentModeKHR present_mode = PRESENT_MODES[static_cast<size_t>(requested)];
+	if (std::find(available_present_modes.begin(), available_present_modes.end(), present_mode) != available_present_modes.end())
+	{
+		return present_mode;
+	}
+
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "The surface has no %s presentation, falling back to FIFO.", get_present_mode_name(requested));
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+void Frame_pacer::set_frame_rate_limit(uint32_t frames_per_second)
+{
+	frame_interval_ns = frames_per_second > 0 ? SDL_NS_PER_SECOND / frames_per_second : 0;
+	next_frame_ns     = 0;
+}
+
+void Frame_pacer::reset_swapchain()
+{
+	waited_present_id = last_present_id;
+	pending_latencies.clear();
+}
+
+void Frame_pacer::record_input(uint64_t timestamp_ns)
+{
+	if (pending_input_ns == 0 || timestamp_ns < pending_input_ns)
+	{
+		pending_input_ns = timestamp_ns;
+	}
+}
+
+uint64_t Frame_pacer::next_present_id()
+{
+	return wait_for_present ? last_present_id + 1 : 0;
+}
+
+void Frame_pacer::mark_present(uint64_t present_id)
+{
+	uint64_t input_ns = pending_input_ns;
+	pending_input_ns  = 0;
+	if (present_id != 0)
+	{
+		last_present_id = present_id;
+	}
+
+	if (input_ns == 0)
+	{
+		return;
+	}
+
+	// Resolved in pace() once the presentation engine reports the frame displayed
+	if (present_id != 0)
+	{
+		pending_latencies.push_back({present_id, input_ns});
+	}
+	else
+	{
+		record_latency(SDL_GetTicksNS() - input_ns);
+	}
+}
+
+void Frame_pacer::pace(VkSwapchainKHR swap_chain)
+{
+	PROFILE_SCOPE("Frame pacing");
+
+	// The timeout keeps a surface that stopped presenting, a hidden window for one, from stalling the loop
+	if (wait_for_present && swap_chain != VK_NULL_HANDLE && last_present_id > waited_present_id + max_queued_frames)
+	{
+		uint64_t target_id = last_present_id - max_queued_frames;
+		VkResult result    = wait_for_present(device, swap_chain, target_id, PRESENT_WAIT_TIMEOUT_MS * SDL_NS_PER_MS);
+		if (result == VK_SUCCESS)
+		{
+			uint64_t displayed_ns = SDL_GetTicksNS();
+			waited_present_id     = target_id;
+			while (!pending_latencies.empty() && pending_latencies.front().present_id <= target_id)
+			{
+				record_latency(displayed_ns - pending_latencies.front().input_ns);
+				pending_latencies.pop_front();
+			}
+		}
+		else if (result != VK_TIMEOUT)
+		{
+			reset_swapchain();
+		}
+	}
+
+	if (frame_interval_ns == 0)
+	{
+		return;
+	}
+
+	// A late frame moves the schedule instead of letting the following frames catch up in a burst
+	uint64_t now_ns = SDL_GetTicksNS();
+	next_frame_ns += frame_interval_ns;
+	if (next_frame_ns <= now_ns)
+	{
+		next_frame_ns = now_ns;
+	}
+	else
+	{
+		SDL_DelayPrecise(next_frame_ns - now_ns);
+	}
+}
+
+const Frame_pacing_stats& Frame_pacer::get_stats() const
+{
+	return stats;
+}
+
+void Frame_pacer::record_latency(uint64_t latency_ns)
+{
+	stats.last_latency_ns    = latency_ns;
+	stats.average_latency_ns = stats.sample_count == 0 ? latency_ns : (stats.average_latency_ns * 15 + latency_ns) / 16;
+	stats.sample_count++;
+
+	window_max_ns = std::max(window_max_ns, latency_ns);
+	if (++window_count < LATENCY_REPORT_SAMPLES)
+	{
+		return;
+	}
+
+	stats.max_latency_ns = window_max_ns;
+	SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
+	             "Input to %s latency: %.2f ms average, %.2f ms worst of the last %u frames with input.",
+	             stats.measures_display ? "display" : "present",
+	             to_ms(stats.average_latency_ns),
+	             to_ms(window_max_ns),
+	             window_count);
+	window_max_ns = 0;
+	window_count  = 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+
+// FIFO waits for vertical blank, relaxed FIFO tears when a frame is late, mailbox replaces the queued frame and
+// immediate tears. FIFO is the only one every surface supports and what any other falls back to.
+enum class Present_mode : uint8_t
+{
+	fifo,
+	fifo_relaxed,
+	mailbox,
+	immediate
+};
+
+// Latency runs from the earliest input a frame picked up to the frame reaching the display, or to the present call
+// when the device cannot wait for presents, which leaves out the time spent in the presentation engine
+struct Frame_pacing_stats
+{
+	uint64_t last_latency_ns    = 0;
+	uint64_t average_latency_ns = 0;
+	uint64_t max_latency_ns     = 0;
+	uint32_t sample_count       = 0;
+	bool     measures_display   = false;
+};
+
+// Keeps the CPU from running ahead of the display. With VK_KHR_present_wait the next frame starts only once no more
+// than max_queued_frames presented frames are still waiting to be displayed, so input is sampled as late as possible;
+// a frame rate limit sleeps on top of that, and is all there is without present wait. Pacing happens at the end of
+// a frame, before the next round of input is polled.
+class Frame_pacer
+{
+public:
+
+	// present_wait: VK_KHR_present_id and VK_KHR_present_wait were enabled on the device
+	void startup(VkDevice device, bool present_wait, uint32_t frame_rate_limit, uint32_t max_queued_frames);
+	void shutdown();
+
+	static VkPresentModeKHR choose_present_mode(Present_mode requested, const std::vector<VkPresentModeKHR>& available_present_modes);
+
+	// Zero is unlimited
+	void set_frame_rate_limit(uint32_t frames_per_second);
+
+	// Ids presented to an old swapchain can never be waited for on the new one
+	void reset_swapchain();
+
+	// SDL event timestamps, they share the SDL_GetTicksNS clock
+	void record_input(uint64_t timestamp_ns);
+
+	// Zero when present wait is not in use, otherwise the id to chain into the present with VkPresentIdKHR
+	uint64_t next_present_id();
+	void     mark_present(uint64_t present_id);
+	void     pace(VkSwapchainKHR swap_chain);
+
+	const Frame_pacing_stats& get_stats() const;
+
+private:
+
+	struct Pending_latency
+	{
+		uint64_t present_id = 0;
+		uint64_t input_ns   = 0;
+	};
+
+	VkDevice                    device            = VK_NULL_HANDLE;
+	PFN_vkWaitForPresentKHR     wait_for_present  = nullptr;
+	uint32_t                    max_queued_frames = 1;
+	uint64_t                    frame_interval_ns = 0;
+	uint64_t                    next_frame_ns     = 0;
+	uint64_t                    last_present_id   = 0;
+	uint64_t                    waited_present_id = 0;
+	uint64_t                    pending_input_ns  = 0;
+	std::deque<Pending_latency> pending_latencies;
+	Frame_pacing_stats          stats;
+	uint64_t                    window_max_ns = 0;
+	uint32_t                    window_count  = 0;
+
+	void record_latency(uint64_t latency_ns);
+};
@@ -0,0 +1,404 @@
+#include "gpu_allocator.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+#include "config/application.hpp"
+
+
+static double to_mib(VkDeviceSize bytes)
+{
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+bool Gpu_allocator::startup(VkPhysicalDevice physical_device, VkDevice logical_device)
+{
+	device = logical_device;
+
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
+
+	VkPhysicalDeviceProperties device_properties;
+	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+	buffer_image_granularity = device_properties.limits.bufferImageGranularity;
+
+	return true;
+}
+
+void Gpu_allocator::shutdown()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (uint32_t type = 0; type < memory_properties.memoryTypeCount; type++)
+	{
+		for (const std::unique_ptr<Gpu_memory_block>& block : blocks[type])
+		{
+			if (!block->tlsf.is_empty())
+			{
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "GPU memory block of type %u still has %u live allocations at shutdown.", type, block->tlsf.get_allocation_count());
+			}
+			vkFreeMemory(device, block->memory, nullptr);
+		}
+		blocks[type].clear();
+	}
+
+	std::fill(std::begin(heap_stats), std::end(heap_stats), Gpu_heap_stats{});
+}
+
+bool Gpu_allocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, Gpu_allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Linear and optimal resources may share a block, so every allocation is padded out to the granularity
+	VkDeviceSize alignment = std::max(requirements.alignment, buffer_image_granularity);
+
+	for (uint32_t type = 0; type < memory_properties.memoryTypeCount; type++)
+	{
+		if ((requirements.memoryTypeBits & (1 << type)) && (memory_properties.memoryTypes[type].propertyFlags & properties) == properties)
+		{
+			if (allocate_from_type(type, requirements.size, alignment, allocation))
+			{
+				return true;
+			}
+		}
+	}
+
+	SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate %llu bytes of GPU memory.", static_cast<unsigned long long>(requirements.size));
+	return false;
+}
+
+void Gpu_allocator::free(Gpu_allocation& allocation)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	free_locked(allocation);
+}
+
+bool Gpu_allocator::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Gpu_allocation& allocation)
+{
+	VkBufferCreateInfo buffer_info = {};
+	buffer_info.sType              = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_info.size               = size;
+	buffer_info.usage              = usage;
+	buffer_info.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateBuffer(device, &buffer_info, nullptr, &buffer) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create buffer.");
+		return false;
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(device, buffer, &memory_requirements);
+
+	if (!allocate(memory_requirements, properties, allocation))
+	{
+		vkDestroyBuffer(device, buffer, nullptr);
+		buffer = VK_NULL_HANDLE;
+		return false;
+	}
+
+	vkBindBufferMemory(device, buffer, allocation.memory, allocation.offset);
+	return true;
+}
+
+void Gpu_allocator::destroy_buffer(VkBuffer& buffer, Gpu_allocation& allocation)
+{
+	vkDestroyBuffer(device, buffer, nullptr);
+	buffer = VK_NULL_HANDLE;
+	free(allocation);
+}
+
+bool Gpu_allocator::create_image(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties, VkImage& image, Gpu_allocation& allocation)
+{
+	if (vkCreateImage(device, &image_info, nullptr, &image) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create image.");
+		return false;
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vkGetImageMemoryRequirements(device, image, &memory_requirements);
+
+	if (!allocate(memory_requirements, properties, allocation))
+	{
+		vkDestroyImage(device, image, nullptr);
+		image = VK_NULL_HANDLE;
+		return false;
+	}
+
+	vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+	return true;
+}
+
+void Gpu_allocator::destroy_image(VkImage& image, Gpu_allocation& allocation)
+{
+	vkDestroyImage(device, image, nullptr);
+	image = VK_NULL_HANDLE;
+	free(allocation);
+}
+
+std::vector<Gpu_defragmentation_move> Gpu_allocator::begin_defragmentation(const std::vector<Gpu_allocation*>& allocations, VkDeviceSize max_bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::vector<Gpu_defragmentation_move> moves;
+	VkDeviceSize                          moved_bytes = 0;
+
+	for (uint32_t type = 0; type < memory_properties.memoryTypeCount; type++)
+	{
+		// Usage is snapshotted up front and data only ever moves towards fuller blocks, so a plan can never cycle
+		std::vector<std::pair<Gpu_memory_block*, VkDeviceSize>> block_usage;
+		for (const std::unique_ptr<Gpu_memory_block>& block : blocks[type])
+		{
+			if (!block->dedicated)
+			{
+				block_usage.emplace_back(block.get(), block->tlsf.get_used_size());
+			}
+		}
+
+		if (block_usage.size() < 2)
+		{
+			continue;
+		}
+
+		std::sort(block_usage.begin(), block_usage.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+
+		auto usage_of = [&](const Gpu_memory_block* block)
+		{
+			auto it = std::find_if(block_usage.begin(), block_usage.end(), [block](const auto& entry) { return entry.first == block; });
+			return it != block_usage.end() ? it->second : VkDeviceSize(0);
+		};
+
+		std::vector<Gpu_allocation*> candidates;
+		for (Gpu_allocation* allocation : allocations)
+		{
+			if (allocation->block && !allocation->block->dedicated && allocation->memory_type == type)
+			{
+				candidates.push_back(allocation);
+			}
+		}
+
+		// Emptiest blocks first, those are the ones that can be released once evacuated
+		std::sort(candidates.begin(), candidates.end(), [&](const Gpu_allocation* a, const Gpu_allocation* b) { return usage_of(a->block) < usage_of(b->block); });
+
+		for (Gpu_allocation* allocation : candidates)
+		{
+			if (moved_bytes + allocation->size > max_bytes)
+			{
+				return moves;
+			}
+
+			VkDeviceSize source_usage = usage_of(allocation->block);
+			for (const auto& [block, usage] : block_usage)
+			{
+				if (usage <= source_usage)
+				{
+					break;
+				}
+
+				Gpu_defragmentation_move move;
+				if (allocate_from_block(block, allocation->size, allocation->alignment, move.destination))
+				{
+					move.allocation = allocation;
+					moves.push_back(move);
+					moved_bytes += allocation->size;
+					break;
+				}
+			}
+		}
+	}
+
+	return moves;
+}
+
+void Gpu_allocator::end_defragmentation(std::vector<Gpu_defragmentation_move>& moves)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (Gpu_defragmentation_move& move : moves)
+	{
+		free_locked(*move.allocation);
+		*move.allocation = move.destination;
+	}
+
+	moves.clear();
+}
+
+Gpu_heap_stats Gpu_allocator::get_heap_stats(uint32_t heap_index) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return heap_stats[heap_index];
+}
+
+void Gpu_allocator::log_stats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (uint32_t heap = 0; heap < memory_properties.memoryHeapCount; heap++)
+	{
+		const Gpu_heap_stats& stats = heap_stats[heap];
+		if (stats.peak_live_bytes == 0)
+		{
+			continue;
+		}
+
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+		            "GPU heap %u: %.2f MiB live (peak %.2f MiB) in %u allocations, %.2f MiB reserved in %u blocks.",
+		            heap,
+		            to_mib(stats.live_bytes),
+		            to_mib(stats.peak_live_bytes),
+		            stats.allocation_count,
+		            to_mib(stats.block_bytes),
+		            stats.block_count);
+	}
+}
+
+VkDeviceSize Gpu_allocator::get_block_size(uint32_t memory_type) const
+{
+	// Small heaps, such as the 256 MiB BAR window, get smaller blocks so one block cannot claim most of the heap
+	VkDeviceSize heap_size = memory_properties.memoryHeaps[memory_properties.memoryTypes[memory_type].heapIndex].size;
+	return std::min<VkDeviceSize>(GPU_MEMORY_BLOCK_SIZE, heap_size / 8);
+}
+
+Gpu_memory_block* Gpu_allocator::create_block(uint32_t memory_type, VkDeviceSize size)
+{
+	VkMemoryAllocateInfo alloc_info = {};
+	alloc_info.sType                = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	alloc_info.allocationSize       = size;
+	alloc_info.memoryTypeIndex      = memory_type;
+
+	std::unique_ptr<Gpu_memory_block> block = std::make_unique<Gpu_memory_block>();
+	if (vkAllocateMemory(device, &alloc_info, nullptr, &block->memory) != VK_SUCCESS)
+	{
+		return nullptr;
+	}
+
+	// Host visible blocks stay mapped for their whole lifetime, mapping per allocation is not allowed to overlap
+	if (memory_properties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&block->mapped));
+	}
+
+	block->size        = size;
+	block->memory_type = memory_type;
+	block->tlsf.startup(size);
+
+	Gpu_heap_stats& stats = heap_stats[memory_properties.memoryTypes[memory_type].heapIndex];
+	stats.block_bytes += size;
+	stats.block_count++;
+
+	blocks[memory_type].push_back(std::move(block));
+	return blocks[memory_type].back().get();
+}
+
+void Gpu_allocator::destroy_block(Gpu_memory_block* block)
+{
+	Gpu_heap_stats& stats = heap_stats[memory_properties.memoryTypes[block->memory_type].heapIndex];
+	stats.block_bytes -= block->size;
+	stats.block_count--;
+
+	vkFreeMemory(device, block->memory, nullptr);
+
+	std::vector<std::unique_ptr<Gpu_memory_block>>& type_blocks = blocks[block->memory_type];
+	type_blocks.erase(std::find_if(type_blocks.begin(), type_blocks.end(), [block](const std::unique_ptr<Gpu_memory_block>& entry) { return entry.get() == block; }));
+}
+
+bool Gpu_allocator::allocate_from_type(uint32_t memory_type, VkDeviceSize size, VkDeviceSize alignment, Gpu_allocation& allocation)
+{
+	VkDeviceSize block_size = get_block_size(memory_type);
+
+	// Large resources get their own allocation rather than leaving most of a shared block stranded
+	if (size > block_size / 2)
+	{
+		Gpu_memory_block* block = create_block(memory_type, size);
+		if (!block)
+		{
+			return false;
+		}
+
+		block->dedicated = true;
+		return allocate_from_block(block, size, alignment, allocation);
+	}
+
+	for (const std::unique_ptr<Gpu_memory_block>& block : blocks[memory_type])
+	{
+		if (!block->dedicated && allocate_from_block(block.get(), size, alignment, allocation))
+		{
+			return true;
+		}
+	}
+
+	Gpu_memory_block* block = create_block(memory_type, block_size);
+	return block && allocate_from_block(block, size, alignment, allocation);
+}
+
+bool Gpu_allocator::allocate_from_block(Gpu_memory_block* block, VkDeviceSize size, VkDeviceSize alignment, Gpu_allocation& allocation)
+{
+	Tlsf_allocation range;
+	if (!block->tlsf.allocate(size, alignment, range))
+	{
+		return false;
+	}
+
+	allocation.memory      = block->memory;
+	allocation.offset      = range.offset;
+	allocation.size        = size;
+	allocation.alignment   = alignment;
+	allocation.mapped      = block->mapped ? block->mapped + range.offset : nullptr;
+	allocation.memory_type = block->memory_type;
+	allocation.block       = block;
+	allocation.range       = range;
+
+	Gpu_heap_stats& stats = heap_stats[memory_properties.memoryTypes[block->memory_type].heapIndex];
+	stats.live_bytes += size;
+	stats.peak_live_bytes = std::max(stats.peak_live_bytes, stats.live_bytes);
+	stats.allocation_count++;
+
+	return true;
+}
+
+void Gpu_allocator::free_locked(Gpu_allocation& allocation)
+{
+	Gpu_memory_block* block = allocation.block;
+	if (!block)
+	{
+		return;
+	}
+
+	block->tlsf.free(allocation.range);
+
+	Gpu_heap_stats& stats = heap_stats[memory_properties.memoryTypes[block->memory_type].heapIndex];
+	stats.live_bytes -= allocation.size;
+	stats.allocation_count--;
+
+	release_empty_blocks(block->memory_type);
+
+	allocation = {};
+}
+
+void Gpu_allocator::release_empty_blocks(uint32_t memory_type)
+{
+	// Keep one empty shared block per type around, so a resource freed and recreated every frame does not hit the driver each time
+	bool kept_empty_block = false;
+
+	std::vector<Gpu_memory_block*> empty_blocks;
+	for (const std::unique_ptr<Gpu_memory_block>& block : blocks[memory_type])
+	{
+		if (!block->tlsf.is_empty())
+		{
+			continue;
+		}
+
+		if (!block->dedicated && !kept_empty_block)
+		{
+			kept_empty_block = true;
+			continue;
+		}
+
+		empty_blocks.push_back(block.get());
+	}
+
+	for (Gpu_memory_block* block : empty_blocks)
+	{
+		destroy_block(block);
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/tlsf_allocator.hpp"
+
+
+struct Gpu_memory_block
+{
+	VkDeviceMemory memory      = VK_NULL_HANDLE;
+	VkDeviceSize   size        = 0;
+	uint8_t*       mapped      = nullptr;
+	uint32_t       memory_type = 0;
+	bool           dedicated   = false;
+	Tlsf_allocator tlsf;
+};
+
+struct Gpu_allocation
+{
+	VkDeviceMemory    memory      = VK_NULL_HANDLE;
+	VkDeviceSize      offset      = 0;
+	VkDeviceSize      size        = 0;
+	VkDeviceSize      alignment   = 0;
+	uint8_t*          mapped      = nullptr;
+	uint32_t          memory_type = 0;
+	Gpu_memory_block* block       = nullptr;
+	Tlsf_allocation   range;
+};
+
+struct Gpu_heap_stats
+{
+	VkDeviceSize block_bytes      = 0;
+	VkDeviceSize live_bytes       = 0;
+	VkDeviceSize peak_live_bytes  = 0;
+	uint32_t     block_count      = 0;
+	uint32_t     allocation_count = 0;
+};
+
+// The caller copies the contents and rebinds its resource to the destination, then hands the moves back to end_defragmentation()
+struct Gpu_defragmentation_move
+{
+	Gpu_allocation* allocation = nullptr;
+	Gpu_allocation  destination;
+};
+
+class Gpu_allocator
+{
+public:
+
+	bool startup(VkPhysicalDevice physical_device, VkDevice device);
+	void shutdown();
+
+	bool allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, Gpu_allocation& allocation);
+	void free(Gpu_allocation& allocation);
+
+	bool create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, Gpu_allocation& allocation);
+	void destroy_buffer(VkBuffer& buffer, Gpu_allocation& allocation);
+	bool create_image(const VkImageCreateInfo& image_info, VkMemoryPropertyFlags properties, VkImage& image, Gpu_allocation& allocation);
+	void destroy_image(VkImage& image, Gpu_allocation& allocation);
+
+	std::vector<Gpu_defragmentation_move> begin_defragmentation(const std::vector<Gpu_allocation*>& allocations, VkDeviceSize max_bytes);
+	void                                  end_defragmentation(std::vector<Gpu_defragmentation_move>& moves);
+
+	Gpu_heap_stats get_heap_stats(uint32_t heap_index) const;
+	void           log_stats() const;
+
+private:
+
+	VkDevice                                       device = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties               memory_properties;
+	VkDeviceSize                                   buffer_image_granularity = 1;
+	std::vector<std::unique_ptr<Gpu_memory_block>> blocks[VK_MAX_MEMORY_TYPES];
+	Gpu_heap_stats                                 heap_stats[VK_MAX_MEMORY_HEAPS];
+	mutable std::mutex                             mutex;
+
+	VkDeviceSize      get_block_size(uint32_t memory_type) const;
+	Gpu_memory_block* create_block(uint32_t memory_type, VkDeviceSize size);
+	void              destroy_block(Gpu_memory_block* block);
+	bool              allocate_from_type(uint32_t memory_type, VkDeviceSize size, VkDeviceSize alignment, Gpu_allocation& allocation);
+	bool              allocate_from_block(Gpu_memory_block* block, VkDeviceSize size, VkDeviceSize alignment, Gpu_allocation& allocation);
+	void              free_locked(Gpu_allocation& allocation);
+	void              release_empty_blocks(uint32_t memory_type);
+};
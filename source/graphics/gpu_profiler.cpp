@@ -0,0 +1,226 @@
+#include "gpu_profiler.hpp"
+
+#if PROFILER_ENABLED
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+
+// The host domain has to be the one std::chrono::steady_clock reads, so GPU and CPU scopes land on one timeline
+#ifdef _WIN32
+constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+
+static uint64_t host_ticks_to_ns(uint64_t ticks)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency = {};
+	QueryPerformanceFrequency(&frequency);
+	return static_cast<uint64_t>(static_cast<double>(ticks) * 1'000'000'000.0 / static_cast<double>(frequency.QuadPart));
+#else
+	return ticks;
+#endif
+}
+
+
+void Gpu_profiler::startup(VkInstance instance, VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family, uint32_t frame_count, bool calibrated_timestamps)
+{
+	this->device = device;
+
+	uint32_t family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> families(family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &family_count, families.data());
+
+	// A queue without valid timestamp bits cannot be timed, the GPU track just stays empty
+	uint32_t valid_bits = queue_family < family_count ? families[queue_family].timestampValidBits : 0;
+	if (valid_bits == 0)
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "The graphics queue has no timestamp support, GPU scopes are disabled.");
+		return;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	timestamp_period = properties.limits.timestampPeriod;
+	timestamp_mask   = valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << valid_bits) - 1;
+
+	if (calibrated_timestamps)
+	{
+		auto get_time_domains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+
+		uint32_t domain_count = 0;
+		if (get_time_domains)
+		{
+			get_time_domains(physical_device, &domain_count, nullptr);
+		}
+		std::vector<VkTimeDomainEXT> domains(domain_count);
+		if (domain_count > 0)
+		{
+			get_time_domains(physical_device, &domain_count, domains.data());
+		}
+
+		bool has_device_domain = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+		bool has_host_domain   = std::find(domains.begin(), domains.end(), HOST_TIME_DOMAIN) != domains.end();
+		if (has_device_domain && has_host_domain)
+		{
+			get_calibrated_timestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(vkGetDeviceProcAddr(device, "vkGetCalibratedTimestampsEXT"));
+		}
+	}
+
+	VkQueryPoolCreateInfo pool_info = {};
+	pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+	pool_info.queryCount            = MAX_GPU_PROFILE_SCOPES * 2;
+
+	frames.resize(frame_count);
+	for (Gpu_profile_frame& frame : frames)
+	{
+		if (vkCreateQueryPool(device, &pool_info, nullptr, &frame.query_pool) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create timestamp query pool, GPU scopes are disabled.");
+			shutdown();
+			return;
+		}
+		frame.scope_names.reserve(MAX_GPU_PROFILE_SCOPES);
+	}
+	query_results.resize(MAX_GPU_PROFILE_SCOPES * 2);
+}
+
+void Gpu_profiler::shutdown()
+{
+	for (Gpu_profile_frame& frame : frames)
+	{
+		if (frame.query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(device, frame.query_pool, nullptr);
+		}
+	}
+	frames.clear();
+	get_calibrated_timestamps = nullptr;
+}
+
+void Gpu_profiler::begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+	if (frame_index >= frames.size())
+	{
+		return;
+	}
+
+	// The timeline has passed this slot's last submission, so whatever it recorded last time is final
+	Gpu_profile_frame& frame = frames[frame_index];
+	read_results(frame);
+
+	frame.scope_names.clear();
+	frame.query_count = 0;
+	vkCmdResetQueryPool(command_buffer, frame.query_pool, 0, MAX_GPU_PROFILE_SCOPES * 2);
+}
+
+uint32_t Gpu_profiler::begin_scope(VkCommandBuffer command_buffer, uint32_t frame_index, const char* name)
+{
+	if (frame_index >= frames.size() || frames[frame_index].scope_names.size() == MAX_GPU_PROFILE_SCOPES)
+	{
+		return INVALID_GPU_SCOPE;
+	}
+
+	Gpu_profile_frame& frame = frames[frame_index];
+	uint32_t           scope = static_cast<uint32_t>(frame.scope_names.size());
+	frame.scope_names.push_back(name);
+	frame.query_count = (scope + 1) * 2;
+
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.query_pool, scope * 2);
+	return scope;
+}
+
+void Gpu_profiler::end_scope(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t scope)
+{
+	if (frame_index >= frames.size() || scope >= frames[frame_index].scope_names.size())
+	{
+		return;
+	}
+
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[frame_index].query_pool, scope * 2 + 1);
+}
+
+void Gpu_profiler::mark_submit(uint32_t frame_index)
+{
+	if (frame_index < frames.size())
+	{
+		frames[frame_index].submit_ns = Profiler::now_ns();
+	}
+}
+
+void Gpu_profiler::read_results(Gpu_profile_frame& frame)
+{
+	if (frame.query_count == 0 || !Profiler::is_capturing())
+	{
+		return;
+	}
+
+	// No wait flag: a scope that was begun but never ended leaves its query unavailable, and the frame is skipped
+	VkResult result = vkGetQueryPoolResults(
+	    device, frame.query_pool, 0, frame.query_count, sizeof(uint64_t) * frame.query_count, query_results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	uint64_t base_ticks = query_results[0];
+	uint64_t base_ns    = frame.submit_ns;
+	if (calibrate())
+	{
+		base_ticks = calibration_gpu_ticks;
+		base_ns    = calibration_cpu_ns;
+	}
+
+	for (uint32_t scope = 0; scope < frame.scope_names.size(); scope++)
+	{
+		Profiler::record_gpu(frame.scope_names[scope], to_cpu_ns(query_results[scope * 2], base_ticks, base_ns), to_cpu_ns(query_results[scope * 2 + 1], base_ticks, base_ns));
+	}
+}
+
+bool Gpu_profiler::calibrate()
+{
+	if (!get_calibrated_timestamps)
+	{
+		return false;
+	}
+
+	// Resampled every time it is used, the two clocks drift apart over a long capture
+	VkCalibratedTimestampInfoEXT infos[2] = {};
+	infos[0].sType                        = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[0].timeDomain                   = VK_TIME_DOMAIN_DEVICE_EXT;
+	infos[1].sType                        = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[1].timeDomain                   = HOST_TIME_DOMAIN;
+
+	uint64_t timestamps[2] = {};
+	uint64_t max_deviation = 0;
+	if (get_calibrated_timestamps(device, 2, infos, timestamps, &max_deviation) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	calibration_gpu_ticks = timestamps[0];
+	calibration_cpu_ns    = host_ticks_to_ns(timestamps[1]);
+	return true;
+}
+
+uint64_t Gpu_profiler::to_cpu_ns(uint64_t ticks, uint64_t base_ticks, uint64_t base_ns) const
+{
+	// Timestamps wrap at the valid bit count, so the distance to the base is taken modulo that and may be negative
+	uint64_t delta        = (ticks - base_ticks) & timestamp_mask;
+	double   signed_delta = delta > timestamp_mask / 2 ? -static_cast<double>(timestamp_mask - delta + 1) : static_cast<double>(delta);
+
+	return static_cast<uint64_t>(static_cast<int64_t>(base_ns) + static_cast<int64_t>(signed_delta * timestamp_period));
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/profiler.hpp"
+
+
+constexpr uint32_t MAX_GPU_PROFILE_SCOPES = 64;
+constexpr uint32_t INVALID_GPU_SCOPE      = UINT32_MAX;
+
+
+// Times command buffer ranges with timestamp queries and hands them to the profiler's GPU track. Every frame in
+// flight has a pool of its own, read back once its timeline value is reached, so reading never stalls the queue.
+class Gpu_profiler
+{
+public:
+
+#if PROFILER_ENABLED
+	// calibrated_timestamps: VK_EXT_calibrated_timestamps was enabled on the device
+	void startup(VkInstance instance, VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family, uint32_t frame_count, bool calibrated_timestamps);
+	void shutdown();
+
+	// Record first thing into the frame's command buffer, outside any render pass
+	void begin_frame(VkCommandBuffer command_buffer, uint32_t frame_index);
+
+	// Scopes cannot begin or end inside a render pass that executes secondary command buffers
+	uint32_t begin_scope(VkCommandBuffer command_buffer, uint32_t frame_index, const char* name);
+	void     end_scope(VkCommandBuffer command_buffer, uint32_t frame_index, uint32_t scope);
+
+	// Without calibrated timestamps the GPU track is anchored to the submit time, which is as early as it can have started
+	void mark_submit(uint32_t frame_index);
+#else
+	void     startup(VkInstance, VkPhysicalDevice, VkDevice, uint32_t, uint32_t, bool) {}
+	void     shutdown() {}
+	void     begin_frame(VkCommandBuffer, uint32_t) {}
+	uint32_t begin_scope(VkCommandBuffer, uint32_t, const char*) { return INVALID_GPU_SCOPE; }
+	void     end_scope(VkCommandBuffer, uint32_t, uint32_t) {}
+	void     mark_submit(uint32_t) {}
+#endif
+
+private:
+
+#if PROFILER_ENABLED
+	struct Gpu_profile_frame
+	{
+		VkQueryPool              query_pool = VK_NULL_HANDLE;
+		std::vector<const char*> scope_names;
+		uint32_t                 query_count = 0;
+		uint64_t                 submit_ns   = 0;
+	};
+
+	VkDevice                         device = VK_NULL_HANDLE;
+	std::vector<Gpu_profile_frame>   frames;
+	std::vector<uint64_t>            query_results;
+	double                           timestamp_period          = 1.0;
+	uint64_t                         timestamp_mask            = 0;
+	PFN_vkGetCalibratedTimestampsEXT get_calibrated_timestamps = nullptr;
+	uint64_t                         calibration_gpu_ticks     = 0;
+	uint64_t                         calibration_cpu_ns        = 0;
+
+	void     read_results(Gpu_profile_frame& frame);
+	bool     calibrate();
+	uint64_t to_cpu_ns(uint64_t ticks, uint64_t base_ticks, uint64_t base_ns) const;
+#endif
+};
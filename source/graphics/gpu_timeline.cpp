@@ -0,0 +1,97 @@
+#include "gpu_timeline.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+
+bool Gpu_timeline::startup(VkDevice logical_device)
+{
+	device          = logical_device;
+	submitted_value = 0;
+	completed_value = 0;
+
+	VkSemaphoreTypeCreateInfo semaphore_type_info = {};
+	semaphore_type_info.sType                     = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	semaphore_type_info.semaphoreType             = VK_SEMAPHORE_TYPE_TIMELINE;
+	semaphore_type_info.initialValue              = 0;
+
+	VkSemaphoreCreateInfo semaphore_info = {};
+	semaphore_info.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphore_info.pNext                 = &semaphore_type_info;
+
+	if (vkCreateSemaphore(device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create timeline semaphore.");
+		return false;
+	}
+
+	return true;
+}
+
+void Gpu_timeline::shutdown()
+{
+	vkDestroySemaphore(device, semaphore, nullptr);
+	semaphore = VK_NULL_HANDLE;
+}
+
+uint64_t Gpu_timeline::get_next_value() const
+{
+	return submitted_value + 1;
+}
+
+uint64_t Gpu_timeline::advance()
+{
+	return ++submitted_value;
+}
+
+uint64_t Gpu_timeline::get_submitted_value() const
+{
+	return submitted_value;
+}
+
+uint64_t Gpu_timeline::get_completed_value()
+{
+	if (completed_value < submitted_value && vkGetSemaphoreCounterValue(device, semaphore, &completed_value) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to read timeline semaphore.");
+	}
+
+	return completed_value;
+}
+
+bool Gpu_timeline::is_complete(uint64_t value)
+{
+	return value <= completed_value || value <= get_completed_value();
+}
+
+bool Gpu_timeline::wait(uint64_t value, uint64_t timeout_ns)
+{
+	if (is_complete(value))
+	{
+		return true;
+	}
+
+	VkSemaphoreWaitInfo wait_info = {};
+	wait_info.sType               = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	wait_info.semaphoreCount      = 1;
+	wait_info.pSemaphores         = &semaphore;
+	wait_info.pValues             = &value;
+
+	if (vkWaitSemaphores(device, &wait_info, timeout_ns) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	completed_value = std::max(completed_value, value);
+	return true;
+}
+
+VkSemaphore Gpu_timeline::get_semaphore() const
+{
+	return semaphore;
+}
+
+Timeline_wait Gpu_timeline::get_wait(uint64_t value, VkPipelineStageFlags stage_mask) const
+{
+	return {semaphore, value, stage_mask};
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vulkan/vulkan_core.h>
+
+
+// A submission waiting for another queue's timeline to reach a value before the given stages run
+struct Timeline_wait
+{
+	VkSemaphore          semaphore  = VK_NULL_HANDLE;
+	uint64_t             value      = 0;
+	VkPipelineStageFlags stage_mask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+};
+
+// A timeline semaphore for one queue. Every submission to the queue signals the next value, so any point in its work
+// is named by a number: resources remember the value they were last used at and are recycled once the timeline
+// passes it. Other queues wait on a value instead of a fence, and the completed value is cached so polling is cheap.
+class Gpu_timeline
+{
+public:
+
+	bool startup(VkDevice device);
+	void shutdown();
+
+	// The value the next submission signals, advance() hands it out and moves on
+	uint64_t get_next_value() const;
+	uint64_t advance();
+
+	// The last value handed to a submission, work recorded up to now completes at or before it
+	uint64_t get_submitted_value() const;
+
+	// Only asks the driver when the cached value has not passed the one asked about
+	uint64_t get_completed_value();
+	bool     is_complete(uint64_t value);
+	bool     wait(uint64_t value, uint64_t timeout_ns = UINT64_MAX);
+
+	VkSemaphore   get_semaphore() const;
+	Timeline_wait get_wait(uint64_t value, VkPipelineStageFlags stage_mask) const;
+
+private:
+
+	VkDevice    device          = VK_NULL_HANDLE;
+	VkSemaphore semaphore       = VK_NULL_HANDLE;
+	uint64_t    submitted_value = 0;
+	uint64_t    completed_value = 0;
+};
@@ -0,0 +1,605 @@
+#include "indirect_renderer.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+
+constexpr uint32_t CULL_GROUP_SIZE        = 64;
+constexpr uint32_t INSTANCE_BINDING       = 0;
+constexpr uint32_t BUCKET_BINDING         = 1;
+constexpr uint32_t COMMAND_BINDING        = 2;
+constexpr uint32_t COUNT_BINDING          = 3;
+constexpr uint32_t INDIRECT_BINDING_COUNT = 4;
+
+
+// Gribb and Hartmann plane extraction for a [0, 1] depth range, normalised so the distance can be compared against a radius
+static void extract_frustum_planes(const glm::mat4& matrix, glm::vec4 (&planes)[FRUSTUM_PLANE_COUNT])
+{
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		rows[i] = glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]);
+	}
+
+	planes[0] = rows[3] + rows[0];
+	planes[1] = rows[3] + rows[0] * -1.0f;
+	planes[2] = rows[3] + rows[1];
+	planes[3] = rows[3] + rows[1] * -1.0f;
+	planes[4] = rows[2];
+	planes[5] = rows[3] + rows[2] * -1.0f;
+
+	for (glm::vec4& plane : planes)
+	{
+		float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		plane        = plane * (1.0f / length);
+	}
+}
+
+
+bool Indirect_renderer::startup(VkDevice                 logical_device,
+                                Gpu_allocator&           allocator,
+                                Upload_manager&          uploads,
+                                VkPipelineCache          pipeline_cache,
+                                const std::vector<char>& cull_shader_code,
+                                uint32_t                 frames_in_flight,
+                                uint32_t                 max_draws,
+                                bool                     use_draw_indirect_count,
+                                VkDescriptorSetLayout    bindless_set_layout)
+{
+	device              = logical_device;
+	gpu_allocator       = &allocator;
+	upload_manager      = &uploads;
+	max_draw_count      = std::max(max_draws, 1u);
+	draw_indirect_count = use_draw_indirect_count;
+	cache               = pipeline_cache;
+	set_view_projection(glm::mat4(1.0f));
+
+	VkDescriptorSetLayoutBinding bindings[INDIRECT_BINDING_COUNT] = {};
+	for (uint32_t i = 0; i < INDIRECT_BINDING_COUNT; i++)
+	{
+		bindings[i].binding         = i;
+		bindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	bindings[INSTANCE_BINDING].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layout_info = {};
+	layout_info.sType                           = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layout_info.bindingCount                    = INDIRECT_BINDING_COUNT;
+	layout_info.pBindings                       = bindings;
+
+	if (vkCreateDescriptorSetLayout(device, &layout_info, nullptr, &descriptor_set_layout) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create instance descriptor set layout.");
+		return false;
+	}
+
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type                 = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_size.descriptorCount      = INDIRECT_BINDING_COUNT * frames_in_flight;
+
+	VkDescriptorPoolCreateInfo pool_info = {};
+	pool_info.sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	pool_info.maxSets                    = frames_in_flight;
+	pool_info.poolSizeCount              = 1;
+	pool_info.pPoolSizes                 = &pool_size;
+
+	if (vkCreateDescriptorPool(device, &pool_info, nullptr, &descriptor_pool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create instance descriptor pool.");
+		return false;
+	}
+
+	frames.resize(frames_in_flight);
+
+	std::vector<VkDescriptorSetLayout> set_layouts(frames_in_flight, descriptor_set_layout);
+	std::vector<VkDescriptorSet>       descriptor_sets(frames_in_flight);
+
+	VkDescriptorSetAllocateInfo allocate_info = {};
+	allocate_info.sType                       = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocate_info.descriptorPool              = descriptor_pool;
+	allocate_info.descriptorSetCount          = frames_in_flight;
+	allocate_info.pSetLayouts                 = set_layouts.data();
+
+	if (vkAllocateDescriptorSets(device, &allocate_info, descriptor_sets.data()) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate instance descriptor sets.");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < frames_in_flight; i++)
+	{
+		frames[i].descriptor_set = descriptor_sets[i];
+	}
+
+	// The graphics pipeline shares this layout, so the instance set stays bound across the cull dispatch and the draws.
+	// With bindless descriptors the resource set follows it, and the draws get push constants of their own.
+	VkDescriptorSetLayout pipeline_set_layouts[]  = {descriptor_set_layout, bindless_set_layout};
+	bool                  bindless                = bindless_set_layout != VK_NULL_HANDLE;
+	VkPushConstantRange   push_constant_ranges[2] = {};
+	push_constant_ranges[0].stageFlags            = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_ranges[0].offset                = 0;
+	push_constant_ranges[0].size                  = sizeof(Cull_constants);
+	push_constant_ranges[1].stageFlags            = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	push_constant_ranges[1].offset                = DRAW_RESOURCES_OFFSET;
+	push_constant_ranges[1].size                  = sizeof(Draw_resources);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+	pipeline_layout_info.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_info.setLayoutCount             = bindless ? 2 : 1;
+	pipeline_layout_info.pSetLayouts                = pipeline_set_layouts;
+	pipeline_layout_info.pushConstantRangeCount     = bindless ? 2 : 1;
+	pipeline_layout_info.pPushConstantRanges        = push_constant_ranges;
+
+	if (vkCreatePipelineLayout(device, &pipeline_layout_info, nullptr, &pipeline_layout) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create instance pipeline layout.");
+		return false;
+	}
+
+	cull_pipeline = create_cull_pipeline(cull_shader_code);
+
+	return cull_pipeline != VK_NULL_HANDLE;
+}
+
+void Indirect_renderer::shutdown()
+{
+	destroy_buffers();
+	for (Retired_buffer& retired : retired_buffers)
+	{
+		gpu_allocator->destroy_buffer(retired.buffer, retired.allocation);
+	}
+	retired_buffers.clear();
+	frames.clear();
+	instances.clear();
+	buckets.clear();
+	instance_slots.clear();
+	instance_bounds.clear();
+	visible_instances.clear();
+
+	vkDestroyPipeline(device, cull_pipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+	vkDestroyDescriptorPool(device, descriptor_pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptor_set_layout, nullptr);
+
+	cull_pipeline         = VK_NULL_HANDLE;
+	pipeline_layout       = VK_NULL_HANDLE;
+	descriptor_pool       = VK_NULL_HANDLE;
+	descriptor_set_layout = VK_NULL_HANDLE;
+}
+
+void Indirect_renderer::set_instances(const std::vector<Mesh_instance>& mesh_instances, const std::vector<Mesh>& meshes, uint64_t retire_value)
+{
+	retire_buffers(retire_value);
+	instances.clear();
+	buckets.clear();
+	instance_bounds.clear();
+	instance_slots.assign(mesh_instances.size(), UINT32_MAX);
+	instances_moved = false;
+	upload_value    = 0;
+
+	// Grouping by mesh gives every bucket a contiguous range, which doubles as its slice of the command buffer
+	std::vector<uint32_t> order(mesh_instances.size());
+	std::iota(order.begin(), order.end(), 0u);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return mesh_instances[a].mesh < mesh_instances[b].mesh; });
+
+	for (uint32_t index : order)
+	{
+		// Streamed meshes have no buffers until they are resident, their placeholder is drawn meanwhile
+		const Mesh_instance& instance = mesh_instances[index];
+		if (instance.mesh >= meshes.size() || (meshes[instance.mesh].vertex_buffer == VK_NULL_HANDLE && meshes[instance.mesh].placeholder == INVALID_MESH))
+		{
+			continue;
+		}
+
+		// A bucket is drawn by a single indirect call, so it is split where it would exceed the device's draw count
+		if (buckets.empty() || buckets.back().mesh != instance.mesh || buckets.back().instance_count == max_draw_count)
+		{
+			buckets.push_back({instance.mesh, static_cast<uint32_t>(instances.size()), 0});
+		}
+		buckets.back().instance_count++;
+
+		// Bounds are taken when the instances are set, a mesh that is still streaming is bounded by its placeholder
+		const Mesh& mesh   = meshes[instance.mesh];
+		float       radius = (mesh.vertex_buffer != VK_NULL_HANDLE ? mesh.bounding_radius : meshes[mesh.placeholder].bounding_radius) * instance.scale;
+
+		Gpu_instance gpu_instance = {};
+		gpu_instance.bounds       = glm::vec4(instance.offset.x, instance.offset.y, 0.0f, radius);
+		gpu_instance.transform    = glm::vec4(instance.offset.x, instance.offset.y, instance.scale, 0.0f);
+		gpu_instance.bucket       = static_cast<uint32_t>(buckets.size() - 1);
+		instance_slots[index]     = static_cast<uint32_t>(instances.size());
+		instances.push_back(gpu_instance);
+	}
+
+	if (instances.empty())
+	{
+		return;
+	}
+
+	instance_bounds.assign(get_block_count(instances.size()), Vec4_block{});
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		set_lane(instance_bounds[i / SIMD_BLOCK_WIDTH], i % SIMD_BLOCK_WIDTH, instances[i].bounds);
+	}
+
+	std::optional<uint64_t> instance_upload;
+	if (create_buffers())
+	{
+		// Culling and the vertex shader read the instances, and moves overwrite them with a copy
+		instance_upload = upload_manager->upload_buffer(instance_buffer,
+		                                                0,
+		                                                instances.data(),
+		                                                sizeof(Gpu_instance) * instances.size(),
+		                                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                                                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
+
+	if (!instance_upload)
+	{
+		upload_manager->discard(instance_buffer);
+		destroy_buffers();
+		instances.clear();
+		buckets.clear();
+		instance_slots.clear();
+		instance_bounds.clear();
+		return;
+	}
+
+	upload_value = *instance_upload;
+
+	for (Indirect_frame& frame : frames)
+	{
+		frame.descriptor_set_stale = true;
+	}
+}
+
+void Indirect_renderer::begin_frame(uint32_t frame_index, uint64_t completed_value)
+{
+	for (size_t i = 0; i < retired_buffers.size();)
+	{
+		Retired_buffer& retired = retired_buffers[i];
+		if (completed_value < retired.timeline_value)
+		{
+			i++;
+			continue;
+		}
+
+		gpu_allocator->destroy_buffer(retired.buffer, retired.allocation);
+		retired_buffers[i] = retired_buffers.back();
+		retired_buffers.pop_back();
+	}
+
+	// No submission of this frame is pending any more, so its set can be pointed at the current buffers
+	Indirect_frame& frame = frames[frame_index];
+	if (frame.descriptor_set_stale)
+	{
+		write_descriptor_set(frame);
+		frame.descriptor_set_stale = false;
+	}
+}
+
+bool Indirect_renderer::move_instances(const std::vector<Mesh_instance>& mesh_instances, const std::vector<Mesh>& meshes)
+{
+	if (mesh_instances.size() != instance_slots.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < mesh_instances.size(); i++)
+	{
+		// Instances left out of the set had nothing to draw, they stay out until the set is replaced
+		const Mesh_instance& instance = mesh_instances[i];
+		uint32_t             slot     = instance_slots[i];
+		if (slot == UINT32_MAX)
+		{
+			continue;
+		}
+
+		Gpu_instance& gpu_instance = instances[slot];
+		if (buckets[gpu_instance.bucket].mesh != instance.mesh)
+		{
+			return false;
+		}
+
+		const Mesh& mesh   = meshes[instance.mesh];
+		float       radius = (mesh.vertex_buffer != VK_NULL_HANDLE ? mesh.bounding_radius : meshes[mesh.placeholder].bounding_radius) * instance.scale;
+
+		gpu_instance.bounds    = glm::vec4(instance.offset.x, instance.offset.y, 0.0f, radius);
+		gpu_instance.transform = glm::vec4(instance.offset.x, instance.offset.y, instance.scale, 0.0f);
+		set_lane(instance_bounds[slot / SIMD_BLOCK_WIDTH], slot % SIMD_BLOCK_WIDTH, gpu_instance.bounds);
+	}
+
+	instances_moved = !instances.empty();
+	return true;
+}
+
+VkDeviceSize Indirect_renderer::get_moved_size() const
+{
+	return instances_moved && is_resident() ? sizeof(Gpu_instance) * instances.size() : 0;
+}
+
+void Indirect_renderer::record_moves(VkCommandBuffer command_buffer, VkBuffer staging_buffer, VkDeviceSize staging_offset, void* staging_data)
+{
+	VkDeviceSize size = sizeof(Gpu_instance) * instances.size();
+	std::memcpy(staging_data, instances.data(), size);
+
+	// The instance buffer is shared by the frames in flight, so the copy waits for the previous frame's reads of it
+	VkMemoryBarrier read_barrier = {};
+	read_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	read_barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &read_barrier, 0, nullptr, 0, nullptr);
+
+	VkBufferCopy region = {};
+	region.srcOffset    = staging_offset;
+	region.size         = size;
+	vkCmdCopyBuffer(command_buffer, staging_buffer, instance_buffer, 1, &region);
+
+	VkMemoryBarrier write_barrier = {};
+	write_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	write_barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+	write_barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 1, &write_barrier, 0, nullptr, 0, nullptr);
+
+	instances_moved = false;
+}
+
+void Indirect_renderer::set_view_projection(const glm::mat4& view_projection)
+{
+	extract_frustum_planes(view_projection, cull_constants.planes);
+}
+
+void Indirect_renderer::record_cull(VkCommandBuffer command_buffer, uint32_t frame_index, const std::vector<Mesh>& meshes, const std::vector<Mesh_handle>& resolved_meshes)
+{
+	Indirect_frame& frame = frames[frame_index];
+
+	// The frame's timeline value has been reached, so its bucket buffer is free to rewrite; a zero index count draws nothing
+	uint32_t* bucket_data = reinterpret_cast<uint32_t*>(frame.bucket_allocation.mapped);
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		Mesh_handle mesh       = resolved_meshes[buckets[i].mesh];
+		bucket_data[i * 2]     = mesh != INVALID_MESH ? meshes[mesh].index_count : 0;
+		bucket_data[i * 2 + 1] = buckets[i].first_instance;
+	}
+
+	// Without a count buffer every slot is drawn, so culled slots have to read as empty draws
+	vkCmdFillBuffer(command_buffer, frame.count_buffer, 0, VK_WHOLE_SIZE, 0);
+	if (!draw_indirect_count)
+	{
+		vkCmdFillBuffer(command_buffer, frame.command_buffer, 0, VK_WHOLE_SIZE, 0);
+	}
+
+	VkMemoryBarrier clear_barrier = {};
+	clear_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	clear_barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clear_barrier.dstAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clear_barrier, 0, nullptr, 0, nullptr);
+
+	cull_constants.instance_count = static_cast<uint32_t>(instances.size());
+
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cull_pipeline);
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_layout, 0, 1, &frame.descriptor_set, 0, nullptr);
+	vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Cull_constants), &cull_constants);
+	vkCmdDispatch(command_buffer, (cull_constants.instance_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	VkMemoryBarrier cull_barrier = {};
+	cull_barrier.sType           = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cull_barrier.srcAccessMask   = VK_ACCESS_SHADER_WRITE_BIT;
+	cull_barrier.dstAccessMask   = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &cull_barrier, 0, nullptr, 0, nullptr);
+}
+
+void Indirect_renderer::record_indirect_draws(VkCommandBuffer command_buffer, uint32_t frame_index, const std::vector<Mesh>& meshes, const std::vector<Mesh_handle>& resolved_meshes)
+{
+	Indirect_frame& frame = frames[frame_index];
+
+	bind_instances(command_buffer, frame_index);
+
+	for (size_t i = 0; i < buckets.size(); i++)
+	{
+		const Instance_bucket& bucket   = buckets[i];
+		Mesh_handle            resolved = resolved_meshes[bucket.mesh];
+		if (resolved == INVALID_MESH)
+		{
+			continue;
+		}
+
+		const Mesh& mesh = meshes[resolved];
+
+		VkDeviceSize vertex_offset = 0;
+		vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh.vertex_buffer, &vertex_offset);
+		vkCmdBindIndexBuffer(command_buffer, mesh.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+		VkDeviceSize command_offset = sizeof(VkDrawIndexedIndirectCommand) * bucket.first_instance;
+		if (draw_indirect_count)
+		{
+			vkCmdDrawIndexedIndirectCount(command_buffer, frame.command_buffer, command_offset, frame.count_buffer, sizeof(uint32_t) * i, bucket.instance_count, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdDrawIndexedIndirect(command_buffer, frame.command_buffer, command_offset, bucket.instance_count, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+}
+
+void Indirect_renderer::bind_instances(VkCommandBuffer command_buffer, uint32_t frame_index)
+{
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &frames[frame_index].descriptor_set, 0, nullptr);
+}
+
+void Indirect_renderer::cull_on_cpu(std::vector<Draw_command>& draw_commands) const
+{
+	visible_instances.resize(instances.size());
+	size_t visible_count = cull_spheres(cull_constants.planes, instance_bounds.data(), instances.size(), visible_instances.data());
+
+	// The visible instances come out in ascending order and the buckets cover ascending ranges, so one pass pairs them
+	size_t bucket = 0;
+	for (size_t i = 0; i < visible_count; i++)
+	{
+		uint32_t instance = visible_instances[i];
+		while (instance >= buckets[bucket].first_instance + buckets[bucket].instance_count)
+		{
+			bucket++;
+		}
+		draw_commands.push_back({buckets[bucket].mesh, 1, instance});
+	}
+}
+
+bool Indirect_renderer::is_resident() const
+{
+	return !instances.empty() && upload_manager->is_complete(upload_value);
+}
+
+uint32_t Indirect_renderer::get_instance_count() const
+{
+	return static_cast<uint32_t>(instances.size());
+}
+
+VkPipelineLayout Indirect_renderer::get_pipeline_layout() const
+{
+	return pipeline_layout;
+}
+
+VkPipeline Indirect_renderer::replace_cull_pipeline(const std::vector<char>& cull_shader_code)
+{
+	VkPipeline pipeline = create_cull_pipeline(cull_shader_code);
+	if (pipeline == VK_NULL_HANDLE)
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	std::swap(pipeline, cull_pipeline);
+	return pipeline;
+}
+
+VkPipeline Indirect_renderer::create_cull_pipeline(const std::vector<char>& cull_shader_code)
+{
+	VkShaderModuleCreateInfo module_info = {};
+	module_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	module_info.codeSize                 = cull_shader_code.size();
+	module_info.pCode                    = reinterpret_cast<const uint32_t*>(cull_shader_code.data());
+
+	VkShaderModule cull_shader_module;
+	if (vkCreateShaderModule(device, &module_info, nullptr, &cull_shader_module) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create cull shader module.");
+		return VK_NULL_HANDLE;
+	}
+
+	VkComputePipelineCreateInfo pipeline_info = {};
+	pipeline_info.sType                       = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_info.stage.sType                 = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_info.stage.stage                 = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_info.stage.module                = cull_shader_module;
+	pipeline_info.stage.pName                 = "main";
+	pipeline_info.layout                      = pipeline_layout;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkResult   result   = vkCreateComputePipelines(device, cache, 1, &pipeline_info, nullptr, &pipeline);
+	vkDestroyShaderModule(device, cull_shader_module, nullptr);
+
+	if (result != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create cull pipeline.");
+		return VK_NULL_HANDLE;
+	}
+
+	return pipeline;
+}
+
+void Indirect_renderer::destroy_buffers()
+{
+	for (Indirect_frame& frame : frames)
+	{
+		if (frame.command_buffer != VK_NULL_HANDLE)
+		{
+			gpu_allocator->destroy_buffer(frame.command_buffer, frame.command_allocation);
+		}
+		if (frame.count_buffer != VK_NULL_HANDLE)
+		{
+			gpu_allocator->destroy_buffer(frame.count_buffer, frame.count_allocation);
+		}
+		if (frame.bucket_buffer != VK_NULL_HANDLE)
+		{
+			gpu_allocator->destroy_buffer(frame.bucket_buffer, frame.bucket_allocation);
+		}
+	}
+
+	if (instance_buffer != VK_NULL_HANDLE)
+	{
+		gpu_allocator->destroy_buffer(instance_buffer, instance_allocation);
+	}
+}
+
+void Indirect_renderer::retire_buffers(uint64_t retire_value)
+{
+	// Frames already submitted keep culling and drawing from the old buffers until they retire
+	for (Indirect_frame& frame : frames)
+	{
+		retired_buffers.push_back({frame.command_buffer, frame.command_allocation, retire_value});
+		retired_buffers.push_back({frame.count_buffer, frame.count_allocation, retire_value});
+		retired_buffers.push_back({frame.bucket_buffer, frame.bucket_allocation, retire_value});
+		frame.command_buffer = VK_NULL_HANDLE;
+		frame.count_buffer   = VK_NULL_HANDLE;
+		frame.bucket_buffer  = VK_NULL_HANDLE;
+	}
+	retired_buffers.push_back({instance_buffer, instance_allocation, retire_value});
+	instance_buffer = VK_NULL_HANDLE;
+
+	std::erase_if(retired_buffers, [](const Retired_buffer& retired) { return retired.buffer == VK_NULL_HANDLE; });
+}
+
+bool Indirect_renderer::create_buffers()
+{
+	VkBufferUsageFlags static_usage   = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	VkBufferUsageFlags indirect_usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	if (!gpu_allocator->create_buffer(sizeof(Gpu_instance) * instances.size(), static_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, instance_buffer, instance_allocation))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create instance buffers.");
+		return false;
+	}
+
+	// Each frame in flight culls into its own commands, so the next frame never overwrites draws still being consumed
+	for (Indirect_frame& frame : frames)
+	{
+		if (!gpu_allocator->create_buffer(sizeof(VkDrawIndexedIndirectCommand) * instances.size(), indirect_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.command_buffer, frame.command_allocation) ||
+		    !gpu_allocator->create_buffer(sizeof(uint32_t) * buckets.size(), indirect_usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.count_buffer, frame.count_allocation) ||
+		    !gpu_allocator->create_buffer(sizeof(uint32_t) * 2 * buckets.size(),
+		                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		                                  frame.bucket_buffer,
+		                                  frame.bucket_allocation))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create indirect draw buffers.");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Indirect_renderer::write_descriptor_set(Indirect_frame& frame)
+{
+	VkDescriptorBufferInfo buffer_infos[INDIRECT_BINDING_COUNT] = {};
+	buffer_infos[INSTANCE_BINDING]                             = {instance_buffer, 0, VK_WHOLE_SIZE};
+	buffer_infos[BUCKET_BINDING]                               = {frame.bucket_buffer, 0, VK_WHOLE_SIZE};
+	buffer_infos[COMMAND_BINDING]                              = {frame.command_buffer, 0, VK_WHOLE_SIZE};
+	buffer_infos[COUNT_BINDING]                                = {frame.count_buffer, 0, VK_WHOLE_SIZE};
+
+	VkWriteDescriptorSet writes[INDIRECT_BINDING_COUNT] = {};
+	for (uint32_t i = 0; i < INDIRECT_BINDING_COUNT; i++)
+	{
+		writes[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet          = frame.descriptor_set;
+		writes[i].dstBinding      = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo     = &buffer_infos[i];
+	}
+
+	vkUpdateDescriptorSets(device, INDIRECT_BINDING_COUNT, writes, 0, nullptr);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/simd_math.hpp"
+#include "graphics/bindless_descriptors.hpp"
+#include "graphics/gpu_allocator.hpp"
+#include "graphics/mesh.hpp"
+#include "graphics/upload_manager.hpp"
+
+
+// Matches the std430 layout in shader.vert and cull.comp
+struct Gpu_instance
+{
+	glm::vec4 bounds;
+	glm::vec4 transform;
+	uint32_t  bucket;
+	uint32_t  padding[3];
+};
+
+struct Cull_constants
+{
+	glm::vec4 planes[FRUSTUM_PLANE_COUNT];
+	uint32_t  instance_count;
+};
+
+// Draw resources follow the cull constants in the shared push constant range, bindless.glsl hard codes the offset
+constexpr uint32_t DRAW_RESOURCES_OFFSET = (sizeof(Cull_constants) + 15) / 16 * 16;
+static_assert(DRAW_RESOURCES_OFFSET + sizeof(Draw_resources) <= 128, "Push constants beyond 128 bytes are not guaranteed");
+
+// Instances of one mesh, their draw commands are compacted into [first_instance, first_instance + instance_count) of the command buffer
+struct Instance_bucket
+{
+	Mesh_handle mesh           = INVALID_MESH;
+	uint32_t    first_instance = 0;
+	uint32_t    instance_count = 0;
+};
+
+// Buckets are rewritten every frame from the host, so a streamed mesh can stand in for its placeholder without touching the instances.
+// The descriptor set may still be read by the frame in flight when the set is replaced, so it is only rewritten at the frame's start.
+struct Indirect_frame
+{
+	VkBuffer        command_buffer = VK_NULL_HANDLE;
+	Gpu_allocation  command_allocation;
+	VkBuffer        count_buffer = VK_NULL_HANDLE;
+	Gpu_allocation  count_allocation;
+	VkBuffer        bucket_buffer = VK_NULL_HANDLE;
+	Gpu_allocation  bucket_allocation;
+	VkDescriptorSet descriptor_set       = VK_NULL_HANDLE;
+	bool            descriptor_set_stale = false;
+};
+
+// Owns the instance buffer and culls it either on the GPU into indirect draws or on the CPU into draw commands
+class Indirect_renderer
+{
+public:
+
+	bool startup(VkDevice                 device,
+	             Gpu_allocator&           gpu_allocator,
+	             Upload_manager&          upload_manager,
+	             VkPipelineCache          pipeline_cache,
+	             const std::vector<char>& cull_shader_code,
+	             uint32_t                 frames_in_flight,
+	             uint32_t                 max_draw_count,
+	             bool                     draw_indirect_count,
+	             VkDescriptorSetLayout    bindless_set_layout = VK_NULL_HANDLE);
+	void shutdown();
+
+	// Replaces the buffers wholesale, the old ones are released once the timeline passes retire_value
+	void set_instances(const std::vector<Mesh_instance>& instances, const std::vector<Mesh>& meshes, uint64_t retire_value);
+
+	// Call once the frame's timeline value has been reached, before anything of the frame is recorded
+	void begin_frame(uint32_t frame_index, uint64_t completed_value);
+
+	// Moves the instances of the last set without touching the buffers, false when the set has changed since and has
+	// to be replaced. The moves reach the GPU with record_moves, which only writes the instances once they are resident.
+	bool         move_instances(const std::vector<Mesh_instance>& instances, const std::vector<Mesh>& meshes);
+	VkDeviceSize get_moved_size() const;
+	void         record_moves(VkCommandBuffer command_buffer, VkBuffer staging_buffer, VkDeviceSize staging_offset, void* staging_data);
+	void         set_view_projection(const glm::mat4& view_projection);
+
+	// resolved_meshes maps every mesh to the one drawn in its place this frame, INVALID_MESH when there is nothing to draw
+	void record_cull(VkCommandBuffer command_buffer, uint32_t frame_index, const std::vector<Mesh>& meshes, const std::vector<Mesh_handle>& resolved_meshes);
+	void record_indirect_draws(VkCommandBuffer command_buffer, uint32_t frame_index, const std::vector<Mesh>& meshes, const std::vector<Mesh_handle>& resolved_meshes);
+	void bind_instances(VkCommandBuffer command_buffer, uint32_t frame_index);
+	void cull_on_cpu(std::vector<Draw_command>& draw_commands) const;
+
+	bool             is_resident() const;
+	uint32_t         get_instance_count() const;
+	VkPipelineLayout get_pipeline_layout() const;
+
+	// Swaps in a pipeline built from new code and returns the old one, which the caller destroys once no frame uses it
+	VkPipeline replace_cull_pipeline(const std::vector<char>& cull_shader_code);
+
+private:
+
+	struct Retired_buffer
+	{
+		VkBuffer       buffer = VK_NULL_HANDLE;
+		Gpu_allocation allocation;
+		uint64_t       timeline_value = 0;
+	};
+
+	VkDevice                     device         = VK_NULL_HANDLE;
+	Gpu_allocator*               gpu_allocator  = nullptr;
+	Upload_manager*              upload_manager = nullptr;
+	VkDescriptorSetLayout        descriptor_set_layout = VK_NULL_HANDLE;
+	VkDescriptorPool             descriptor_pool       = VK_NULL_HANDLE;
+	VkPipelineLayout             pipeline_layout       = VK_NULL_HANDLE;
+	VkPipeline                   cull_pipeline         = VK_NULL_HANDLE;
+	VkPipelineCache              cache                 = VK_NULL_HANDLE;
+	std::vector<Indirect_frame>  frames;
+	uint32_t                     max_draw_count      = 0;
+	bool                         draw_indirect_count = false;
+	std::vector<Gpu_instance>    instances;
+	std::vector<Instance_bucket> buckets;
+	std::vector<uint32_t>        instance_slots;
+	bool                         instances_moved = false;
+	VkBuffer                     instance_buffer = VK_NULL_HANDLE;
+	Gpu_allocation               instance_allocation;
+	uint64_t                     upload_value = 0;
+	Cull_constants               cull_constants;
+	std::vector<Retired_buffer>  retired_buffers;
+
+	// The sphere of every instance again, in blocks for the SIMD culling on the CPU
+	std::vector<Vec4_block>       instance_bounds;
+	mutable std::vector<uint32_t> visible_instances;
+
+	VkPipeline create_cull_pipeline(const std::vector<char>& cull_shader_code);
+	void       destroy_buffers();
+	void       retire_buffers(uint64_t retire_value);
+	bool       create_buffers();
+	void       write_descriptor_set(Indirect_frame& frame);
+};
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vulkan/vulkan_core.h>
+
+#include "graphics/gpu_allocator.hpp"
+
+
+using Mesh_handle = uint32_t;
+
+constexpr Mesh_handle INVALID_MESH = UINT32_MAX;
+
+
+struct Vertex
+{
+	glm::vec2 position;
+	glm::vec3 color;
+
+	static VkVertexInputBindingDescription get_binding_description()
+	{
+		VkVertexInputBindingDescription binding_description = {};
+		binding_description.binding                         = 0;
+		binding_description.stride                          = sizeof(Vertex);
+		binding_description.inputRate                       = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return binding_description;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 2> get_attribute_descriptions()
+	{
+		std::array<VkVertexInputAttributeDescription, 2> attribute_descriptions = {};
+
+		attribute_descriptions[0].binding  = 0;
+		attribute_descriptions[0].location = 0;
+		attribute_descriptions[0].format   = VK_FORMAT_R32G32_SFLOAT;
+		attribute_descriptions[0].offset   = offsetof(Vertex, position);
+
+		attribute_descriptions[1].binding  = 0;
+		attribute_descriptions[1].location = 1;
+		attribute_descriptions[1].format   = VK_FORMAT_R32G32B32_SFLOAT;
+		attribute_descriptions[1].offset   = offsetof(Vertex, color);
+
+		return attribute_descriptions;
+	}
+};
+
+// A mesh without buffers yet, or whose upload is still in flight, is drawn as its placeholder
+struct Mesh
+{
+	VkBuffer       vertex_buffer = VK_NULL_HANDLE;
+	Gpu_allocation vertex_allocation;
+	VkBuffer       index_buffer = VK_NULL_HANDLE;
+	Gpu_allocation index_allocation;
+	uint32_t       index_count     = 0;
+	float          bounding_radius = 0.0f;
+	uint64_t       upload_value    = 0;
+	Mesh_handle    placeholder     = INVALID_MESH;
+};
+
+struct Mesh_instance
+{
+	Mesh_handle mesh   = INVALID_MESH;
+	glm::vec2   offset = glm::vec2(0.0f);
+	float       scale  = 1.0f;
+};
+
+// A CPU submitted draw, first_instance indexes the instance buffer
+struct Draw_command
+{
+	Mesh_handle mesh           = INVALID_MESH;
+	uint32_t    instance_count = 1;
+	uint32_t    first_instance = 0;
+};
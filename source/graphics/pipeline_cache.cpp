@@ -0,0 +1,225 @@
+#include "pipeline_cache.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "core/hash.hpp"
+
+
+const uint32_t PIPELINE_CACHE_MAGIC   = 0x43504244; // "DBPC"
+const uint32_t PIPELINE_CACHE_VERSION = 1;
+
+bool Pipeline_cache::startup(VkDevice logical_device, VkPhysicalDevice physical_device, const std::string& file_path)
+{
+	device = logical_device;
+	path   = file_path;
+
+	vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+
+	// The driver copies the blob on creation, so it is read straight out of the mapping
+	Mapped_file           file;
+	std::span<const char> initial_data = load(file);
+	warm                               = !initial_data.empty();
+
+	VkPipelineCacheCreateInfo create_info = {};
+	create_info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	create_info.initialDataSize           = initial_data.size();
+	create_info.pInitialData              = initial_data.data();
+
+	VkResult result = vkCreatePipelineCache(device, &create_info, nullptr, &cache);
+	if (result != VK_SUCCESS && warm)
+	{
+		// The driver may still reject a blob that passed our checks, so fall back to a cold cache
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Driver rejected pipeline cache %s, starting cold.", path.c_str());
+		warm                        = false;
+		create_info.initialDataSize = 0;
+		create_info.pInitialData    = nullptr;
+		result                      = vkCreatePipelineCache(device, &create_info, nullptr, &cache);
+	}
+
+	if (result != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create pipeline cache.");
+		return false;
+	}
+
+	return true;
+}
+
+void Pipeline_cache::shutdown()
+{
+	if (cache == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	merge_worker_caches();
+	save();
+
+	vkDestroyPipelineCache(device, cache, nullptr);
+	cache = VK_NULL_HANDLE;
+}
+
+VkPipelineCache Pipeline_cache::get_handle() const
+{
+	return cache;
+}
+
+bool Pipeline_cache::is_warm() const
+{
+	return warm;
+}
+
+VkPipelineCache Pipeline_cache::create_worker_cache()
+{
+	VkPipelineCacheCreateInfo create_info = {};
+	create_info.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	VkPipelineCache worker_cache = VK_NULL_HANDLE;
+	if (vkCreatePipelineCache(device, &create_info, nullptr, &worker_cache) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create worker pipeline cache.");
+		return VK_NULL_HANDLE;
+	}
+
+	std::lock_guard<std::mutex> lock(worker_caches_mutex);
+	worker_caches.push_back(worker_cache);
+
+	return worker_cache;
+}
+
+void Pipeline_cache::merge_worker_caches()
+{
+	std::lock_guard<std::mutex> lock(worker_caches_mutex);
+
+	if (worker_caches.empty())
+	{
+		return;
+	}
+
+	if (vkMergePipelineCaches(device, cache, static_cast<uint32_t>(worker_caches.size()), worker_caches.data()) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to merge worker pipeline caches.");
+	}
+
+	for (VkPipelineCache worker_cache : worker_caches)
+	{
+		vkDestroyPipelineCache(device, worker_cache, nullptr);
+	}
+	worker_caches.clear();
+}
+
+std::span<const char> Pipeline_cache::load(Mapped_file& file)
+{
+	if (!file.open(path, Access_pattern::sequential))
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "No pipeline cache at %s, starting cold.", path.c_str());
+		return {};
+	}
+
+	std::span<const char>      contents = file.get_data();
+	Pipeline_cache_file_header header   = {};
+	if (contents.size() < sizeof(header))
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s is corrupt, starting cold.", path.c_str());
+		return {};
+	}
+	std::memcpy(&header, contents.data(), sizeof(header));
+
+	if (header.magic != PIPELINE_CACHE_MAGIC || header.data_size != contents.size() - sizeof(header))
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s is corrupt, starting cold.", path.c_str());
+		return {};
+	}
+
+	std::span<const char> data = contents.subspan(sizeof(header));
+	if (!validate(header, data))
+	{
+		return {};
+	}
+
+	return data;
+}
+
+bool Pipeline_cache::validate(const Pipeline_cache_file_header& header, std::span<const char> data)
+{
+	if (header.version != PIPELINE_CACHE_VERSION || header.data_hash != hash(data.data(), data.size()))
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s failed its integrity check, starting cold.", path.c_str());
+		return false;
+	}
+
+	if (header.vendor_id != device_properties.vendorID || header.device_id != device_properties.deviceID || header.driver_version != device_properties.driverVersion
+	    || std::memcmp(header.uuid, device_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s was written by another device or driver, starting cold.", path.c_str());
+		return false;
+	}
+
+	// The driver's own header has to agree with ours, otherwise the blob was not produced by this device
+	VkPipelineCacheHeaderVersionOne driver_header = {};
+	if (data.size() < sizeof(driver_header))
+	{
+		return false;
+	}
+	std::memcpy(&driver_header, data.data(), sizeof(driver_header));
+
+	return driver_header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && driver_header.vendorID == device_properties.vendorID && driver_header.deviceID == device_properties.deviceID
+	    && std::memcmp(driver_header.pipelineCacheUUID, device_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void Pipeline_cache::save()
+{
+	size_t data_size = 0;
+	if (vkGetPipelineCacheData(device, cache, &data_size, nullptr) != VK_SUCCESS || data_size == 0)
+	{
+		return;
+	}
+
+	std::vector<char> data(data_size);
+	if (vkGetPipelineCacheData(device, cache, &data_size, data.data()) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to read back pipeline cache data.");
+		return;
+	}
+	data.resize(data_size);
+
+	Pipeline_cache_file_header header = {};
+	header.magic                      = PIPELINE_CACHE_MAGIC;
+	header.version                    = PIPELINE_CACHE_VERSION;
+	header.vendor_id                  = device_properties.vendorID;
+	header.device_id                  = device_properties.deviceID;
+	header.driver_version             = device_properties.driverVersion;
+	header.data_size                  = data.size();
+	header.data_hash                  = hash(data.data(), data.size());
+	std::memcpy(header.uuid, device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	// Write next to the real file and rename over it, so a crash mid-write never leaves a torn cache behind
+	std::string temporary_path = path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		if (!file.good())
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to write pipeline cache %s.", temporary_path.c_str());
+			return;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary_path, path, error);
+	if (error)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to replace pipeline cache %s: %s", path.c_str(), error.message().c_str());
+		std::filesystem::remove(temporary_path, error);
+	}
+}
+
+uint64_t Pipeline_cache::hash(const char* data, size_t size)
+{
+	// Enough to catch truncated or bit-rotted files
+	return hash_bytes(FNV_OFFSET_BASIS, data, size);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/file_io.hpp"
+
+
+struct Pipeline_cache_file_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendor_id;
+	uint32_t device_id;
+	uint32_t driver_version;
+	uint8_t  uuid[VK_UUID_SIZE];
+	uint64_t data_size;
+	uint64_t data_hash;
+};
+
+class Pipeline_cache
+{
+public:
+
+	bool startup(VkDevice device, VkPhysicalDevice physical_device, const std::string& file_path);
+	void shutdown();
+
+	VkPipelineCache get_handle() const;
+	bool            is_warm() const;
+
+	VkPipelineCache create_worker_cache();
+	void            merge_worker_caches();
+
+private:
+
+	VkDevice                     device = VK_NULL_HANDLE;
+	VkPhysicalDeviceProperties   device_properties;
+	VkPipelineCache              cache = VK_NULL_HANDLE;
+	std::vector<VkPipelineCache> worker_caches;
+	std::mutex                   worker_caches_mutex;
+	std::string                  path;
+	bool                         warm = false;
+
+	std::span<const char> load(Mapped_file& file);
+	bool                  validate(const Pipeline_cache_file_header& header, std::span<const char> data);
+	void                  save();
+
+	static uint64_t hash(const char* data, size_t size);
+};
@@ -0,0 +1,471 @@
+#include "pipeline_manager.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <utility>
+
+#include "config/application.hpp"
+#include "core/hash.hpp"
+#include "core/profiler.hpp"
+
+
+static double to_ms(uint64_t ns)
+{
+	return static_cast<double>(ns) / SDL_NS_PER_MS;
+}
+
+// Every field widened to a word, so states compare and hash without ever touching struct padding
+static std::vector<uint64_t> get_key(const Graphics_pipeline_state& state)
+{
+	std::vector<uint64_t> key = {
+	    state.vert_shader,
+	    state.frag_shader,
+	    reinterpret_cast<uint64_t>(state.layout),
+	    state.vertex_stride,
+	    state.attribute_count,
+	    static_cast<uint64_t>(state.topology),
+	    static_cast<uint64_t>(state.polygon_mode),
+	    state.cull_mode,
+	    static_cast<uint64_t>(state.front_face),
+	    state.depth_test,
+	    state.depth_write,
+	    static_cast<uint64_t>(state.depth_compare),
+	    state.blend_enable,
+	    static_cast<uint64_t>(state.src_color_factor),
+	    static_cast<uint64_t>(state.dst_color_factor),
+	    static_cast<uint64_t>(state.color_blend_op),
+	    static_cast<uint64_t>(state.src_alpha_factor),
+	    static_cast<uint64_t>(state.dst_alpha_factor),
+	    static_cast<uint64_t>(state.alpha_blend_op),
+	    state.color_write_mask,
+	    reinterpret_cast<uint64_t>(state.render_pass),
+	    static_cast<uint64_t>(state.color_format),
+	    static_cast<uint64_t>(state.depth_format),
+	    static_cast<uint64_t>(state.samples),
+	};
+
+	for (uint32_t i = 0; i < std::min(state.attribute_count, MAX_VERTEX_ATTRIBUTES); i++)
+	{
+		const VkVertexInputAttributeDescription& attribute = state.attributes[i];
+		key.push_back(attribute.location);
+		key.push_back(attribute.binding);
+		key.push_back(static_cast<uint64_t>(attribute.format));
+		key.push_back(attribute.offset);
+	}
+
+	return key;
+}
+
+static uint64_t hash_key(const std::vector<uint64_t>& key)
+{
+	uint64_t hash = FNV_OFFSET_BASIS;
+	for (uint64_t word : key)
+	{
+		for (uint32_t byte = 0; byte < 8; byte++)
+		{
+			hash = hash_byte(hash, static_cast<uint8_t>(word >> (byte * 8)));
+		}
+	}
+
+	return hash;
+}
+
+static VkShaderModule create_shader_module(VkDevice device, const std::vector<char>& code)
+{
+	VkShaderModuleCreateInfo create_info = {};
+	create_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	create_info.codeSize                 = code.size();
+	create_info.pCode                    = reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shader_module = VK_NULL_HANDLE;
+	if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	return shader_module;
+}
+
+
+void Pipeline_manager::startup(VkDevice device, const Pipeline_cache& pipeline_cache, const Shader_manager& shader_manager, Job_system& job_system)
+{
+	this->device         = device;
+	this->pipeline_cache = &pipeline_cache;
+	this->shader_manager = &shader_manager;
+	this->job_system     = &job_system;
+	retire_value         = 0;
+	completed_value      = 0;
+	stats                = {};
+}
+
+void Pipeline_manager::shutdown()
+{
+	// A compile still running writes its result into its entry, so wait for the counter before destroying any
+	if (job_system)
+	{
+		job_system->wait_for(compile_counter);
+	}
+
+	for (const std::unique_ptr<Pipeline_entry>& entry : entries)
+	{
+		vkDestroyPipeline(device, entry->pipeline, nullptr);
+		vkDestroyPipeline(device, entry->compiled, nullptr);
+	}
+	for (const Retired_pipeline& retired : retired_pipelines)
+	{
+		vkDestroyPipeline(device, retired.pipeline, nullptr);
+	}
+
+	entries.clear();
+	entry_lookup.clear();
+	compile_queue.clear();
+	compiling.clear();
+	retired_pipelines.clear();
+	stats = {};
+}
+
+Pipeline_handle Pipeline_manager::request(const Graphics_pipeline_state& state, Pipeline_handle fallback)
+{
+	std::vector<uint64_t> key   = get_key(state);
+	uint64_t              hash  = hash_key(key);
+	auto                  found = entry_lookup.find(hash);
+	if (found != entry_lookup.end() && entries[found->second]->key == key)
+	{
+		Pipeline_entry& entry = *entries[found->second];
+		if (entry.fallback == INVALID_PIPELINE && fallback < found->second)
+		{
+			entry.fallback = fallback;
+		}
+		return found->second;
+	}
+
+	// Fallbacks always point at earlier entries, so resolving one can never loop
+	Pipeline_handle pipeline = static_cast<Pipeline_handle>(entries.size());
+	entries.push_back(std::make_unique<Pipeline_entry>());
+	Pipeline_entry& entry = *entries.back();
+	entry.state           = state;
+	entry.key             = std::move(key);
+	entry.fallback        = fallback < pipeline ? fallback : INVALID_PIPELINE;
+
+	// A colliding hash only costs the deduplication of the later state
+	entry_lookup.emplace(hash, pipeline);
+
+	queue_compile(pipeline);
+
+	return pipeline;
+}
+
+VkPipeline Pipeline_manager::get(Pipeline_handle pipeline) const
+{
+	while (pipeline < entries.size())
+	{
+		const Pipeline_entry& entry = *entries[pipeline];
+		if (entry.pipeline != VK_NULL_HANDLE)
+		{
+			return entry.pipeline;
+		}
+		pipeline = entry.fallback;
+	}
+
+	return VK_NULL_HANDLE;
+}
+
+bool Pipeline_manager::is_ready(Pipeline_handle pipeline) const
+{
+	return pipeline < entries.size() && entries[pipeline]->pipeline != VK_NULL_HANDLE;
+}
+
+void Pipeline_manager::recompile(Shader_handle shader)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i]->state.vert_shader == shader || entries[i]->state.frag_shader == shader)
+		{
+			queue_compile(static_cast<Pipeline_handle>(i));
+		}
+	}
+}
+
+void Pipeline_manager::update(uint64_t retire_value, uint64_t completed_value)
+{
+	PROFILE_SCOPE("Pipeline manager update");
+
+	this->retire_value    = retire_value;
+	this->completed_value = completed_value;
+	stats.started_count  = 0;
+	stats.compiled_count = 0;
+	stats.failed_count   = 0;
+	stats.compile_ns     = 0;
+	stats.max_compile_ns = 0;
+
+	collect_compiles();
+	release_retired();
+	start_compiles(PIPELINE_MAX_COMPILES);
+
+	stats.pipeline_count = static_cast<uint32_t>(entries.size());
+	stats.pending_count  = static_cast<uint32_t>(compile_queue.size() + compiling.size());
+
+	if (stats.started_count + stats.compiled_count + stats.failed_count > 0)
+	{
+		SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION,
+		             "Pipelines: %u compiled in %.2f ms (longest %.2f ms), %u failed, %u started, %u pending.",
+		             stats.compiled_count,
+		             to_ms(stats.compile_ns),
+		             to_ms(stats.max_compile_ns),
+		             stats.failed_count,
+		             stats.started_count,
+		             stats.pending_count);
+	}
+}
+
+void Pipeline_manager::flush()
+{
+	PROFILE_SCOPE("Pipeline manager flush");
+
+	while (!compile_queue.empty() || !compiling.empty())
+	{
+		start_compiles(SIZE_MAX);
+		job_system->wait_for(compile_counter);
+		collect_compiles();
+	}
+}
+
+const Pipeline_stats& Pipeline_manager::get_stats() const
+{
+	return stats;
+}
+
+void Pipeline_manager::queue_compile(Pipeline_handle pipeline)
+{
+	Pipeline_entry& entry = *entries[pipeline];
+	switch (entry.compile_state.load(std::memory_order_relaxed))
+	{
+	case Compile_state::idle:
+		entry.compile_state.store(Compile_state::queued, std::memory_order_relaxed);
+		compile_queue.push_back(pipeline);
+		break;
+	case Compile_state::queued:
+		break;
+	default:
+		// The running compile already copied the old code, go again once it lands
+		entry.recompile = true;
+		break;
+	}
+}
+
+void Pipeline_manager::start_compiles(size_t max_compiles)
+{
+	// Pipeline creation can take milliseconds, capping how many run at once leaves workers for the frame's own jobs
+	while (!compile_queue.empty() && compiling.size() < max_compiles)
+	{
+		Pipeline_handle pipeline = compile_queue.front();
+		Pipeline_entry* entry    = entries[pipeline].get();
+		compile_queue.pop_front();
+
+		// Shader hot reload swaps the code between frames, the job builds from a copy taken now
+		entry->vert_code = shader_manager->get_code(entry->state.vert_shader);
+		entry->frag_code = shader_manager->get_code(entry->state.frag_shader);
+		entry->compile_state.store(Compile_state::compiling, std::memory_order_relaxed);
+		compiling.push_back(pipeline);
+		stats.started_count++;
+
+		job_system->run([this, entry]() { compile(*entry); }, &compile_counter);
+	}
+}
+
+void Pipeline_manager::collect_compiles()
+{
+	for (size_t i = 0; i < compiling.size();)
+	{
+		Pipeline_handle pipeline = compiling[i];
+		Pipeline_entry& entry    = *entries[pipeline];
+		Compile_state   state    = entry.compile_state.load(std::memory_order_acquire);
+
+		if (state == Compile_state::compiled)
+		{
+			// Frames already recorded may have bound the old pipeline
+			if (entry.pipeline != VK_NULL_HANDLE)
+			{
+				retire(entry.pipeline, retire_value);
+			}
+			entry.pipeline = entry.compiled;
+			stats.compiled_count++;
+			stats.compile_ns += entry.compile_ns;
+			stats.max_compile_ns = std::max(stats.max_compile_ns, entry.compile_ns);
+		}
+		else if (state == Compile_state::failed)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create pipeline %u, keeping %s.", pipeline, entry.pipeline != VK_NULL_HANDLE ? "the previous one" : "its fallback");
+			stats.failed_count++;
+		}
+		else
+		{
+			i++;
+			continue;
+		}
+
+		entry.compiled  = VK_NULL_HANDLE;
+		entry.vert_code = {};
+		entry.frag_code = {};
+		entry.compile_state.store(Compile_state::idle, std::memory_order_relaxed);
+		compiling[i] = compiling.back();
+		compiling.pop_back();
+
+		if (entry.recompile)
+		{
+			entry.recompile = false;
+			queue_compile(pipeline);
+		}
+	}
+}
+
+void Pipeline_manager::retire(VkPipeline pipeline, uint64_t timeline_value)
+{
+	retired_pipelines.push_back({pipeline, timeline_value});
+}
+
+void Pipeline_manager::release_retired()
+{
+	for (size_t i = 0; i < retired_pipelines.size();)
+	{
+		if (completed_value < retired_pipelines[i].timeline_value)
+		{
+			i++;
+			continue;
+		}
+
+		vkDestroyPipeline(device, retired_pipelines[i].pipeline, nullptr);
+		retired_pipelines[i] = retired_pipelines.back();
+		retired_pipelines.pop_back();
+	}
+}
+
+void Pipeline_manager::compile(Pipeline_entry& entry) const
+{
+	PROFILE_SCOPE("Compile pipeline");
+
+	uint64_t                       compile_start = SDL_GetTicksNS();
+	const Graphics_pipeline_state& state         = entry.state;
+
+	VkShaderModule vert_shader_module = create_shader_module(device, entry.vert_code);
+	VkShaderModule frag_shader_module = create_shader_module(device, entry.frag_code);
+
+	VkPipelineShaderStageCreateInfo shader_stages[2] = {};
+	shader_stages[0].sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stages[0].stage                           = VK_SHADER_STAGE_VERTEX_BIT;
+	shader_stages[0].module                          = vert_shader_module;
+	shader_stages[0].pName                           = "main";
+	shader_stages[1].sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stages[1].stage                           = VK_SHADER_STAGE_FRAGMENT_BIT;
+	shader_stages[1].module                          = frag_shader_module;
+	shader_stages[1].pName                           = "main";
+
+	VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+
+	VkPipelineDynamicStateCreateInfo dynamic_state = {};
+	dynamic_state.sType                            = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic_state.dynamicStateCount                = 2;
+	dynamic_state.pDynamicStates                   = dynamic_states;
+
+	VkVertexInputBindingDescription binding_description = {};
+	binding_description.binding                         = 0;
+	binding_description.stride                          = state.vertex_stride;
+	binding_description.inputRate                       = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	VkPipelineVertexInputStateCreateInfo vertex_input_info = {};
+	vertex_input_info.sType                                = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input_info.vertexBindingDescriptionCount        = state.vertex_stride > 0 ? 1 : 0;
+	vertex_input_info.pVertexBindingDescriptions           = &binding_description;
+	vertex_input_info.vertexAttributeDescriptionCount      = std::min(state.attribute_count, MAX_VERTEX_ATTRIBUTES);
+	vertex_input_info.pVertexAttributeDescriptions         = state.attributes;
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+	input_assembly.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly.topology                               = state.topology;
+	input_assembly.primitiveRestartEnable                 = VK_FALSE;
+
+	VkPipelineViewportStateCreateInfo viewport_state = {};
+	viewport_state.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount                     = 1;
+	viewport_state.scissorCount                      = 1;
+
+	VkPipelineRasterizationStateCreateInfo rasterizer = {};
+	rasterizer.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterizer.depthClampEnable                       = VK_FALSE;
+	rasterizer.rasterizerDiscardEnable                = VK_FALSE;
+	rasterizer.polygonMode                            = state.polygon_mode;
+	rasterizer.lineWidth                              = 1.0f;
+	rasterizer.cullMode                               = state.cull_mode;
+	rasterizer.frontFace                              = state.front_face;
+	rasterizer.depthBiasEnable                        = VK_FALSE;
+
+	VkPipelineMultisampleStateCreateInfo multisampling = {};
+	multisampling.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisampling.sampleShadingEnable                  = VK_FALSE;
+	multisampling.rasterizationSamples                 = state.samples;
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil = {};
+	depth_stencil.sType                                 = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil.depthTestEnable                       = state.depth_test;
+	depth_stencil.depthWriteEnable                      = state.depth_write;
+	depth_stencil.depthCompareOp                        = state.depth_compare;
+
+	VkPipelineColorBlendAttachmentState color_blend_attachment = {};
+	color_blend_attachment.blendEnable                         = state.blend_enable;
+	color_blend_attachment.srcColorBlendFactor                 = state.src_color_factor;
+	color_blend_attachment.dstColorBlendFactor                 = state.dst_color_factor;
+	color_blend_attachment.colorBlendOp                        = state.color_blend_op;
+	color_blend_attachment.srcAlphaBlendFactor                 = state.src_alpha_factor;
+	color_blend_attachment.dstAlphaBlendFactor                 = state.dst_alpha_factor;
+	color_blend_attachment.alphaBlendOp                        = state.alpha_blend_op;
+	color_blend_attachment.colorWriteMask                      = state.color_write_mask;
+
+	VkPipelineColorBlendStateCreateInfo color_blending = {};
+	color_blending.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blending.logicOpEnable                       = VK_FALSE;
+	color_blending.attachmentCount                     = 1;
+	color_blending.pAttachments                        = &color_blend_attachment;
+
+	VkGraphicsPipelineCreateInfo pipeline_info = {};
+	pipeline_info.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_info.stageCount                   = 2;
+	pipeline_info.pStages                      = shader_stages;
+	pipeline_info.pVertexInputState            = &vertex_input_info;
+	pipeline_info.pInputAssemblyState          = &input_assembly;
+	pipeline_info.pViewportState               = &viewport_state;
+	pipeline_info.pRasterizationState          = &rasterizer;
+	pipeline_info.pMultisampleState            = &multisampling;
+	pipeline_info.pDepthStencilState           = &depth_stencil;
+	pipeline_info.pColorBlendState             = &color_blending;
+	pipeline_info.pDynamicState                = &dynamic_state;
+	pipeline_info.layout                       = state.layout;
+	pipeline_info.renderPass                   = state.render_pass;
+	pipeline_info.subpass                      = 0;
+
+	// Without a render pass the attachment formats are given to the pipeline directly
+	VkPipelineRenderingCreateInfo rendering_info = {};
+	rendering_info.sType                         = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	rendering_info.colorAttachmentCount          = 1;
+	rendering_info.pColorAttachmentFormats       = &state.color_format;
+	rendering_info.depthAttachmentFormat         = state.depth_format;
+	if (state.render_pass == VK_NULL_HANDLE)
+	{
+		pipeline_info.pNext = &rendering_info;
+	}
+
+	// The driver synchronizes the cache itself, sharing it lets every compile hit what earlier runs stored
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkResult   result   = VK_ERROR_INITIALIZATION_FAILED;
+	if (vert_shader_module != VK_NULL_HANDLE && frag_shader_module != VK_NULL_HANDLE)
+	{
+		result = vkCreateGraphicsPipelines(device, pipeline_cache->get_handle(), 1, &pipeline_info, nullptr, &pipeline);
+	}
+
+	vkDestroyShaderModule(device, vert_shader_module, nullptr);
+	vkDestroyShaderModule(device, frag_shader_module, nullptr);
+
+	entry.compiled   = result == VK_SUCCESS ? pipeline : VK_NULL_HANDLE;
+	entry.compile_ns = SDL_GetTicksNS() - compile_start;
+	entry.compile_state.store(result == VK_SUCCESS ? Compile_state::compiled : Compile_state::failed, std::memory_order_release);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/job_system.hpp"
+#include "graphics/pipeline_cache.hpp"
+#include "graphics/shader_manager.hpp"
+
+
+using Pipeline_handle = uint32_t;
+
+constexpr Pipeline_handle INVALID_PIPELINE      = UINT32_MAX;
+constexpr uint32_t        MAX_VERTEX_ATTRIBUTES = 8;
+
+
+// Everything a graphics pipeline is built from, requests with equal states share one pipeline. Viewport and scissor
+// are always dynamic. A render pass selects the classic path, without one the formats are used for dynamic rendering.
+struct Graphics_pipeline_state
+{
+	Shader_handle    vert_shader = 0;
+	Shader_handle    frag_shader = 0;
+	VkPipelineLayout layout      = VK_NULL_HANDLE;
+
+	uint32_t                          vertex_stride   = 0;
+	uint32_t                          attribute_count = 0;
+	VkVertexInputAttributeDescription attributes[MAX_VERTEX_ATTRIBUTES] = {};
+
+	VkPrimitiveTopology topology      = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode       polygon_mode  = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags     cull_mode     = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace         front_face    = VK_FRONT_FACE_CLOCKWISE;
+	bool                depth_test    = false;
+	bool                depth_write   = false;
+	VkCompareOp         depth_compare = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	bool                  blend_enable     = false;
+	VkBlendFactor         src_color_factor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor         dst_color_factor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp             color_blend_op   = VK_BLEND_OP_ADD;
+	VkBlendFactor         src_alpha_factor = VK_BLEND_FACTOR_ONE;
+	VkBlendFactor         dst_alpha_factor = VK_BLEND_FACTOR_ZERO;
+	VkBlendOp             alpha_blend_op   = VK_BLEND_OP_ADD;
+	VkColorComponentFlags color_write_mask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	VkRenderPass          render_pass  = VK_NULL_HANDLE;
+	VkFormat              color_format = VK_FORMAT_UNDEFINED;
+	VkFormat              depth_format = VK_FORMAT_UNDEFINED;
+	VkSampleCountFlagBits samples      = VK_SAMPLE_COUNT_1_BIT;
+};
+
+// Compiles finished and started cover the last update only, the pending count is current
+struct Pipeline_stats
+{
+	uint32_t pipeline_count = 0;
+	uint32_t pending_count  = 0;
+	uint32_t started_count  = 0;
+	uint32_t compiled_count = 0;
+	uint32_t failed_count   = 0;
+	uint64_t compile_ns     = 0;
+	uint64_t max_compile_ns = 0;
+};
+
+// Deduplicates graphics pipelines by a hash of their full state and compiles them on the job system, so a new
+// material never stalls the frame that first draws it. Until its pipeline is ready a request is served its fallback,
+// and a pipeline being rebuilt after a shader edit keeps serving the old one. Replaced pipelines are destroyed once
+// the graphics timeline has passed every submission that may have bound them.
+class Pipeline_manager
+{
+public:
+
+	void startup(VkDevice device, const Pipeline_cache& pipeline_cache, const Shader_manager& shader_manager, Job_system& job_system);
+	void shutdown();
+
+	// The fallback is drawn with until this pipeline is compiled, it has to be requested first
+	Pipeline_handle request(const Graphics_pipeline_state& state, Pipeline_handle fallback = INVALID_PIPELINE);
+
+	// The pipeline to bind this frame, VK_NULL_HANDLE when neither it nor any fallback is ready
+	VkPipeline get(Pipeline_handle pipeline) const;
+	bool       is_ready(Pipeline_handle pipeline) const;
+
+	// Rebuilds every pipeline using the shader, for hot reload
+	void recompile(Shader_handle shader);
+
+	// Call once per frame before recording, with the last submitted and the completed values of the graphics timeline
+	void update(uint64_t retire_value, uint64_t completed_value);
+
+	// For pipelines built elsewhere, such as compute, destroyed once the graphics timeline reaches the value
+	void retire(VkPipeline pipeline, uint64_t timeline_value);
+
+	// Blocks until nothing is queued or compiling, for startup where there is nothing to fall back on yet
+	void flush();
+
+	const Pipeline_stats& get_stats() const;
+
+private:
+
+	// A replaced pipeline is destroyed once the timeline passes the last submission that may have bound it
+	struct Retired_pipeline
+	{
+		VkPipeline pipeline       = VK_NULL_HANDLE;
+		uint64_t   timeline_value = 0;
+	};
+
+	enum class Compile_state : uint32_t
+	{
+		idle,
+		queued,
+		compiling,
+		compiled,
+		failed,
+	};
+
+	// compile_state hands an entry between threads: the job fills in compiled and compile_ns before storing compiled or
+	// failed, and only the main thread touches the other fields
+	struct Pipeline_entry
+	{
+		Graphics_pipeline_state    state;
+		std::vector<uint64_t>      key;
+		Pipeline_handle            fallback      = INVALID_PIPELINE;
+		VkPipeline                 pipeline      = VK_NULL_HANDLE;
+		std::atomic<Compile_state> compile_state = Compile_state::idle;
+		bool                       recompile     = false;
+		VkPipeline                 compiled      = VK_NULL_HANDLE;
+		uint64_t                   compile_ns    = 0;
+		std::vector<char>          vert_code;
+		std::vector<char>          frag_code;
+	};
+
+	VkDevice                                      device          = VK_NULL_HANDLE;
+	const Pipeline_cache*                         pipeline_cache  = nullptr;
+	const Shader_manager*                         shader_manager  = nullptr;
+	Job_system*                                   job_system      = nullptr;
+	uint64_t                                      retire_value    = 0;
+	uint64_t                                      completed_value = 0;
+	std::vector<std::unique_ptr<Pipeline_entry>>  entries;
+	std::unordered_map<uint64_t, Pipeline_handle> entry_lookup;
+	std::deque<Pipeline_handle>                   compile_queue;
+	std::vector<Pipeline_handle>                  compiling;
+	std::vector<Retired_pipeline>                 retired_pipelines;
+	Job_counter                                   compile_counter;
+	Pipeline_stats                                stats;
+
+	void queue_compile(Pipeline_handle pipeline);
+	void start_compiles(size_t max_compiles);
+	void collect_compiles();
+	void release_retired();
+	void compile(Pipeline_entry& entry) const;
+};
@@ -0,0 +1,999 @@
+#include "render_graph.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+
+struct Image_access
+{
+	VkPipelineStageFlags2 stage        = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        access       = VK_ACCESS_2_NONE;
+	VkAccessFlags2        write_access = VK_ACCESS_2_NONE;
+	VkImageLayout         layout       = VK_IMAGE_LAYOUT_UNDEFINED;
+};
+
+struct Render_usage_info
+{
+	VkPipelineStageFlags2 stage        = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        read_access  = VK_ACCESS_2_NONE;
+	VkAccessFlags2        write_access = VK_ACCESS_2_NONE;
+	VkImageLayout         read_layout  = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImageLayout         write_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImageUsageFlags     read_usage   = 0;
+	VkImageUsageFlags     write_usage  = 0;
+};
+
+// A write layout of VK_IMAGE_LAYOUT_UNDEFINED marks a usage that cannot be written
+static const Render_usage_info USAGE_INFOS[] = {
+    {},
+    {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+     VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
+     VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+     VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT},
+    {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+     VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+     VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+     VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+     VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+     VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT},
+    {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_SAMPLED_BIT, 0},
+    {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_USAGE_SAMPLED_BIT, 0},
+    {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+     VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+     VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+     VK_IMAGE_LAYOUT_GENERAL,
+     VK_IMAGE_LAYOUT_GENERAL,
+     VK_IMAGE_USAGE_STORAGE_BIT,
+     VK_IMAGE_USAGE_STORAGE_BIT},
+    {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+     VK_ACCESS_2_TRANSFER_READ_BIT,
+     VK_ACCESS_2_TRANSFER_WRITE_BIT,
+     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+     VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+     VK_IMAGE_USAGE_TRANSFER_DST_BIT},
+    {VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, VK_ACCESS_2_NONE, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0},
+};
+
+static_assert(std::size(USAGE_INFOS) == static_cast<size_t>(Render_usage::count), "Every render usage needs its barrier info");
+
+
+struct Flag_name
+{
+	uint64_t    flag;
+	const char* name;
+};
+
+static const Flag_name STAGE_NAMES[] = {
+    {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, "color output"},
+    {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT, "early tests"},
+    {VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT, "late tests"},
+    {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, "fragment"},
+    {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, "compute"},
+    {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, "transfer"},
+};
+
+static const Flag_name ACCESS_NAMES[] = {
+    {VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT, "color read"},
+    {VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, "color write"},
+    {VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, "depth read"},
+    {VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, "depth write"},
+    {VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, "sampled read"},
+    {VK_ACCESS_2_SHADER_STORAGE_READ_BIT, "storage read"},
+    {VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, "storage write"},
+    {VK_ACCESS_2_TRANSFER_READ_BIT, "transfer read"},
+    {VK_ACCESS_2_TRANSFER_WRITE_BIT, "transfer write"},
+};
+
+
+static std::string get_flag_names(uint64_t flags, const Flag_name* names, size_t name_count)
+{
+	std::string text;
+	for (size_t i = 0; i < name_count; i++)
+	{
+		if (flags & names[i].flag)
+		{
+			text += text.empty() ? names[i].name : std::string(" | ") + names[i].name;
+		}
+	}
+	return text.empty() ? "none" : text;
+}
+
+static const char* get_layout_name(VkImageLayout layout)
+{
+	switch (layout)
+	{
+	case VK_IMAGE_LAYOUT_UNDEFINED:
+		return "undefined";
+	case VK_IMAGE_LAYOUT_GENERAL:
+		return "general";
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+		return "color attachment";
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+		return "depth attachment";
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+		return "depth read only";
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+		return "shader read only";
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+		return "transfer source";
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+		return "transfer destination";
+	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+		return "present";
+	default:
+		return "other";
+	}
+}
+
+static VkImageAspectFlags get_aspect(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_D16_UNORM:
+	case VK_FORMAT_D32_SFLOAT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	case VK_FORMAT_S8_UINT:
+		return VK_IMAGE_ASPECT_STENCIL_BIT;
+	case VK_FORMAT_D16_UNORM_S8_UINT:
+	case VK_FORMAT_D24_UNORM_S8_UINT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	default:
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+	}
+}
+
+static Image_access get_access(Render_usage usage, bool read, bool written)
+{
+	const Render_usage_info& info = USAGE_INFOS[static_cast<size_t>(usage)];
+
+	Image_access access;
+	access.stage        = info.stage;
+	access.access       = (read ? info.read_access : VK_ACCESS_2_NONE) | (written ? info.write_access : VK_ACCESS_2_NONE);
+	access.write_access = written ? info.write_access : VK_ACCESS_2_NONE;
+	access.layout       = written ? info.write_layout : info.read_layout;
+	return access;
+}
+
+static double to_mib(VkDeviceSize bytes)
+{
+	return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+
+// What is known about an image while barriers are placed: its last write, and the reads and stages since then
+struct Image_state
+{
+	VkImageLayout         layout            = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkPipelineStageFlags2 write_stage       = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        write_access      = VK_ACCESS_2_NONE;
+	VkPipelineStageFlags2 read_stages       = VK_PIPELINE_STAGE_2_NONE;
+	VkPipelineStageFlags2 visible_stages    = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        visible_access    = VK_ACCESS_2_NONE;
+	bool                  wait_at_first_use = false;
+	bool                  used              = false;
+};
+
+static bool transition(Image_state& state, const Image_access& access, bool written, Render_barrier& barrier)
+{
+	VkPipelineStageFlags2 src_stage  = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        src_access = VK_ACCESS_2_NONE;
+	bool                  needed     = false;
+
+	if (written || access.layout != state.layout)
+	{
+		// Writes and layout transitions wait for every access since the last write, whose data a read barrier already made available
+		src_stage  = state.write_stage | state.read_stages;
+		src_access = state.visible_stages == VK_PIPELINE_STAGE_2_NONE ? state.write_access : VK_ACCESS_2_NONE;
+		needed     = src_stage != VK_PIPELINE_STAGE_2_NONE || access.layout != state.layout;
+	}
+	else if (state.write_stage != VK_PIPELINE_STAGE_2_NONE && ((access.stage & ~state.visible_stages) || (access.access & ~state.visible_access)))
+	{
+		src_stage  = state.write_stage;
+		src_access = state.write_access;
+		needed     = true;
+	}
+
+	// An image handed over by a semaphore is waited for at the stage the semaphore wait is on, which is its first use
+	if (state.wait_at_first_use)
+	{
+		src_stage               = access.stage;
+		src_access              = VK_ACCESS_2_NONE;
+		needed                  = true;
+		state.wait_at_first_use = false;
+	}
+
+	barrier.old_layout = state.layout;
+	barrier.new_layout = access.layout;
+	barrier.src_stage  = src_stage;
+	barrier.src_access = src_access;
+	barrier.dst_stage  = access.stage;
+	barrier.dst_access = access.access;
+
+	if (written)
+	{
+		state.write_stage    = access.stage;
+		state.write_access   = access.write_access;
+		state.read_stages    = VK_PIPELINE_STAGE_2_NONE;
+		state.visible_stages = VK_PIPELINE_STAGE_2_NONE;
+		state.visible_access = VK_ACCESS_2_NONE;
+	}
+	else
+	{
+		state.read_stages |= access.stage;
+		if (needed)
+		{
+			state.visible_stages |= access.stage;
+			state.visible_access |= access.access;
+		}
+	}
+	state.layout = access.layout;
+	state.used   = true;
+
+	return needed;
+}
+
+
+void Render_graph::reset()
+{
+	release();
+	passes.clear();
+	images.clear();
+	schedule.clear();
+	barriers.clear();
+	final_barriers.clear();
+}
+
+void Render_graph::release()
+{
+	for (Render_image& image : images)
+	{
+		if (image.imported)
+		{
+			continue;
+		}
+
+		if (image.image_view != VK_NULL_HANDLE)
+		{
+			vkDestroyImageView(device, image.image_view, nullptr);
+		}
+		if (image.image != VK_NULL_HANDLE)
+		{
+			vkDestroyImage(device, image.image, nullptr);
+		}
+		image.image_view = VK_NULL_HANDLE;
+		image.image      = VK_NULL_HANDLE;
+	}
+
+	for (Render_heap& heap : heaps)
+	{
+		if (heap.allocation.memory != VK_NULL_HANDLE)
+		{
+			gpu_allocator->free(heap.allocation);
+		}
+	}
+	heaps.clear();
+}
+
+Render_resource Render_graph::create_image(const std::string& name, const Render_image_desc& desc)
+{
+	Render_image image;
+	image.name = name;
+	image.desc = desc;
+	images.push_back(image);
+	return static_cast<Render_resource>(images.size() - 1);
+}
+
+Render_resource Render_graph::import_image(const std::string& name, const Render_image_desc& desc, Render_usage initial_usage, Render_usage final_usage)
+{
+	Render_image image;
+	image.name          = name;
+	image.desc          = desc;
+	image.imported      = true;
+	image.initial_usage = initial_usage;
+	image.final_usage   = final_usage;
+	images.push_back(image);
+	return static_cast<Render_resource>(images.size() - 1);
+}
+
+void Render_graph::set_imported_image(Render_resource resource, VkImage image, VkImageView image_view)
+{
+	if (resource < images.size() && images[resource].imported)
+	{
+		images[resource].image      = image;
+		images[resource].image_view = image_view;
+	}
+}
+
+Render_pass_handle Render_graph::add_pass(const std::string& name, Render_pass_function function, bool side_effects)
+{
+	Render_pass_node pass;
+	pass.name         = name;
+	pass.function     = std::move(function);
+	pass.side_effects = side_effects;
+	passes.push_back(std::move(pass));
+	return static_cast<Render_pass_handle>(passes.size() - 1);
+}
+
+void Render_graph::read(Render_pass_handle pass, Render_resource resource, Render_usage usage)
+{
+	use(pass, resource, usage, false);
+}
+
+void Render_graph::write(Render_pass_handle pass, Render_resource resource, Render_usage usage)
+{
+	use(pass, resource, usage, true);
+}
+
+void Render_graph::use(Render_pass_handle pass, Render_resource resource, Render_usage usage, bool written)
+{
+	if (pass >= passes.size() || resource >= images.size())
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Render graph use of an unknown pass or image.");
+		return;
+	}
+
+	const Render_usage_info& info = USAGE_INFOS[static_cast<size_t>(usage)];
+	if (usage == Render_usage::none || usage == Render_usage::present || (written && info.write_layout == VK_IMAGE_LAYOUT_UNDEFINED))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Pass %s cannot %s %s that way.", passes[pass].name.c_str(), written ? "write" : "read", images[resource].name.c_str());
+		return;
+	}
+
+	// A pass that reads and writes an image has to use it one way, a feedback loop needs two layouts at once
+	for (Render_use& existing : passes[pass].uses)
+	{
+		if (existing.resource != resource)
+		{
+			continue;
+		}
+
+		if (existing.usage != usage)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Pass %s uses %s in two different ways.", passes[pass].name.c_str(), images[resource].name.c_str());
+			return;
+		}
+		existing.written |= written;
+		existing.read |= !written;
+		images[resource].usage |= written ? info.write_usage : info.read_usage;
+		return;
+	}
+
+	passes[pass].uses.push_back({resource, usage, written, !written});
+	images[resource].usage |= written ? info.write_usage : info.read_usage;
+}
+
+bool Render_graph::compile(const Image_requirements_function& get_requirements)
+{
+	schedule.clear();
+	barriers.clear();
+	final_barriers.clear();
+	heaps.clear();
+	for (Render_image& image : images)
+	{
+		image.placed       = false;
+		image.placement    = {};
+		image.requirements = {};
+	}
+
+	build_dependencies();
+	cull_passes();
+	order_passes();
+	place_images(get_requirements);
+	place_barriers();
+
+	return !schedule.empty();
+}
+
+bool Render_graph::compile(VkDevice device, Gpu_allocator& gpu_allocator)
+{
+	release();
+	this->device        = device;
+	this->gpu_allocator = &gpu_allocator;
+
+	// Images are created as their requirements are asked for, so only the ones that survive culling exist
+	bool images_created   = true;
+	auto get_requirements = [&](Render_resource resource)
+	{
+		VkMemoryRequirements requirements = {};
+		if (create_transient_image(images[resource]))
+		{
+			vkGetImageMemoryRequirements(device, images[resource].image, &requirements);
+		}
+		else
+		{
+			images_created = false;
+		}
+		return requirements;
+	};
+
+	bool compiled = compile(get_requirements);
+	if (!compiled || !images_created || !bind_images())
+	{
+		release();
+		return false;
+	}
+
+	return true;
+}
+
+void Render_graph::execute(VkCommandBuffer command_buffer) const
+{
+	for (size_t i = 0; i < schedule.size(); i++)
+	{
+		record_barriers(command_buffer, barriers[i]);
+
+		const Render_pass_node& pass = passes[schedule[i]];
+		if (pass.function)
+		{
+			pass.function(command_buffer);
+		}
+	}
+
+	record_barriers(command_buffer, final_barriers);
+}
+
+VkImage Render_graph::get_image(Render_resource resource) const
+{
+	return resource < images.size() ? images[resource].image : VK_NULL_HANDLE;
+}
+
+VkImageView Render_graph::get_image_view(Render_resource resource) const
+{
+	return resource < images.size() ? images[resource].image_view : VK_NULL_HANDLE;
+}
+
+const Render_image_desc& Render_graph::get_desc(Render_resource resource) const
+{
+	return images[resource].desc;
+}
+
+const std::vector<Render_pass_handle>& Render_graph::get_schedule() const
+{
+	return schedule;
+}
+
+const std::vector<Render_barrier>& Render_graph::get_barriers(uint32_t schedule_index) const
+{
+	return barriers[schedule_index];
+}
+
+const std::vector<Render_barrier>& Render_graph::get_final_barriers() const
+{
+	return final_barriers;
+}
+
+const Render_placement& Render_graph::get_placement(Render_resource resource) const
+{
+	return images[resource].placement;
+}
+
+bool Render_graph::is_placed(Render_resource resource) const
+{
+	return resource < images.size() && images[resource].placed;
+}
+
+const std::string& Render_graph::get_name(Render_resource resource) const
+{
+	return images[resource].name;
+}
+
+uint32_t Render_graph::get_image_count() const
+{
+	return static_cast<uint32_t>(images.size());
+}
+
+VkDeviceSize Render_graph::get_heap_size(uint32_t heap) const
+{
+	return heap < heaps.size() ? heaps[heap].size : 0;
+}
+
+uint32_t Render_graph::get_heap_count() const
+{
+	return static_cast<uint32_t>(heaps.size());
+}
+
+void Render_graph::log_schedule() const
+{
+	SDL_Log("Render graph: %zu of %zu passes scheduled.", schedule.size(), passes.size());
+	for (const Render_pass_node& pass : passes)
+	{
+		if (!pass.live)
+		{
+			SDL_Log("  culled %s", pass.name.c_str());
+		}
+	}
+
+	auto log_barrier = [this](const Render_barrier& barrier)
+	{
+		SDL_Log("      %-16s %s -> %s, %s (%s) -> %s (%s)",
+		        images[barrier.resource].name.c_str(),
+		        get_layout_name(barrier.old_layout),
+		        get_layout_name(barrier.new_layout),
+		        get_flag_names(barrier.src_stage, STAGE_NAMES, std::size(STAGE_NAMES)).c_str(),
+		        get_flag_names(barrier.src_access, ACCESS_NAMES, std::size(ACCESS_NAMES)).c_str(),
+		        get_flag_names(barrier.dst_stage, STAGE_NAMES, std::size(STAGE_NAMES)).c_str(),
+		        get_flag_names(barrier.dst_access, ACCESS_NAMES, std::size(ACCESS_NAMES)).c_str());
+	};
+
+	for (size_t i = 0; i < schedule.size(); i++)
+	{
+		SDL_Log("  %2zu %s, %zu barriers", i, passes[schedule[i]].name.c_str(), barriers[i].size());
+		for (const Render_barrier& barrier : barriers[i])
+		{
+			log_barrier(barrier);
+		}
+	}
+	SDL_Log("  end, %zu barriers", final_barriers.size());
+	for (const Render_barrier& barrier : final_barriers)
+	{
+		log_barrier(barrier);
+	}
+
+	VkDeviceSize unaliased_size = 0;
+	VkDeviceSize aliased_size   = 0;
+	for (uint32_t heap = 0; heap < heaps.size(); heap++)
+	{
+		SDL_Log("  heap %u, %.2f MiB", heap, to_mib(heaps[heap].size));
+		for (const Render_image& image : images)
+		{
+			if (image.placed && image.placement.heap == heap)
+			{
+				SDL_Log("      %-16s %8.2f MiB at %8.2f MiB, passes %u to %u",
+				        image.name.c_str(),
+				        to_mib(image.placement.size),
+				        to_mib(image.placement.offset),
+				        image.placement.first_pass,
+				        image.placement.last_pass);
+				unaliased_size += image.placement.size;
+			}
+		}
+		aliased_size += heaps[heap].size;
+	}
+	SDL_Log("  transient images take %.2f MiB, %.2f MiB without aliasing.", to_mib(aliased_size), to_mib(unaliased_size));
+}
+
+void Render_graph::build_dependencies()
+{
+	std::vector<Render_pass_handle>              last_writers(images.size(), INVALID_RENDER_PASS);
+	std::vector<std::vector<Render_pass_handle>> readers(images.size());
+
+	// Passes only ever depend on passes declared before them, so declaration order is always a valid schedule
+	for (Render_pass_handle pass = 0; pass < passes.size(); pass++)
+	{
+		Render_pass_node& node = passes[pass];
+		node.dependencies.clear();
+		node.order_dependencies.clear();
+
+		for (const Render_use& use : node.uses)
+		{
+			Render_pass_handle last_writer = last_writers[use.resource];
+
+			// A write that does not also read replaces the whole image, the previous contents are only ordered against
+			if (use.read && last_writer != INVALID_RENDER_PASS)
+			{
+				node.dependencies.push_back(last_writer);
+			}
+
+			if (!use.written)
+			{
+				readers[use.resource].push_back(pass);
+				continue;
+			}
+
+			if (last_writer != INVALID_RENDER_PASS)
+			{
+				node.order_dependencies.push_back(last_writer);
+			}
+			for (Render_pass_handle reader : readers[use.resource])
+			{
+				if (reader != pass)
+				{
+					node.order_dependencies.push_back(reader);
+				}
+			}
+			last_writers[use.resource] = pass;
+			readers[use.resource].clear();
+		}
+
+		std::sort(node.dependencies.begin(), node.dependencies.end());
+		node.dependencies.erase(std::unique(node.dependencies.begin(), node.dependencies.end()), node.dependencies.end());
+		std::sort(node.order_dependencies.begin(), node.order_dependencies.end());
+		node.order_dependencies.erase(std::unique(node.order_dependencies.begin(), node.order_dependencies.end()), node.order_dependencies.end());
+	}
+}
+
+void Render_graph::cull_passes()
+{
+	// Whatever leaves the graph through an imported image is an output, everything else has to be read to matter
+	for (Render_pass_node& pass : passes)
+	{
+		pass.live = pass.side_effects;
+		for (const Render_use& use : pass.uses)
+		{
+			pass.live |= use.written && images[use.resource].imported;
+		}
+	}
+
+	for (size_t pass = passes.size(); pass-- > 0;)
+	{
+		if (!passes[pass].live)
+		{
+			continue;
+		}
+
+		for (Render_pass_handle dependency : passes[pass].dependencies)
+		{
+			passes[dependency].live = true;
+		}
+	}
+}
+
+void Render_graph::order_passes()
+{
+	std::vector<uint32_t>                        remaining(passes.size(), 0);
+	std::vector<std::vector<Render_pass_handle>> dependents(passes.size());
+	for (Render_pass_handle pass = 0; pass < passes.size(); pass++)
+	{
+		if (!passes[pass].live)
+		{
+			continue;
+		}
+
+		auto add_edges = [&](const std::vector<Render_pass_handle>& dependencies)
+		{
+			for (Render_pass_handle dependency : dependencies)
+			{
+				if (passes[dependency].live)
+				{
+					dependents[dependency].push_back(pass);
+					remaining[pass]++;
+				}
+			}
+		};
+		add_edges(passes[pass].dependencies);
+		add_edges(passes[pass].order_dependencies);
+	}
+
+	std::vector<Render_pass_handle> ready;
+	for (Render_pass_handle pass = 0; pass < passes.size(); pass++)
+	{
+		if (passes[pass].live && remaining[pass] == 0)
+		{
+			ready.push_back(pass);
+		}
+	}
+
+	// A pass that does not depend on the one just scheduled goes first, so a barrier has other work to overlap with
+	while (!ready.empty())
+	{
+		size_t chosen = 0;
+		if (!schedule.empty())
+		{
+			Render_pass_handle previous = schedule.back();
+			for (size_t i = 0; i < ready.size(); i++)
+			{
+				const std::vector<Render_pass_handle>& dependencies = passes[ready[i]].dependencies;
+				if (!std::binary_search(dependencies.begin(), dependencies.end(), previous))
+				{
+					chosen = i;
+					break;
+				}
+			}
+		}
+
+		Render_pass_handle pass = ready[chosen];
+		ready.erase(ready.begin() + chosen);
+		schedule.push_back(pass);
+
+		for (Render_pass_handle dependent : dependents[pass])
+		{
+			if (--remaining[dependent] == 0)
+			{
+				ready.insert(std::upper_bound(ready.begin(), ready.end(), dependent), dependent);
+			}
+		}
+	}
+}
+
+void Render_graph::place_images(const Image_requirements_function& get_requirements)
+{
+	std::vector<Render_resource> transients;
+	for (uint32_t index = 0; index < schedule.size(); index++)
+	{
+		for (const Render_use& use : passes[schedule[index]].uses)
+		{
+			Render_image& image = images[use.resource];
+			if (image.imported)
+			{
+				continue;
+			}
+
+			if (!image.placed)
+			{
+				image.placed               = true;
+				image.placement.first_pass = index;
+				transients.push_back(use.resource);
+			}
+			image.placement.last_pass = index;
+		}
+	}
+
+	for (Render_resource resource : transients)
+	{
+		images[resource].requirements   = get_requirements(resource);
+		images[resource].placement.size = images[resource].requirements.size;
+	}
+
+	// Largest first, the small images then fill the gaps the large ones leave between their lifetimes
+	std::sort(transients.begin(),
+	          transients.end(),
+	          [this](Render_resource a, Render_resource b)
+	          {
+		          return images[a].placement.size != images[b].placement.size ? images[a].placement.size > images[b].placement.size : a < b;
+	          });
+
+	std::vector<Render_resource> placed;
+	for (Render_resource resource : transients)
+	{
+		Render_image&               image        = images[resource];
+		const VkMemoryRequirements& requirements = image.requirements;
+
+		uint32_t heap = 0;
+		while (heap < heaps.size() && !(heaps[heap].memory_type_bits & requirements.memoryTypeBits))
+		{
+			heap++;
+		}
+		if (heap == heaps.size())
+		{
+			heaps.emplace_back();
+		}
+
+		// Only images alive at the same time get in the way, the lowest offset that clears all of them wins
+		std::vector<const Render_placement*> overlapping;
+		for (Render_resource other : placed)
+		{
+			const Render_placement& placement = images[other].placement;
+			if (placement.heap == heap && placement.first_pass <= image.placement.last_pass && image.placement.first_pass <= placement.last_pass)
+			{
+				overlapping.push_back(&placement);
+			}
+		}
+
+		VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+		VkDeviceSize offset    = 0;
+		for (bool moved = true; moved;)
+		{
+			moved = false;
+			for (const Render_placement* placement : overlapping)
+			{
+				if (offset < placement->offset + placement->size && placement->offset < offset + image.placement.size)
+				{
+					offset = (placement->offset + placement->size + alignment - 1) / alignment * alignment;
+					moved  = true;
+				}
+			}
+		}
+
+		image.placement.heap   = heap;
+		image.placement.offset = offset;
+		heaps[heap].size       = std::max(heaps[heap].size, offset + image.placement.size);
+		heaps[heap].alignment  = std::max(heaps[heap].alignment, alignment);
+		heaps[heap].memory_type_bits &= requirements.memoryTypeBits;
+		placed.push_back(resource);
+	}
+}
+
+void Render_graph::place_barriers()
+{
+	// Each image's last use is what whoever takes its memory next, or itself in the next frame, has to wait for
+	std::vector<Image_access> last_accesses(images.size());
+	for (Render_pass_handle pass : schedule)
+	{
+		for (const Render_use& use : passes[pass].uses)
+		{
+			last_accesses[use.resource] = get_access(use.usage, use.read, use.written);
+		}
+	}
+
+	std::vector<Image_state> states(images.size());
+	for (Render_resource resource = 0; resource < images.size(); resource++)
+	{
+		const Render_image& image = images[resource];
+		Image_state&        state = states[resource];
+
+		if (!image.imported)
+		{
+			if (!image.placed)
+			{
+				continue;
+			}
+
+			for (Render_resource other = 0; other < images.size(); other++)
+			{
+				const Render_placement& placement = images[other].placement;
+				if (!images[other].placed || placement.heap != image.placement.heap || placement.offset >= image.placement.offset + image.placement.size ||
+				    image.placement.offset >= placement.offset + placement.size)
+				{
+					continue;
+				}
+				state.write_stage |= last_accesses[other].stage;
+				state.write_access |= last_accesses[other].write_access;
+			}
+		}
+		else if (image.initial_usage == Render_usage::none)
+		{
+			state.wait_at_first_use = true;
+		}
+		else
+		{
+			const Render_usage_info& info = USAGE_INFOS[static_cast<size_t>(image.initial_usage)];
+			if (info.write_layout != VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				state.layout       = info.write_layout;
+				state.write_stage  = info.stage;
+				state.write_access = info.write_access;
+			}
+			else
+			{
+				state.layout         = info.read_layout;
+				state.read_stages    = info.stage;
+				state.visible_stages = info.stage;
+				state.visible_access = info.read_access;
+			}
+		}
+	}
+
+	barriers.resize(schedule.size());
+	for (size_t i = 0; i < schedule.size(); i++)
+	{
+		for (const Render_use& use : passes[schedule[i]].uses)
+		{
+			Render_barrier barrier;
+			barrier.resource = use.resource;
+			if (transition(states[use.resource], get_access(use.usage, use.read, use.written), use.written, barrier))
+			{
+				barriers[i].push_back(barrier);
+			}
+		}
+	}
+
+	for (Render_resource resource = 0; resource < images.size(); resource++)
+	{
+		const Render_image& image = images[resource];
+		if (!image.imported || image.final_usage == Render_usage::none || !states[resource].used)
+		{
+			continue;
+		}
+
+		Render_barrier barrier;
+		barrier.resource = resource;
+		if (transition(states[resource], get_access(image.final_usage, true, false), false, barrier))
+		{
+			final_barriers.push_back(barrier);
+		}
+	}
+}
+
+bool Render_graph::create_transient_image(Render_image& image)
+{
+	VkImageCreateInfo image_info = {};
+	image_info.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_info.imageType         = VK_IMAGE_TYPE_2D;
+	image_info.extent.width      = image.desc.extent.width;
+	image_info.extent.height     = image.desc.extent.height;
+	image_info.extent.depth      = 1;
+	image_info.mipLevels         = 1;
+	image_info.arrayLayers       = 1;
+	image_info.format            = image.desc.format;
+	image_info.tiling            = VK_IMAGE_TILING_OPTIMAL;
+	image_info.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+	image_info.usage             = image.usage;
+	image_info.samples           = VK_SAMPLE_COUNT_1_BIT;
+	image_info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+
+	if (vkCreateImage(device, &image_info, nullptr, &image.image) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create render graph image %s.", image.name.c_str());
+		image.image = VK_NULL_HANDLE;
+		return false;
+	}
+
+	return true;
+}
+
+bool Render_graph::bind_images()
+{
+	for (Render_heap& heap : heaps)
+	{
+		VkMemoryRequirements requirements = {};
+		requirements.size                 = heap.size;
+		requirements.alignment            = heap.alignment;
+		requirements.memoryTypeBits       = heap.memory_type_bits;
+
+		if (!gpu_allocator->allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, heap.allocation))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate %.2f MiB for render graph images.", to_mib(heap.size));
+			return false;
+		}
+	}
+
+	for (Render_image& image : images)
+	{
+		if (image.imported || !image.placed)
+		{
+			continue;
+		}
+
+		const Gpu_allocation& allocation = heaps[image.placement.heap].allocation;
+		if (vkBindImageMemory(device, image.image, allocation.memory, allocation.offset + image.placement.offset) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to bind render graph image %s.", image.name.c_str());
+			return false;
+		}
+
+		VkImageViewCreateInfo view_info           = {};
+		view_info.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		view_info.image                           = image.image;
+		view_info.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+		view_info.format                          = image.desc.format;
+		view_info.subresourceRange.aspectMask     = get_aspect(image.desc.format);
+		view_info.subresourceRange.baseMipLevel   = 0;
+		view_info.subresourceRange.levelCount     = 1;
+		view_info.subresourceRange.baseArrayLayer = 0;
+		view_info.subresourceRange.layerCount     = 1;
+
+		if (vkCreateImageView(device, &view_info, nullptr, &image.image_view) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create render graph image view %s.", image.name.c_str());
+			image.image_view = VK_NULL_HANDLE;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Render_graph::record_barriers(VkCommandBuffer command_buffer, const std::vector<Render_barrier>& pass_barriers) const
+{
+	if (pass_barriers.empty())
+	{
+		return;
+	}
+
+	// Imported images may change every frame, so the Vulkan barriers are filled in as they are recorded
+	image_barriers.clear();
+	for (const Render_barrier& barrier : pass_barriers)
+	{
+		const Render_image& image = images[barrier.resource];
+
+		VkImageMemoryBarrier2 image_barrier           = {};
+		image_barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		image_barrier.srcStageMask                    = barrier.src_stage;
+		image_barrier.srcAccessMask                   = barrier.src_access;
+		image_barrier.dstStageMask                    = barrier.dst_stage;
+		image_barrier.dstAccessMask                   = barrier.dst_access;
+		image_barrier.oldLayout                       = barrier.old_layout;
+		image_barrier.newLayout                       = barrier.new_layout;
+		image_barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+		image_barrier.image                           = image.image;
+		image_barrier.subresourceRange.aspectMask     = get_aspect(image.desc.format);
+		image_barrier.subresourceRange.baseMipLevel   = 0;
+		image_barrier.subresourceRange.levelCount     = 1;
+		image_barrier.subresourceRange.baseArrayLayer = 0;
+		image_barrier.subresourceRange.layerCount     = 1;
+		image_barriers.push_back(image_barrier);
+	}
+
+	VkDependencyInfo dependency_info        = {};
+	dependency_info.sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(image_barriers.size());
+	dependency_info.pImageMemoryBarriers    = image_barriers.data();
+	vkCmdPipelineBarrier2(command_buffer, &dependency_info);
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "graphics/gpu_allocator.hpp"
+
+
+using Render_resource    = uint32_t;
+using Render_pass_handle = uint32_t;
+
+constexpr Render_resource    INVALID_RENDER_RESOURCE = UINT32_MAX;
+constexpr Render_pass_handle INVALID_RENDER_PASS     = UINT32_MAX;
+
+using Render_pass_function        = std::function<void(VkCommandBuffer command_buffer)>;
+using Image_requirements_function = std::function<VkMemoryRequirements(Render_resource resource)>;
+
+// What an image is used as, together with read or write this picks the stages, accesses and layout of its barriers
+enum class Render_usage : uint8_t
+{
+	none,
+	color_attachment,
+	depth_attachment,
+	fragment_sampled,
+	compute_sampled,
+	compute_storage,
+	transfer,
+	present,
+	count
+};
+
+struct Render_image_desc
+{
+	VkFormat   format = VK_FORMAT_UNDEFINED;
+	VkExtent2D extent = {};
+};
+
+struct Render_barrier
+{
+	Render_resource       resource   = INVALID_RENDER_RESOURCE;
+	VkImageLayout         old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkImageLayout         new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkPipelineStageFlags2 src_stage  = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        src_access = VK_ACCESS_2_NONE;
+	VkPipelineStageFlags2 dst_stage  = VK_PIPELINE_STAGE_2_NONE;
+	VkAccessFlags2        dst_access = VK_ACCESS_2_NONE;
+};
+
+// Where a transient image lives, first and last index into the schedule bound the range it may not share memory in
+struct Render_placement
+{
+	uint32_t     heap       = 0;
+	VkDeviceSize offset     = 0;
+	VkDeviceSize size       = 0;
+	uint32_t     first_pass = 0;
+	uint32_t     last_pass  = 0;
+};
+
+// Passes declare the images they read and write, compiling culls the passes nothing depends on, orders the rest,
+// works out the barriers between them and packs transient images with disjoint lifetimes into shared memory.
+// Compiling never touches the GPU when the memory requirements come from the caller, so a graph can be checked
+// without a device. Barriers are synchronization2, the graph needs a device that enabled it.
+class Render_graph
+{
+public:
+
+	// Releases the GPU resources too, the graph is empty afterwards
+	void reset();
+	void release();
+
+	Render_resource create_image(const std::string& name, const Render_image_desc& desc);
+
+	// Imported images are not aliased, initial_usage is how they were last written (none discards the contents)
+	// and final_usage is the state they are left in for whoever uses them after the graph
+	Render_resource import_image(const std::string& name, const Render_image_desc& desc, Render_usage initial_usage, Render_usage final_usage);
+	void            set_imported_image(Render_resource resource, VkImage image, VkImageView image_view);
+
+	// Passes with side effects are never culled, passes that write an imported image are kept for the same reason.
+	// A write that does not also read replaces the whole image, a pass that loads the previous contents declares both.
+	Render_pass_handle add_pass(const std::string& name, Render_pass_function function, bool side_effects = false);
+	void               read(Render_pass_handle pass, Render_resource resource, Render_usage usage);
+	void               write(Render_pass_handle pass, Render_resource resource, Render_usage usage);
+
+	// CPU only, the requirements of every transient image that survives culling are asked for once
+	bool compile(const Image_requirements_function& get_requirements);
+
+	// Creates, allocates and binds the transient images as well
+	bool compile(VkDevice device, Gpu_allocator& gpu_allocator);
+
+	void execute(VkCommandBuffer command_buffer) const;
+
+	VkImage     get_image(Render_resource resource) const;
+	VkImageView get_image_view(Render_resource resource) const;
+
+	// Inspection of the compiled graph, placements only exist for transient images a scheduled pass uses
+	const std::string&                     get_name(Render_resource resource) const;
+	const Render_image_desc&               get_desc(Render_resource resource) const;
+	uint32_t                               get_image_count() const;
+	const std::vector<Render_pass_handle>& get_schedule() const;
+	const std::vector<Render_barrier>&     get_barriers(uint32_t schedule_index) const;
+	const std::vector<Render_barrier>&     get_final_barriers() const;
+	bool                                   is_placed(Render_resource resource) const;
+	const Render_placement&                get_placement(Render_resource resource) const;
+	VkDeviceSize                           get_heap_size(uint32_t heap) const;
+	uint32_t                               get_heap_count() const;
+
+	void log_schedule() const;
+
+private:
+
+	struct Render_use
+	{
+		Render_resource resource = INVALID_RENDER_RESOURCE;
+		Render_usage    usage    = Render_usage::none;
+		bool            written  = false;
+		bool            read     = false;
+	};
+
+	struct Render_pass_node
+	{
+		std::string                     name;
+		Render_pass_function            function;
+		std::vector<Render_use>         uses;
+		std::vector<Render_pass_handle> dependencies;
+		std::vector<Render_pass_handle> order_dependencies;
+		bool                            side_effects = false;
+		bool                            live         = false;
+	};
+
+	struct Render_image
+	{
+		std::string          name;
+		Render_image_desc    desc;
+		VkImageUsageFlags    usage         = 0;
+		bool                 imported      = false;
+		Render_usage         initial_usage = Render_usage::none;
+		Render_usage         final_usage   = Render_usage::none;
+		VkImage              image         = VK_NULL_HANDLE;
+		VkImageView          image_view    = VK_NULL_HANDLE;
+		VkMemoryRequirements requirements  = {};
+		Render_placement     placement;
+		bool                 placed = false;
+	};
+
+	struct Render_heap
+	{
+		VkDeviceSize   size             = 0;
+		VkDeviceSize   alignment        = 1;
+		uint32_t       memory_type_bits = UINT32_MAX;
+		Gpu_allocation allocation;
+	};
+
+	std::vector<Render_pass_node>              passes;
+	std::vector<Render_image>                  images;
+	std::vector<Render_pass_handle>            schedule;
+	std::vector<std::vector<Render_barrier>>   barriers;
+	std::vector<Render_barrier>                final_barriers;
+	std::vector<Render_heap>                   heaps;
+	VkDevice                                   device        = VK_NULL_HANDLE;
+	Gpu_allocator*                             gpu_allocator = nullptr;
+	mutable std::vector<VkImageMemoryBarrier2> image_barriers;
+
+	void use(Render_pass_handle pass, Render_resource resource, Render_usage usage, bool written);
+	void build_dependencies();
+	void cull_passes();
+	void order_passes();
+	void place_images(const Image_requirements_function& get_requirements);
+	void place_barriers();
+	bool create_transient_image(Render_image& image);
+	bool bind_images();
+	void record_barriers(VkCommandBuffer command_buffer, const std::vector<Render_barrier>& pass_barriers) const;
+};
@@ -1,34 +1,77 @@
 #include "render_manager.hpp"
 
+#include <SDL3/SDL_filesystem.h>
 #include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
 #include <SDL3/SDL_video.h>
 #include <SDL3/SDL_vulkan.h>
 #include <algorithm>
-#include <fstream>
+#include <array>
+#include <cmath>
+#include <cstring>
 #include <limits>
 #include <set>
+#include <string>
 
 #include "config/application.hpp"
-#include <string>
+#include "core/profiler.hpp"
 
 
 #ifdef NDEBUG
 const bool enable_validation_layers = false;
+const bool enable_shader_hot_reload = false;
 #else
 const bool enable_validation_layers = true;
+const bool enable_shader_hot_reload = true;
 #endif
 
 
 const std::vector<const char*> validation_layers    = {"VK_LAYER_KHRONOS_validation"};
 const std::vector<const char*> device_extensions    = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
-const int                      MAX_FRAMES_IN_FLIGHT = 2;
+const VkFormat                 OFFSCREEN_FORMAT     = VK_FORMAT_B8G8R8A8_SRGB;
+const VkPipelineStageFlags     MESH_UPLOAD_STAGES   = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+const VkAccessFlags            MESH_UPLOAD_ACCESS   = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+// The device type outweighs everything else, so an integrated GPU never wins on the system memory it reports as local
+const int64_t DEVICE_SCORE_DISCRETE   = 1'000'000'000;
+const int64_t DEVICE_SCORE_INTEGRATED = 100'000'000;
+const int64_t DEVICE_SCORE_VIRTUAL    = 10'000'000;
+const int64_t DEVICE_SCORE_FEATURE    = 256;
+
+static bool has_device_extension(const std::vector<VkExtensionProperties>& available_extensions, const char* extension_name)
+{
+	return std::any_of(available_extensions.begin(), available_extensions.end(), [&](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, extension_name) == 0; });
+}
 
-bool Render_manager::startup()
+static std::string get_pref_file_path(const char* file_name)
 {
-	window = SDL_CreateWindow(GAME_NAME, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_VULKAN);
-	if (!window)
+	std::string path = file_name;
+
+	char* pref_path = SDL_GetPrefPath(nullptr, GAME_NAME);
+	if (pref_path)
 	{
-		return false;
+		path = std::string(pref_path) + file_name;
+		SDL_free(pref_path);
+	}
+
+	return path;
+}
+
+bool Render_manager::startup(Job_system& job_system, const Render_settings& render_settings)
+{
+	settings                  = render_settings;
+	settings.frames_in_flight = std::max(settings.frames_in_flight, 1u);
+
+	uint64_t startup_start = SDL_GetTicksNS();
+
+	if (!settings.headless)
+	{
+		window = SDL_CreateWindow(GAME_NAME, settings.width, settings.height, SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+		if (!window)
+		{
+			return false;
+		}
 	}
 
 	if (!create_vulkan_instance())
@@ -36,39 +79,175 @@ bool Render_manager::startup()
 		return false;
 	}
 	setup_debug_messenger();
-	create_surface();
-	pick_physical_device();
+	if (!settings.headless)
+	{
+		create_surface();
+	}
+	if (!pick_physical_device())
+	{
+		return false;
+	}
 	create_logical_device();
-	create_swapchain();
-	create_image_views();
-	create_render_pass();
-	create_graphics_pipeline();
-	create_frame_buffers();
+	gpu_allocator.startup(physical_device, device);
+	pipeline_cache.startup(device, physical_device, get_pref_file_path(PIPELINE_CACHE_FILE));
+
+	// Packed by the build next to the executable; loose files, compiled beside it or committed under shaders/, are the fallback
+	std::string base_path    = SDL_GetBasePath() ? SDL_GetBasePath() : "";
+	std::string archive_path = base_path + ASSET_ARCHIVE_FILE;
+	if (!asset_archive.open(archive_path))
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "No asset archive at %s, loading loose files.", archive_path.c_str());
+	}
+
+	shader_manager.startup(SHADER_DIRECTORY, base_path + SHADER_DIRECTORY, get_pref_file_path(SHADER_CACHE_DIRECTORY), enable_shader_hot_reload, &asset_archive);
+	vert_shader = shader_manager.load("shader.vert", "vert.spv");
+	frag_shader = shader_manager.load("shader.frag", "frag.spv");
+	cull_shader = shader_manager.load("cull.comp", "cull.spv");
+	if (vert_shader == INVALID_SHADER || frag_shader == INVALID_SHADER || cull_shader == INVALID_SHADER)
+	{
+		return false;
+	}
+
+	const Queue_family_indices& indices = physical_device_info.queue_family_indices;
+	if (!upload_manager.startup(device, gpu_allocator, transfer_queue, indices.transfer_family.value(), indices.graphics_family.value()))
+	{
+		return false;
+	}
+	if (!async_compute.startup(device, compute_queue, indices.compute_family.value(), compute_queue != graphics_queue))
+	{
+		return false;
+	}
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Compute queue family %u, %s", indices.compute_family.value(), async_compute.is_async() ? "async" : "shared with graphics");
+	if (bindless_supported && !bindless_descriptors.startup(device, physical_device))
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Bindless descriptors unavailable, continuing without them.");
+		bindless_descriptors.shutdown();
+		bindless_supported = false;
+	}
+	if (!indirect_renderer.startup(device,
+	                               gpu_allocator,
+	                               upload_manager,
+	                               pipeline_cache.get_handle(),
+	                               shader_manager.get_code(cull_shader),
+	                               settings.frames_in_flight,
+	                               max_draw_indirect_count,
+	                               draw_indirect_count_supported,
+	                               bindless_descriptors.get_set_layout()))
+	{
+		return false;
+	}
+	set_gpu_culling(settings.gpu_culling);
+	if (settings.headless)
+	{
+		create_offscreen_targets();
+	}
+	else
+	{
+		create_swapchain();
+		create_image_views();
+	}
+	if (!dynamic_rendering_enabled)
+	{
+		create_render_pass();
+	}
+
+	// Nothing can be drawn before the first pipeline exists, so startup waits for it where frames would fall back
+	uint64_t pipeline_start = SDL_GetTicksNS();
+	pipeline_manager.startup(device, pipeline_cache, shader_manager, job_system);
+	scene_pipeline = pipeline_manager.request(get_graphics_pipeline_state());
+	pipeline_manager.flush();
+	graphics_pipeline = pipeline_manager.get(scene_pipeline);
+	if (graphics_pipeline == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+	uint64_t pipeline_end = SDL_GetTicksNS();
+
+	if (dynamic_rendering_enabled)
+	{
+		if (!build_render_graph())
+		{
+			return false;
+		}
+	}
+	else
+	{
+		create_frame_buffers();
+	}
 	create_command_pool();
 	create_command_buffers();
 	create_sync_objects();
+	create_transient_buffer();
+
+	command_recorder.startup(device, indices.graphics_family.value(), settings.frames_in_flight, job_system);
+	gpu_profiler.startup(vulkan_instance, physical_device, device, indices.graphics_family.value(), settings.frames_in_flight, calibrated_timestamps_supported);
+	frame_pacer.startup(device, present_wait_supported, settings.frame_rate_limit, settings.max_queued_frames);
+
+	const std::vector<Vertex>   triangle_vertices = {{{0.0f, -0.5f}, {1.0f, 0.0f, 0.0f}}, {{0.5f, 0.5f}, {0.0f, 1.0f, 0.0f}}, {{-0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}}};
+	const std::vector<uint32_t> triangle_indices  = {0, 1, 2};
+	placeholder_mesh                              = create_mesh(triangle_vertices, triangle_indices);
+	set_instances({{placeholder_mesh}});
+
+	asset_streamer.startup(*this, job_system, &asset_archive, settings.upload_budget, settings.memory_budget);
+
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION,
+	            "Renderer started in %.2f ms, pipelines built in %.2f ms (%s pipeline cache).",
+	            static_cast<double>(SDL_GetTicksNS() - startup_start) / SDL_NS_PER_MS,
+	            static_cast<double>(pipeline_end - pipeline_start) / SDL_NS_PER_MS,
+	            pipeline_cache.is_warm() ? "warm" : "cold");
 
 	return true;
 }
 
 void Render_manager::shutdown()
 {
-	cleanup_swapchain();
-
-	vkDestroyPipeline(device, graphics_pipeline, nullptr);
-	vkDestroyPipelineLayout(device, pipeline_layout, nullptr);
+	vkDeviceWaitIdle(device);
 
-	vkDestroyRenderPass(device, render_pass, nullptr);
+	asset_streamer.shutdown();
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	retire_swapchain();
+	for (Retired_swapchain& retired : retired_swapchains)
 	{
-		vkDestroySemaphore(device, image_available_semaphores[i], nullptr);
-		vkDestroySemaphore(device, render_finished_semaphores[i], nullptr);
-		vkDestroyFence(device, in_flight_fences[i], nullptr);
+		destroy_retired_swapchain(retired);
 	}
+	retired_swapchains.clear();
 
-	vkDestroyCommandPool(device, command_pool, nullptr);
+	pipeline_manager.shutdown();
+	shader_manager.shutdown();
+	asset_archive.close();
+
+	if (render_pass != VK_NULL_HANDLE)
+	{
+		vkDestroyRenderPass(device, render_pass, nullptr);
+	}
 
+	for (Mesh& mesh : meshes)
+	{
+		release_mesh(mesh);
+	}
+	meshes.clear();
+	free_meshes.clear();
+	retired_meshes.clear();
+	resolved_meshes.clear();
+	placeholder_mesh = INVALID_MESH;
+	indirect_renderer.shutdown();
+	bindless_descriptors.shutdown();
+	async_compute.shutdown();
+	upload_manager.shutdown();
+
+	command_recorder.shutdown();
+	destroy_frame_contexts();
+	gpu_allocator.destroy_buffer(transient_buffer, transient_allocation);
+	transient_bindless_handle = INVALID_BINDLESS_HANDLE;
+	transient_ring.shutdown();
+
+	pipeline_cache.shutdown();
+
+	gpu_allocator.log_stats();
+	gpu_allocator.shutdown();
+
+	gpu_profiler.shutdown();
+	frame_pacer.shutdown();
 	vkDestroyDevice(device, nullptr);
 
 	if (enable_validation_layers)
@@ -76,17 +255,291 @@ void Render_manager::shutdown()
 		destroy_debug_utils_messenger_ext(vulkan_instance, debug_messenger, nullptr);
 	}
 
+	if (surface != VK_NULL_HANDLE)
+	{
+		SDL_Vulkan_DestroySurface(vulkan_instance, surface, nullptr);
+	}
 	vkDestroyInstance(vulkan_instance, nullptr);
-	SDL_Vulkan_DestroySurface(vulkan_instance, surface, nullptr);
 
-	SDL_DestroyWindow(window);
+	if (window)
+	{
+		SDL_DestroyWindow(window);
+	}
 }
 
 void Render_manager::update()
 {
+	PROFILE_SCOPE("Frame");
+
+	reload_shaders();
 	draw_frame();
 }
 
+void Render_manager::set_instances(const std::vector<Mesh_instance>& instances)
+{
+	// Also reached every frame a streamed mesh changes the set, so the old buffers are retired on the timeline rather than idled on
+	indirect_renderer.set_instances(instances, meshes, graphics_timeline.get_submitted_value());
+}
+
+void Render_manager::update_instances(const std::vector<Mesh_instance>& instances)
+{
+	// Moving is cheap and happens every frame, only a change to which meshes are drawn replaces the set
+	if (!indirect_renderer.move_instances(instances, meshes))
+	{
+		set_instances(instances);
+	}
+}
+
+void Render_manager::set_view_projection(const glm::mat4& view_projection)
+{
+	indirect_renderer.set_view_projection(view_projection);
+}
+
+void Render_manager::set_gpu_culling(bool enabled)
+{
+	settings.gpu_culling = enabled && gpu_culling_supported;
+}
+
+bool Render_manager::is_gpu_culling_supported() const
+{
+	return gpu_culling_supported;
+}
+
+void Render_manager::set_present_mode(Present_mode present_mode)
+{
+	if (settings.present_mode != present_mode)
+	{
+		settings.present_mode = present_mode;
+		framebuffer_resized   = !settings.headless;
+	}
+}
+
+void Render_manager::set_frame_rate_limit(uint32_t frames_per_second)
+{
+	settings.frame_rate_limit = frames_per_second;
+	frame_pacer.set_frame_rate_limit(frames_per_second);
+}
+
+void Render_manager::record_input(uint64_t timestamp_ns)
+{
+	frame_pacer.record_input(timestamp_ns);
+}
+
+Mesh_handle Render_manager::create_mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	Mesh_handle handle = reserve_mesh();
+	if (!upload_mesh(handle, vertices, indices))
+	{
+		free_meshes.push_back(handle);
+		return INVALID_MESH;
+	}
+
+	return handle;
+}
+
+void Render_manager::destroy_mesh(Mesh_handle mesh)
+{
+	if (mesh < meshes.size())
+	{
+		retired_meshes.push_back({mesh, graphics_timeline.get_submitted_value()});
+	}
+}
+
+Mesh_handle Render_manager::reserve_mesh(Mesh_handle placeholder)
+{
+	Mesh mesh        = {};
+	mesh.placeholder = placeholder;
+
+	Mesh_handle handle;
+	if (!free_meshes.empty())
+	{
+		handle = free_meshes.back();
+		free_meshes.pop_back();
+		meshes[handle] = mesh;
+	}
+	else
+	{
+		handle = static_cast<Mesh_handle>(meshes.size());
+		meshes.push_back(mesh);
+	}
+
+	return handle;
+}
+
+bool Render_manager::upload_mesh(Mesh_handle handle, std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+{
+	if (handle >= meshes.size())
+	{
+		return false;
+	}
+	unload_mesh(handle);
+
+	Mesh         mesh        = {};
+	VkDeviceSize vertex_size = sizeof(Vertex) * vertices.size();
+	VkDeviceSize index_size  = sizeof(uint32_t) * indices.size();
+	mesh.placeholder         = meshes[handle].placeholder;
+
+	if (!gpu_allocator.create_buffer(vertex_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.vertex_buffer, mesh.vertex_allocation) ||
+	    !gpu_allocator.create_buffer(index_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mesh.index_buffer, mesh.index_allocation))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create mesh buffers.");
+		release_mesh(mesh);
+		return false;
+	}
+
+	// Both copies land in the same batch, so the index upload's value covers the vertices as well
+	std::optional<uint64_t> vertex_upload = upload_manager.upload_buffer(mesh.vertex_buffer, 0, vertices.data(), vertex_size, MESH_UPLOAD_STAGES, MESH_UPLOAD_ACCESS);
+	std::optional<uint64_t> index_upload  = vertex_upload ? upload_manager.upload_buffer(mesh.index_buffer, 0, indices.data(), index_size, MESH_UPLOAD_STAGES, MESH_UPLOAD_ACCESS) : std::nullopt;
+	if (!index_upload)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to upload mesh.");
+		upload_manager.discard(mesh.vertex_buffer);
+		upload_manager.discard(mesh.index_buffer);
+		release_mesh(mesh);
+		return false;
+	}
+
+	mesh.upload_value = *index_upload;
+	mesh.index_count  = static_cast<uint32_t>(indices.size());
+
+	for (const Vertex& vertex : vertices)
+	{
+		mesh.bounding_radius = std::max(mesh.bounding_radius, std::sqrt(vertex.position.x * vertex.position.x + vertex.position.y * vertex.position.y));
+	}
+
+	meshes[handle] = mesh;
+	return true;
+}
+
+void Render_manager::unload_mesh(Mesh_handle mesh)
+{
+	if (mesh >= meshes.size() || meshes[mesh].vertex_buffer == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	// The buffers move to a slot of their own that retires like a destroyed mesh, the handle stays valid and falls back to its placeholder
+	Mesh_handle retired     = reserve_mesh();
+	Mesh_handle placeholder = meshes[mesh].placeholder;
+
+	meshes[retired]             = meshes[mesh];
+	meshes[retired].placeholder = INVALID_MESH;
+	meshes[mesh]                = {};
+	meshes[mesh].placeholder    = placeholder;
+	destroy_mesh(retired);
+}
+
+bool Render_manager::is_mesh_resident(Mesh_handle mesh) const
+{
+	return mesh < meshes.size() && meshes[mesh].vertex_buffer != VK_NULL_HANDLE && upload_manager.is_complete(meshes[mesh].upload_value);
+}
+
+Mesh_handle Render_manager::get_placeholder_mesh() const
+{
+	return placeholder_mesh;
+}
+
+void Render_manager::resize(uint32_t width, uint32_t height)
+{
+	settings.width      = width;
+	settings.height     = height;
+	framebuffer_resized = true;
+}
+
+Transient_allocation Render_manager::allocate_transient(VkDeviceSize size, VkDeviceSize alignment)
+{
+	VkDeviceSize offset = 0;
+	if (!transient_ring.allocate(size, alignment, offset))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Transient buffer exhausted, %llu bytes requested.", static_cast<unsigned long long>(size));
+		return {};
+	}
+
+	Transient_allocation allocation = {};
+	allocation.buffer               = transient_buffer;
+	allocation.offset               = offset;
+	allocation.data                 = transient_allocation.mapped + offset;
+	allocation.bindless_handle      = transient_bindless_handle;
+
+	return allocation;
+}
+
+const Frame_timings& Render_manager::get_last_frame_timings() const
+{
+	return last_frame_timings;
+}
+
+const Frame_pacing_stats& Render_manager::get_frame_pacing_stats() const
+{
+	return frame_pacer.get_stats();
+}
+
+Gpu_allocator& Render_manager::get_gpu_allocator()
+{
+	return gpu_allocator;
+}
+
+Asset_streamer& Render_manager::get_asset_streamer()
+{
+	return asset_streamer;
+}
+
+Pipeline_manager& Render_manager::get_pipeline_manager()
+{
+	return pipeline_manager;
+}
+
+const Pipeline_stats& Render_manager::get_pipeline_stats() const
+{
+	return pipeline_manager.get_stats();
+}
+
+Shader_manager& Render_manager::get_shader_manager()
+{
+	return shader_manager;
+}
+
+VkDevice Render_manager::get_device() const
+{
+	return device;
+}
+
+const Physical_device_info& Render_manager::get_physical_device_info() const
+{
+	return physical_device_info;
+}
+
+Compute_queue& Render_manager::get_compute_queue()
+{
+	return async_compute;
+}
+
+Gpu_timeline& Render_manager::get_graphics_timeline()
+{
+	return graphics_timeline;
+}
+
+void Render_manager::wait_for_compute(uint64_t value, VkPipelineStageFlags stage_mask)
+{
+	compute_wait_value   = std::max(compute_wait_value, value);
+	compute_wait_stages |= stage_mask;
+}
+
+Bindless_descriptors& Render_manager::get_bindless_descriptors()
+{
+	return bindless_descriptors;
+}
+
+bool Render_manager::is_bindless_supported() const
+{
+	return bindless_supported;
+}
+
+void Render_manager::release_bindless(Bindless_type type, Bindless_handle handle)
+{
+	bindless_descriptors.release(type, handle, graphics_timeline.get_submitted_value());
+}
+
 bool Render_manager::create_vulkan_instance()
 {
 	if (enable_validation_layers && !check_validation_layer_support())
@@ -100,7 +553,7 @@ bool Render_manager::create_vulkan_instance()
 	app_info.applicationVersion = VK_MAKE_API_VERSION(0, 0, 0, 0);
 	app_info.pEngineName        = "No Engine";
 	app_info.engineVersion      = VK_MAKE_API_VERSION(0, 0, 0, 0);
-	app_info.apiVersion         = VK_API_VERSION_1_0;
+	app_info.apiVersion         = VK_API_VERSION_1_3;
 
 	std::vector<const char*> extensions = get_required_extensions();
 
@@ -168,15 +621,10 @@ bool Render_manager::check_validation_layer_support()
 	return true;
 }
 
-bool Render_manager::check_device_extension_support(VkPhysicalDevice device)
+bool Render_manager::check_device_extension_support(const std::vector<VkExtensionProperties>& available_extensions)
 {
-	uint32_t extension_count;
-	vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
-
-	std::vector<VkExtensionProperties> available_extensions(extension_count);
-	vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, available_extensions.data());
-
-	std::set<std::string> required_extensions(device_extensions.begin(), device_extensions.end());
+	std::vector<const char*> extensions = get_required_device_extensions();
+	std::set<std::string>    required_extensions(extensions.begin(), extensions.end());
 
 	for (const auto& extension : available_extensions)
 	{
@@ -188,10 +636,15 @@ bool Render_manager::check_device_extension_support(VkPhysicalDevice device)
 
 std::vector<const char*> Render_manager::get_required_extensions()
 {
-	uint32_t           sdl_extension_count = 0;
-	const char* const* sdl_extensions      = SDL_Vulkan_GetInstanceExtensions(&sdl_extension_count);
+	std::vector<const char*> extensions;
 
-	std::vector<const char*> extensions(sdl_extensions, sdl_extensions + sdl_extension_count);
+	// Headless runs never present, so they do not need SDL's surface extensions
+	if (!settings.headless)
+	{
+		uint32_t           sdl_extension_count = 0;
+		const char* const* sdl_extensions      = SDL_Vulkan_GetInstanceExtensions(&sdl_extension_count);
+		extensions.assign(sdl_extensions, sdl_extensions + sdl_extension_count);
+	}
 
 	if (enable_validation_layers)
 	{
@@ -201,6 +654,16 @@ std::vector<const char*> Render_manager::get_required_extensions()
 	return extensions;
 }
 
+std::vector<const char*> Render_manager::get_required_device_extensions()
+{
+	if (settings.headless)
+	{
+		return {};
+	}
+
+	return device_extensions;
+}
+
 void Render_manager::setup_debug_messenger()
 {
 	if (!enable_validation_layers)
@@ -260,7 +723,46 @@ void Render_manager::destroy_debug_utils_messenger_ext(VkInstance vulkan_instanc
 	}
 }
 
-void Render_manager::pick_physical_device()
+static int64_t score_device(const Physical_device_info& info)
+{
+	int64_t score = 0;
+	switch (info.properties.deviceType)
+	{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score += DEVICE_SCORE_DISCRETE;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score += DEVICE_SCORE_INTEGRATED;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score += DEVICE_SCORE_VIRTUAL;
+			break;
+		default:
+			break;
+	}
+
+	// Between devices of one type memory decides, in megabytes, so each optional feature is worth a quarter of a gigabyte
+	score += static_cast<int64_t>(info.device_local_bytes / (1024 * 1024));
+
+	const Queue_family_indices&             indices  = info.queue_family_indices;
+	const VkPhysicalDeviceVulkan12Features& features = info.vulkan_12_features;
+
+	int64_t feature_count = 0;
+	feature_count += info.features.multiDrawIndirect && info.features.drawIndirectFirstInstance;
+	feature_count += features.drawIndirectCount == VK_TRUE;
+	feature_count += features.runtimeDescriptorArray && features.descriptorBindingPartiallyBound && features.descriptorBindingUpdateUnusedWhilePending;
+	feature_count += has_device_extension(info.extensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+
+	// Dedicated transfer and compute families run beside graphics
+	feature_count += indices.transfer_family != indices.graphics_family;
+	feature_count += indices.compute_family != indices.graphics_family;
+
+	score += feature_count * DEVICE_SCORE_FEATURE;
+
+	return score;
+}
+
+bool Render_manager::pick_physical_device()
 {
 	uint32_t device_count = 0;
 	vkEnumeratePhysicalDevices(vulkan_instance, &device_count, nullptr);
@@ -268,51 +770,211 @@ void Render_manager::pick_physical_device()
 	if (device_count == 0)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to find GPUs with Vulkan support.");
+		return false;
 	}
 
 	std::vector<VkPhysicalDevice> devices(device_count);
 	vkEnumeratePhysicalDevices(vulkan_instance, &device_count, devices.data());
 
-	for (const VkPhysicalDevice& device : devices)
+	std::vector<Physical_device_info> infos;
+	infos.reserve(device_count);
+	for (uint32_t i = 0; i < device_count; i++)
 	{
-		if (is_device_suitable(device))
-		{
-			physical_device = device;
-			break;
-		}
+		infos.push_back(query_physical_device(devices[i], i));
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "GPU %u: %s, score %lld%s", i, infos[i].properties.deviceName, static_cast<long long>(infos[i].score), infos[i].suitable ? "" : ", unsuitable");
 	}
 
-	if (physical_device == VK_NULL_HANDLE)
+	// Hybrid laptops list the integrated GPU first, so the order only breaks ties between equal scores
+	const Physical_device_info* best = nullptr;
+	for (const Physical_device_info& info : infos)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to find a suitable GPU.");
+		if (info.suitable && (!best || info.score > best->score))
+		{
+			best = &info;
+		}
 	}
-}
-
-bool Render_manager::is_device_suitable(VkPhysicalDevice device)
-{
-	Queue_family_indices indices = find_queue_families(device);
-
-	bool extensions_supported = check_device_extension_support(device);
 
-	bool swap_chain_adequate = false;
-	if (extensions_supported)
+	// The override names a device by its index or part of its name
+	const char* env_override = SDL_getenv(GPU_OVERRIDE_ENV);
+	std::string preferred    = !settings.gpu.empty() ? settings.gpu : env_override ? env_override : "";
+	if (!preferred.empty())
 	{
-		Swap_chain_support_details swap_chain_support = query_swap_chain_support(device);
-		swap_chain_adequate                           = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
+		bool     is_index = std::all_of(preferred.begin(), preferred.end(), [](char c) { return c >= '0' && c <= '9'; });
+		uint32_t index    = is_index ? static_cast<uint32_t>(std::strtoul(preferred.c_str(), nullptr, 10)) : UINT32_MAX;
+
+		const Physical_device_info* found = nullptr;
+		for (const Physical_device_info& info : infos)
+		{
+			if (is_index ? info.index == index : std::strstr(info.properties.deviceName, preferred.c_str()) != nullptr)
+			{
+				found = &info;
+				break;
+			}
+		}
+
+		if (!found)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "No GPU matches \"%s\", picking by score.", preferred.c_str());
+		}
+		else if (!found->suitable)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "GPU %s is unsuitable, picking by score.", found->properties.deviceName);
+		}
+		else
+		{
+			best = found;
+		}
 	}
 
-	return indices.is_complete() && extensions_supported && swap_chain_adequate;
+	if (!best)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to find a suitable GPU.");
+		return false;
+	}
+
+	physical_device_info = *best;
+	physical_device      = best->device;
+	SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Using GPU %u: %s", best->index, best->properties.deviceName);
+
+	return true;
 }
 
-Queue_family_indices Render_manager::find_queue_families(VkPhysicalDevice device)
+Physical_device_info Render_manager::query_physical_device(VkPhysicalDevice device, uint32_t index)
 {
-	Queue_family_indices indices;
+	Physical_device_info info;
+	info.device = device;
+	info.index  = index;
+
+	vkGetPhysicalDeviceProperties(device, &info.properties);
+
+	uint32_t extension_count = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, nullptr);
+	info.extensions.resize(extension_count);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extension_count, info.extensions.data());
 
 	uint32_t queue_family_count = 0;
 	vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, nullptr);
+	info.queue_families.resize(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, info.queue_families.data());
+	info.queue_family_indices = find_queue_families(device, info.queue_families);
+
+	// The largest local heap is the VRAM on a discrete GPU, the small host visible heap beside it is the BAR window
+	VkPhysicalDeviceMemoryProperties memory_properties;
+	vkGetPhysicalDeviceMemoryProperties(device, &memory_properties);
+	for (uint32_t i = 0; i < memory_properties.memoryHeapCount; i++)
+	{
+		if (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			info.device_local_bytes = std::max(info.device_local_bytes, memory_properties.memoryHeaps[i].size);
+		}
+	}
+
+	// Each struct may only be chained on a device that knows it, the present ones only when both extensions are there
+	info.vulkan_11_features.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES;
+	info.vulkan_12_features.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	info.vulkan_13_features.sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	info.present_id_features.sType   = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	info.present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	if (info.properties.apiVersion >= VK_API_VERSION_1_2)
+	{
+		VkPhysicalDeviceFeatures2 features = {};
+		features.sType                     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features.pNext                     = &info.vulkan_11_features;
+		info.vulkan_11_features.pNext      = &info.vulkan_12_features;
+		if (info.properties.apiVersion >= VK_API_VERSION_1_3)
+		{
+			info.vulkan_12_features.pNext = &info.vulkan_13_features;
+		}
+		if (has_device_extension(info.extensions, VK_KHR_PRESENT_ID_EXTENSION_NAME) && has_device_extension(info.extensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+		{
+			info.present_id_features.pNext   = &info.present_wait_features;
+			info.present_wait_features.pNext = features.pNext;
+			features.pNext                   = &info.present_id_features;
+		}
+		vkGetPhysicalDeviceFeatures2(device, &features);
+
+		// The cached structs outlive this chain
+		info.features                    = features.features;
+		info.vulkan_11_features.pNext    = nullptr;
+		info.vulkan_12_features.pNext    = nullptr;
+		info.vulkan_13_features.pNext    = nullptr;
+		info.present_id_features.pNext   = nullptr;
+		info.present_wait_features.pNext = nullptr;
+	}
+	else
+	{
+		vkGetPhysicalDeviceFeatures(device, &info.features);
+	}
 
-	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-	vkGetPhysicalDeviceQueueFamilyProperties(device, &queue_family_count, queue_families.data());
+	info.suitable = is_device_suitable(info);
+	info.score    = score_device(info);
+
+	return info;
+}
+
+bool Render_manager::is_device_suitable(const Physical_device_info& info)
+{
+	bool extensions_supported = check_device_extension_support(info.extensions);
+
+	bool swap_chain_adequate = settings.headless;
+	if (extensions_supported && !settings.headless)
+	{
+		Swap_chain_support_details swap_chain_support = query_swap_chain_support(info.device);
+		swap_chain_adequate                           = !swap_chain_support.formats.empty() && !swap_chain_support.present_modes.empty();
+	}
+
+	// Uploads are tracked with timeline semaphores, which are core from Vulkan 1.2
+	bool timeline_supported = info.properties.apiVersion >= VK_API_VERSION_1_2 && info.vulkan_12_features.timelineSemaphore == VK_TRUE;
+
+	return info.queue_family_indices.is_complete() && extensions_supported && swap_chain_adequate && timeline_supported;
+}
+
+Queue_family_indices Render_manager::find_queue_families(VkPhysicalDevice device, const std::vector<VkQueueFamilyProperties>& queue_families)
+{
+	Queue_family_indices indices;
+
+	uint32_t queue_family_count = static_cast<uint32_t>(queue_families.size());
+
+	// Prefer a transfer only family, those map to the copy engines and run beside graphics work
+	std::optional<uint32_t> transfer_without_graphics;
+	for (uint32_t family = 0; family < queue_family_count; family++)
+	{
+		VkQueueFlags flags = queue_families[family].queueFlags;
+		if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			continue;
+		}
+
+		if (!(flags & VK_QUEUE_COMPUTE_BIT))
+		{
+			indices.transfer_family = family;
+			break;
+		}
+
+		if (!transfer_without_graphics.has_value())
+		{
+			transfer_without_graphics = family;
+		}
+	}
+	if (!indices.transfer_family.has_value())
+	{
+		indices.transfer_family = transfer_without_graphics;
+	}
+
+	// A compute family without graphics is the async compute engine, one not already taken for transfers is better
+	for (uint32_t family = 0; family < queue_family_count; family++)
+	{
+		VkQueueFlags flags = queue_families[family].queueFlags;
+		if (!(flags & VK_QUEUE_COMPUTE_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			continue;
+		}
+
+		if (!indices.compute_family.has_value() || indices.compute_family == indices.transfer_family)
+		{
+			indices.compute_family = family;
+		}
+	}
 
 	int i = 0;
 	for (const VkQueueFamilyProperties& queue_family : queue_families)
@@ -322,11 +984,19 @@ Queue_family_indices Render_manager::find_queue_families(VkPhysicalDevice device
 			indices.graphics_family = i;
 		}
 
-		VkBool32 present_support = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
-		if (present_support)
+		if (settings.headless)
 		{
-			indices.present_family = i;
+			// Nothing is presented, the graphics queue stands in for the present queue
+			indices.present_family = indices.graphics_family;
+		}
+		else
+		{
+			VkBool32 present_support = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &present_support);
+			if (present_support)
+			{
+				indices.present_family = i;
+			}
 		}
 
 		if (indices.is_complete())
@@ -337,36 +1007,124 @@ Queue_family_indices Render_manager::find_queue_families(VkPhysicalDevice device
 		i++;
 	}
 
+	// Graphics queues always support transfers and compute, so they are the fallback
+	if (!indices.transfer_family.has_value())
+	{
+		indices.transfer_family = indices.graphics_family;
+	}
+	if (!indices.compute_family.has_value())
+	{
+		indices.compute_family = indices.graphics_family;
+	}
+
 	return indices;
 }
 
 void Render_manager::create_logical_device()
 {
-	Queue_family_indices indices = find_queue_families(physical_device);
+	const Queue_family_indices&                 indices        = physical_device_info.queue_family_indices;
+	const std::vector<VkQueueFamilyProperties>& queue_families = physical_device_info.queue_families;
 
 	std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-	std::set<uint32_t>                   unique_queue_families = {indices.graphics_family.value(), indices.present_family.value()};
+	std::set<uint32_t>                   unique_queue_families = {indices.graphics_family.value(), indices.present_family.value(), indices.transfer_family.value(), indices.compute_family.value()};
+
+	// Compute sharing a family still overlaps on a second queue of it, when the family has one
+	uint32_t compute_family      = indices.compute_family.value();
+	bool     compute_shared      = compute_family == indices.graphics_family.value() || compute_family == indices.transfer_family.value();
+	uint32_t compute_queue_index = compute_shared && queue_families[compute_family].queueCount > 1 ? 1 : 0;
 
-	float queue_priority = 1.0f;
+	float queue_priorities[2] = {1.0f, 1.0f};
 	for (uint32_t queue_family : unique_queue_families)
 	{
 		VkDeviceQueueCreateInfo queue_create_info = {};
 		queue_create_info.sType                   = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queue_create_info.queueFamilyIndex        = queue_family;
-		queue_create_info.queueCount              = 1;
-		queue_create_info.pQueuePriorities        = &queue_priority;
+		queue_create_info.queueCount              = queue_family == compute_family ? compute_queue_index + 1 : 1;
+		queue_create_info.pQueuePriorities        = queue_priorities;
 		queue_create_infos.push_back(queue_create_info);
 	}
 
-	VkPhysicalDeviceFeatures device_features = {};
+	const VkPhysicalDeviceProperties& properties = physical_device_info.properties;
+
+	const VkPhysicalDeviceVulkan12Features& supported_12_features = physical_device_info.vulkan_12_features;
+	const VkPhysicalDeviceVulkan13Features& supported_13_features = physical_device_info.vulkan_13_features;
+
+	// Present wait needs both extensions, their feature structs were only queried when both are there
+	bool present_wait_available = !settings.headless && has_device_extension(physical_device_info.extensions, VK_KHR_PRESENT_ID_EXTENSION_NAME)
+	                           && has_device_extension(physical_device_info.extensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+
+	// GPU culling writes many draws with a non zero first instance, a count buffer is optional and saves the empty draws
+	gpu_culling_supported         = physical_device_info.features.multiDrawIndirect && physical_device_info.features.drawIndirectFirstInstance;
+	draw_indirect_count_supported = gpu_culling_supported && supported_12_features.drawIndirectCount;
+	max_draw_indirect_count       = properties.limits.maxDrawIndirectCount;
+
+	// Bindless needs runtime arrays that can be partially bound and written while a frame in flight uses the set
+	bindless_supported = supported_12_features.runtimeDescriptorArray && supported_12_features.descriptorBindingPartiallyBound
+	                  && supported_12_features.descriptorBindingSampledImageUpdateAfterBind && supported_12_features.descriptorBindingStorageBufferUpdateAfterBind
+	                  && supported_12_features.descriptorBindingUpdateUnusedWhilePending && supported_12_features.shaderSampledImageArrayNonUniformIndexing;
+
+	VkPhysicalDeviceFeatures device_features  = {};
+	device_features.multiDrawIndirect         = gpu_culling_supported;
+	device_features.drawIndirectFirstInstance = gpu_culling_supported;
+
+	VkPhysicalDeviceVulkan12Features vulkan_12_features = {};
+	vulkan_12_features.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan_12_features.timelineSemaphore                = VK_TRUE;
+	vulkan_12_features.drawIndirectCount                = draw_indirect_count_supported;
+
+	vulkan_12_features.runtimeDescriptorArray                        = bindless_supported;
+	vulkan_12_features.descriptorBindingPartiallyBound               = bindless_supported;
+	vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind  = bindless_supported;
+	vulkan_12_features.descriptorBindingStorageBufferUpdateAfterBind = bindless_supported;
+	vulkan_12_features.descriptorBindingUpdateUnusedWhilePending     = bindless_supported;
+	vulkan_12_features.shaderSampledImageArrayNonUniformIndexing     = bindless_supported;
+
+	// Older drivers keep the render pass and framebuffer path
+	dynamic_rendering_enabled = settings.dynamic_rendering && supported_13_features.dynamicRendering && supported_13_features.synchronization2;
+
+	VkPhysicalDeviceVulkan13Features vulkan_13_features = {};
+	vulkan_13_features.sType                            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	vulkan_13_features.dynamicRendering                 = dynamic_rendering_enabled;
+	vulkan_13_features.synchronization2                 = dynamic_rendering_enabled;
+	if (dynamic_rendering_enabled)
+	{
+		vulkan_12_features.pNext = &vulkan_13_features;
+	}
+
+	present_wait_supported = present_wait_available && physical_device_info.present_id_features.presentId && physical_device_info.present_wait_features.presentWait;
+
+	VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {};
+	present_wait_features.sType                                  = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	present_wait_features.pNext                                  = &vulkan_12_features;
+	present_wait_features.presentWait                            = VK_TRUE;
+
+	VkPhysicalDevicePresentIdFeaturesKHR present_id_features = {};
+	present_id_features.sType                                = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	present_id_features.pNext                                = &present_wait_features;
+	present_id_features.presentId                            = VK_TRUE;
+
+	std::vector<const char*> extensions = get_required_device_extensions();
+	if (present_wait_supported)
+	{
+		extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+		extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	}
+
+	// Puts GPU scopes on the CPU timeline in profile captures, without it they are anchored to the submit
+	calibrated_timestamps_supported = PROFILER_ENABLED && has_device_extension(physical_device_info.extensions, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	if (calibrated_timestamps_supported)
+	{
+		extensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
 
 	VkDeviceCreateInfo create_info      = {};
 	create_info.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	create_info.pNext                   = present_wait_supported ? static_cast<void*>(&present_id_features) : &vulkan_12_features;
 	create_info.pQueueCreateInfos       = queue_create_infos.data();
 	create_info.queueCreateInfoCount    = static_cast<uint32_t>(queue_create_infos.size());
 	create_info.pEnabledFeatures        = &device_features;
-	create_info.enabledExtensionCount   = static_cast<uint32_t>(device_extensions.size());
-	create_info.ppEnabledExtensionNames = device_extensions.data();
+	create_info.enabledExtensionCount   = static_cast<uint32_t>(extensions.size());
+	create_info.ppEnabledExtensionNames = extensions.data();
 	if (enable_validation_layers)
 	{
 		create_info.enabledLayerCount   = static_cast<uint32_t>(validation_layers.size());
@@ -380,6 +1138,8 @@ void Render_manager::create_logical_device()
 
 	vkGetDeviceQueue(device, indices.graphics_family.value(), 0, &graphics_queue);
 	vkGetDeviceQueue(device, indices.present_family.value(), 0, &present_queue);
+	vkGetDeviceQueue(device, indices.transfer_family.value(), 0, &transfer_queue);
+	vkGetDeviceQueue(device, compute_family, compute_queue_index, &compute_queue);
 }
 
 Swap_chain_support_details Render_manager::query_swap_chain_support(VkPhysicalDevice device)
@@ -424,15 +1184,7 @@ VkSurfaceFormatKHR Render_manager::choose_swap_surface_format(const std::vector<
 
 VkPresentModeKHR Render_manager::choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes)
 {
-	for (const auto& available_present_mode : available_present_modes)
-	{
-		if (available_present_mode == VK_PRESENT_MODE_MAILBOX_KHR)
-		{
-			return available_present_mode;
-		}
-	}
-
-	return VK_PRESENT_MODE_FIFO_KHR;
+	return Frame_pacer::choose_present_mode(settings.present_mode, available_present_modes);
 }
 
 VkExtent2D Render_manager::choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities)
@@ -456,7 +1208,7 @@ VkExtent2D Render_manager::choose_swap_extent(const VkSurfaceCapabilitiesKHR& ca
 	}
 }
 
-void Render_manager::create_swapchain()
+void Render_manager::create_swapchain(VkSwapchainKHR old_swap_chain)
 {
 	Swap_chain_support_details swap_chain_support = query_swap_chain_support(physical_device);
 
@@ -480,8 +1232,8 @@ void Render_manager::create_swapchain()
 	create_info.imageArrayLayers         = 1;
 	create_info.imageUsage               = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-	Queue_family_indices indices                = find_queue_families(physical_device);
-	uint32_t             queue_family_indices[] = {indices.graphics_family.value(), indices.present_family.value()};
+	const Queue_family_indices& indices                = physical_device_info.queue_family_indices;
+	uint32_t                    queue_family_indices[] = {indices.graphics_family.value(), indices.present_family.value()};
 	if (indices.graphics_family != indices.present_family)
 	{
 		create_info.imageSharingMode      = VK_SHARING_MODE_CONCURRENT;
@@ -497,7 +1249,7 @@ void Render_manager::create_swapchain()
 	create_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	create_info.presentMode    = present_mode;
 	create_info.clipped        = VK_TRUE;
-	create_info.oldSwapchain   = VK_NULL_HANDLE;
+	create_info.oldSwapchain   = old_swap_chain;
 
 	if (vkCreateSwapchainKHR(device, &create_info, nullptr, &swap_chain))
 	{
@@ -507,35 +1259,149 @@ void Render_manager::create_swapchain()
 	vkGetSwapchainImagesKHR(device, swap_chain, &image_count, nullptr);
 	swap_chain_images.resize(image_count);
 	vkGetSwapchainImagesKHR(device, swap_chain, &image_count, swap_chain_images.data());
+	swap_chain_images_acquired.assign(image_count, false);
+	unacquired_image_count = image_count;
 
 	swap_chain_image_format = surface_format.format;
 	swap_chain_extent       = extent;
+
+	// Presentation holds on to its wait semaphore until the image comes back, so these are per image rather than per frame
+	render_finished_semaphores.resize(image_count);
+
+	VkSemaphoreCreateInfo semaphore_info = {};
+	semaphore_info.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for (VkSemaphore& semaphore : render_finished_semaphores)
+	{
+		if (vkCreateSemaphore(device, &semaphore_info, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create semaphores.");
+		}
+	}
 }
 
-void Render_manager::recreate_swapchain()
+bool Render_manager::recreate_swapchain()
 {
-	vkDeviceWaitIdle(device);
+	PROFILE_SCOPE("Recreate swapchain");
 
-	cleanup_swapchain();
+	// A minimized window has a zero extent and no swapchain can be made for it, frames are skipped until it is restored
+	VkExtent2D extent = {settings.width, settings.height};
+	if (!settings.headless)
+	{
+		VkSurfaceCapabilitiesKHR capabilities;
+		vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_device, surface, &capabilities);
+		extent = capabilities.currentExtent;
+	}
 
-	create_swapchain();
-	create_image_views();
-	create_frame_buffers();
+	if (extent.width == 0 || extent.height == 0)
+	{
+		return false;
+	}
+
+	// Frames in flight keep rendering to the old images, so they are retired rather than waited for
+	VkSwapchainKHR old_swap_chain = swap_chain;
+	retire_swapchain();
+
+	if (settings.headless)
+	{
+		create_offscreen_targets();
+	}
+	else
+	{
+		create_swapchain(old_swap_chain);
+		create_image_views();
+	}
+
+	// Dynamic rendering points straight at the image views, there are no framebuffers to rebuild, only the graph's extent
+	if (dynamic_rendering_enabled)
+	{
+		build_render_graph();
+	}
+	else
+	{
+		create_frame_buffers();
+	}
+
+	frame_pacer.reset_swapchain();
+	framebuffer_resized = false;
+	return true;
 }
 
-void Render_manager::cleanup_swapchain()
+void Render_manager::retire_swapchain()
 {
-	for (auto framebuffer : swap_chain_frame_buffers)
+	Retired_swapchain retired;
+	retired.swap_chain                 = swap_chain;
+	retired.image_views                = std::move(swap_chain_image_views);
+	retired.frame_buffers              = std::move(swap_chain_frame_buffers);
+	retired.render_finished_semaphores = std::move(render_finished_semaphores);
+	retired.render_graph               = std::move(render_graph);
+	retired.timeline_value             = graphics_timeline.get_submitted_value();
+	retired.presentation_released      = settings.headless;
+
+	// Swapchain images belong to the swapchain, only offscreen targets are owned
+	if (settings.headless)
+	{
+		retired.images            = std::move(swap_chain_images);
+		retired.image_allocations = std::move(offscreen_image_allocations);
+	}
+
+	swap_chain = VK_NULL_HANDLE;
+	swap_chain_images.clear();
+	swap_chain_image_views.clear();
+	swap_chain_frame_buffers.clear();
+	render_finished_semaphores.clear();
+	offscreen_image_allocations.clear();
+	render_graph = Render_graph();
+
+	retired_swapchains.push_back(std::move(retired));
+}
+
+void Render_manager::release_retired_swapchains()
+{
+	// The timeline only proves the frames finished, presentation may still hold their semaphores until it lets go of the
+	// images, which the acquires of the next swapchain stand in for since presentation has no fence of its own
+	for (size_t i = 0; i < retired_swapchains.size();)
+	{
+		if (!retired_swapchains[i].presentation_released || !graphics_timeline.is_complete(retired_swapchains[i].timeline_value))
+		{
+			i++;
+			continue;
+		}
+
+		destroy_retired_swapchain(retired_swapchains[i]);
+		retired_swapchains[i] = std::move(retired_swapchains.back());
+		retired_swapchains.pop_back();
+	}
+}
+
+void Render_manager::destroy_retired_swapchain(Retired_swapchain& retired)
+{
+	retired.render_graph.reset();
+
+	for (VkFramebuffer framebuffer : retired.frame_buffers)
 	{
 		vkDestroyFramebuffer(device, framebuffer, nullptr);
 	}
 
-	for (auto image_view : swap_chain_image_views)
+	for (VkImageView image_view : retired.image_views)
 	{
 		vkDestroyImageView(device, image_view, nullptr);
 	}
 
-	vkDestroySwapchainKHR(device, swap_chain, nullptr);
+	for (size_t i = 0; i < retired.images.size(); i++)
+	{
+		gpu_allocator.destroy_image(retired.images[i], retired.image_allocations[i]);
+	}
+
+	for (VkSemaphore semaphore : retired.render_finished_semaphores)
+	{
+		vkDestroySemaphore(device, semaphore, nullptr);
+	}
+
+	if (retired.swap_chain != VK_NULL_HANDLE)
+	{
+		vkDestroySwapchainKHR(device, retired.swap_chain, nullptr);
+	}
 }
 
 void Render_manager::create_image_views()
@@ -566,154 +1432,61 @@ void Render_manager::create_image_views()
 	}
 }
 
-void Render_manager::create_graphics_pipeline()
+void Render_manager::create_offscreen_targets()
 {
-	auto vert_shader_code = read_file("shaders/vert.spv");
-	auto frag_shader_code = read_file("shaders/frag.spv");
-
-	VkShaderModule vert_shader_module = create_shader_module(vert_shader_code);
-	VkShaderModule frag_shader_module = create_shader_module(frag_shader_code);
-
-	VkPipelineShaderStageCreateInfo vert_shader_stage_info = {};
-	vert_shader_stage_info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	vert_shader_stage_info.stage                           = VK_SHADER_STAGE_VERTEX_BIT;
-	vert_shader_stage_info.module                          = vert_shader_module;
-	vert_shader_stage_info.pName                           = "main";
-
-	VkPipelineShaderStageCreateInfo frag_shader_stage_info = {};
-	frag_shader_stage_info.sType                           = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	frag_shader_stage_info.stage                           = VK_SHADER_STAGE_FRAGMENT_BIT;
-	frag_shader_stage_info.module                          = frag_shader_module;
-	frag_shader_stage_info.pName                           = "main";
-
-	VkPipelineShaderStageCreateInfo shader_stages[] = {vert_shader_stage_info, frag_shader_stage_info};
-
-	std::vector<VkDynamicState> dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
-
-	VkPipelineDynamicStateCreateInfo dynamic_state = {};
-	dynamic_state.sType                            = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-	dynamic_state.dynamicStateCount                = static_cast<uint32_t>(dynamic_states.size());
-	dynamic_state.pDynamicStates                   = dynamic_states.data();
-
-	VkPipelineVertexInputStateCreateInfo vertex_input_info = {};
-	vertex_input_info.sType                                = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertex_input_info.vertexBindingDescriptionCount        = 0;
-	vertex_input_info.vertexAttributeDescriptionCount      = 0;
-
-	VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
-	input_assembly.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	input_assembly.topology                               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	input_assembly.primitiveRestartEnable                 = VK_FALSE;
-
-	VkViewport viewport = {};
-	viewport.x          = 0.0f;
-	viewport.y          = 0.0f;
-	viewport.height     = (float)swap_chain_extent.width;
-	viewport.width      = (float)swap_chain_extent.height;
-	viewport.minDepth   = 0.0f;
-	viewport.maxDepth   = 1.0f;
-
-	VkRect2D scissors = {};
-	scissors.offset   = {0, 0};
-	scissors.extent   = swap_chain_extent;
-
-	VkPipelineViewportStateCreateInfo viewport_state = {};
-	viewport_state.sType                             = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-	viewport_state.viewportCount                     = 1;
-	viewport_state.pViewports                        = &viewport;
-	viewport_state.scissorCount                      = 1;
-	viewport_state.pScissors                         = &scissors;
-
-	VkPipelineRasterizationStateCreateInfo rasterizer = {};
-	rasterizer.sType                                  = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	rasterizer.depthClampEnable                       = VK_FALSE;
-	rasterizer.rasterizerDiscardEnable                = VK_FALSE;
-	rasterizer.polygonMode                            = VK_POLYGON_MODE_FILL;
-	rasterizer.lineWidth                              = 1.0f;
-	rasterizer.cullMode                               = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace                              = VK_FRONT_FACE_CLOCKWISE;
-	rasterizer.depthBiasEnable                        = VK_FALSE;
-
-	VkPipelineMultisampleStateCreateInfo multisampling = {};
-	multisampling.sType                                = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampling.sampleShadingEnable                  = VK_FALSE;
-	multisampling.rasterizationSamples                 = VK_SAMPLE_COUNT_1_BIT;
+	// One target per frame in flight, so waiting on a frame's timeline value also frees its target
+	swap_chain_image_format = OFFSCREEN_FORMAT;
+	swap_chain_extent       = {settings.width, settings.height};
 
-	VkPipelineColorBlendAttachmentState color_blend_attachment = {};
-	color_blend_attachment.colorWriteMask                      = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	color_blend_attachment.blendEnable                         = VK_FALSE;
+	swap_chain_images.resize(settings.frames_in_flight);
+	offscreen_image_allocations.resize(settings.frames_in_flight);
 
-	VkPipelineColorBlendStateCreateInfo color_blending = {};
-	color_blending.sType                               = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-	color_blending.logicOpEnable                       = VK_FALSE;
-	color_blending.attachmentCount                     = 1;
-	color_blending.pAttachments                        = &color_blend_attachment;
-
-	VkPipelineLayoutCreateInfo pipeline_create_info = {};
-	pipeline_create_info.sType                      = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-	if (vkCreatePipelineLayout(device, &pipeline_create_info, nullptr, &pipeline_layout) != VK_SUCCESS)
-	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create pipeline layout.");
-	}
-
-	VkGraphicsPipelineCreateInfo pipeline_info = {};
-	pipeline_info.sType                        = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-	pipeline_info.stageCount                   = 2;
-	pipeline_info.pStages                      = shader_stages;
-	pipeline_info.pVertexInputState            = &vertex_input_info;
-	pipeline_info.pInputAssemblyState          = &input_assembly;
-	pipeline_info.pViewportState               = &viewport_state;
-	pipeline_info.pRasterizationState          = &rasterizer;
-	pipeline_info.pMultisampleState            = &multisampling;
-	pipeline_info.pColorBlendState             = &color_blending;
-	pipeline_info.pDynamicState                = &dynamic_state;
-	pipeline_info.layout                       = pipeline_layout;
-	pipeline_info.renderPass                   = render_pass;
-	pipeline_info.subpass                      = 0;
-
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &graphics_pipeline))
+	for (size_t i = 0; i < swap_chain_images.size(); i++)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create pipeline.");
+		VkImageCreateInfo image_info = {};
+		image_info.sType             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		image_info.imageType         = VK_IMAGE_TYPE_2D;
+		image_info.format            = swap_chain_image_format;
+		image_info.extent            = {swap_chain_extent.width, swap_chain_extent.height, 1};
+		image_info.mipLevels         = 1;
+		image_info.arrayLayers       = 1;
+		image_info.samples           = VK_SAMPLE_COUNT_1_BIT;
+		image_info.tiling            = VK_IMAGE_TILING_OPTIMAL;
+		image_info.usage             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		image_info.sharingMode       = VK_SHARING_MODE_EXCLUSIVE;
+		image_info.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (!gpu_allocator.create_image(image_info, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, swap_chain_images[i], offscreen_image_allocations[i]))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create offscreen image.");
+		}
 	}
 
-	vkDestroyShaderModule(device, vert_shader_module, nullptr);
-	vkDestroyShaderModule(device, frag_shader_module, nullptr);
+	create_image_views();
 }
 
-std::vector<char> Render_manager::read_file(const std::string& filename)
+Graphics_pipeline_state Render_manager::get_graphics_pipeline_state()
 {
-	std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-	if (!file.is_open())
-	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to open file %s.", filename.c_str());
-	}
-
-	size_t            file_size = (size_t)file.tellg();
-	std::vector<char> buffer(file_size);
-
-	file.seekg(0);
-	file.read(buffer.data(), file_size);
-	file.close();
+	// Shared with the cull pipeline, the vertex shader reads its transform from the instance buffer
+	pipeline_layout = indirect_renderer.get_pipeline_layout();
 
-	return buffer;
-}
-
-VkShaderModule Render_manager::create_shader_module(const std::vector<char>& code)
-{
-	VkShaderModuleCreateInfo create_info = {};
-	create_info.sType                    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	create_info.codeSize                 = code.size();
-	create_info.pCode                    = reinterpret_cast<const uint32_t*>(code.data());
+	Graphics_pipeline_state state = {};
+	state.vert_shader             = vert_shader;
+	state.frag_shader             = frag_shader;
+	state.layout                  = pipeline_layout;
+	state.vertex_stride           = Vertex::get_binding_description().stride;
 
-	VkShaderModule shader_module;
-	if (vkCreateShaderModule(device, &create_info, nullptr, &shader_module) != VK_SUCCESS)
+	std::array<VkVertexInputAttributeDescription, 2> attribute_descriptions = Vertex::get_attribute_descriptions();
+	for (const VkVertexInputAttributeDescription& attribute : attribute_descriptions)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create shader module.");
+		state.attributes[state.attribute_count++] = attribute;
 	}
 
-	return shader_module;
+	// Without a render pass the attachment formats are given to the pipeline directly
+	state.render_pass  = dynamic_rendering_enabled ? VK_NULL_HANDLE : render_pass;
+	state.color_format = swap_chain_image_format;
+
+	return state;
 }
 
 void Render_manager::create_render_pass()
@@ -726,7 +1499,7 @@ void Render_manager::create_render_pass()
 	color_attachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	color_attachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	color_attachment.initialLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
-	color_attachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	color_attachment.finalLayout             = settings.headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference color_attachment_ref = {};
 	color_attachment_ref.attachment            = 0;
@@ -786,32 +1559,39 @@ void Render_manager::create_frame_buffers()
 
 void Render_manager::create_command_pool()
 {
-	Queue_family_indices queue_family_indices = find_queue_families(physical_device);
+	const Queue_family_indices& queue_family_indices = physical_device_info.queue_family_indices;
+
+	frames.resize(settings.frames_in_flight);
 
+	// Each frame owns its pool and resets it wholesale once the timeline reaches its value
 	VkCommandPoolCreateInfo pool_info = {};
 	pool_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	pool_info.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	pool_info.flags                   = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 	pool_info.queueFamilyIndex        = queue_family_indices.graphics_family.value();
 
-	if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
+	for (Frame_context& frame : frames)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create command pool");
+		if (vkCreateCommandPool(device, &pool_info, nullptr, &frame.command_pool) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create command pool");
+		}
 	}
 }
 
 void Render_manager::create_command_buffers()
 {
-	command_buffers.resize(MAX_FRAMES_IN_FLIGHT);
-
-	VkCommandBufferAllocateInfo alloc_info = {};
-	alloc_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	alloc_info.commandPool                 = command_pool;
-	alloc_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	alloc_info.commandBufferCount          = (uint32_t)command_buffers.size();
-
-	if (vkAllocateCommandBuffers(device, &alloc_info, command_buffers.data()) != VK_SUCCESS)
+	for (Frame_context& frame : frames)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create command buffer");
+		VkCommandBufferAllocateInfo alloc_info = {};
+		alloc_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		alloc_info.commandPool                 = frame.command_pool;
+		alloc_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		alloc_info.commandBufferCount          = 1;
+
+		if (vkAllocateCommandBuffers(device, &alloc_info, &frame.command_buffer) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create command buffer");
+		}
 	}
 }
 
@@ -819,24 +1599,222 @@ void Render_manager::record_command_buffer(VkCommandBuffer command_buffer, uint3
 {
 	VkCommandBufferBeginInfo begin_info = {};
 	begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 	if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to begin recording command buffer.");
 	}
+	gpu_profiler.begin_frame(command_buffer, current_frame);
+
+	// Ownership of finished uploads has to be taken over outside the render pass
+	upload_wait = upload_manager.record_acquires(command_buffer);
+	resolve_meshes();
+
+	// Moved instances are copied in before culling or drawing reads them
+	VkDeviceSize moved_size = indirect_renderer.get_moved_size();
+	if (moved_size > 0)
+	{
+		Transient_allocation staging = allocate_transient(moved_size);
+		if (staging.data)
+		{
+			indirect_renderer.record_moves(command_buffer, staging.buffer, staging.offset, staging.data);
+		}
+	}
+
+	// Culling has to finish before the render pass, the compute dispatch cannot be recorded inside it
+	bool instances_resident = indirect_renderer.is_resident();
+	bool gpu_driven         = instances_resident && settings.gpu_culling;
+
+	draw_commands.clear();
+	if (gpu_driven)
+	{
+		uint32_t cull_scope = gpu_profiler.begin_scope(command_buffer, current_frame, "Culling");
+		if (bindless_supported)
+		{
+			bindless_descriptors.bind(command_buffer, pipeline_layout, VK_PIPELINE_BIND_POINT_COMPUTE);
+		}
+		indirect_renderer.record_cull(command_buffer, current_frame, meshes, resolved_meshes);
+		gpu_profiler.end_scope(command_buffer, current_frame, cull_scope);
+	}
+	else if (instances_resident)
+	{
+		indirect_renderer.cull_on_cpu(draw_commands);
+	}
 
-	VkRenderPassBeginInfo render_pass_info = {};
-	render_pass_info.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	render_pass_info.renderPass            = render_pass;
-	render_pass_info.framebuffer           = swap_chain_frame_buffers[image_index];
-	render_pass_info.renderArea.offset     = {0, 0};
-	render_pass_info.renderArea.extent     = swap_chain_extent;
+	// The render graph calls back into the main pass, so what it records from is kept on the manager
+	current_image_index = image_index;
+	record_gpu_driven   = gpu_driven;
 
-	VkClearValue clear_color         = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-	render_pass_info.clearValueCount = 1;
-	render_pass_info.pClearValues    = &clear_color;
+	// Small scenes are cheaper to record inline than to fan out to the workers
+	record_parallel = !gpu_driven && command_recorder.get_worker_count() > 1 && draw_commands.size() >= PARALLEL_RECORD_DRAWS;
+
+	// Timed from outside the pass, timestamps cannot be written inside one that executes secondary command buffers
+	uint32_t main_pass_scope = gpu_profiler.begin_scope(command_buffer, current_frame, "Main pass");
+	if (dynamic_rendering_enabled)
+	{
+		render_graph.set_imported_image(swapchain_target, swap_chain_images[image_index], swap_chain_image_views[image_index]);
+		render_graph.execute(command_buffer);
+	}
+	else
+	{
+		record_main_pass(command_buffer);
+	}
+	gpu_profiler.end_scope(command_buffer, current_frame, main_pass_scope);
 
-	vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+	if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to record command buffer.");
+	}
+}
+
+void Render_manager::record_main_pass(VkCommandBuffer command_buffer)
+{
+	begin_main_pass(command_buffer, current_image_index, record_parallel);
+
+	if (record_gpu_driven)
+	{
+		bind_graphics_state(command_buffer);
+		indirect_renderer.record_indirect_draws(command_buffer, current_frame, meshes, resolved_meshes);
+	}
+	else if (record_parallel)
+	{
+		VkCommandBufferInheritanceRenderingInfo rendering_info = {};
+		rendering_info.sType                                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		rendering_info.colorAttachmentCount                    = 1;
+		rendering_info.pColorAttachmentFormats                 = &swap_chain_image_format;
+		rendering_info.rasterizationSamples                    = VK_SAMPLE_COUNT_1_BIT;
+
+		VkCommandBufferInheritanceInfo inheritance_info = {};
+		inheritance_info.sType                          = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		if (dynamic_rendering_enabled)
+		{
+			inheritance_info.pNext = &rendering_info;
+		}
+		else
+		{
+			inheritance_info.renderPass  = render_pass;
+			inheritance_info.subpass     = 0;
+			inheritance_info.framebuffer = swap_chain_frame_buffers[current_image_index];
+		}
+
+		secondary_command_buffers.clear();
+		command_recorder.record(current_frame,
+		                        inheritance_info,
+		                        draw_commands.size(),
+		                        [this](VkCommandBuffer secondary_buffer, size_t first, size_t last) { record_draws(secondary_buffer, first, last); },
+		                        secondary_command_buffers);
+
+		vkCmdExecuteCommands(command_buffer, static_cast<uint32_t>(secondary_command_buffers.size()), secondary_command_buffers.data());
+	}
+	else
+	{
+		record_draws(command_buffer, 0, draw_commands.size());
+	}
+
+	if (dynamic_rendering_enabled)
+	{
+		vkCmdEndRendering(command_buffer);
+	}
+	else
+	{
+		vkCmdEndRenderPass(command_buffer);
+	}
+}
+
+void Render_manager::begin_main_pass(VkCommandBuffer command_buffer, uint32_t image_index, bool secondary_buffers)
+{
+	VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
+
+	if (!dynamic_rendering_enabled)
+	{
+		VkRenderPassBeginInfo render_pass_info = {};
+		render_pass_info.sType                 = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_pass_info.renderPass            = render_pass;
+		render_pass_info.framebuffer           = swap_chain_frame_buffers[image_index];
+		render_pass_info.renderArea.offset     = {0, 0};
+		render_pass_info.renderArea.extent     = swap_chain_extent;
+		render_pass_info.clearValueCount       = 1;
+		render_pass_info.pClearValues          = &clear_color;
+
+		vkCmdBeginRenderPass(command_buffer, &render_pass_info, secondary_buffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+		return;
+	}
+
+	VkRenderingAttachmentInfo color_attachment = {};
+	color_attachment.sType                     = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	color_attachment.imageView                 = swap_chain_image_views[image_index];
+	color_attachment.imageLayout               = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	color_attachment.loadOp                    = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	color_attachment.storeOp                   = VK_ATTACHMENT_STORE_OP_STORE;
+	color_attachment.clearValue                = clear_color;
+
+	VkRenderingInfo rendering_info      = {};
+	rendering_info.sType                = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	rendering_info.flags                = secondary_buffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+	rendering_info.renderArea.offset    = {0, 0};
+	rendering_info.renderArea.extent    = swap_chain_extent;
+	rendering_info.layerCount           = 1;
+	rendering_info.colorAttachmentCount = 1;
+	rendering_info.pColorAttachments    = &color_attachment;
+
+	vkCmdBeginRendering(command_buffer, &rendering_info);
+}
+
+bool Render_manager::build_render_graph()
+{
+	render_graph.reset();
+
+	// Acquired images arrive undefined, the graph waits for them at the stage the acquire semaphore is waited on
+	Render_usage final_usage = settings.headless ? Render_usage::transfer : Render_usage::present;
+	swapchain_target         = render_graph.import_image("Swapchain", {swap_chain_image_format, swap_chain_extent}, Render_usage::none, final_usage);
+
+	Render_pass_handle main_pass = render_graph.add_pass("Main pass", [this](VkCommandBuffer command_buffer) { record_main_pass(command_buffer); });
+	render_graph.write(main_pass, swapchain_target, Render_usage::color_attachment);
+
+	if (!render_graph.compile(device, gpu_allocator))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to compile the render graph.");
+		return false;
+	}
+
+	return true;
+}
+
+void Render_manager::record_draws(VkCommandBuffer command_buffer, size_t first, size_t last)
+{
+	PROFILE_SCOPE("Record draws");
+
+	// Secondary buffers inherit no state from the primary, so every range binds its own
+	bind_graphics_state(command_buffer);
+	indirect_renderer.bind_instances(command_buffer, current_frame);
+
+	Mesh_handle bound_mesh = INVALID_MESH;
+	for (size_t i = first; i < last; i++)
+	{
+		// Meshes still in flight on the transfer queue draw as their placeholder, or not at all
+		const Draw_command& draw     = draw_commands[i];
+		Mesh_handle         resolved = draw.mesh < resolved_meshes.size() ? resolved_meshes[draw.mesh] : INVALID_MESH;
+		if (resolved == INVALID_MESH)
+		{
+			continue;
+		}
+
+		const Mesh& mesh = meshes[resolved];
+		if (resolved != bound_mesh)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(command_buffer, 0, 1, &mesh.vertex_buffer, &offset);
+			vkCmdBindIndexBuffer(command_buffer, mesh.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+			bound_mesh = resolved;
+		}
+
+		vkCmdDrawIndexed(command_buffer, mesh.index_count, draw.instance_count, 0, 0, draw.first_instance);
+	}
+}
+
+void Render_manager::bind_graphics_state(VkCommandBuffer command_buffer)
+{
 	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline);
 
 	VkViewport viewport = {};
@@ -853,100 +1831,344 @@ void Render_manager::record_command_buffer(VkCommandBuffer command_buffer, uint3
 	scissors.extent   = swap_chain_extent;
 	vkCmdSetScissor(command_buffer, 0, 1, &scissors);
 
-	vkCmdDraw(command_buffer, 3, 1, 0, 0);
-
-	vkCmdEndRenderPass(command_buffer);
-
-	if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
+	if (bindless_supported)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to record command buffer.");
+		Draw_resources draw_resources = {};
+		draw_resources.buffer_handle  = transient_bindless_handle;
+		bindless_descriptors.bind(command_buffer, pipeline_layout);
+		vkCmdPushConstants(command_buffer, pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, DRAW_RESOURCES_OFFSET, sizeof(Draw_resources), &draw_resources);
 	}
 }
 
 void Render_manager::create_sync_objects()
 {
-	image_available_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	render_finished_semaphores.resize(MAX_FRAMES_IN_FLIGHT);
-	in_flight_fences.resize(MAX_FRAMES_IN_FLIGHT);
-
 	VkSemaphoreCreateInfo semaphore_info = {};
 	semaphore_info.sType                 = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo fence_info = {};
-	fence_info.sType             = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fence_info.flags             = VK_FENCE_CREATE_SIGNALED_BIT;
-
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+	for (Frame_context& frame : frames)
 	{
-		if (vkCreateSemaphore(device, &semaphore_info, nullptr, &image_available_semaphores[i]) != VK_SUCCESS
-		    || vkCreateSemaphore(device, &semaphore_info, nullptr, &render_finished_semaphores[i]) != VK_SUCCESS || vkCreateFence(device, &fence_info, nullptr, &in_flight_fences[i]) != VK_SUCCESS)
+		if (vkCreateSemaphore(device, &semaphore_info, nullptr, &frame.image_available) != VK_SUCCESS)
 		{
 			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create semaphores.");
 		}
 	}
+
+	// One timeline for every graphics submission replaces a fence per frame, acquire and present still need binary semaphores
+	graphics_timeline.startup(device);
+}
+
+void Render_manager::create_transient_buffer()
+{
+	// One ring shared by all frames in flight, each frame gets back what it used once the timeline reaches its value
+	VkDeviceSize       size  = TRANSIENT_BUFFER_SIZE * settings.frames_in_flight;
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+	                         | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	if (!gpu_allocator.create_buffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, transient_buffer, transient_allocation))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create transient buffer.");
+	}
+
+	// Shaders find transient data through one handle for the whole ring plus the offset of the allocation
+	if (bindless_supported && transient_buffer != VK_NULL_HANDLE)
+	{
+		transient_bindless_handle = bindless_descriptors.register_buffer(transient_buffer);
+	}
+
+	transient_ring.startup(size, settings.frames_in_flight);
+}
+
+void Render_manager::release_mesh(Mesh& mesh)
+{
+	if (mesh.vertex_buffer != VK_NULL_HANDLE)
+	{
+		gpu_allocator.destroy_buffer(mesh.vertex_buffer, mesh.vertex_allocation);
+	}
+	if (mesh.index_buffer != VK_NULL_HANDLE)
+	{
+		gpu_allocator.destroy_buffer(mesh.index_buffer, mesh.index_allocation);
+	}
+	mesh = {};
+}
+
+void Render_manager::release_retired_meshes()
+{
+	// Polled rather than waited on, a mesh stays until the timeline has passed the last frame that drew it
+	for (size_t i = 0; i < retired_meshes.size();)
+	{
+		Retired_mesh& retired = retired_meshes[i];
+		Mesh&         mesh    = meshes[retired.mesh];
+
+		// An upload acquired after the destroy call moves the value on, the frame about to be recorded may acquire it
+		if (!upload_manager.is_complete(mesh.upload_value))
+		{
+			retired.timeline_value = graphics_timeline.get_next_value();
+		}
+
+		if (!graphics_timeline.is_complete(retired.timeline_value))
+		{
+			i++;
+			continue;
+		}
+
+		release_mesh(mesh);
+		free_meshes.push_back(retired.mesh);
+		retired_meshes[i] = retired_meshes.back();
+		retired_meshes.pop_back();
+	}
+}
+
+void Render_manager::resolve_meshes()
+{
+	// Read by every recording of this frame, so a mesh swaps in for its placeholder on the frame its upload is acquired
+	resolved_meshes.resize(meshes.size());
+	for (Mesh_handle mesh = 0; mesh < meshes.size(); mesh++)
+	{
+		Mesh_handle placeholder = meshes[mesh].placeholder;
+		if (is_mesh_resident(mesh))
+		{
+			resolved_meshes[mesh] = mesh;
+		}
+		else
+		{
+			resolved_meshes[mesh] = is_mesh_resident(placeholder) ? placeholder : INVALID_MESH;
+		}
+	}
+}
+
+void Render_manager::reload_shaders()
+{
+	PROFILE_SCOPE("Reload shaders");
+
+	// New pipelines are picked up by the next recording, the ones they replace are released like meshes
+	for (Shader_handle shader : shader_manager.poll())
+	{
+		if (shader == cull_shader)
+		{
+			VkPipeline retired = indirect_renderer.replace_cull_pipeline(shader_manager.get_code(cull_shader));
+			if (retired != VK_NULL_HANDLE)
+			{
+				pipeline_manager.retire(retired, graphics_timeline.get_submitted_value());
+			}
+		}
+		else
+		{
+			pipeline_manager.recompile(shader);
+		}
+	}
+}
+
+void Render_manager::destroy_frame_contexts()
+{
+	for (Frame_context& frame : frames)
+	{
+		vkDestroySemaphore(device, frame.image_available, nullptr);
+		vkDestroyCommandPool(device, frame.command_pool, nullptr);
+	}
+
+	frames.clear();
+	graphics_timeline.shutdown();
 }
 
 void Render_manager::draw_frame()
 {
-	vkWaitForFences(device, 1, &in_flight_fences[current_frame], VK_TRUE, UINT64_MAX);
+	Frame_context& frame = frames[current_frame];
+
+	uint64_t frame_start = SDL_GetTicksNS();
 
-	uint32_t image_index;
-	VkResult result = vkAcquireNextImageKHR(device, swap_chain, UINT64_MAX, image_available_semaphores[current_frame], VK_NULL_HANDLE, &image_index);
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebuffer_resized)
 	{
-		framebuffer_resized = true;
-		recreate_swapchain();
+		PROFILE_SCOPE("Wait for frame timeline");
+		graphics_timeline.wait(frame.timeline_value);
 	}
-	else if (result != VK_SUCCESS)
+
+	uint64_t fence_wait_end = SDL_GetTicksNS();
+
+	// Nothing is submitted on a skipped frame, its old value stays reached and the next attempt does not block on it
+	release_retired_swapchains();
+	if (framebuffer_resized && !recreate_swapchain())
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to acquire swap chain image!");
+		return;
 	}
 
-	vkResetFences(device, 1, &in_flight_fences[current_frame]);
+	uint32_t image_index = current_frame;
+	if (!settings.headless)
+	{
+		VkResult result = vkAcquireNextImageKHR(device, swap_chain, UINT64_MAX, frame.image_available, VK_NULL_HANDLE, &image_index);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		{
+			framebuffer_resized = true;
+			return;
+		}
+		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to acquire swap chain image!");
+			return;
+		}
 
-	current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+		// Once every image of the current swapchain has come back, the presents queued on the retired ones are done
+		if (!swap_chain_images_acquired[image_index])
+		{
+			swap_chain_images_acquired[image_index] = true;
+			if (--unacquired_image_count == 0)
+			{
+				for (Retired_swapchain& retired : retired_swapchains)
+				{
+					retired.presentation_released = true;
+				}
+			}
+		}
+	}
 
-	vkResetCommandBuffer(command_buffers[current_frame], 0);
-	record_command_buffer(command_buffers[current_frame], image_index);
+	vkResetCommandPool(device, frame.command_pool, 0);
+	command_recorder.begin_frame(current_frame);
+	transient_ring.begin_frame(current_frame);
+	release_retired_meshes();
+	bindless_descriptors.release_retired(graphics_timeline.get_completed_value());
+	indirect_renderer.begin_frame(current_frame, graphics_timeline.get_completed_value());
+
+	// Until a rebuilt pipeline lands its old version, or a new one's fallback, is drawn with
+	pipeline_manager.update(graphics_timeline.get_submitted_value(), graphics_timeline.get_completed_value());
+	graphics_pipeline = pipeline_manager.get(scene_pipeline);
+	asset_streamer.update(frame_number);
+
+	// Kick off whatever was uploaded since the last frame, it is picked up by a later frame once the transfer queue is done
+	upload_manager.flush();
+
+	{
+		PROFILE_SCOPE("Record commands");
+		record_command_buffer(frame.command_buffer, image_index);
+	}
+
+	// Everything allocated up to here is read by this submission and is released when its timeline value is next waited on
+	transient_ring.end_frame(current_frame);
+
+	uint64_t record_end = SDL_GetTicksNS();
 
 	VkSubmitInfo submit_info{};
 	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore          waitSemaphores[] = {image_available_semaphores[current_frame]};
-	VkPipelineStageFlags waitStages[]     = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submit_info.waitSemaphoreCount        = 1;
-	submit_info.pWaitSemaphores           = waitSemaphores;
-	submit_info.pWaitDstStageMask         = waitStages;
+	VkSemaphore          waitSemaphores[3]   = {};
+	VkPipelineStageFlags waitStages[3]       = {};
+	uint64_t             waitValues[3]       = {};
+	uint32_t             waitCount           = 0;
+	VkSemaphore          signalSemaphores[2] = {};
+	uint64_t             signalValues[2]     = {};
+	uint32_t             signalCount         = 0;
 
-	submit_info.commandBufferCount = 1;
-	submit_info.pCommandBuffers    = &command_buffers[current_frame];
+	// Offscreen targets are neither acquired nor presented, so there is nothing to wait on or signal for the swapchain
+	if (!settings.headless)
+	{
+		waitSemaphores[waitCount] = frame.image_available;
+		waitStages[waitCount]     = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		waitCount++;
+
+		signalSemaphores[signalCount] = render_finished_semaphores[image_index];
+		signalCount++;
+	}
+
+	// Binary semaphores ignore their value, the timeline one marks the end of this frame for everything keyed on it
+	frame.timeline_value          = graphics_timeline.advance();
+	signalSemaphores[signalCount] = graphics_timeline.get_semaphore();
+	signalValues[signalCount]     = frame.timeline_value;
+	signalCount++;
 
-	VkSemaphore signalSemaphores[]   = {render_finished_semaphores[current_frame]};
-	submit_info.signalSemaphoreCount = 1;
+	// The value was already reached when the acquires were recorded, so this orders the uploads without stalling
+	if (upload_wait.value > 0)
+	{
+		waitSemaphores[waitCount] = upload_wait.semaphore;
+		waitStages[waitCount]     = upload_wait.stage_mask;
+		waitValues[waitCount]     = upload_wait.value;
+		waitCount++;
+	}
+
+	// Compute results read this frame, the stages before the first reader still overlap with it
+	if (compute_wait_value > 0)
+	{
+		waitSemaphores[waitCount] = async_compute.get_timeline().get_semaphore();
+		waitStages[waitCount]     = compute_wait_stages;
+		waitValues[waitCount]     = compute_wait_value;
+		waitCount++;
+
+		compute_wait_value  = 0;
+		compute_wait_stages = 0;
+	}
+
+	VkTimelineSemaphoreSubmitInfo timeline_info = {};
+	timeline_info.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_info.waitSemaphoreValueCount       = waitCount;
+	timeline_info.pWaitSemaphoreValues          = waitValues;
+	timeline_info.signalSemaphoreValueCount     = signalCount;
+	timeline_info.pSignalSemaphoreValues        = signalValues;
+
+	submit_info.pNext                = &timeline_info;
+	submit_info.waitSemaphoreCount   = waitCount;
+	submit_info.pWaitSemaphores      = waitSemaphores;
+	submit_info.pWaitDstStageMask    = waitStages;
+	submit_info.signalSemaphoreCount = signalCount;
 	submit_info.pSignalSemaphores    = signalSemaphores;
 
-	if (vkQueueSubmit(graphics_queue, 1, &submit_info, in_flight_fences[current_frame]) != VK_SUCCESS)
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers    = &frame.command_buffer;
+
+	gpu_profiler.mark_submit(current_frame);
+	if (vkQueueSubmit(graphics_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
 	{
 		throw std::runtime_error("failed to submit draw command buffer!");
 	}
 
-	VkPresentInfoKHR present_info{};
-	present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	uint64_t submit_end = SDL_GetTicksNS();
 
-	present_info.waitSemaphoreCount = 1;
-	present_info.pWaitSemaphores    = signalSemaphores;
+	if (!settings.headless)
+	{
+		VkPresentInfoKHR present_info{};
+		present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-	VkSwapchainKHR swapChains[] = {swap_chain};
-	present_info.swapchainCount = 1;
-	present_info.pSwapchains    = swapChains;
+		present_info.waitSemaphoreCount = 1;
+		present_info.pWaitSemaphores    = &render_finished_semaphores[image_index];
 
-	present_info.pImageIndices = &image_index;
+		VkSwapchainKHR swapChains[] = {swap_chain};
+		present_info.swapchainCount = 1;
+		present_info.pSwapchains    = swapChains;
 
-	vkQueuePresentKHR(present_queue, &present_info);
+		present_info.pImageIndices = &image_index;
 
-	current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
-}
+		// Present ids let the pacer wait for this frame to reach the display
+		uint64_t       present_id      = frame_pacer.next_present_id();
+		VkPresentIdKHR present_id_info = {};
+		present_id_info.sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+		present_id_info.swapchainCount = 1;
+		present_id_info.pPresentIds    = &present_id;
+		if (present_id != 0)
+		{
+			present_info.pNext = &present_id_info;
+		}
 
-void Render_manager::framebuffer_resize_callback(SDL_Window* window, int width, int height)
-{
+		PROFILE_SCOPE("Present");
+		VkResult result = vkQueuePresentKHR(present_queue, &present_info);
+		frame_pacer.mark_present(present_id);
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+		{
+			framebuffer_resized = true;
+		}
+		else if (result != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to present swap chain image!");
+		}
+	}
+
+	current_frame = (current_frame + 1) % settings.frames_in_flight;
+	frame_number++;
+
+	uint64_t frame_end = SDL_GetTicksNS();
+
+	last_frame_timings.fence_wait_ns = fence_wait_end - frame_start;
+	last_frame_timings.record_ns     = record_end - fence_wait_end;
+	last_frame_timings.submit_ns     = submit_end - record_end;
+	last_frame_timings.cpu_ns        = frame_end - fence_wait_end;
+
+	if (settings.headless)
+	{
+		frame_pacer.mark_present(0);
+	}
+	frame_pacer.pace(swap_chain);
 }
@@ -1,10 +1,31 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
+#include <span>
 #include <string>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
+#include "config/application.hpp"
+#include "core/asset_archive.hpp"
+#include "core/ring_allocator.hpp"
+#include "graphics/asset_streamer.hpp"
+#include "graphics/bindless_descriptors.hpp"
+#include "graphics/command_recorder.hpp"
+#include "graphics/compute_queue.hpp"
+#include "graphics/frame_pacer.hpp"
+#include "graphics/gpu_allocator.hpp"
+#include "graphics/gpu_profiler.hpp"
+#include "graphics/gpu_timeline.hpp"
+#include "graphics/indirect_renderer.hpp"
+#include "graphics/mesh.hpp"
+#include "graphics/pipeline_cache.hpp"
+#include "graphics/pipeline_manager.hpp"
+#include "graphics/render_graph.hpp"
+#include "graphics/shader_manager.hpp"
+#include "graphics/upload_manager.hpp"
+
 
 class SDL_Window;
 class SDL_Surface;
@@ -14,13 +35,35 @@ struct Queue_family_indices
 {
 	std::optional<uint32_t> graphics_family;
 	std::optional<uint32_t> present_family;
+	std::optional<uint32_t> transfer_family;
+	std::optional<uint32_t> compute_family;
 
-	bool is_complete()
+	bool is_complete() const
 	{
 		return graphics_family.has_value() && present_family.has_value();
 	}
 };
 
+// What selection asked the driver about one physical device, kept so the rest of startup does not ask again
+struct Physical_device_info
+{
+	VkPhysicalDevice                       device                = VK_NULL_HANDLE;
+	uint32_t                               index                 = 0;
+	VkPhysicalDeviceProperties             properties            = {};
+	VkPhysicalDeviceFeatures               features              = {};
+	VkPhysicalDeviceVulkan11Features       vulkan_11_features    = {};
+	VkPhysicalDeviceVulkan12Features       vulkan_12_features    = {};
+	VkPhysicalDeviceVulkan13Features       vulkan_13_features    = {};
+	VkPhysicalDevicePresentIdFeaturesKHR   present_id_features   = {};
+	VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features = {};
+	VkDeviceSize                           device_local_bytes    = 0;
+	std::vector<VkQueueFamilyProperties>   queue_families;
+	std::vector<VkExtensionProperties>     extensions;
+	Queue_family_indices                   queue_family_indices;
+	bool                                   suitable = false;
+	int64_t                                score    = 0;
+};
+
 struct Swap_chain_support_details
 {
 	VkSurfaceCapabilitiesKHR        capabilities;
@@ -28,48 +71,211 @@ struct Swap_chain_support_details
 	std::vector<VkPresentModeKHR>   present_modes;
 };
 
+// The frame's commands are done once the graphics timeline reaches its value, zero before its first submit
+struct Frame_context
+{
+	VkCommandPool   command_pool    = VK_NULL_HANDLE;
+	VkCommandBuffer command_buffer  = VK_NULL_HANDLE;
+	VkSemaphore     image_available = VK_NULL_HANDLE;
+	uint64_t        timeline_value  = 0;
+};
+
+// The bindless handle names the whole transient buffer, INVALID_BINDLESS_HANDLE without bindless descriptors
+struct Transient_allocation
+{
+	VkBuffer        buffer          = VK_NULL_HANDLE;
+	VkDeviceSize    offset          = 0;
+	void*           data            = nullptr;
+	Bindless_handle bindless_handle = INVALID_BINDLESS_HANDLE;
+};
+
+// A destroyed mesh is released once the graphics timeline passes the last submission that could reference it
+struct Retired_mesh
+{
+	Mesh_handle mesh           = INVALID_MESH;
+	uint64_t    timeline_value = 0;
+};
+
+// Old swapchain images are only released once every frame that rendered to them has retired and presentation has let go of
+// their semaphores, so a resize never idles the device
+struct Retired_swapchain
+{
+	VkSwapchainKHR              swap_chain = VK_NULL_HANDLE;
+	std::vector<VkImage>        images;
+	std::vector<Gpu_allocation> image_allocations;
+	std::vector<VkImageView>    image_views;
+	std::vector<VkFramebuffer>  frame_buffers;
+	std::vector<VkSemaphore>    render_finished_semaphores;
+	Render_graph                render_graph;
+	uint64_t                    timeline_value        = 0;
+	bool                        presentation_released = false;
+};
+
+struct Render_settings
+{
+	bool         headless          = false;
+	uint32_t     width             = WINDOW_WIDTH;
+	uint32_t     height            = WINDOW_HEIGHT;
+	uint32_t     frames_in_flight  = MAX_FRAMES_IN_FLIGHT;
+	bool         gpu_culling       = true;
+	bool         dynamic_rendering = true;
+	uint64_t     upload_budget     = STREAM_UPLOAD_BUDGET;
+	uint64_t     memory_budget     = STREAM_MEMORY_BUDGET;
+	Present_mode present_mode      = Present_mode::mailbox;
+	uint32_t     frame_rate_limit  = FRAME_RATE_LIMIT;
+	uint32_t     max_queued_frames = MAX_QUEUED_FRAMES;
+
+	// An enumeration index or part of a device name, empty falls back to GPU_OVERRIDE_ENV and then to the best score
+	std::string gpu;
+};
+
+struct Frame_timings
+{
+	uint64_t cpu_ns        = 0;
+	uint64_t fence_wait_ns = 0;
+	uint64_t record_ns     = 0;
+	uint64_t submit_ns     = 0;
+};
+
 class Render_manager
 {
 public:
 
-	bool startup();
+	bool startup(Job_system& job_system, const Render_settings& render_settings = {});
 	void shutdown();
 	void update();
+	void resize(uint32_t width, uint32_t height);
+	void set_instances(const std::vector<Mesh_instance>& instances);
+	void update_instances(const std::vector<Mesh_instance>& instances);
+	void set_view_projection(const glm::mat4& view_projection);
+	void set_gpu_culling(bool enabled);
+	bool is_gpu_culling_supported() const;
+
+	// A new present mode takes effect when the swapchain is recreated at the start of the next frame
+	void set_present_mode(Present_mode present_mode);
+	void set_frame_rate_limit(uint32_t frames_per_second);
+	void record_input(uint64_t timestamp_ns);
+
+	Mesh_handle create_mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	void        destroy_mesh(Mesh_handle mesh);
+
+	// A reserved mesh has a handle but no buffers and draws as its placeholder; unloading returns it to that state
+	Mesh_handle reserve_mesh(Mesh_handle placeholder = INVALID_MESH);
+	bool        upload_mesh(Mesh_handle mesh, std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+	void        unload_mesh(Mesh_handle mesh);
+	bool        is_mesh_resident(Mesh_handle mesh) const;
+	Mesh_handle get_placeholder_mesh() const;
+
+	Transient_allocation allocate_transient(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+	const Frame_timings&      get_last_frame_timings() const;
+	const Frame_pacing_stats& get_frame_pacing_stats() const;
+	Gpu_allocator&            get_gpu_allocator();
+	Asset_streamer&           get_asset_streamer();
+	Pipeline_manager&         get_pipeline_manager();
+	const Pipeline_stats&     get_pipeline_stats() const;
+	Shader_manager&           get_shader_manager();
+	VkDevice                  get_device() const;
+
+	const Physical_device_info& get_physical_device_info() const;
+
+	// Compute beside the frame is recorded into get_compute_queue().begin() and submitted there. The next frame's
+	// graphics submit waits for the returned value before the given stages, compute waits on the graphics timeline
+	Compute_queue& get_compute_queue();
+	Gpu_timeline&  get_graphics_timeline();
+	void           wait_for_compute(uint64_t value, VkPipelineStageFlags stage_mask);
+
+	// Registration goes through the descriptors directly, releasing here stamps the slot with the current frame
+	Bindless_descriptors& get_bindless_descriptors();
+	bool                  is_bindless_supported() const;
+	void                  release_bindless(Bindless_type type, Bindless_handle handle);
 
 private:
 
-	SDL_Window*                  window = nullptr;
-	VkSurfaceKHR                 surface;
+	Render_settings              settings;
+	SDL_Window*                  window  = nullptr;
+	VkSurfaceKHR                 surface = VK_NULL_HANDLE;
 	VkInstance                   vulkan_instance;
 	VkDebugUtilsMessengerEXT     debug_messenger;
 	VkPhysicalDevice             physical_device = VK_NULL_HANDLE;
+	Physical_device_info         physical_device_info;
 	VkDevice                     device;
 	VkQueue                      graphics_queue;
 	VkQueue                      present_queue;
-	VkSwapchainKHR               swap_chain;
+	VkQueue                      transfer_queue;
+	VkQueue                      compute_queue;
+	VkSwapchainKHR               swap_chain = VK_NULL_HANDLE;
 	std::vector<VkImage>         swap_chain_images;
 	std::vector<VkImageView>     swap_chain_image_views;
 	VkFormat                     swap_chain_image_format;
 	VkExtent2D                   swap_chain_extent;
-	VkRenderPass                 render_pass;
+	VkRenderPass                 render_pass = VK_NULL_HANDLE;
 	VkPipelineLayout             pipeline_layout;
-	VkPipeline                   graphics_pipeline;
+	VkPipeline                   graphics_pipeline = VK_NULL_HANDLE;
+	Pipeline_cache               pipeline_cache;
+	Pipeline_manager             pipeline_manager;
+	Pipeline_handle              scene_pipeline = INVALID_PIPELINE;
+	Asset_archive                asset_archive;
+	Shader_manager               shader_manager;
+	Shader_handle                vert_shader = 0;
+	Shader_handle                frag_shader = 0;
+	Shader_handle                cull_shader = 0;
+	Gpu_allocator                gpu_allocator;
 	std::vector<VkFramebuffer>   swap_chain_frame_buffers;
-	VkCommandPool                command_pool;
-	std::vector<VkCommandBuffer> command_buffers;
-	std::vector<VkSemaphore>     image_available_semaphores;
+	std::vector<Frame_context>   frames;
+	Gpu_timeline                 graphics_timeline;
 	std::vector<VkSemaphore>     render_finished_semaphores;
-	std::vector<VkFence>         in_flight_fences;
+	Command_recorder             command_recorder;
+	Upload_manager               upload_manager;
+	Compute_queue                async_compute;
+	uint64_t                     compute_wait_value  = 0;
+	VkPipelineStageFlags         compute_wait_stages = 0;
+	std::vector<Mesh>            meshes;
+	std::vector<Mesh_handle>     free_meshes;
+	std::vector<Retired_mesh>    retired_meshes;
+	std::vector<Mesh_handle>     resolved_meshes;
+	Mesh_handle                  placeholder_mesh = INVALID_MESH;
+	Asset_streamer               asset_streamer;
+	Indirect_renderer            indirect_renderer;
+	Bindless_descriptors         bindless_descriptors;
+	std::vector<Draw_command>    draw_commands;
+	std::vector<VkCommandBuffer> secondary_command_buffers;
 	uint32_t                     current_frame = 0;
-	std::vector<VkFence>         in_flight_fences;
-	bool                         framebuffer_resized = false;
+	uint64_t                     frame_number  = 0;
+	Timeline_wait                upload_wait;
+	bool                         framebuffer_resized             = false;
+	bool                         gpu_culling_supported           = false;
+	bool                         draw_indirect_count_supported   = false;
+	bool                         calibrated_timestamps_supported = false;
+	bool                         dynamic_rendering_enabled       = false;
+	bool                         present_wait_supported          = false;
+	bool                         bindless_supported              = false;
+	uint32_t                     max_draw_indirect_count         = 1;
+	std::vector<Gpu_allocation>  offscreen_image_allocations;
+	VkBuffer                     transient_buffer          = VK_NULL_HANDLE;
+	Bindless_handle              transient_bindless_handle = INVALID_BINDLESS_HANDLE;
+	Gpu_allocation               transient_allocation;
+	Ring_allocator               transient_ring;
+	Frame_timings                last_frame_timings;
+	Gpu_profiler                 gpu_profiler;
+	Frame_pacer                  frame_pacer;
+	Render_graph                 render_graph;
+	Render_resource              swapchain_target    = INVALID_RENDER_RESOURCE;
+	uint32_t                     current_image_index = 0;
+	bool                         record_gpu_driven   = false;
+	bool                         record_parallel     = false;
+
+	std::vector<Retired_swapchain> retired_swapchains;
+	std::vector<bool>              swap_chain_images_acquired;
+	uint32_t                       unacquired_image_count = 0;
 
 	bool create_vulkan_instance();
 	void create_surface();
 	bool check_validation_layer_support();
-	bool check_device_extension_support(VkPhysicalDevice device);
+	bool check_device_extension_support(const std::vector<VkExtensionProperties>& available_extensions);
 
 	std::vector<const char*> get_required_extensions();
+	std::vector<const char*> get_required_device_extensions();
 
 	void setup_debug_messenger();
 
@@ -82,9 +288,10 @@ private:
 	static void populate_debug_messenger_create_info(VkDebugUtilsMessengerCreateInfoEXT& create_info);
 	static void destroy_debug_utils_messenger_ext(VkInstance instance, VkDebugUtilsMessengerEXT debug_messenger, const VkAllocationCallbacks* allocator);
 
-	void                 pick_physical_device();
-	bool                 is_device_suitable(VkPhysicalDevice device);
-	Queue_family_indices find_queue_families(VkPhysicalDevice device);
+	bool                 pick_physical_device();
+	Physical_device_info query_physical_device(VkPhysicalDevice device, uint32_t index);
+	bool                 is_device_suitable(const Physical_device_info& info);
+	Queue_family_indices find_queue_families(VkPhysicalDevice device, const std::vector<VkQueueFamilyProperties>& queue_families);
 
 	void                       create_logical_device();
 	Swap_chain_support_details query_swap_chain_support(VkPhysicalDevice device);
@@ -92,20 +299,31 @@ private:
 	VkSurfaceFormatKHR choose_swap_surface_format(const std::vector<VkSurfaceFormatKHR>& available_formats);
 	VkPresentModeKHR   choose_swap_present_mode(const std::vector<VkPresentModeKHR>& available_present_modes);
 	VkExtent2D         choose_swap_extent(const VkSurfaceCapabilitiesKHR& capabilities);
-	void               create_swapchain();
-	void               recreate_swapchain();
-	void               cleanup_swapchain();
+	void               create_swapchain(VkSwapchainKHR old_swap_chain = VK_NULL_HANDLE);
+	bool               recreate_swapchain();
+	void               retire_swapchain();
+	void               release_retired_swapchains();
+	void               destroy_retired_swapchain(Retired_swapchain& retired);
 	void               create_image_views();
-	void               create_graphics_pipeline();
+	void               create_offscreen_targets();
 
-	static std::vector<char> read_file(const std::string& filename);
-	VkShaderModule           create_shader_module(const std::vector<char>& code);
+	Graphics_pipeline_state  get_graphics_pipeline_state();
 	void                     create_render_pass();
 	void                     create_frame_buffers();
 	void                     create_command_pool();
 	void                     create_command_buffers();
 	void                     record_command_buffer(VkCommandBuffer command_buffer, uint32_t image_index);
+	bool                     build_render_graph();
+	void                     record_main_pass(VkCommandBuffer command_buffer);
+	void                     begin_main_pass(VkCommandBuffer command_buffer, uint32_t image_index, bool secondary_buffers);
+	void                     record_draws(VkCommandBuffer command_buffer, size_t first, size_t last);
+	void                     bind_graphics_state(VkCommandBuffer command_buffer);
 	void                     create_sync_objects();
+	void                     create_transient_buffer();
+	void                     release_mesh(Mesh& mesh);
+	void                     release_retired_meshes();
+	void                     resolve_meshes();
+	void                     reload_shaders();
+	void                     destroy_frame_contexts();
 	void                     draw_frame();
-	static void              framebuffer_resize_callback(SDL_Window* window, int width, int height);
 };
\ No newline at end of file
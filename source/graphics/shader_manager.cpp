@@ -0,0 +1,459 @@
+#include "shader_manager.hpp"
+
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_process.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+#include "config/application.hpp"
+#include "core/file_io.hpp"
+#include "core/hash.hpp"
+#include "core/profiler.hpp"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+
+// The quoted names of the #include directives in the source, in order. Directives inside disabled blocks are picked
+// up too, which only costs a recompile when such a file changes
+static std::vector<std::string> find_include_names(const std::vector<char>& source)
+{
+	std::vector<std::string> names;
+	std::string_view         text(source.data(), source.size());
+
+	for (size_t line_start = 0; line_start < text.size();)
+	{
+		size_t line_end = std::min(text.find('\n', line_start), text.size());
+		std::string_view line = text.substr(line_start, line_end - line_start);
+		line_start            = line_end + 1;
+
+		size_t directive = line.find_first_not_of(" \t");
+		if (directive == std::string_view::npos || line[directive] != '#')
+		{
+			continue;
+		}
+
+		directive = line.find_first_not_of(" \t", directive + 1);
+		if (directive == std::string_view::npos || line.substr(directive, 7) != "include")
+		{
+			continue;
+		}
+
+		size_t open  = line.find('"', directive + 7);
+		size_t close = open == std::string_view::npos ? open : line.find('"', open + 1);
+		if (close != std::string_view::npos)
+		{
+			names.emplace_back(line.substr(open + 1, close - open - 1));
+		}
+	}
+
+	return names;
+}
+
+// Resolves includes the way glslc does, relative to the including file, and hashes each one once by name and contents
+static uint64_t hash_includes(uint64_t hash, const std::string& path, const std::vector<char>& source, std::vector<std::string>& include_paths)
+{
+	for (const std::string& name : find_include_names(source))
+	{
+		std::string include_path = (std::filesystem::path(path).parent_path() / name).lexically_normal().string();
+		if (std::find(include_paths.begin(), include_paths.end(), include_path) != include_paths.end())
+		{
+			continue;
+		}
+		include_paths.push_back(include_path);
+
+		// A missing include still goes into the key, so creating it later counts as an edit
+		hash = hash_bytes(hash, name.c_str(), name.size() + 1);
+
+		std::vector<char> include_source;
+		if (read_file(include_path, include_source))
+		{
+			hash = hash_bytes(hash, include_source.data(), include_source.size());
+			hash = hash_includes(hash, include_path, include_source, include_paths);
+		}
+	}
+
+	return hash;
+}
+
+// glslc picks the stage from the extension, so the same text under another name is a different shader
+static uint64_t hash_source(const std::string& name, const std::string& path, const std::vector<char>& source, std::vector<std::string>& include_paths)
+{
+	std::string key  = std::string(SHADER_COMPILER) + ' ' + name.substr(name.find_last_of('.') + 1) + '\n';
+	uint64_t    hash = hash_bytes(FNV_OFFSET_BASIS, key.data(), key.size());
+
+	include_paths.clear();
+	return hash_includes(hash_bytes(hash, source.data(), source.size()), path, source, include_paths);
+}
+
+#ifndef __linux__
+// Edits always move a file's time forward, so the newest time of the source and its includes changes with any of them
+static std::filesystem::file_time_type get_newest_write_time(const std::string& source_path, const std::vector<std::string>& include_paths)
+{
+	std::error_code                 error;
+	std::filesystem::file_time_type newest = std::filesystem::last_write_time(source_path, error);
+
+	for (const std::string& include_path : include_paths)
+	{
+		std::filesystem::file_time_type modified_time = std::filesystem::last_write_time(include_path, error);
+		if (!error)
+		{
+			newest = std::max(newest, modified_time);
+		}
+	}
+
+	return newest;
+}
+#endif
+
+
+void Shader_manager::startup(const std::string& source_path, const std::string& spirv_path, const std::string& cache_path, bool enable_hot_reload, const Asset_archive* asset_archive)
+{
+	source_directory = source_path;
+	spirv_directory  = spirv_path;
+	cache_directory  = cache_path;
+	hot_reload       = enable_hot_reload;
+	archive          = asset_archive && asset_archive->is_open() ? asset_archive : nullptr;
+	stopping         = false;
+
+	if (!hot_reload)
+	{
+		return;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(cache_directory, error);
+	if (error)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader cache %s, hot reload disabled.", cache_directory.c_str());
+		hot_reload = false;
+		return;
+	}
+
+#ifdef __linux__
+	watch_descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	int directory_watch = watch_descriptor < 0 ? -1 : inotify_add_watch(watch_descriptor, source_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (directory_watch < 0)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to watch %s, hot reload disabled.", source_directory.c_str());
+		if (watch_descriptor >= 0)
+		{
+			close(watch_descriptor);
+			watch_descriptor = -1;
+		}
+		hot_reload = false;
+		return;
+	}
+	watched_directories[directory_watch] = source_directory;
+#endif
+
+	compile_thread = std::thread(&Shader_manager::compile_loop, this);
+}
+
+void Shader_manager::shutdown()
+{
+	if (compile_thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		compile_condition.notify_one();
+		compile_thread.join();
+	}
+
+#ifdef __linux__
+	if (watch_descriptor >= 0)
+	{
+		close(watch_descriptor);
+		watch_descriptor = -1;
+	}
+	watched_directories.clear();
+#endif
+
+	shaders.clear();
+	compile_jobs.clear();
+	compile_results.clear();
+}
+
+Shader_handle Shader_manager::load(const std::string& source_name, const std::string& spirv_name)
+{
+	Shader shader;
+	shader.name        = source_name;
+	shader.source_path = source_directory + source_name;
+
+	// Packed and committed SPIR-V sit beside the sources, what the build compiled sits in its output directory
+	std::string spirv_path = source_directory + spirv_name;
+	if (!archive || !archive->read(spirv_path, shader.code))
+	{
+		if (!read_file(spirv_directory + spirv_name, shader.code))
+		{
+			read_file(spirv_path, shader.code);
+		}
+	}
+
+	std::vector<char> source;
+	if (hot_reload && read_file(shader.source_path, source))
+	{
+		// The prebuilt SPIR-V is assumed to match its source, unless an edit from an earlier session is in the cache
+		shader.source_hash = hash_source(source_name, shader.source_path, source, shader.include_paths);
+		read_file(get_cache_path(shader.source_hash), shader.code);
+		watch_includes(shader);
+
+#ifndef __linux__
+		shader.modified_time = get_newest_write_time(shader.source_path, shader.include_paths);
+#endif
+	}
+
+	// Nothing to build a pipeline from, hot reload would only fill it in once the source is edited
+	if (shader.code.empty())
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to open file %s.", spirv_path.c_str());
+		return INVALID_SHADER;
+	}
+
+	shaders.push_back(std::move(shader));
+
+	return static_cast<Shader_handle>(shaders.size() - 1);
+}
+
+const std::vector<char>& Shader_manager::get_code(Shader_handle shader) const
+{
+	return shaders[shader].code;
+}
+
+std::vector<Shader_handle> Shader_manager::poll()
+{
+	std::vector<Shader_handle> changed;
+	if (!hot_reload)
+	{
+		return changed;
+	}
+
+	std::vector<Shader_handle> modified;
+	find_modified_shaders(modified);
+
+	for (Shader_handle shader : modified)
+	{
+		refresh(shader, changed);
+	}
+
+	std::vector<Compile_result> results;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		results.swap(compile_results);
+	}
+
+	for (Compile_result& result : results)
+	{
+		Shader& shader = shaders[result.shader];
+
+		// A newer edit is already queued, its result replaces this one
+		if (result.source_hash != shader.pending_hash)
+		{
+			continue;
+		}
+
+		shader.code         = std::move(result.code);
+		shader.source_hash  = result.source_hash;
+		shader.pending_hash = 0;
+
+		if (std::find(changed.begin(), changed.end(), result.shader) == changed.end())
+		{
+			changed.push_back(result.shader);
+		}
+	}
+
+	for (Shader_handle shader : changed)
+	{
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Reloaded shader %s.", shaders[shader].name.c_str());
+	}
+
+	return changed;
+}
+
+void Shader_manager::find_modified_shaders(std::vector<Shader_handle>& modified)
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+
+	ssize_t length = 0;
+	while ((length = read(watch_descriptor, buffer, sizeof(buffer))) > 0)
+	{
+		const inotify_event* event = nullptr;
+		for (char* position = buffer; position < buffer + length; position += sizeof(inotify_event) + event->len)
+		{
+			event = reinterpret_cast<const inotify_event*>(position);
+			if (event->len == 0 || !watched_directories.contains(event->wd))
+			{
+				continue;
+			}
+
+			std::string changed = (std::filesystem::path(watched_directories[event->wd]) / event->name).lexically_normal().string();
+
+			for (Shader_handle i = 0; i < shaders.size(); i++)
+			{
+				const Shader& shader          = shaders[i];
+				bool          source_changed  = std::filesystem::path(shader.source_path).lexically_normal() == changed;
+				bool          include_changed = std::find(shader.include_paths.begin(), shader.include_paths.end(), changed) != shader.include_paths.end();
+
+				if ((source_changed || include_changed) && std::find(modified.begin(), modified.end(), i) == modified.end())
+				{
+					modified.push_back(i);
+				}
+			}
+		}
+	}
+#else
+	// No change notifications here, so compare modification times a few times a second
+	uint64_t now = SDL_GetTicksNS();
+	if (now < next_scan_ns)
+	{
+		return;
+	}
+	next_scan_ns = now + SHADER_POLL_INTERVAL_MS * SDL_NS_PER_MS;
+
+	for (Shader_handle i = 0; i < shaders.size(); i++)
+	{
+		std::filesystem::file_time_type modified_time = get_newest_write_time(shaders[i].source_path, shaders[i].include_paths);
+		if (modified_time != shaders[i].modified_time)
+		{
+			shaders[i].modified_time = modified_time;
+			modified.push_back(i);
+		}
+	}
+#endif
+}
+
+void Shader_manager::refresh(Shader_handle handle, std::vector<Shader_handle>& changed)
+{
+	Shader&           shader = shaders[handle];
+	std::vector<char> source;
+
+	// Editors may still be writing, the next notification picks the final contents up
+	if (!read_file(shader.source_path, source))
+	{
+		return;
+	}
+
+	// The edit may have added or dropped includes, so the watch list follows the source
+	uint64_t source_hash = hash_source(shader.name, shader.source_path, source, shader.include_paths);
+	watch_includes(shader);
+	if (source_hash == shader.source_hash || source_hash == shader.pending_hash)
+	{
+		return;
+	}
+
+	std::vector<char> code;
+	if (read_file(get_cache_path(source_hash), code))
+	{
+		shader.code         = std::move(code);
+		shader.source_hash  = source_hash;
+		shader.pending_hash = 0;
+		changed.push_back(handle);
+		return;
+	}
+
+	shader.pending_hash = source_hash;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		compile_jobs.push_back({handle, source_hash, shader.source_path, get_cache_path(source_hash)});
+	}
+	compile_condition.notify_one();
+}
+
+void Shader_manager::watch_includes(const Shader& shader)
+{
+#ifdef __linux__
+	// Watching the same directory again hands back its existing descriptor
+	for (const std::string& include_path : shader.include_paths)
+	{
+		std::string directory = std::filesystem::path(include_path).parent_path().string();
+		int         watch     = inotify_add_watch(watch_descriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (watch < 0)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to watch %s, edits to %s are not reloaded.", directory.c_str(), include_path.c_str());
+			continue;
+		}
+		watched_directories.try_emplace(watch, directory);
+	}
+#else
+	(void)shader;
+#endif
+}
+
+void Shader_manager::compile_loop()
+{
+	PROFILE_THREAD_NAME("Shader compiler");
+
+	while (true)
+	{
+		Compile_job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			compile_condition.wait(lock, [this] { return stopping || !compile_jobs.empty(); });
+
+			if (stopping)
+			{
+				return;
+			}
+
+			job = std::move(compile_jobs.front());
+			compile_jobs.pop_front();
+		}
+
+		PROFILE_SCOPE("Compile shader");
+
+		// Compiled next to its final name and renamed, so a crash never leaves a truncated entry in the cache
+		std::string temporary_path = job.spirv_path + ".tmp";
+		const char* arguments[]    = {SHADER_COMPILER, job.source_path.c_str(), "-o", temporary_path.c_str(), nullptr};
+
+		SDL_Process* process = SDL_CreateProcess(arguments, false);
+		if (!process)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to run %s: %s", SHADER_COMPILER, SDL_GetError());
+			continue;
+		}
+
+		int exit_code = -1;
+		SDL_WaitProcess(process, true, &exit_code);
+		SDL_DestroyProcess(process);
+
+		std::error_code error;
+		if (exit_code != 0)
+		{
+			// glslc has printed the diagnostics, the previous code stays in use until the source compiles again
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to compile %s.", job.source_path.c_str());
+			std::filesystem::remove(temporary_path, error);
+			continue;
+		}
+
+		std::filesystem::rename(temporary_path, job.spirv_path, error);
+
+		Compile_result result;
+		result.shader      = job.shader;
+		result.source_hash = job.source_hash;
+
+		if (error || !read_file(job.spirv_path, result.code))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to store %s in the shader cache.", job.source_path.c_str());
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		compile_results.push_back(std::move(result));
+	}
+}
+
+std::string Shader_manager::get_cache_path(uint64_t source_hash) const
+{
+	char file_name[32];
+	std::snprintf(file_name, sizeof(file_name), "%016llx.spv", static_cast<unsigned long long>(source_hash));
+
+	return cache_directory + file_name;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "core/asset_archive.hpp"
+
+
+using Shader_handle = uint32_t;
+
+constexpr Shader_handle INVALID_SHADER = UINT32_MAX;
+
+// Owns the SPIR-V every pipeline is built from. With hot reload on, edited sources are recompiled on a background
+// thread and the results are kept in an on-disk cache keyed by a hash of the source and everything it includes, so
+// reverting an edit is free.
+class Shader_manager
+{
+public:
+
+	// Loose SPIR-V is looked up in the build output directory first, then beside the sources where the committed copies live
+	void startup(const std::string& source_directory, const std::string& spirv_directory, const std::string& cache_directory, bool hot_reload, const Asset_archive* asset_archive = nullptr);
+	void shutdown();
+
+	// Starts from the prebuilt SPIR-V, packed or loose, or from the cache when the current source has been compiled before.
+	// INVALID_SHADER when there is neither
+	Shader_handle            load(const std::string& source_name, const std::string& spirv_name);
+	const std::vector<char>& get_code(Shader_handle shader) const;
+
+	// Call between frames, returns the shaders whose code changed since the last call
+	std::vector<Shader_handle> poll();
+
+private:
+
+	struct Shader
+	{
+		std::string                     name;
+		std::string                     source_path;
+		std::vector<std::string>        include_paths;
+		std::vector<char>               code;
+		uint64_t                        source_hash  = 0;
+		uint64_t                        pending_hash = 0;
+		std::filesystem::file_time_type modified_time;
+	};
+
+	struct Compile_job
+	{
+		Shader_handle shader      = 0;
+		uint64_t      source_hash = 0;
+		std::string   source_path;
+		std::string   spirv_path;
+	};
+
+	struct Compile_result
+	{
+		Shader_handle     shader      = 0;
+		uint64_t          source_hash = 0;
+		std::vector<char> code;
+	};
+
+	std::string                          source_directory;
+	std::string                          spirv_directory;
+	std::string                          cache_directory;
+	bool                                 hot_reload = false;
+	const Asset_archive*                 archive    = nullptr;
+	std::vector<Shader>                  shaders;
+	int                                  watch_descriptor = -1;
+	std::unordered_map<int, std::string> watched_directories;
+	uint64_t                             next_scan_ns = 0;
+	std::thread                          compile_thread;
+	std::mutex                           mutex;
+	std::condition_variable              compile_condition;
+	std::deque<Compile_job>              compile_jobs;
+	std::vector<Compile_result>          compile_results;
+	bool                                 stopping = false;
+
+	void        find_modified_shaders(std::vector<Shader_handle>& modified);
+	void        refresh(Shader_handle shader, std::vector<Shader_handle>& changed);
+	void        watch_includes(const Shader& shader);
+	void        compile_loop();
+	std::string get_cache_path(uint64_t source_hash) const;
+};
@@ -0,0 +1,309 @@
+#include "upload_manager.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <cstring>
+
+#include "config/application.hpp"
+
+
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+
+bool Upload_manager::startup(VkDevice logical_device, Gpu_allocator& allocator, VkQueue queue, uint32_t transfer_family_index, uint32_t graphics_family_index)
+{
+	device          = logical_device;
+	gpu_allocator   = &allocator;
+	transfer_queue  = queue;
+	transfer_family = transfer_family_index;
+	graphics_family = graphics_family_index;
+	acquired_value  = 0;
+
+	VkCommandPoolCreateInfo pool_info = {};
+	pool_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	pool_info.flags                   = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	pool_info.queueFamilyIndex        = transfer_family;
+
+	if (vkCreateCommandPool(device, &pool_info, nullptr, &command_pool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create upload command pool.");
+		return false;
+	}
+
+	if (!timeline.startup(device))
+	{
+		return false;
+	}
+
+	if (!gpu_allocator->create_buffer(STAGING_BUFFER_SIZE,
+	                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+	                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+	                                  staging_buffer,
+	                                  staging_allocation))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to create staging buffer.");
+		return false;
+	}
+
+	// Staging space is handed back per batch as the timeline passes it, not per frame
+	staging_ring.startup(STAGING_BUFFER_SIZE, 0);
+
+	return true;
+}
+
+void Upload_manager::shutdown()
+{
+	// The caller has waited for the device to go idle, so every batch is done
+	if (staging_buffer != VK_NULL_HANDLE)
+	{
+		gpu_allocator->destroy_buffer(staging_buffer, staging_allocation);
+	}
+	staging_ring.shutdown();
+
+	timeline.shutdown();
+	vkDestroyCommandPool(device, command_pool, nullptr);
+
+	command_pool = VK_NULL_HANDLE;
+	recording    = VK_NULL_HANDLE;
+	release_barriers.clear();
+	pending_acquires.clear();
+	in_flight.clear();
+	free_command_buffers.clear();
+}
+
+std::optional<uint64_t> Upload_manager::upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size, VkPipelineStageFlags dst_stages, VkAccessFlags dst_access)
+{
+	// Chunks of a quarter ring always fit once the ring has drained, even when the head has to skip past the wrap
+	if (size == 0)
+	{
+		return acquired_value;
+	}
+
+	VkDeviceSize max_chunk = staging_ring.get_size() / 4;
+	VkDeviceSize copied    = 0;
+
+	while (copied < size)
+	{
+		VkDeviceSize chunk_size     = std::min(size - copied, max_chunk);
+		VkDeviceSize staging_offset = 0;
+
+		if (!allocate_staging(chunk_size, staging_offset))
+		{
+			return std::nullopt;
+		}
+
+		std::memcpy(staging_allocation.mapped + staging_offset, static_cast<const uint8_t*>(data) + copied, chunk_size);
+
+		VkBufferCopy copy_region = {};
+		copy_region.srcOffset    = staging_offset;
+		copy_region.dstOffset    = offset + copied;
+		copy_region.size         = chunk_size;
+
+		vkCmdCopyBuffer(get_recording_command_buffer(), staging_buffer, buffer, 1, &copy_region);
+
+		copied += chunk_size;
+	}
+
+	// Buffers are exclusive to one family, so a dedicated transfer queue has to hand ownership over to graphics
+	bool ownership = transfer_family != graphics_family;
+
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask         = 0;
+	barrier.srcQueueFamilyIndex   = transfer_family;
+	barrier.dstQueueFamilyIndex   = graphics_family;
+	barrier.buffer                = buffer;
+	barrier.offset                = offset;
+	barrier.size                  = size;
+	if (ownership)
+	{
+		release_barriers.push_back(barrier);
+	}
+
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = dst_access;
+	pending_acquires.push_back({timeline.get_next_value(), dst_stages, ownership, barrier});
+
+	return timeline.get_next_value();
+}
+
+void Upload_manager::discard(VkBuffer buffer)
+{
+	std::erase_if(release_barriers, [&](const VkBufferMemoryBarrier& barrier) { return barrier.buffer == buffer; });
+	std::erase_if(pending_acquires, [&](const Pending_acquire& acquire) { return acquire.barrier.buffer == buffer; });
+}
+
+void Upload_manager::flush()
+{
+	if (recording == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	if (!release_barriers.empty())
+	{
+		vkCmdPipelineBarrier(recording,
+		                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		                     0,
+		                     0,
+		                     nullptr,
+		                     static_cast<uint32_t>(release_barriers.size()),
+		                     release_barriers.data(),
+		                     0,
+		                     nullptr);
+		release_barriers.clear();
+	}
+
+	if (vkEndCommandBuffer(recording) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to record upload command buffer.");
+	}
+
+	uint64_t    signal_value     = timeline.advance();
+	VkSemaphore signal_semaphore = timeline.get_semaphore();
+
+	VkTimelineSemaphoreSubmitInfo timeline_info = {};
+	timeline_info.sType                         = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timeline_info.signalSemaphoreValueCount     = 1;
+	timeline_info.pSignalSemaphoreValues        = &signal_value;
+
+	VkSubmitInfo submit_info         = {};
+	submit_info.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.pNext                = &timeline_info;
+	submit_info.commandBufferCount   = 1;
+	submit_info.pCommandBuffers      = &recording;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores    = &signal_semaphore;
+
+	if (vkQueueSubmit(transfer_queue, 1, &submit_info, VK_NULL_HANDLE) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to submit upload command buffer.");
+	}
+
+	in_flight.push_back({recording, signal_value, staging_ring.get_head()});
+	recording = VK_NULL_HANDLE;
+}
+
+Timeline_wait Upload_manager::record_acquires(VkCommandBuffer command_buffer)
+{
+	uint64_t completed_value = timeline.get_completed_value();
+	retire(completed_value);
+
+	// Only batches the host has seen finish are acquired, so the graphics queue's wait on them never blocks
+	std::vector<VkBufferMemoryBarrier> acquire_barriers;
+	std::vector<Pending_acquire>       still_pending;
+	VkPipelineStageFlags               acquire_stages = 0;
+	uint64_t                           acquire_value  = 0;
+
+	for (const Pending_acquire& acquire : pending_acquires)
+	{
+		if (acquire.value > completed_value)
+		{
+			still_pending.push_back(acquire);
+			continue;
+		}
+
+		acquire_stages |= acquire.dst_stages;
+		acquire_value   = std::max(acquire_value, acquire.value);
+		if (acquire.ownership)
+		{
+			acquire_barriers.push_back(acquire.barrier);
+		}
+	}
+	pending_acquires.swap(still_pending);
+
+	// The barrier waits on the same stages as the semaphore, which chains it after the transfer queue's release
+	if (!acquire_barriers.empty())
+	{
+		vkCmdPipelineBarrier(command_buffer,
+		                     acquire_stages,
+		                     acquire_stages,
+		                     0,
+		                     0,
+		                     nullptr,
+		                     static_cast<uint32_t>(acquire_barriers.size()),
+		                     acquire_barriers.data(),
+		                     0,
+		                     nullptr);
+	}
+
+	acquired_value = std::max(acquired_value, completed_value);
+	return timeline.get_wait(acquire_value, acquire_stages);
+}
+
+bool Upload_manager::is_complete(uint64_t value) const
+{
+	return value <= acquired_value;
+}
+
+Gpu_timeline& Upload_manager::get_timeline()
+{
+	return timeline;
+}
+
+bool Upload_manager::allocate_staging(VkDeviceSize size, VkDeviceSize& offset)
+{
+	while (!staging_ring.allocate(size, STAGING_ALIGNMENT, offset))
+	{
+		// Out of staging space, push what is recorded and block on the oldest batch to free its range
+		flush();
+
+		if (in_flight.empty())
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Upload of %llu bytes does not fit the staging buffer.", static_cast<unsigned long long>(size));
+			return false;
+		}
+
+		timeline.wait(in_flight.front().value);
+		retire(in_flight.front().value);
+	}
+
+	return true;
+}
+
+VkCommandBuffer Upload_manager::get_recording_command_buffer()
+{
+	if (recording != VK_NULL_HANDLE)
+	{
+		return recording;
+	}
+
+	if (!free_command_buffers.empty())
+	{
+		recording = free_command_buffers.back();
+		free_command_buffers.pop_back();
+	}
+	else
+	{
+		VkCommandBufferAllocateInfo allocate_info = {};
+		allocate_info.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocate_info.commandPool                 = command_pool;
+		allocate_info.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocate_info.commandBufferCount          = 1;
+
+		if (vkAllocateCommandBuffers(device, &allocate_info, &recording) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to allocate upload command buffer.");
+		}
+	}
+
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType                    = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags                    = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	vkBeginCommandBuffer(recording, &begin_info);
+
+	return recording;
+}
+
+void Upload_manager::retire(uint64_t completed_value)
+{
+	while (!in_flight.empty() && in_flight.front().value <= completed_value)
+	{
+		staging_ring.release(in_flight.front().staging_end);
+		free_command_buffers.push_back(in_flight.front().command_buffer);
+		in_flight.pop_front();
+	}
+}
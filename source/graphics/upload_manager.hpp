@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "core/ring_allocator.hpp"
+#include "graphics/gpu_allocator.hpp"
+#include "graphics/gpu_timeline.hpp"
+
+
+// Streams data into device local buffers through a staging ring on the transfer queue.
+// Completion is tracked with a timeline semaphore, so neither queue waits on the other unless it has to.
+class Upload_manager
+{
+public:
+
+	bool startup(VkDevice device, Gpu_allocator& gpu_allocator, VkQueue transfer_queue, uint32_t transfer_family, uint32_t graphics_family);
+	void shutdown();
+
+	// The stages and accesses are the graphics queue's first uses of the data. Empty when the staging ring could not
+	// take it, the ring has drained by then, so no batch references the buffer anymore and it can be destroyed once
+	// discard() dropped the ownership transfers of its earlier uploads.
+	std::optional<uint64_t> upload_buffer(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size, VkPipelineStageFlags dst_stages, VkAccessFlags dst_access);
+	void                    discard(VkBuffer buffer);
+	void                    flush();
+	bool                    is_complete(uint64_t value) const;
+
+	// The graphics submit has to wait on the returned value before the returned stages, no value when nothing finished
+	Timeline_wait record_acquires(VkCommandBuffer command_buffer);
+
+	Gpu_timeline& get_timeline();
+
+private:
+
+	struct Batch
+	{
+		VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+		uint64_t        value          = 0;
+		uint64_t        staging_end    = 0;
+	};
+
+	// Uploads on the graphics family need no barrier, the semaphore wait before their stages makes the copies visible
+	struct Pending_acquire
+	{
+		uint64_t              value      = 0;
+		VkPipelineStageFlags  dst_stages = 0;
+		bool                  ownership  = false;
+		VkBufferMemoryBarrier barrier;
+	};
+
+	VkDevice                           device          = VK_NULL_HANDLE;
+	Gpu_allocator*                     gpu_allocator   = nullptr;
+	VkQueue                            transfer_queue  = VK_NULL_HANDLE;
+	uint32_t                           transfer_family = 0;
+	uint32_t                           graphics_family = 0;
+	VkCommandPool                      command_pool    = VK_NULL_HANDLE;
+	VkBuffer                           staging_buffer  = VK_NULL_HANDLE;
+	Gpu_timeline                       timeline;
+	Gpu_allocation                     staging_allocation;
+	Ring_allocator                     staging_ring;
+	VkCommandBuffer                    recording = VK_NULL_HANDLE;
+	std::vector<VkBufferMemoryBarrier> release_barriers;
+	std::vector<Pending_acquire>       pending_acquires;
+	std::deque<Batch>                  in_flight;
+	std::vector<VkCommandBuffer>       free_command_buffers;
+	uint64_t                           acquired_value = 0;
+
+	bool            allocate_staging(VkDeviceSize size, VkDeviceSize& offset);
+	VkCommandBuffer get_recording_command_buffer();
+	void            retire(uint64_t completed_value);
+};
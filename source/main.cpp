@@ -3,15 +3,23 @@
 
 #include <SDL3/SDL_log.h>
 #include <SDL3/SDL_main.h>
+#include <SDL3/SDL_timer.h>
+#include <vector>
 
 #include "config/application.hpp"
+#include "core/job_system.hpp"
+#include "core/profiler.hpp"
 #include "graphics/render_manager.hpp"
+#include "simulation/simulation.hpp"
 
 
 // =================================================================================================
 // Globals
 // =================================================================================================
-Render_manager render_manager;
+Job_system                 job_system;
+Render_manager             render_manager;
+Simulation                 simulation;
+std::vector<Mesh_instance> instances;
 
 
 // =================================================================================================
@@ -31,18 +39,36 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char** argv)
 		return SDL_APP_FAILURE;
 	}
 
-	if (!render_manager.startup())
+	PROFILE_THREAD_NAME("Main");
+
+	if (!job_system.startup())
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start job system.");
+		return SDL_APP_FAILURE;
+	}
+
+	if (!render_manager.startup(job_system))
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start render manager: %s", SDL_GetError());
 		return SDL_APP_FAILURE;
 	}
 
+	if (!simulation.startup(render_manager.get_placeholder_mesh()))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start simulation.");
+		return SDL_APP_FAILURE;
+	}
+
 	return SDL_APP_CONTINUE;
 }
 
 SDL_AppResult SDL_AppIterate(void* appstate)
 {
+	// The simulation ticks on its own thread, a frame only picks up its newest state
+	simulation.interpolate(SDL_GetTicksNS(), instances);
+	render_manager.update_instances(instances);
 	render_manager.update();
+	Profiler::end_frame();
 
 	return SDL_APP_CONTINUE;
 }
@@ -54,10 +80,30 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
 		return SDL_APP_SUCCESS;
 	}
 
+	// Only flags the swapchain, it is rebuilt at the start of the next frame without waiting for the GPU
+	if (event->type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED)
+	{
+		render_manager.resize(static_cast<uint32_t>(event->window.data1), static_cast<uint32_t>(event->window.data2));
+	}
+
+	// Presses are what a player feels the delay of, latency is measured from the earliest one a frame picks up
+	if (event->type == SDL_EVENT_KEY_DOWN || event->type == SDL_EVENT_MOUSE_BUTTON_DOWN || event->type == SDL_EVENT_GAMEPAD_BUTTON_DOWN)
+	{
+		render_manager.record_input(event->common.timestamp);
+	}
+
+	// F11 writes the next few frames to a Chrome trace in the working directory
+	if (event->type == SDL_EVENT_KEY_DOWN && event->key.key == SDLK_F11 && !event->key.repeat)
+	{
+		Profiler::start_capture(PROFILE_CAPTURE_FRAMES, PROFILE_TRACE_FILE);
+	}
+
 	return SDL_APP_CONTINUE;
 }
 
 void SDL_AppQuit(void* appstate, SDL_AppResult result)
 {
+	simulation.shutdown();
 	render_manager.shutdown();
+	job_system.shutdown();
 }
\ No newline at end of file
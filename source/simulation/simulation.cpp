@@ -0,0 +1,144 @@
+#include "simulation.hpp"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <cmath>
+
+#include "config/application.hpp"
+#include "core/profiler.hpp"
+
+
+const glm::vec2 DEMO_VELOCITY = glm::vec2(0.3f, 0.2f);
+
+
+static Transform interpolate_transform(const Transform& previous, const Transform& current, float alpha)
+{
+	Transform transform;
+	transform.offset = previous.offset + (current.offset - previous.offset) * alpha;
+	transform.scale  = previous.scale + (current.scale - previous.scale) * alpha;
+	return transform;
+}
+
+
+bool Simulation::startup(Mesh_handle mesh, uint32_t tick_rate)
+{
+	if (tick_rate == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "The simulation tick rate has to be positive.");
+		return false;
+	}
+
+	tick_interval_ns = SDL_NS_PER_SECOND / tick_rate;
+	tick             = 0;
+
+	Entity entity = world.create_entity();
+	world.add_component<Transform>(entity);
+	world.add_component<Previous_transform>(entity);
+	world.add_component<Velocity>(entity, {DEMO_VELOCITY});
+	world.add_component<Renderable>(entity, {mesh});
+
+	// The first snapshot is there before the thread starts, so the renderer never draws an empty world
+	publish(SDL_GetTicksNS());
+
+	running = true;
+	thread  = std::thread(&Simulation::run, this);
+	return true;
+}
+
+void Simulation::shutdown()
+{
+	running = false;
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+	world = World();
+}
+
+void Simulation::interpolate(uint64_t now_ns, std::vector<Mesh_instance>& instances)
+{
+	snapshots.acquire();
+	const Simulation_snapshot& snapshot = snapshots.get_read_buffer();
+
+	// A late tick holds at the newest state rather than extrapolating past it
+	float alpha = now_ns > snapshot.time_ns ? static_cast<float>(now_ns - snapshot.time_ns) / static_cast<float>(tick_interval_ns) : 0.0f;
+	alpha       = std::clamp(alpha, 0.0f, 1.0f);
+
+	instances.resize(snapshot.instances.size());
+	for (size_t i = 0; i < snapshot.instances.size(); i++)
+	{
+		const Snapshot_instance& source    = snapshot.instances[i];
+		Transform                transform = interpolate_transform(source.previous, source.current, alpha);
+
+		instances[i].mesh   = source.mesh;
+		instances[i].offset = transform.offset;
+		instances[i].scale  = transform.scale;
+	}
+}
+
+void Simulation::run()
+{
+	PROFILE_THREAD_NAME("Simulation");
+
+	float    delta_time   = static_cast<float>(tick_interval_ns) / SDL_NS_PER_SECOND;
+	uint64_t next_tick_ns = SDL_GetTicksNS() + tick_interval_ns;
+
+	while (running.load(std::memory_order_relaxed))
+	{
+		uint64_t now_ns = SDL_GetTicksNS();
+		if (now_ns < next_tick_ns)
+		{
+			SDL_DelayPrecise(next_tick_ns - now_ns);
+			continue;
+		}
+
+		// Ticks missed to a hitch or a debugger are caught up, but past a few the time is dropped instead of run in a burst
+		if (now_ns - next_tick_ns > tick_interval_ns * SIMULATION_MAX_CATCH_UP_TICKS)
+		{
+			next_tick_ns = now_ns;
+		}
+
+		update(delta_time);
+		publish(next_tick_ns);
+		next_tick_ns += tick_interval_ns;
+	}
+}
+
+void Simulation::update(float delta_time)
+{
+	PROFILE_SCOPE("Simulation tick");
+
+	world.each<Transform, Previous_transform>([](Transform& transform, Previous_transform& previous) { previous.value = transform; });
+
+	// Stand-in game logic until there is some, it keeps the interpolation visible
+	world.each<Transform, Velocity>(
+	    [delta_time](Transform& transform, Velocity& velocity)
+	    {
+		    transform.offset += velocity.value * delta_time;
+		    for (int axis = 0; axis < 2; axis++)
+		    {
+			    if (std::abs(transform.offset[axis]) > SIMULATION_BOUNDS)
+			    {
+				    transform.offset[axis] = std::clamp(transform.offset[axis], -SIMULATION_BOUNDS, SIMULATION_BOUNDS);
+				    velocity.value[axis]   = -velocity.value[axis];
+			    }
+		    }
+	    });
+
+	tick++;
+}
+
+void Simulation::publish(uint64_t time_ns)
+{
+	// The write buffer still holds an older snapshot, clearing it keeps the capacity
+	Simulation_snapshot& snapshot = snapshots.get_write_buffer();
+	snapshot.tick                 = tick;
+	snapshot.time_ns              = time_ns;
+	snapshot.instances.clear();
+
+	world.each<Transform, Previous_transform, Renderable>(
+	    [&snapshot](Transform& transform, Previous_transform& previous, Renderable& renderable) { snapshot.instances.push_back({renderable.mesh, previous.value, transform}); });
+
+	snapshots.publish();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <thread>
+#include <vector>
+
+#include "config/application.hpp"
+#include "core/triple_buffer.hpp"
+#include "ecs/world.hpp"
+#include "graphics/mesh.hpp"
+
+
+struct Transform
+{
+	glm::vec2 offset = glm::vec2(0.0f);
+	float     scale  = 1.0f;
+};
+
+// Where the entity was at the start of the current tick, what the renderer interpolates from
+struct Previous_transform
+{
+	Transform value;
+};
+
+struct Velocity
+{
+	glm::vec2 value = glm::vec2(0.0f);
+};
+
+struct Renderable
+{
+	Mesh_handle mesh = INVALID_MESH;
+};
+
+struct Snapshot_instance
+{
+	Mesh_handle mesh = INVALID_MESH;
+	Transform   previous;
+	Transform   current;
+};
+
+// Everything the renderer needs from one tick. time_ns is when the tick was due on the SDL_GetTicksNS clock, the
+// previous transforms belong one tick interval before it.
+struct Simulation_snapshot
+{
+	uint64_t                       tick    = 0;
+	uint64_t                       time_ns = 0;
+	std::vector<Snapshot_instance> instances;
+};
+
+// Runs the game world at a fixed rate on a thread of its own and hands every tick to the renderer through a triple
+// buffer, so neither side ever waits for the other. The world belongs to the simulation thread alone.
+class Simulation
+{
+public:
+
+	bool startup(Mesh_handle mesh, uint32_t tick_rate = SIMULATION_TICK_RATE);
+	void shutdown();
+
+	// Render thread only. Blends the newest tick with the one before it for now_ns, which puts what is drawn one tick
+	// behind the simulation; instances is refilled in place so it stops allocating once it has grown
+	void interpolate(uint64_t now_ns, std::vector<Mesh_instance>& instances);
+
+private:
+
+	World                              world;
+	std::thread                        thread;
+	std::atomic<bool>                  running = false;
+	Triple_buffer<Simulation_snapshot> snapshots;
+	uint64_t                           tick_interval_ns = 0;
+	uint64_t                           tick             = 0;
+
+	void run();
+	void update(float delta_time);
+	void publish(uint64_t time_ns);
+};
@@ -0,0 +1,417 @@
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "core/ring_allocator.hpp"
+#include "core/tlsf_allocator.hpp"
+#include "graphics/gpu_allocator.hpp"
+
+
+// =================================================================================================
+// Test configuration
+// =================================================================================================
+constexpr uint64_t TLSF_HEAP_SIZE        = 1024 * 1024;
+constexpr uint32_t RANDOM_OPERATIONS     = 100'000;
+constexpr uint32_t RANDOM_SEED           = 1234;
+constexpr uint64_t MAX_RANDOM_SIZE       = 16 * 1024;
+constexpr uint32_t MAX_RANDOM_SHIFT      = 12;
+constexpr uint64_t FAKE_HEAP_SIZE        = 8 * 1024 * 1024;
+constexpr uint64_t FAKE_BLOCK_SIZE       = FAKE_HEAP_SIZE / 8;
+constexpr uint64_t DEFRAGMENT_SIZE       = 64 * 1024;
+constexpr uint32_t ALLOCATIONS_PER_BLOCK = static_cast<uint32_t>(FAKE_BLOCK_SIZE / DEFRAGMENT_SIZE);
+
+
+static bool expect(bool condition, const char* test, const char* description)
+{
+	if (!condition)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: %s", test, description);
+	}
+	return condition;
+}
+
+
+// =================================================================================================
+// Fake device
+// =================================================================================================
+// Gpu_allocator only asks the driver for memory properties and opaque memory handles, so defining those entry points
+// here lets its bookkeeping run without a GPU. One device local heap, nothing host visible, so nothing is ever mapped.
+static uint64_t fake_memory_count = 0;
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* memory_properties)
+{
+	*memory_properties                              = {};
+	memory_properties->memoryTypeCount              = 1;
+	memory_properties->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	memory_properties->memoryTypes[0].heapIndex     = 0;
+	memory_properties->memoryHeapCount              = 1;
+	memory_properties->memoryHeaps[0].size          = FAKE_HEAP_SIZE;
+	memory_properties->memoryHeaps[0].flags         = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* properties)
+{
+	*properties                               = {};
+	properties->limits.bufferImageGranularity = 1;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo*, const VkAllocationCallbacks*, VkDeviceMemory* memory)
+{
+	*memory = reinterpret_cast<VkDeviceMemory>(++fake_memory_count);
+	return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory, const VkAllocationCallbacks*)
+{
+}
+
+
+// =================================================================================================
+// TLSF
+// =================================================================================================
+static bool test_tlsf_coalescing()
+{
+	const char*    test = "tlsf coalescing";
+	Tlsf_allocator tlsf;
+	tlsf.startup(TLSF_HEAP_SIZE);
+
+	// Four quarters fill the heap exactly, so nothing is left for a fifth
+	Tlsf_allocation quarters[4];
+	bool            passed = true;
+	for (Tlsf_allocation& quarter : quarters)
+	{
+		passed = expect(tlsf.allocate(TLSF_HEAP_SIZE / 4, 1, quarter), test, "a quarter of the heap did not fit") && passed;
+	}
+
+	Tlsf_allocation overflow;
+	passed = expect(!tlsf.allocate(TLSF_MIN_BLOCK, 1, overflow), test, "a full heap handed out more") && passed;
+	passed = expect(tlsf.get_used_size() == TLSF_HEAP_SIZE && tlsf.get_largest_free_block() == 0, test, "a full heap reports free space") && passed;
+
+	// Freeing two neighbours has to leave one block spanning both
+	tlsf.free(quarters[1]);
+	tlsf.free(quarters[2]);
+	passed = expect(tlsf.get_largest_free_block() == TLSF_HEAP_SIZE / 2, test, "freed neighbours were not merged") && passed;
+
+	Tlsf_allocation half;
+	passed = expect(tlsf.allocate(TLSF_HEAP_SIZE / 2, 1, half), test, "the merged block cannot be allocated") && passed;
+	passed = expect(half.offset == quarters[1].offset, test, "the merged block does not start at the first neighbour") && passed;
+
+	tlsf.free(half);
+	tlsf.free(quarters[0]);
+	tlsf.free(quarters[3]);
+	passed = expect(tlsf.is_empty() && tlsf.get_used_size() == 0, test, "an emptied heap still reports allocations") && passed;
+	passed = expect(tlsf.get_largest_free_block() == TLSF_HEAP_SIZE, test, "an emptied heap is not one block again") && passed;
+
+	// Freeing twice is ignored rather than corrupting the free lists
+	tlsf.free(quarters[0]);
+	passed = expect(tlsf.is_empty() && tlsf.get_largest_free_block() == TLSF_HEAP_SIZE, test, "a double free changed the heap") && passed;
+
+	return passed;
+}
+
+static bool test_tlsf_alignment()
+{
+	const char*    test = "tlsf alignment";
+	Tlsf_allocator tlsf;
+	tlsf.startup(TLSF_HEAP_SIZE);
+
+	bool                         passed = true;
+	std::vector<Tlsf_allocation> allocations;
+	for (uint64_t alignment = 1; alignment <= 64 * 1024; alignment *= 2)
+	{
+		// An odd size first, so the next allocation starts off any useful boundary
+		Tlsf_allocation odd;
+		Tlsf_allocation aligned;
+		passed = expect(tlsf.allocate(3, 1, odd), test, "a small allocation failed") && passed;
+		passed = expect(tlsf.allocate(alignment + 7, alignment, aligned), test, "an aligned allocation failed") && passed;
+		passed = expect(aligned.offset % alignment == 0, test, "an allocation is not aligned") && passed;
+		passed = expect(aligned.size >= alignment + 7 && aligned.offset + aligned.size <= tlsf.get_size(), test, "an allocation is too small or out of range") && passed;
+
+		allocations.push_back(odd);
+		allocations.push_back(aligned);
+	}
+
+	// Non power of two alignments are rounded up rather than ignored
+	Tlsf_allocation rounded;
+	passed = expect(tlsf.allocate(100, 48, rounded) && rounded.offset % 64 == 0, test, "an alignment of 48 was not rounded up to 64") && passed;
+	allocations.push_back(rounded);
+
+	for (const Tlsf_allocation& allocation : allocations)
+	{
+		tlsf.free(allocation);
+	}
+	passed = expect(tlsf.is_empty() && tlsf.get_largest_free_block() == TLSF_HEAP_SIZE, test, "the padding was not given back") && passed;
+
+	return passed;
+}
+
+static bool test_tlsf_random_workload()
+{
+	const char*    test = "tlsf random workload";
+	Tlsf_allocator tlsf;
+	tlsf.startup(TLSF_HEAP_SIZE);
+
+	std::mt19937                            random(RANDOM_SEED);
+	std::uniform_int_distribution<uint64_t> size(1, MAX_RANDOM_SIZE);
+	std::uniform_int_distribution<uint32_t> shift(0, MAX_RANDOM_SHIFT);
+	std::uniform_int_distribution<uint32_t> coin(0, 2);
+
+	// Live ranges keyed by offset, an overlap shows up as a neighbour reaching past the new range or into it
+	std::map<uint64_t, Tlsf_allocation> live;
+	uint64_t                            failures = 0;
+
+	for (uint32_t operation = 0; operation < RANDOM_OPERATIONS; operation++)
+	{
+		// Two allocations for every free, so the heap runs full and both paths get exercised
+		if (live.empty() || coin(random) != 0)
+		{
+			uint64_t        alignment = uint64_t(1) << shift(random);
+			Tlsf_allocation allocation;
+			if (!tlsf.allocate(size(random), alignment, allocation))
+			{
+				failures++;
+				continue;
+			}
+
+			if (allocation.offset % alignment != 0 || allocation.offset + allocation.size > tlsf.get_size())
+			{
+				return expect(false, test, "an allocation is misaligned or out of range");
+			}
+
+			auto next = live.lower_bound(allocation.offset);
+			if (next != live.end() && next->first < allocation.offset + allocation.size)
+			{
+				return expect(false, test, "an allocation overlaps the one after it");
+			}
+			if (next != live.begin() && std::prev(next)->first + std::prev(next)->second.size > allocation.offset)
+			{
+				return expect(false, test, "an allocation overlaps the one before it");
+			}
+
+			live.emplace(allocation.offset, allocation);
+		}
+		else
+		{
+			auto victim = std::next(live.begin(), std::uniform_int_distribution<size_t>(0, live.size() - 1)(random));
+			tlsf.free(victim->second);
+			live.erase(victim);
+		}
+
+		if (tlsf.get_allocation_count() != live.size())
+		{
+			return expect(false, test, "the allocation count drifted from the live set");
+		}
+	}
+
+	uint64_t live_size = 0;
+	for (const auto& [offset, allocation] : live)
+	{
+		live_size += allocation.size;
+	}
+
+	bool passed = expect(failures > 0, test, "the workload never filled the heap");
+	passed      = expect(tlsf.get_used_size() == live_size, test, "the used size drifted from the live set") && passed;
+
+	for (const auto& [offset, allocation] : live)
+	{
+		tlsf.free(allocation);
+	}
+	passed = expect(tlsf.is_empty() && tlsf.get_largest_free_block() == TLSF_HEAP_SIZE, test, "the heap did not merge back into one block") && passed;
+
+	return passed;
+}
+
+
+// =================================================================================================
+// Ring
+// =================================================================================================
+static bool test_ring_frames()
+{
+	const char*    test = "ring frames";
+	Ring_allocator ring;
+	ring.startup(1024, 2);
+
+	uint64_t offset = 0;
+	bool     passed = true;
+
+	ring.begin_frame(0);
+	passed = expect(ring.allocate(400, 16, offset) && offset == 0, test, "the first allocation is not at the start") && passed;
+	ring.end_frame(0);
+
+	ring.begin_frame(1);
+	passed = expect(ring.allocate(400, 16, offset) && offset == 400, test, "the second frame does not follow the first") && passed;
+	ring.end_frame(1);
+
+	// Frame 0 is still in flight, the tail would not fit and the start is still taken
+	passed = expect(!ring.allocate(400, 16, offset), test, "space still in flight was handed out") && passed;
+	passed = expect(ring.get_used_size() == 800, test, "a failed allocation moved the head") && passed;
+
+	// Once frame 0 retires its space comes back, and an allocation that would straddle the end wraps to the start
+	ring.begin_frame(0);
+	passed = expect(ring.get_used_size() == 400, test, "beginning a frame did not release what it allocated last time") && passed;
+	passed = expect(ring.allocate(400, 16, offset) && offset == 0, test, "an allocation did not wrap to the start") && passed;
+	passed = expect(ring.allocate(16, 16, offset) == false, test, "a wrapped allocation ran into the frame in flight") && passed;
+	ring.end_frame(0);
+
+	ring.begin_frame(1);
+	passed = expect(ring.get_used_size() == 400 + 224, test, "the skipped tail was not accounted to the wrapped frame") && passed;
+	passed = expect(ring.allocate(100, 64, offset) && offset == 448, test, "the offset after a wrap is not aligned") && passed;
+	ring.end_frame(1);
+
+	ring.begin_frame(0);
+	ring.begin_frame(1);
+	passed = expect(ring.get_used_size() == 0, test, "retiring every frame left space in use") && passed;
+
+	return passed;
+}
+
+static bool test_ring_release()
+{
+	const char*    test = "ring release";
+	Ring_allocator ring;
+	ring.startup(256, 1);
+
+	// Owners that retire by timeline value release up to a head they recorded themselves
+	uint64_t offset = 0;
+	bool     passed = expect(ring.allocate(128, 1, offset), test, "the first batch did not fit");
+	uint64_t first  = ring.get_head();
+	passed          = expect(ring.allocate(128, 1, offset), test, "the second batch did not fit") && passed;
+	uint64_t second = ring.get_head();
+
+	passed = expect(!ring.allocate(1, 1, offset), test, "a full ring handed out more") && passed;
+	ring.release(first);
+	passed = expect(ring.allocate(64, 1, offset) && offset == 0, test, "released space was not reused") && passed;
+
+	// Releasing an older position again must not move the tail back
+	ring.release(first - 64);
+	passed = expect(ring.get_used_size() == 192, test, "an older release moved the tail back") && passed;
+	ring.release(second);
+	passed = expect(ring.get_used_size() == 64, test, "releasing the second batch left it in use") && passed;
+
+	return passed;
+}
+
+
+// =================================================================================================
+// Defragmentation
+// =================================================================================================
+static bool test_defragmentation()
+{
+	const char*   test = "defragmentation";
+	Gpu_allocator allocator;
+	allocator.startup(VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+	VkMemoryRequirements requirements = {};
+	requirements.size                 = DEFRAGMENT_SIZE;
+	requirements.alignment            = 256;
+	requirements.memoryTypeBits       = 1;
+
+	// Alignment padding keeps a block from taking quite ALLOCATIONS_PER_BLOCK, so this fills one block and spills into a
+	// second, then the first is thinned out to two allocations
+	std::vector<Gpu_allocation> allocations(ALLOCATIONS_PER_BLOCK + ALLOCATIONS_PER_BLOCK / 2);
+	bool                        passed = true;
+	for (Gpu_allocation& allocation : allocations)
+	{
+		passed = expect(allocator.allocate(requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocation), test, "the fake heap ran out") && passed;
+	}
+	if (!passed)
+	{
+		return false;
+	}
+
+	Gpu_memory_block* sparse_block = allocations.front().block;
+	Gpu_memory_block* dense_block  = allocations.back().block;
+	passed                         = expect(sparse_block != dense_block, test, "the allocations did not spill into a second block") && passed;
+
+	uint32_t kept = 0;
+	for (Gpu_allocation& allocation : allocations)
+	{
+		if (allocation.block == sparse_block && kept++ >= 2)
+		{
+			allocator.free(allocation);
+		}
+	}
+
+	std::vector<Gpu_allocation*> live;
+	for (Gpu_allocation& allocation : allocations)
+	{
+		if (allocation.block)
+		{
+			live.push_back(&allocation);
+		}
+	}
+
+	// The budget caps a pass, and data only ever moves from the emptier block to the fuller one
+	std::vector<Gpu_defragmentation_move> moves = allocator.begin_defragmentation(live, DEFRAGMENT_SIZE);
+	passed = expect(moves.size() == 1, test, "the byte budget did not limit the pass to one move") && passed;
+	for (const Gpu_defragmentation_move& move : moves)
+	{
+		passed = expect(move.allocation->block == sparse_block && move.destination.block == dense_block, test, "a move does not go from the sparse to the dense block") && passed;
+		passed = expect(move.destination.offset % requirements.alignment == 0, test, "a destination is misaligned") && passed;
+	}
+	allocator.end_defragmentation(moves);
+	passed = expect(moves.empty(), test, "end_defragmentation did not consume the moves") && passed;
+
+	moves  = allocator.begin_defragmentation(live, UINT64_MAX);
+	passed = expect(moves.size() == 1, test, "the second pass did not move the last sparse allocation") && passed;
+	allocator.end_defragmentation(moves);
+
+	// Every allocation now lives in the dense block, without overlapping, and the sparse one is empty
+	std::sort(live.begin(), live.end(), [](const Gpu_allocation* a, const Gpu_allocation* b) { return a->offset < b->offset; });
+	for (size_t i = 0; i < live.size(); i++)
+	{
+		passed = expect(live[i]->block == dense_block && live[i]->memory == dense_block->memory, test, "an allocation was left behind or not rebound") && passed;
+		passed = expect(i == 0 || live[i - 1]->offset + live[i - 1]->size <= live[i]->offset, test, "moved allocations overlap") && passed;
+	}
+	passed = expect(sparse_block->tlsf.is_empty(), test, "the evacuated block still has allocations") && passed;
+
+	Gpu_heap_stats stats = allocator.get_heap_stats(0);
+	passed               = expect(stats.allocation_count == live.size() && stats.live_bytes == live.size() * DEFRAGMENT_SIZE, test, "moving changed the heap totals") && passed;
+
+	// Nothing is left to gain, so a further pass plans nothing
+	moves  = allocator.begin_defragmentation(live, UINT64_MAX);
+	passed = expect(moves.empty(), test, "a compacted heap still planned moves") && passed;
+
+	for (Gpu_allocation* allocation : live)
+	{
+		allocator.free(*allocation);
+	}
+	allocator.shutdown();
+
+	return passed;
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main()
+{
+	bool (*tests[])() = {
+	    test_tlsf_coalescing,
+	    test_tlsf_alignment,
+	    test_tlsf_random_workload,
+	    test_ring_frames,
+	    test_ring_release,
+	    test_defragmentation,
+	};
+
+	uint32_t failed = 0;
+	for (bool (*test)() : tests)
+	{
+		failed += test() ? 0 : 1;
+	}
+
+	if (failed > 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%u of %zu allocator tests failed.", failed, std::size(tests));
+		return EXIT_FAILURE;
+	}
+
+	SDL_Log("All %zu allocator tests passed.", std::size(tests));
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,182 @@
+#include <SDL3/SDL_log.h>
+#include <atomic>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+
+#include "core/job_system.hpp"
+#include "ecs/world.hpp"
+
+
+// =================================================================================================
+// Test configuration
+// =================================================================================================
+constexpr uint32_t ENTITY_COUNT = 10'000;
+constexpr uint32_t WORKER_COUNT = 4;
+
+
+static bool expect(bool condition, const char* test, const char* description)
+{
+	if (!condition)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: %s", test, description);
+	}
+	return condition;
+}
+
+
+// =================================================================================================
+// Components
+// =================================================================================================
+struct Position
+{
+	float x = 0.0f;
+	float y = 0.0f;
+	float z = 0.0f;
+};
+
+struct Velocity
+{
+	float x = 0.0f;
+	float y = 0.0f;
+	float z = 0.0f;
+};
+
+// Three of these fill most of a chunk, the fourth leaves no room for even one row
+template <uint32_t Index>
+struct Large
+{
+	uint8_t bytes[MAX_COMPONENT_SIZE] = {};
+};
+
+
+// =================================================================================================
+// World
+// =================================================================================================
+static bool test_add_remove_each()
+{
+	const char*         test   = "add remove each";
+	bool                passed = true;
+	World               world;
+	std::vector<Entity> entities;
+
+	for (uint32_t i = 0; i < ENTITY_COUNT; i++)
+	{
+		Entity entity = world.create_entity();
+		entities.push_back(entity);
+		world.add_component<Position>(entity, {static_cast<float>(i), 0.0f, 0.0f});
+		if (i % 2 == 0)
+		{
+			world.add_component<Velocity>(entity, {1.0f, 0.0f, 0.0f});
+		}
+	}
+
+	uint32_t moving = 0;
+	world.each<Position, Velocity>(
+	    [&](Position& position, const Velocity& velocity)
+	    {
+		    position.x += velocity.x;
+		    moving++;
+	    });
+	passed &= expect(moving == ENTITY_COUNT / 2, test, "each visited the wrong number of moving entities");
+
+	uint32_t positioned = 0;
+	world.each<Position>(
+	    [&](Entity entity, const Position& position)
+	    {
+		    positioned++;
+		    passed &= expect(position.x == static_cast<float>(entity.index + (entity.index % 2 == 0 ? 1 : 0)), test, "a component lost its value when the entity moved");
+	    });
+	passed &= expect(positioned == ENTITY_COUNT, test, "each visited the wrong number of entities");
+
+	// Structural changes are not allowed while a query iterates, so remove afterwards
+	for (Entity entity : entities)
+	{
+		world.remove_component<Velocity>(entity);
+	}
+
+	moving = 0;
+	world.each<Velocity>([&](const Velocity&) { moving++; });
+	passed &= expect(moving == 0, test, "removed components are still visited");
+
+	return passed;
+}
+
+static bool test_destroyed_entities()
+{
+	const char* test   = "destroyed entities";
+	bool        passed = true;
+	World       world;
+
+	Entity entity = world.create_entity();
+	world.add_component<Position>(entity);
+	world.destroy_entity(entity);
+
+	passed &= expect(!world.is_alive(entity), test, "a destroyed entity is still alive");
+	passed &= expect(world.add_component<Velocity>(entity) == nullptr, test, "a component was added to a destroyed entity");
+	passed &= expect(world.get_component<Position>(entity) == nullptr, test, "a destroyed entity still resolves its components");
+
+	Entity recycled = world.create_entity();
+	passed &= expect(recycled.index == entity.index && recycled.generation != entity.generation, test, "a recycled index kept its generation");
+	passed &= expect(!world.is_alive(entity), test, "a stale handle resolves to the recycled entity");
+
+	return passed;
+}
+
+static bool test_oversized_row()
+{
+	const char* test   = "oversized row";
+	bool        passed = true;
+	World       world;
+
+	Entity entity = world.create_entity();
+	passed &= expect(world.add_component<Large<0>>(entity) != nullptr, test, "the first large component was refused");
+	passed &= expect(world.add_component<Large<1>>(entity) != nullptr, test, "the second large component was refused");
+	passed &= expect(world.add_component<Large<2>>(entity) != nullptr, test, "the third large component was refused");
+	passed &= expect(world.add_component<Large<3>>(entity) == nullptr, test, "a row larger than a chunk was accepted");
+	passed &= expect(world.add_component<Large<3>>(entity) == nullptr, test, "a row larger than a chunk was accepted on retry");
+	passed &= expect(world.has_component<Large<2>>(entity) && !world.has_component<Large<3>>(entity), test, "the refused add moved the entity");
+
+	// Iterating after a refused add must not see an archetype without room for a row
+	uint32_t visited = 0;
+	world.each<Large<0>>([&](const Large<0>&) { visited++; });
+	world.each<Large<3>>([&](const Large<3>&) { visited += 100; });
+	passed &= expect(visited == 1, test, "each visited the wrong entities after a refused add");
+
+	Job_system job_system;
+	job_system.startup(WORKER_COUNT);
+	std::atomic<uint32_t> parallel_visited = 0;
+	world.parallel_each<Large<0>>(job_system, [&](const Large<0>&) { parallel_visited++; });
+	job_system.shutdown();
+	passed &= expect(parallel_visited == 1, test, "parallel_each visited the wrong entities after a refused add");
+
+	return passed;
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main()
+{
+	bool (*tests[])() = {
+	    test_add_remove_each,
+	    test_destroyed_entities,
+	    test_oversized_row,
+	};
+
+	uint32_t failed = 0;
+	for (bool (*test)() : tests)
+	{
+		failed += test() ? 0 : 1;
+	}
+
+	if (failed > 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%u of %zu ecs tests failed.", failed, std::size(tests));
+		return EXIT_FAILURE;
+	}
+
+	SDL_Log("All %zu ecs tests passed.", std::size(tests));
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "core/simd_math.hpp"
+
+
+// =================================================================================================
+// Test configuration
+// =================================================================================================
+// Not a multiple of the block width, so the kernels also see a partially filled last block
+constexpr uint32_t OBJECT_COUNT    = 10'003;
+constexpr uint32_t RANDOM_SEED     = 1234;
+constexpr float    SCATTER_EXTENT  = 60.0f;
+constexpr float    MAX_EXTENT      = 4.0f;
+constexpr float    TOLERANCE       = 1e-5f;
+constexpr float    SLERP_TOLERANCE = 5e-5f;
+
+// Objects this close to a plane may fall either way depending on how the compiler contracts the reference loop
+constexpr float CULL_MARGIN = 1e-4f;
+
+// A camera at the origin looking down -z with a 90 degree field of view, near at 1 and far at 100
+const glm::vec4 PLANES[FRUSTUM_PLANE_COUNT] = {
+    glm::vec4(0.70710678f, 0.0f, -0.70710678f, 0.0f),
+    glm::vec4(-0.70710678f, 0.0f, -0.70710678f, 0.0f),
+    glm::vec4(0.0f, 0.70710678f, -0.70710678f, 0.0f),
+    glm::vec4(0.0f, -0.70710678f, -0.70710678f, 0.0f),
+    glm::vec4(0.0f, 0.0f, -1.0f, -1.0f),
+    glm::vec4(0.0f, 0.0f, 1.0f, 100.0f),
+};
+
+
+// =================================================================================================
+// Scene
+// =================================================================================================
+struct Scene
+{
+	uint32_t  object_count = 0;
+	glm::mat4 matrix;
+
+	// The glm side, one object per element
+	std::vector<glm::vec4> points;
+	std::vector<glm::vec4> spheres;
+	std::vector<glm::vec3> centers;
+	std::vector<glm::vec3> extents;
+	std::vector<glm::mat4> parents;
+	std::vector<glm::mat4> locals;
+	std::vector<glm::quat> from;
+	std::vector<glm::quat> to;
+	std::vector<float>     factors;
+
+	// The same objects in blocks of eight
+	std::vector<Vec4_block> point_blocks;
+	std::vector<Vec4_block> sphere_blocks;
+	std::vector<Aabb_block> box_blocks;
+	std::vector<Vec4_block> from_blocks;
+	std::vector<Vec4_block> to_blocks;
+	std::vector<float>      factor_lanes;
+};
+
+struct Results
+{
+	std::vector<glm::vec4> points;
+	std::vector<glm::mat4> matrices;
+	std::vector<uint32_t>  visible_spheres;
+	std::vector<uint32_t>  visible_boxes;
+	std::vector<glm::quat> rotations;
+};
+
+static glm::quat random_rotation(std::mt19937& random)
+{
+	std::normal_distribution<float> component;
+
+	glm::vec4 value(component(random), component(random), component(random), component(random));
+	value = value * (1.0f / std::sqrt(glm::dot(value, value)));
+	return glm::quat(value.w, value.x, value.y, value.z);
+}
+
+static Scene create_scene(uint32_t object_count)
+{
+	std::mt19937                          random(RANDOM_SEED);
+	std::uniform_real_distribution<float> position(-SCATTER_EXTENT, SCATTER_EXTENT);
+	std::uniform_real_distribution<float> extent(0.1f, MAX_EXTENT);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::uniform_real_distribution<float> signed_unit(-1.0f, 1.0f);
+
+	Scene scene;
+	scene.object_count = object_count;
+	scene.matrix       = glm::mat4(1.0f);
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			scene.matrix[column][row] += signed_unit(random) * 0.5f;
+		}
+	}
+
+	size_t block_count = get_block_count(object_count);
+	scene.point_blocks.resize(block_count);
+	scene.sphere_blocks.resize(block_count);
+	scene.box_blocks.resize(block_count);
+	scene.from_blocks.resize(block_count);
+	scene.to_blocks.resize(block_count);
+	scene.factor_lanes.resize(block_count * SIMD_BLOCK_WIDTH);
+
+	for (uint32_t i = 0; i < object_count; i++)
+	{
+		// Centered on the frustum's middle so a good share is inside, outside and crossing a plane
+		glm::vec3 center(position(random), position(random), position(random) - SCATTER_EXTENT);
+		glm::vec3 box_extent(extent(random), extent(random), extent(random));
+
+		glm::mat4 parent(1.0f);
+		glm::mat4 local(1.0f);
+		for (int column = 0; column < 4; column++)
+		{
+			for (int row = 0; row < 4; row++)
+			{
+				parent[column][row] = signed_unit(random);
+				local[column][row]  = signed_unit(random);
+			}
+		}
+
+		scene.points.push_back(glm::vec4(center, 1.0f));
+		scene.spheres.push_back(glm::vec4(center, box_extent.x));
+		scene.centers.push_back(center);
+		scene.extents.push_back(box_extent);
+		scene.parents.push_back(parent);
+		scene.locals.push_back(local);
+		scene.from.push_back(random_rotation(random));
+		scene.to.push_back(random_rotation(random));
+		scene.factors.push_back(unit(random));
+
+		size_t block = i / SIMD_BLOCK_WIDTH;
+		size_t lane  = i % SIMD_BLOCK_WIDTH;
+		set_lane(scene.point_blocks[block], lane, scene.points[i]);
+		set_lane(scene.sphere_blocks[block], lane, scene.spheres[i]);
+		set_lane(scene.box_blocks[block], lane, center, box_extent);
+		set_lane(scene.from_blocks[block], lane, glm::vec4(scene.from[i].x, scene.from[i].y, scene.from[i].z, scene.from[i].w));
+		set_lane(scene.to_blocks[block], lane, glm::vec4(scene.to[i].x, scene.to[i].y, scene.to[i].z, scene.to[i].w));
+		scene.factor_lanes[i] = scene.factors[i];
+	}
+
+	return scene;
+}
+
+
+// =================================================================================================
+// Reference loops
+// =================================================================================================
+static float get_sphere_margin(const glm::vec4& sphere)
+{
+	float margin = INFINITY;
+	for (const glm::vec4& plane : PLANES)
+	{
+		margin = std::min(margin, plane.x * sphere.x + plane.y * sphere.y + plane.z * sphere.z + plane.w + sphere.w);
+	}
+	return margin;
+}
+
+static float get_box_margin(const glm::vec3& center, const glm::vec3& extent)
+{
+	float margin = INFINITY;
+	for (const glm::vec4& plane : PLANES)
+	{
+		float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+		float reach    = std::abs(plane.x) * extent.x + std::abs(plane.y) * extent.y + std::abs(plane.z) * extent.z;
+		margin         = std::min(margin, distance + reach);
+	}
+	return margin;
+}
+
+static void run_glm(const Scene& scene, Results& results)
+{
+	results.points.resize(scene.object_count);
+	results.matrices.resize(scene.object_count);
+	results.rotations.resize(scene.object_count);
+	results.visible_spheres.clear();
+	results.visible_boxes.clear();
+
+	for (uint32_t i = 0; i < scene.object_count; i++)
+	{
+		results.points[i]    = scene.matrix * scene.points[i];
+		results.matrices[i]  = scene.parents[i] * scene.locals[i];
+		results.rotations[i] = glm::slerp(scene.from[i], scene.to[i], scene.factors[i]);
+		if (get_sphere_margin(scene.spheres[i]) >= 0.0f)
+		{
+			results.visible_spheres.push_back(i);
+		}
+		if (get_box_margin(scene.centers[i], scene.extents[i]) >= 0.0f)
+		{
+			results.visible_boxes.push_back(i);
+		}
+	}
+}
+
+
+// =================================================================================================
+// Correctness
+// =================================================================================================
+static float get_difference(const glm::vec4& a, const glm::vec4& b)
+{
+	return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z), std::abs(a.w - b.w)});
+}
+
+static float get_relative_difference(const glm::mat4& a, const glm::mat4& b)
+{
+	float difference = 0.0f;
+	for (int column = 0; column < 4; column++)
+	{
+		float scale = std::max(1.0f, std::max({std::abs(b[column].x), std::abs(b[column].y), std::abs(b[column].z), std::abs(b[column].w)}));
+		difference  = std::max(difference, get_difference(a[column], b[column]) / scale);
+	}
+	return difference;
+}
+
+// Both lists are ascending, objects on a plane within the margin may be in either
+template <typename Margin>
+static bool check_visible(const char* name, const std::vector<uint32_t>& expected, const std::vector<uint32_t>& actual, size_t actual_count, const Margin& get_margin)
+{
+	size_t expected_index = 0;
+	size_t actual_index   = 0;
+	while (expected_index < expected.size() || actual_index < actual_count)
+	{
+		uint32_t expected_object = expected_index < expected.size() ? expected[expected_index] : UINT32_MAX;
+		uint32_t actual_object   = actual_index < actual_count ? actual[actual_index] : UINT32_MAX;
+		if (expected_object == actual_object)
+		{
+			expected_index++;
+			actual_index++;
+			continue;
+		}
+
+		uint32_t object = std::min(expected_object, actual_object);
+		if (std::abs(get_margin(object)) > CULL_MARGIN)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: object %u is %s but should not be.", name, object, object == actual_object ? "visible" : "culled");
+			return false;
+		}
+		(object == expected_object ? expected_index : actual_index)++;
+	}
+	return true;
+}
+
+static bool check_level(Simd_level level, const Scene& scene, const Results& expected)
+{
+	set_simd_level(level);
+
+	size_t                  block_count = scene.point_blocks.size();
+	std::vector<Vec4_block> points(block_count);
+	std::vector<glm::mat4>  matrices(scene.object_count);
+	std::vector<Vec4_block> rotations(block_count);
+	std::vector<uint32_t>   visible(scene.object_count);
+
+	transform_vectors(scene.matrix, scene.point_blocks.data(), points.data(), block_count);
+	multiply_matrices(scene.parents.data(), scene.locals.data(), matrices.data(), scene.object_count);
+	slerp_quaternions(scene.from_blocks.data(), scene.to_blocks.data(), scene.factor_lanes.data(), rotations.data(), block_count);
+
+	float point_error    = 0.0f;
+	float matrix_error   = 0.0f;
+	float rotation_error = 0.0f;
+	for (uint32_t i = 0; i < scene.object_count; i++)
+	{
+		const glm::quat& rotation = expected.rotations[i];
+
+		float scale    = std::max(1.0f, get_difference(expected.points[i], glm::vec4(0.0f)));
+		point_error    = std::max(point_error, get_difference(get_lane(points[i / SIMD_BLOCK_WIDTH], i % SIMD_BLOCK_WIDTH), expected.points[i]) / scale);
+		matrix_error   = std::max(matrix_error, get_relative_difference(matrices[i], expected.matrices[i]));
+		rotation_error = std::max(rotation_error, get_difference(get_lane(rotations[i / SIMD_BLOCK_WIDTH], i % SIMD_BLOCK_WIDTH), glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w)));
+	}
+
+	const char* name = get_simd_level_name(level);
+	SDL_Log("%-8s max error | transform %.2e | multiply %.2e | slerp %.2e", name, point_error, matrix_error, rotation_error);
+
+	// The polynomial slerp trades a little accuracy for its speed
+	bool passed = point_error <= TOLERANCE && matrix_error <= TOLERANCE && rotation_error <= SLERP_TOLERANCE;
+	if (!passed)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s: results differ from glm by more than the tolerance.", name);
+	}
+
+	auto sphere_margin = [&](uint32_t object) { return get_sphere_margin(scene.spheres[object]); };
+	auto box_margin    = [&](uint32_t object) { return get_box_margin(scene.centers[object], scene.extents[object]); };
+
+	size_t visible_count = cull_spheres(PLANES, scene.sphere_blocks.data(), scene.object_count, visible.data());
+	passed               = check_visible(name, expected.visible_spheres, visible, visible_count, sphere_margin) && passed;
+	visible_count        = cull_aabbs(PLANES, scene.box_blocks.data(), scene.object_count, visible.data());
+	passed               = check_visible(name, expected.visible_boxes, visible, visible_count, box_margin) && passed;
+
+	// Counts that end inside a block must leave the lanes past them out
+	uint32_t              partial_count = scene.object_count - std::min(scene.object_count, 3u);
+	std::vector<uint32_t> partial_expected;
+	std::copy_if(expected.visible_spheres.begin(), expected.visible_spheres.end(), std::back_inserter(partial_expected), [&](uint32_t object) { return object < partial_count; });
+	visible_count = cull_spheres(PLANES, scene.sphere_blocks.data(), partial_count, visible.data());
+	passed        = check_visible(name, partial_expected, visible, visible_count, sphere_margin) && passed;
+
+	return passed;
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main()
+{
+	Scene   scene = create_scene(OBJECT_COUNT);
+	Results results;
+	run_glm(scene, results);
+
+	// Every level the CPU has is checked against glm, the ones it lacks cannot run here
+	SDL_Log("Widest supported level: %s", get_simd_level_name(get_supported_simd_level()));
+	bool passed = true;
+	for (uint8_t level = 0; level <= static_cast<uint8_t>(get_supported_simd_level()); level++)
+	{
+		passed = check_level(static_cast<Simd_level>(level), scene, results) && passed;
+	}
+
+	if (!passed)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "The SIMD kernels do not match glm.");
+		return EXIT_FAILURE;
+	}
+
+	SDL_Log("The SIMD kernels match glm at every supported level.");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/asset_archive.hpp"
+#include "core/file_io.hpp"
+
+
+// =================================================================================================
+// Packer configuration
+// =================================================================================================
+
+// Compressed data is only kept when it saves at least 1/MIN_COMPRESSION_GAIN of the entry, otherwise reads stay zero copy
+constexpr uint64_t MIN_COMPRESSION_GAIN = 16;
+
+
+struct Packed_asset
+{
+	std::string           name;
+	std::filesystem::path root;
+	std::vector<char>     data;
+	Asset_entry           entry = {};
+};
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+static uint64_t align_up(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool collect_assets(const std::filesystem::path& root, const std::filesystem::path& input, std::vector<Packed_asset>& assets)
+{
+	std::error_code error;
+	if (std::filesystem::is_regular_file(root / input, error))
+	{
+		Packed_asset asset = {};
+		asset.name         = input.generic_string();
+		asset.root         = root;
+		assets.push_back(std::move(asset));
+		return true;
+	}
+
+	std::filesystem::recursive_directory_iterator iterator(root / input, error);
+	if (error)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to open %s.", (root / input).string().c_str());
+		return false;
+	}
+
+	for (const std::filesystem::directory_entry& entry : iterator)
+	{
+		if (entry.is_regular_file())
+		{
+			Packed_asset asset = {};
+			asset.name         = std::filesystem::relative(entry.path(), root).generic_string();
+			asset.root         = root;
+			assets.push_back(std::move(asset));
+		}
+	}
+
+	return true;
+}
+
+static void compress_asset(Packed_asset& asset)
+{
+	asset.entry.path_hash   = hash_asset_path(asset.name);
+	asset.entry.size        = asset.data.size();
+	asset.entry.stored_size = asset.data.size();
+	asset.entry.compression = Asset_compression::none;
+
+	if (asset.data.empty() || asset.data.size() > LZ4_MAX_INPUT_SIZE)
+	{
+		return;
+	}
+
+	std::vector<char> compressed(static_cast<size_t>(LZ4_compressBound(static_cast<int>(asset.data.size()))));
+	int compressed_size = LZ4_compress_HC(asset.data.data(), compressed.data(), static_cast<int>(asset.data.size()), static_cast<int>(compressed.size()), LZ4HC_CLEVEL_MAX);
+
+	if (compressed_size > 0 && static_cast<uint64_t>(compressed_size) <= asset.data.size() - asset.data.size() / MIN_COMPRESSION_GAIN)
+	{
+		compressed.resize(static_cast<size_t>(compressed_size));
+		asset.data.swap(compressed);
+		asset.entry.stored_size = asset.data.size();
+		asset.entry.compression = Asset_compression::lz4;
+	}
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s <archive> <root> <file or directory relative to root>... [--root <root> <file or directory>...]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::string           archive_path = argv[1];
+	std::filesystem::path root         = argv[2];
+
+	// --root switches the root for the inputs after it, so build outputs can be packed next to the sources
+	std::vector<Packed_asset> assets;
+	for (int i = 3; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--root" && i + 1 < argc)
+		{
+			root = argv[++i];
+			continue;
+		}
+		if (!collect_assets(root, argv[i], assets))
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Sorted so the same inputs always produce the same archive, a name found under a later root replaces the earlier one
+	std::stable_sort(assets.begin(), assets.end(), [](const Packed_asset& a, const Packed_asset& b) { return a.name < b.name; });
+	std::reverse(assets.begin(), assets.end());
+	assets.erase(std::unique(assets.begin(), assets.end(), [](const Packed_asset& a, const Packed_asset& b) { return a.name == b.name; }), assets.end());
+	std::reverse(assets.begin(), assets.end());
+
+	uint64_t total_size = 0;
+	for (Packed_asset& asset : assets)
+	{
+		if (!read_file((asset.root / asset.name).string(), asset.data))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to read %s.", asset.name.c_str());
+			return EXIT_FAILURE;
+		}
+		total_size += asset.data.size();
+		compress_asset(asset);
+	}
+
+	// At most half full, so probes stay short and always end on an empty slot
+	Asset_archive_header header = {};
+	header.magic                = ASSET_ARCHIVE_MAGIC;
+	header.version              = ASSET_ARCHIVE_VERSION;
+	header.entry_count          = static_cast<uint32_t>(assets.size());
+	header.slot_count           = std::bit_ceil(std::max<uint32_t>(header.entry_count * 2, 1));
+	header.index_offset         = sizeof(Asset_archive_header);
+
+	std::vector<Asset_entry> slots(header.slot_count);
+	uint64_t                 offset = align_up(header.index_offset + slots.size() * sizeof(Asset_entry), ASSET_ARCHIVE_ALIGNMENT);
+
+	for (Packed_asset& asset : assets)
+	{
+		asset.entry.offset = offset;
+		offset             = align_up(offset + asset.entry.stored_size, ASSET_ARCHIVE_ALIGNMENT);
+
+		uint64_t slot = asset.entry.path_hash & (header.slot_count - 1);
+		while (slots[slot].path_hash != EMPTY_ASSET_SLOT)
+		{
+			if (slots[slot].path_hash == asset.entry.path_hash)
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s collides with another asset's path hash, rename one of them.", asset.name.c_str());
+				return EXIT_FAILURE;
+			}
+			slot = (slot + 1) & (header.slot_count - 1);
+		}
+		slots[slot] = asset.entry;
+	}
+
+	// Written next to the real file and renamed over it, so an interrupted build never leaves a torn archive
+	std::string temporary_path = archive_path + ".tmp";
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to open %s.", temporary_path.c_str());
+			return EXIT_FAILURE;
+		}
+
+		const std::vector<char> padding(ASSET_ARCHIVE_ALIGNMENT, 0);
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(Asset_entry)));
+
+		for (const Packed_asset& asset : assets)
+		{
+			file.write(padding.data(), static_cast<std::streamsize>(asset.entry.offset - static_cast<uint64_t>(file.tellp())));
+			file.write(asset.data.data(), static_cast<std::streamsize>(asset.data.size()));
+		}
+
+		if (!file.good())
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to write %s.", temporary_path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary_path, archive_path, error);
+	if (error)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "Failed to move %s into place.", archive_path.c_str());
+		return EXIT_FAILURE;
+	}
+
+	uint64_t archive_size = std::filesystem::file_size(archive_path, error);
+	SDL_Log("Packed %zu assets, %llu bytes into %llu bytes.", assets.size(), static_cast<unsigned long long>(total_size), static_cast<unsigned long long>(archive_size));
+
+	return EXIT_SUCCESS;
+}
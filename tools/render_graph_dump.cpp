@@ -0,0 +1,183 @@
+#include <SDL3/SDL_log.h>
+#include <cstdlib>
+#include <string>
+
+#include "graphics/render_graph.hpp"
+
+
+// =================================================================================================
+// Dump configuration
+// =================================================================================================
+
+// Render targets are placed at 64 KiB, which is what desktop drivers ask for, and one memory type fits them all
+constexpr VkDeviceSize ESTIMATED_ALIGNMENT   = 64 * 1024;
+constexpr uint32_t     ESTIMATED_TYPE_BITS   = 1;
+constexpr uint32_t     DEFAULT_WIDTH         = 1920;
+constexpr uint32_t     DEFAULT_HEIGHT        = 1080;
+constexpr uint32_t     SHADOW_MAP_RESOLUTION = 2048;
+
+
+// =================================================================================================
+// Helpers
+// =================================================================================================
+static VkDeviceSize get_bytes_per_pixel(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+	case VK_FORMAT_D32_SFLOAT_S8_UINT:
+		return 8;
+	case VK_FORMAT_R8_UNORM:
+		return 1;
+	default:
+		return 4;
+	}
+}
+
+static VkMemoryRequirements estimate_requirements(const Render_graph& graph, Render_resource resource)
+{
+	const Render_image_desc& desc = graph.get_desc(resource);
+
+	VkMemoryRequirements requirements = {};
+	requirements.size                 = VkDeviceSize(desc.extent.width) * desc.extent.height * get_bytes_per_pixel(desc.format);
+	requirements.size                 = (requirements.size + ESTIMATED_ALIGNMENT - 1) / ESTIMATED_ALIGNMENT * ESTIMATED_ALIGNMENT;
+	requirements.alignment            = ESTIMATED_ALIGNMENT;
+	requirements.memoryTypeBits       = ESTIMATED_TYPE_BITS;
+	return requirements;
+}
+
+// A deferred frame with the passes that are planned, plus a debug view nothing reads, which has to be culled
+static void build_frame_graph(Render_graph& graph, uint32_t width, uint32_t height)
+{
+	VkExtent2D extent        = {width, height};
+	VkExtent2D half_extent   = {width / 2, height / 2};
+	VkExtent2D shadow_extent = {SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION};
+
+	Render_resource swapchain  = graph.import_image("Swapchain", {VK_FORMAT_B8G8R8A8_SRGB, extent}, Render_usage::none, Render_usage::present);
+	Render_resource shadow_map = graph.create_image("Shadow map", {VK_FORMAT_D32_SFLOAT, shadow_extent});
+	Render_resource depth      = graph.create_image("Depth", {VK_FORMAT_D32_SFLOAT, extent});
+	Render_resource albedo     = graph.create_image("Albedo", {VK_FORMAT_R8G8B8A8_SRGB, extent});
+	Render_resource normals    = graph.create_image("Normals", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+	Render_resource lit        = graph.create_image("Lit", {VK_FORMAT_R16G16B16A16_SFLOAT, extent});
+	Render_resource bloom      = graph.create_image("Bloom", {VK_FORMAT_R16G16B16A16_SFLOAT, half_extent});
+	Render_resource tonemapped = graph.create_image("Tonemapped", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+	Render_resource debug_view = graph.create_image("Debug view", {VK_FORMAT_R8G8B8A8_UNORM, extent});
+
+	Render_pass_handle shadow = graph.add_pass("Shadows", nullptr);
+	graph.write(shadow, shadow_map, Render_usage::depth_attachment);
+
+	Render_pass_handle prepass = graph.add_pass("Depth prepass", nullptr);
+	graph.write(prepass, depth, Render_usage::depth_attachment);
+
+	Render_pass_handle gbuffer = graph.add_pass("G-buffer", nullptr);
+	graph.read(gbuffer, depth, Render_usage::depth_attachment);
+	graph.write(gbuffer, albedo, Render_usage::color_attachment);
+	graph.write(gbuffer, normals, Render_usage::color_attachment);
+
+	Render_pass_handle debug = graph.add_pass("Debug view", nullptr);
+	graph.read(debug, normals, Render_usage::fragment_sampled);
+	graph.write(debug, debug_view, Render_usage::color_attachment);
+
+	Render_pass_handle lighting = graph.add_pass("Lighting", nullptr);
+	graph.read(lighting, shadow_map, Render_usage::fragment_sampled);
+	graph.read(lighting, depth, Render_usage::fragment_sampled);
+	graph.read(lighting, albedo, Render_usage::fragment_sampled);
+	graph.read(lighting, normals, Render_usage::fragment_sampled);
+	graph.write(lighting, lit, Render_usage::color_attachment);
+
+	Render_pass_handle bloom_pass = graph.add_pass("Bloom", nullptr);
+	graph.read(bloom_pass, lit, Render_usage::compute_sampled);
+	graph.write(bloom_pass, bloom, Render_usage::compute_storage);
+
+	Render_pass_handle tonemap = graph.add_pass("Tonemap", nullptr);
+	graph.read(tonemap, lit, Render_usage::fragment_sampled);
+	graph.read(tonemap, bloom, Render_usage::fragment_sampled);
+	graph.write(tonemap, tonemapped, Render_usage::color_attachment);
+
+	Render_pass_handle interface = graph.add_pass("Interface", nullptr);
+	graph.read(interface, tonemapped, Render_usage::fragment_sampled);
+	graph.write(interface, swapchain, Render_usage::color_attachment);
+}
+
+// Images that share memory must never be alive at once, and every transient's first use has to discard it
+static bool verify(const Render_graph& graph)
+{
+	bool valid = true;
+	for (Render_resource a = 0; a < graph.get_image_count(); a++)
+	{
+		if (!graph.is_placed(a))
+		{
+			continue;
+		}
+
+		const Render_placement& first = graph.get_placement(a);
+		for (Render_resource b = a + 1; b < graph.get_image_count(); b++)
+		{
+			if (!graph.is_placed(b))
+			{
+				continue;
+			}
+
+			const Render_placement& second          = graph.get_placement(b);
+			bool                    memory_overlaps = first.heap == second.heap && first.offset < second.offset + second.size && second.offset < first.offset + first.size;
+			bool                    alive_together  = first.first_pass <= second.last_pass && second.first_pass <= first.last_pass;
+			if (memory_overlaps && alive_together)
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s and %s share memory while both are alive.", graph.get_name(a).c_str(), graph.get_name(b).c_str());
+				valid = false;
+			}
+		}
+
+		bool discarded = false;
+		for (const Render_barrier& barrier : graph.get_barriers(first.first_pass))
+		{
+			discarded |= barrier.resource == a && barrier.old_layout == VK_IMAGE_LAYOUT_UNDEFINED;
+		}
+		if (!discarded)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_ERROR, "%s is not transitioned from undefined on its first use.", graph.get_name(a).c_str());
+			valid = false;
+		}
+	}
+
+	return valid;
+}
+
+
+// =================================================================================================
+// Entry point
+// =================================================================================================
+int main(int argc, char** argv)
+{
+	if (argc > 3)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: %s [width] [height]", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	uint32_t width  = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_WIDTH;
+	uint32_t height = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_HEIGHT;
+	if (width == 0 || height == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Width and height have to be positive.");
+		return EXIT_FAILURE;
+	}
+
+	Render_graph graph;
+	build_frame_graph(graph, width, height);
+
+	if (!graph.compile([&graph](Render_resource resource) { return estimate_requirements(graph, resource); }))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_ERROR, "The frame graph has nothing to schedule.");
+		return EXIT_FAILURE;
+	}
+
+	graph.log_schedule();
+	if (!verify(graph))
+	{
+		return EXIT_FAILURE;
+	}
+
+	SDL_Log("Frame graph verified.");
+	return EXIT_SUCCESS;
+}